@@ -1,13 +1,113 @@
 {
+    "variables": {
+        # node-gyp rebuild --tsan=1: ThreadSanitizer instrumented build
+        "tsan%": 0,
+        # node-gyp rebuild --native_benchmarks=1: also build the native benchmarks
+        "native_benchmarks%": 0,
+        # node-gyp rebuild --native_tests=1: also build the native tests
+        "native_tests%": 0
+    },
+    "target_defaults": {
+        "conditions": [
+            [ "tsan==1", {
+                "cflags_cc": [ "-fsanitize=thread", "-g", "-O1" ],
+                "ldflags": [ "-fsanitize=thread" ]
+            } ]
+        ]
+    },
     "targets": [
+        {
+            # Device layer shared by the addon and the tuxedo-io CLI
+            "target_name": "tuxedo_io",
+            "type": "static_library",
+            "sources": [ "src/native-lib/tuxedo_io_lib/tuxedo_io_runtime.cc" ],
+            "include_dirs": [ "./src/native-lib/tuxedo_io_lib" ],
+            "cflags_cc": [ "-fPIC" ],
+            "direct_dependent_settings": {
+                "include_dirs": [ "./src/native-lib/tuxedo_io_lib" ]
+            }
+        },
         {
             "target_name": "TuxedoIOAPI",
             "sources": [ "src/native-lib/tuxedo_io_napi.cc" ],
-            "include_dirs": [ "<!@(node -p \"require('node-addon-api').include\")", "./src/native-lib/tuxedo_io_lib" ],
-            "dependencies": [ "<!(node -p \"require('node-addon-api').gyp\")" ],
+            "include_dirs": [ "<!@(node -p \"require('node-addon-api').include\")" ],
+            "dependencies": [ "<!(node -p \"require('node-addon-api').gyp\")", "tuxedo_io" ],
             "libraries": [ "-ludev" ],
-            "defines": [ "NAPI_CPP_EXCEPTIONS" ],
+            "defines": [ "NAPI_CPP_EXCEPTIONS", "NAPI_VERSION=6" ],
+            "cflags_cc": ['-fexceptions']
+        },
+        {
+            "target_name": "tuxedo-io",
+            "type": "executable",
+            "sources": [ "src/native-lib/cli/tuxedo_io_cli.cc" ],
+            "dependencies": [ "tuxedo_io" ],
+            "libraries": [ "-lpthread" ],
             "cflags_cc": ['-fexceptions']
         }
+    ],
+    "conditions": [
+        [ "native_benchmarks==1", {
+            "targets": [
+                {
+                    "target_name": "tuxedo_io_stress",
+                    "type": "executable",
+                    "sources": [ "src/native-lib/benchmarks/tuxedo_io_stress.cc" ],
+                    "include_dirs": [ "./src/native-lib/tuxedo_io_lib" ],
+                    "libraries": [ "-lpthread" ],
+                    "cflags_cc": ['-fexceptions']
+                }
+            ]
+        } ],
+        [ "native_tests==1", {
+            "targets": [
+                {
+                    "target_name": "led_frame_engine_test",
+                    "type": "executable",
+                    "sources": [ "src/native-lib/tests/led_frame_engine_test.cc" ],
+                    "include_dirs": [ "./src/native-lib/tuxedo_io_lib" ],
+                    "libraries": [ "-lpthread" ],
+                    "cflags_cc": ['-fexceptions']
+                },
+                {
+                    "target_name": "drm_connector_catalog_test",
+                    "type": "executable",
+                    "sources": [ "src/native-lib/tests/drm_connector_catalog_test.cc" ],
+                    "include_dirs": [ "./src/native-lib/tuxedo_io_lib" ],
+                    "cflags_cc": ['-fexceptions']
+                },
+                {
+                    "target_name": "throttle_monitor_test",
+                    "type": "executable",
+                    "sources": [ "src/native-lib/tests/throttle_monitor_test.cc" ],
+                    "include_dirs": [ "./src/native-lib/tuxedo_io_lib" ],
+                    "libraries": [ "-lpthread" ],
+                    "cflags_cc": ['-fexceptions']
+                },
+                {
+                    "target_name": "telemetry_fallback_test",
+                    "type": "executable",
+                    "sources": [ "src/native-lib/tests/telemetry_fallback_test.cc" ],
+                    "include_dirs": [ "./src/native-lib/tuxedo_io_lib" ],
+                    "libraries": [ "-lpthread" ],
+                    "cflags_cc": ['-fexceptions']
+                },
+                {
+                    "target_name": "load_classifier_test",
+                    "type": "executable",
+                    "sources": [ "src/native-lib/tests/load_classifier_test.cc" ],
+                    "include_dirs": [ "./src/native-lib/tuxedo_io_lib" ],
+                    "libraries": [ "-lpthread" ],
+                    "cflags_cc": ['-fexceptions']
+                },
+                {
+                    "target_name": "tdp_autotuner_test",
+                    "type": "executable",
+                    "sources": [ "src/native-lib/tests/tdp_autotuner_test.cc" ],
+                    "include_dirs": [ "./src/native-lib/tuxedo_io_lib" ],
+                    "libraries": [ "-lpthread" ],
+                    "cflags_cc": ['-fexceptions']
+                }
+            ]
+        } ]
     ]
 }
@@ -56,6 +56,7 @@ async function buildDeb(filenameAddition: string): Promise<void> {
         extraResources: [
             distSrc + '/data/service/tccd',
             distSrc + '/data/service/TuxedoIOAPI.node',
+            distSrc + '/data/service/tuxedo-io',
             distSrc + '/data/CHANGELOG.md',
             distSrc + '/data/dist-data/tccd.service',
             distSrc + '/data/dist-data/tccd-sleep.service',
@@ -120,6 +121,7 @@ async function buildRpm(filenameAddition: string): Promise<void> {
         extraResources: [
             distSrc + '/data/service/tccd',
             distSrc + '/data/service/TuxedoIOAPI.node',
+            distSrc + '/data/service/tuxedo-io',
             distSrc + '/data/dist-data/tccd.service',
             distSrc + '/data/dist-data/tccd-sleep.service',
             distSrc + '/data/dist-data/tuxedo-control-center_256.svg',
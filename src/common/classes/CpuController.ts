@@ -21,10 +21,15 @@ import { LogicalCpuController, ScalingDriver } from './LogicalCpuController';
 import { SysFsPropertyInteger, SysFsPropertyNumList, SysFsPropertyBoolean, SysFsPropertyString } from './SysFsProperties';
 import { IntelPstateController } from './IntelPStateController';
 import { findClosestValue } from './Utils';
+import { SysFsBatch, SysFsBatchWriteFunction } from './SysFsBatch';
 
 export class CpuController {
 
-    constructor(public readonly basePath: string) {
+    /**
+     * @param batchWriter Used to apply batches created by createBatch, plain
+     *                    file writes if undefined
+     */
+    constructor(public readonly basePath: string, private batchWriter?: SysFsBatchWriteFunction) {
         this.cores = [];
         this.getAvailableLogicalCores();
     }
@@ -64,30 +69,40 @@ export class CpuController {
         } catch (err) {}
     }
 
+    /**
+     * Batch for the setters below, applied with the batch writer of this controller
+     */
+    public createBatch(): SysFsBatch {
+        return new SysFsBatch(this.batchWriter);
+    }
+
     /**
      * Sets the selected number of cpu cores to be online, the rest to be offline
      *
      * @param numberOfCores Number of logical cpu cores to use, defaults to "use all available"
+     * @param batch Queue writes in batch instead of writing directly
      */
-    public useCores(numberOfCores?: number): void {
+    public useCores(numberOfCores?: number, batch?: SysFsBatch): void {
         if (numberOfCores === undefined) { numberOfCores = this.cores.length; }
         if (numberOfCores === 0) { return; }
         for (let i = 1; i < this.cores.length; ++i) {
             if (!this.cores[i].online.isAvailable()) { continue; }
             if (i < numberOfCores) {
-                this.cores[i].online.writeValue(true);
+                this.cores[i].online.writeValueQueued(true, batch);
             } else {
-                this.cores[i].online.writeValue(false);
+                this.cores[i].online.writeValueQueued(false, batch);
             }
         }
+        batch?.barrier();
     }
 
     /**
      * Sets the scaling_max_freq parameter for the current governor for all available logical cores
      *
      * @param setMaxFrequency Maximum scaling frequency value to set, defaults to max value for core
+     * @param batch Queue writes in batch instead of writing directly
      */
-    public setGovernorScalingMaxFrequency(setMaxFrequency?: number): void {
+    public setGovernorScalingMaxFrequency(setMaxFrequency?: number, batch?: SysFsBatch): void {
         let scalingDriver;
 
         for (const core of this.cores) {
@@ -96,7 +111,7 @@ export class CpuController {
             if (core.coreIndex !== 0 && !core.online.readValue()) { continue; }
             const coreMinFrequency = core.cpuinfoMinFreq.readValue();
             const coreMaxFrequency = core.cpuinfoMaxFreq.readValue();
-            const scalingMinFrequency = core.scalingMinFreq.readValue();
+            const scalingMinFrequency = core.scalingMinFreq.readValueQueued(batch);
             let availableFrequencies = core.scalingAvailableFrequencies.readValueNT();
             scalingDriver = core.scalingDriver.readValueNT();
             let newMaxFrequency: number;
@@ -130,7 +145,7 @@ export class CpuController {
                 newMaxFrequency = findClosestValue(newMaxFrequency, availableFrequencies);
             }
 
-            core.scalingMaxFreq.writeValue(newMaxFrequency);
+            core.scalingMaxFreq.writeValueQueued(newMaxFrequency, batch);
         }
 
         // AMD does not count boost frequency to coreMaxFrequency while Intel does. So on AMD a setMaxFrequency over
@@ -144,27 +159,29 @@ export class CpuController {
         }
         if (this.boost.isAvailable() && scalingDriver === ScalingDriver.acpi_cpufreq) {
             if (setMaxFrequency === undefined || setMaxFrequency > maximumAvailableFrequency) {
-                this.boost.writeValue(true);
+                this.boost.writeValueQueued(true, batch);
             }
             else {
-                this.boost.writeValue(false);
+                this.boost.writeValueQueued(false, batch);
             }
         }
+        batch?.barrier();
     }
 
     /**
      * Sets the scaling_min_freq parameter for the current governor for all available logical cores
      *
      * @param setMinFrequency Minimum scaling frequency value to set, defaults to min value for core
+     * @param batch Queue writes in batch instead of writing directly
      */
-    public setGovernorScalingMinFrequency(setMinFrequency?: number): void {
+    public setGovernorScalingMinFrequency(setMinFrequency?: number, batch?: SysFsBatch): void {
         for (const core of this.cores) {
             if (!core.scalingMinFreq.isAvailable() || !core.scalingMaxFreq.isAvailable()
                 || !core.cpuinfoMinFreq.isAvailable() || !core.cpuinfoMaxFreq.isAvailable()) { continue; }
             if (core.coreIndex !== 0 && !core.online.readValue()) { continue; }
             const coreMinFrequency = core.cpuinfoMinFreq.readValue();
             const coreMaxFrequency = core.cpuinfoMaxFreq.readValue();
-            const scalingMaxFrequency = core.scalingMaxFreq.readValue();
+            const scalingMaxFrequency = core.scalingMaxFreq.readValueQueued(batch);
             let availableFrequencies = core.scalingAvailableFrequencies.readValueNT();
 
             let newMinFrequency: number;
@@ -193,8 +210,9 @@ export class CpuController {
                 newMinFrequency = findClosestValue(newMinFrequency, availableFrequencies);
             }
 
-            core.scalingMinFreq.writeValue(newMinFrequency);
+            core.scalingMinFreq.writeValueQueued(newMinFrequency, batch);
         }
+        batch?.barrier();
     }
 
     /**
@@ -203,8 +221,9 @@ export class CpuController {
      *
      * @param governor The chosen governor (the same will be applied to all cores),
      *                 defaults to "don't set"
+     * @param batch Queue writes in batch instead of writing directly
      */
-    public setGovernor(governor?: string) {
+    public setGovernor(governor?: string, batch?: SysFsBatch) {
         if (governor === undefined) {
             return;
         }
@@ -214,13 +233,14 @@ export class CpuController {
             if (core.coreIndex !== 0 && !core.online.readValue()) { return; }
             const availableGovernors = core.scalingAvailableGovernors.readValue();
             if (availableGovernors.includes(governor)) {
-                core.scalingGovernor.writeValue(governor);
+                core.scalingGovernor.writeValueQueued(governor, batch);
             } else {
                 throw Error('setGovernor: choosen governor \''
                  + governor + '\' is not available (' + core.cpuPath
                  + ') available are: ' + JSON.stringify(availableGovernors));
             }
         }
+        batch?.barrier();
     }
 
     /**
@@ -229,8 +249,9 @@ export class CpuController {
      *
      * @param performancePreference The chosen energy performance preference (the same
      *                              will be applied to all cores), defaults to "don't set"
+     * @param batch Queue writes in batch instead of writing directly
      */
-    public setEnergyPerformancePreference(performancePreference?: string) {
+    public setEnergyPerformancePreference(performancePreference?: string, batch?: SysFsBatch) {
         if (performancePreference === undefined) {
             return;
         }
@@ -239,8 +260,9 @@ export class CpuController {
             if (!core.energyPerformancePreference.isAvailable() || !core.energyPerformanceAvailablePreferences.isAvailable()) { continue; }
             if (core.coreIndex !== 0 && !core.online.readValue()) { return; }
             if (core.energyPerformanceAvailablePreferences.readValue().includes(performancePreference)) {
-                core.energyPerformancePreference.writeValue(performancePreference);
+                core.energyPerformancePreference.writeValueQueued(performancePreference, batch);
             }
         }
+        batch?.barrier();
     }
 }
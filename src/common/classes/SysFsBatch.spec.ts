@@ -0,0 +1,89 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import 'jasmine';
+import * as fs from 'fs';
+const mock = require('mock-fs');
+
+import { SysFsBatch, ISysFsWrite } from './SysFsBatch';
+import { SysFsPropertyInteger } from './SysFsProperties';
+
+describe('SysFsBatch', () => {
+
+    beforeEach(() => {
+        mock({
+            '/sys/devices/system/cpu/cpu0/cpufreq': {
+                'scaling_min_freq': '800000',
+                'scaling_max_freq': '4000000'
+            }
+        });
+    });
+
+    afterEach(() => {
+        mock.restore();
+    });
+
+    it('should only write on commit', () => {
+        const batch = new SysFsBatch();
+        const maxFreq = new SysFsPropertyInteger('/sys/devices/system/cpu/cpu0/cpufreq/scaling_max_freq');
+        maxFreq.writeValueQueued(2000000, batch);
+        expect(batch.length).toBe(1);
+        expect(maxFreq.readValue()).toBe(4000000);
+        expect(maxFreq.readValueQueued(batch)).toBe(2000000);
+
+        const results = batch.commit();
+        expect(results.length).toBe(1);
+        expect(results[0].errno).toBe(0);
+        expect(maxFreq.readValue()).toBe(2000000);
+        expect(batch.length).toBe(0);
+    });
+
+    it('should report failed writes per entry', () => {
+        const batch = new SysFsBatch();
+        batch.add('/sys/devices/system/cpu/cpu0/cpufreq/scaling_min_freq', '1000000');
+        batch.add('/sys/devices/system/cpu/cpu1/cpufreq/scaling_min_freq', '1000000');
+        const results = batch.commit();
+        expect(results[0].errno).toBe(0);
+        expect(results[1].errno).not.toBe(0);
+        expect(results[1].error).toBe('ENOENT');
+        expect(fs.readFileSync('/sys/devices/system/cpu/cpu0/cpufreq/scaling_min_freq').toString()).toBe('1000000');
+    });
+
+    it('should mark the first write after a barrier', () => {
+        let committed: ISysFsWrite[];
+        const batch = new SysFsBatch((writes, results) => {
+            committed = writes;
+            writes.forEach((write, i) => results[i] = 0);
+            return true;
+        });
+        batch.barrier();
+        batch.add('a', '1');
+        batch.add('b', '1');
+        batch.barrier();
+        batch.add('a', '2');
+        batch.commit();
+        expect(committed.map(write => write.barrier)).toEqual([ false, false, true ]);
+    });
+
+    it('should fall back to plain writes if the write function throws', () => {
+        const batch = new SysFsBatch(() => { throw Error('not available'); });
+        batch.add('/sys/devices/system/cpu/cpu0/cpufreq/scaling_max_freq', '3000000');
+        expect(batch.commit()[0].errno).toBe(0);
+        expect(fs.readFileSync('/sys/devices/system/cpu/cpu0/cpufreq/scaling_max_freq').toString()).toBe('3000000');
+    });
+});
@@ -0,0 +1,152 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import * as fs from 'fs';
+import * as os from 'os';
+
+export interface ISysFsWrite {
+    path: string;
+    value: string;
+    /**
+     * Start only after all previous writes of the batch completed
+     */
+    barrier?: boolean;
+}
+
+export interface ISysFsWriteResult {
+    path: string;
+    value: string;
+    /**
+     * 0 on success, errno otherwise
+     */
+    errno: number;
+    error?: string;
+}
+
+/**
+ * Applies the writes, fills results with 0 or errno per write
+ *
+ * @returns True if all writes succeeded
+ */
+export type SysFsBatchWriteFunction = (writes: ISysFsWrite[], results: number[]) => boolean;
+
+/**
+ * Collects sysfs writes to apply them at once
+ *
+ * Writes added between two barriers are independent of each other and may be
+ * applied concurrently by the write function (e.g. the native io_uring batch
+ * writer). Without a write function they are written one by one.
+ */
+export class SysFsBatch {
+
+    private writes: ISysFsWrite[] = [];
+    private barrierPending = false;
+
+    constructor(private writeFunction: SysFsBatchWriteFunction = SysFsBatch.writeSync) {}
+
+    public get length(): number {
+        return this.writes.length;
+    }
+
+    public add(path: string, value: string): void {
+        this.writes.push({ path, value, barrier: this.barrierPending });
+        this.barrierPending = false;
+    }
+
+    /**
+     * Following writes only start after all writes added so far completed
+     */
+    public barrier(): void {
+        if (this.writes.length > 0) {
+            this.barrierPending = true;
+        }
+    }
+
+    /**
+     * Last value queued for a path, undefined if none
+     */
+    public getQueued(path: string): string {
+        for (let i = this.writes.length - 1; i >= 0; --i) {
+            if (this.writes[i].path === path) {
+                return this.writes[i].value;
+            }
+        }
+        return undefined;
+    }
+
+    /**
+     * Apply all queued writes and empty the batch
+     *
+     * @returns Result for each write in the order they were added
+     */
+    public commit(): ISysFsWriteResult[] {
+        const writes = this.writes;
+        this.writes = [];
+        this.barrierPending = false;
+        if (writes.length === 0) {
+            return [];
+        }
+
+        const results: number[] = [];
+        try {
+            this.writeFunction(writes, results);
+        } catch (err) {
+            // Native writer not usable, fall back to plain writes
+            results.length = 0;
+            SysFsBatch.writeSync(writes, results);
+        }
+
+        return writes.map((write, i) => {
+            const errno = results[i] === undefined ? 0 : results[i];
+            const result: ISysFsWriteResult = { path: write.path, value: write.value, errno };
+            if (errno !== 0) {
+                result.error = SysFsBatch.errnoToString(errno);
+            }
+            return result;
+        });
+    }
+
+    public static writeSync(writes: ISysFsWrite[], results: number[]): boolean {
+        let success = true;
+        for (let i = 0; i < writes.length; ++i) {
+            try {
+                // Attributes can not be created, do not try to
+                if (!fs.existsSync(writes[i].path)) {
+                    results[i] = os.constants.errno.ENOENT;
+                    success = false;
+                    continue;
+                }
+                fs.writeFileSync(writes[i].path, writes[i].value, { flag: 'w' });
+                results[i] = 0;
+            } catch (err) {
+                results[i] = err.errno !== undefined ? Math.abs(err.errno) : os.constants.errno.EIO;
+                success = false;
+            }
+        }
+        return success;
+    }
+
+    private static errnoToString(errno: number): string {
+        for (const name of Object.keys(os.constants.errno)) {
+            if (os.constants.errno[name] === errno) {
+                return name;
+            }
+        }
+        return 'errno ' + errno;
+    }
+}
@@ -19,6 +19,7 @@
 import * as fs from 'fs';
 import { promises as fsp} from 'fs';
 import { ISysFsProperty } from '../models/IDeviceProperty';
+import { SysFsBatch } from './SysFsBatch';
 
 /**
  * Base (abstract) IO class for communicating with devices in /sys
@@ -125,6 +126,35 @@ export abstract class SysFsPropertyIO<T> implements ISysFsProperty {
         }
     }
 
+    /**
+     * Value last queued for this property in the batch, otherwise the value
+     * read from the device. Throws error if file operation fails.
+     *
+     * @param batch Batch to look into, reads directly if undefined
+     */
+    public readValueQueued(batch?: SysFsBatch): T {
+        const queuedValue = batch !== undefined ? batch.getQueued(this.writePath) : undefined;
+        if (queuedValue !== undefined) {
+            return this.convertStringToType(queuedValue);
+        }
+        return this.readValue();
+    }
+
+    /**
+     * Queues the write in the batch to be applied on commit. Without batch
+     * same as writeValue.
+     *
+     * @param value Value in the appropriate type to write
+     * @param batch Batch to queue the write in
+     */
+    public writeValueQueued(value: T, batch?: SysFsBatch) {
+        if (batch === undefined) {
+            this.writeValue(value);
+        } else {
+            batch.add(this.writePath, this.convertTypeToString(value));
+        }
+    }
+
     /**
      * Checks if read/write paths exist
      */
@@ -30,7 +30,8 @@ export class TccDBusController {
     private interface: dbus.ClientInterface;
 
     constructor() {
-        this.bus = dbus.systemBus();
+        // Unix fds to receive the telemetry page
+        this.bus = dbus.systemBus({ negotiateUnixFd: true });
     }
 
     async init(): Promise<boolean> {
@@ -176,6 +177,18 @@ export class TccDBusController {
         }
     }
 
+    /**
+     * @returns Read only descriptor of the telemetry page owned by the
+     *          caller, -1 if not available
+     */
+    async getTelemetryPageFd(): Promise<number> {
+        try {
+            return await this.interface.GetTelemetryPageFd();
+        } catch (err) {
+            return -1;
+        }
+    }
+
     async getPrimeState(): Promise<string> {
         try {
             return await this.interface.GetPrimeState();
@@ -30,4 +30,7 @@ export class TccPaths {
     static readonly AUTOSAVE_FILE: string = '/etc/tcc/autosave';
     static readonly FANTABLES_FILE: string = '/etc/tcc/fantables';
     static readonly TCCD_LOG_FILE: string = '/var/log/tccd/log';
+    static readonly CAPABILITIES_CACHE_FILE: string = '/var/cache/tccd/capabilities';
+    static readonly TUXEDO_IO_API_FILE: string =
+        '/opt/tuxedo-control-center/resources/dist/tuxedo-control-center/data/service/TuxedoIOAPI.node';
 }
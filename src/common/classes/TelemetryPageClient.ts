@@ -0,0 +1,88 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import { ITuxedoIOAPI, TelemetryPageData } from '../../native-lib/TuxedoIOAPI';
+import { TccDBusController } from './TccDBusController';
+
+/**
+ * Reads the telemetry page published by tccd. A read only descriptor of the
+ * page is received over DBus once, afterwards reads are plain memory reads.
+ *
+ * If the page is not available (older tccd, addon not found) read() returns
+ * undefined and callers stay with DBus polling. Opening is retried at a low
+ * rate, e.g. after a tccd restart.
+ */
+export class TelemetryPageClient {
+
+    private static readonly REOPEN_INTERVAL_MS = 10000;
+
+    private api: ITuxedoIOAPI;
+    private opened = false;
+    private lastOpenAttempt: number;
+
+    /**
+     * @param loadAPI Loads the native addon, the GUI renderer and the
+     *                electron main process require it differently
+     */
+    constructor(private dbus: TccDBusController, private loadAPI: () => ITuxedoIOAPI) {}
+
+    /**
+     * Latest snapshot or undefined if the page is not available
+     */
+    public async read(): Promise<TelemetryPageData> {
+        if (!this.opened && !(await this.open())) {
+            return undefined;
+        }
+        const data = this.api.telemetryPageRead();
+        if (data === undefined) {
+            // Page is gone, tccd stopped or recreated it
+            this.close();
+        }
+        return data;
+    }
+
+    public close(): void {
+        if (this.opened) {
+            this.api.telemetryPageClose();
+            this.opened = false;
+        }
+    }
+
+    private async open(): Promise<boolean> {
+        const now = Date.now();
+        if (this.lastOpenAttempt !== undefined && now - this.lastOpenAttempt < TelemetryPageClient.REOPEN_INTERVAL_MS) {
+            return false;
+        }
+        this.lastOpenAttempt = now;
+
+        try {
+            if (this.api === undefined) {
+                this.api = this.loadAPI();
+            }
+        } catch (err) {
+            return false;
+        }
+        const pageFd = await this.dbus.getTelemetryPageFd();
+        if (pageFd < 0) {
+            return false;
+        }
+        // Closes the descriptor whether mapped or not
+        this.opened = this.api.telemetryPageOpen(pageFd);
+        return this.opened;
+    }
+}
@@ -18,6 +18,7 @@
  */
 import { createBluetooth } from 'node-ble';
 import * as NodeBle from 'node-ble';
+import { ILCTTransport, LCTCommandPipeline } from './LCTCommandPipeline';
 
 function sleep(ms: number, arg = 'timeout') {
     return new Promise(resolve => setTimeout(resolve, ms, arg));
@@ -50,6 +51,28 @@ export class DeviceInfo {
     rssi: number;
 }
 
+/**
+ * Nordic UART service of a connected device as pipeline transport
+ */
+class GattUartTransport implements ILCTTransport {
+
+    constructor(private uartRx: NodeBle.GattCharacteristic, private writeBuffer: (buffer: Buffer) => Promise<void>) {}
+
+    async open(listener: (buffer: Buffer) => void) {
+        this.uartRx.on('valuechanged', listener);
+        await this.uartRx.startNotifications();
+    }
+
+    write(buffer: Buffer) {
+        return this.writeBuffer(buffer);
+    }
+
+    async close() {
+        this.uartRx.removeAllListeners('valuechanged');
+        await this.uartRx.stopNotifications();
+    }
+}
+
 /**
  * Encapsulates communication with the Bluetooth LE device.
  */
@@ -64,6 +87,8 @@ export class LCT21001 {
     private static readonly CMD_PUMP = 0x1c;
     private static readonly CMD_RGB = 0x1e;
 
+    private static readonly PIPELINE_WINDOW = 4;
+
     public static RGBState = RGBState;
     public static PumpVoltage = PumpVoltage;
 
@@ -72,6 +97,7 @@ export class LCT21001 {
     private uartRx: NodeBle.GattCharacteristic | undefined;
     private uartTx: NodeBle.GattCharacteristic | undefined;
     private destroy: (() => any) | undefined;
+    private pipeline: LCTCommandPipeline | undefined;
 
     private connectedModel: LCTDeviceModel | undefined;
 
@@ -122,6 +148,9 @@ export class LCT21001 {
         const uartService = await gattServer.getPrimaryService(LCT21001.NORDIC_UART_SERVICE_UUID);
         this.uartTx = await uartService.getCharacteristic(LCT21001.NORDIC_UART_CHAR_TX);
         this.uartRx = await uartService.getCharacteristic(LCT21001.NORDIC_UART_CHAR_RX);
+        await this.closePipeline();
+        this.pipeline = new LCTCommandPipeline(new GattUartTransport(this.uartRx, buffer => this.writeBuffer(buffer)),
+                                               LCT21001.PIPELINE_WINDOW);
 
         this.connectedModel = await this.deviceModelFromName(deviceName);
     }
@@ -134,12 +163,34 @@ export class LCT21001 {
             // Data written on disconnect by original control, seems to reset
             // or turn off configured parameters
             try { await this.writeReset(); } catch(err) {}
+            await this.closePipeline();
             try { await this.device.disconnect(); } catch (err) {}
             this.device = undefined;
             this.connectedModel = undefined;
         }
     }
 
+    private async closePipeline() {
+        if (this.pipeline !== undefined) {
+            await this.pipeline.close();
+            this.pipeline = undefined;
+        }
+    }
+
+    /**
+     * Queue command on the pipeline
+     *
+     * @param coalesceKey Commands setting the same state, a queued older one is replaced
+     *
+     * Note: Throws error if not connected
+     */
+    private async submit(buffer: Buffer, coalesceKey?: string, expectResponse = false): Promise<Buffer | undefined> {
+        if (this.pipeline === undefined) {
+            throw Error('submit(): not connected');
+        }
+        return await this.pipeline.submit(buffer, { coalesceKey, expectResponse });
+    }
+
     async startDiscover() {
         try {
             const { bluetooth, destroy } = createBluetooth();
@@ -270,25 +321,7 @@ export class LCT21001 {
      * Note: Throws error if not connected
      */
     async writeReceive(inputBuffer: Buffer): Promise<Buffer> {
-        return new Promise<Buffer>(async (resolve, reject) => {
-            if (this.uartRx !== undefined && await this.isConnected()) {
-                if (await this.uartRx.isNotifying()) {
-                    reject('rx already awaiting notify');
-                }
-                await this.uartRx.startNotifications();
-                this.uartRx.once('valuechanged', async outputBuffer => {
-                    await this.uartRx?.stopNotifications();
-                    resolve(outputBuffer);
-                });
-                this.writeBuffer(inputBuffer).catch(async () => {
-                    await this.uartRx?.stopNotifications();
-                    this.uartRx?.removeAllListeners();
-                    reject()
-                });
-            } else {
-                throw Error('writeReceive(): not connected');
-            }
-        });
+        return await this.submit(inputBuffer, undefined, true);
     }
 
     /**
@@ -306,12 +339,12 @@ export class LCT21001 {
         if (state < 0 || state > 0x03) throw Error('writeRGB(): param out of range');
 
         const data = Buffer.from([0xfe, LCT21001.CMD_RGB, 0x01, red, green, blue, state, 0xef]);
-        await this.writeBuffer(data);
+        await this.submit(data, 'rgb');
     }
 
     async writeRGBOff() {
         const data = Buffer.from([0xfe, LCT21001.CMD_RGB, 0x00, 0x00, 0x00, 0x00, 0x00, 0xef]);
-        await this.writeBuffer(data);
+        await this.submit(data, 'rgb');
     }
 
     /**
@@ -322,12 +355,12 @@ export class LCT21001 {
     async writeFanMode(dutyCyclePercent: number) {
         if (dutyCyclePercent < 0 || dutyCyclePercent > 0xff) throw Error('writeFanMode(): param out of range');
         const data = Buffer.from([0xfe, LCT21001.CMD_FAN, 0x01, dutyCyclePercent, 0x00, 0x00, 0x00, 0xef]);
-        await this.writeBuffer(data);
+        await this.submit(data, 'fan');
     }
 
     async writeFanOff() {
         const data = Buffer.from([0xfe, LCT21001.CMD_FAN, 0x00, 0x00, 0x00, 0x00, 0x00, 0xef]);
-        await this.writeBuffer(data);
+        await this.submit(data, 'fan');
     }
 
     /**
@@ -347,12 +380,12 @@ export class LCT21001 {
         if (pumpVoltage < 0 || pumpVoltage > 0x03) throw Error('writePumpMode(): param out of range');
 
         const data = Buffer.from([0xfe, LCT21001.CMD_PUMP, 0x01, pumpDutyCyclePercent, pumpVoltage, 0x00, 0x00, 0xef]);
-        await this.writeBuffer(data);
+        await this.submit(data, 'pump');
     }
 
     async writePumpOff() {
         const data = Buffer.from([0xfe, LCT21001.CMD_PUMP, 0x00, 0x00, 0x00, 0x00, 0x00, 0xef]);
-        await this.writeBuffer(data);
+        await this.submit(data, 'pump');
     }
 
     /**
@@ -368,6 +401,6 @@ export class LCT21001 {
      * Write (presumably) reset to device
      */
     async writeReset() {
-        await this.writeBuffer(Buffer.from([0xfe, LCT21001.CMD_RESET, 0x00, 0x01, 0x00, 0x00, 0x00, 0xef]));
+        await this.submit(Buffer.from([0xfe, LCT21001.CMD_RESET, 0x00, 0x01, 0x00, 0x00, 0x00, 0xef]));
     }
 }
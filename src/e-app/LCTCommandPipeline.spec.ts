@@ -0,0 +1,123 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import 'jasmine';
+import { ILCTTransport, LCTCommandPipeline } from './LCTCommandPipeline';
+
+/**
+ * Transport acknowledging writes only when the test says so
+ */
+class ManualTransport implements ILCTTransport {
+    public writes: string[] = [];
+    public notify: (buffer: Buffer) => void;
+    private acks: (() => void)[] = [];
+
+    public async open(listener: (buffer: Buffer) => void): Promise<void> {
+        this.notify = listener;
+    }
+
+    public write(buffer: Buffer): Promise<void> {
+        this.writes.push(buffer.toString());
+        return new Promise<void>(resolve => this.acks.push(resolve));
+    }
+
+    public async close(): Promise<void> {}
+
+    public ackAll(): void {
+        const acks = this.acks;
+        this.acks = [];
+        acks.forEach(ack => ack());
+    }
+}
+
+function settle(ms: number = 0): Promise<void> {
+    return new Promise(resolve => setTimeout(resolve, ms));
+}
+
+describe('LCTCommandPipeline', () => {
+
+    let transport: ManualTransport;
+
+    beforeEach(() => {
+        transport = new ManualTransport();
+    });
+
+    it('should let keyed commands overtake but not pass a barrier', async () => {
+        const pipeline = new LCTCommandPipeline(transport, 4);
+        pipeline.submit(Buffer.from('fan 20'), { coalesceKey: 'fan' });
+        await settle();
+        pipeline.submit(Buffer.from('fan 40'), { coalesceKey: 'fan' });
+        pipeline.submit(Buffer.from('led'), { coalesceKey: 'led' });
+        const version = pipeline.submit(Buffer.from('sw'), { expectResponse: true });
+        pipeline.submit(Buffer.from('pump'), { coalesceKey: 'pump' });
+        await settle();
+
+        // fan 40 waits for fan 20, led overtakes it, sw waits for both
+        expect(transport.writes).toEqual([ 'fan 20', 'led' ]);
+
+        transport.ackAll();
+        await settle();
+        expect(transport.writes).toEqual([ 'fan 20', 'led', 'fan 40', 'sw', 'pump' ]);
+
+        transport.notify(Buffer.from('V1.0.0'));
+        transport.ackAll();
+        expect((await version).toString()).toBe('V1.0.0');
+        await pipeline.close();
+    });
+
+    it('should coalesce queued commands with the same key', async () => {
+        const pipeline = new LCTCommandPipeline(transport, 4);
+        const results: string[] = [];
+        pipeline.submit(Buffer.from('fan 20'), { coalesceKey: 'fan' }).then(() => results.push('20'));
+        await settle();
+        pipeline.submit(Buffer.from('fan 40'), { coalesceKey: 'fan' }).then(() => results.push('40'));
+        pipeline.submit(Buffer.from('fan 60'), { coalesceKey: 'fan' }).then(() => results.push('60'));
+        await settle();
+        transport.ackAll();
+        await settle();
+        transport.ackAll();
+        await settle();
+
+        // fan 40 was replaced by fan 60 while queued, both callers are resolved by it
+        expect(transport.writes).toEqual([ 'fan 20', 'fan 60' ]);
+        expect(results).toEqual([ '20', '40', '60' ]);
+        expect(pipeline.getStatistics().coalesced).toBe(1);
+        expect(pipeline.getStatistics().completed).toBe(3);
+        await pipeline.close();
+    });
+
+    it('should drop responses arriving after the timeout', async () => {
+        const pipeline = new LCTCommandPipeline(transport, 1, 20);
+        let timeoutError: Error;
+        const first = pipeline.submit(Buffer.from('first'), { expectResponse: true }).catch(err => { timeoutError = err; });
+        await settle();
+        transport.ackAll();
+        await first;
+        expect(timeoutError.message).toContain('timeout');
+
+        const second = pipeline.submit(Buffer.from('second'), { expectResponse: true });
+        await settle();
+        transport.notify(Buffer.from('late answer to first'));
+        transport.notify(Buffer.from('answer to second'));
+        transport.ackAll();
+
+        expect((await second).toString()).toBe('answer to second');
+        expect(pipeline.getStatistics().lateResponses).toBe(1);
+        await pipeline.close();
+    });
+});
@@ -0,0 +1,309 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Byte link to the device, writes are delivered in the order they are issued
+ */
+export interface ILCTTransport {
+    /**
+     * Start delivering notifications (responses) of the device to the listener
+     */
+    open(listener: (buffer: Buffer) => void): Promise<void>;
+    /**
+     * Write buffer, resolves when the device acknowledged the write
+     */
+    write(buffer: Buffer): Promise<void>;
+    close(): Promise<void>;
+}
+
+export interface LCTCommandOptions {
+    /**
+     * Commands with the same key set the same device state. A queued, not yet
+     * sent command is replaced by a newer one with the same key.
+     */
+    coalesceKey?: string;
+    /**
+     * Command is answered by a notification, responses are matched in order
+     */
+    expectResponse?: boolean;
+}
+
+export class LCTPipelineStatistics {
+    submitted = 0;
+    sent = 0;
+    coalesced = 0;
+    completed = 0;
+    failed = 0;
+    // Responses arriving after their command timed out, dropped
+    lateResponses = 0;
+    maxInFlight = 0;
+}
+
+interface LCTCommandWaiter {
+    resolve: (response: Buffer | undefined) => void;
+    reject: (reason: any) => void;
+}
+
+interface LCTCommand {
+    tag: number;
+    buffer: Buffer;
+    coalesceKey: string | undefined;
+    expectResponse: boolean;
+    written: boolean;
+    response: Buffer | undefined;
+    responseTimeout: NodeJS.Timeout | undefined;
+    // Response timed out, the command keeps its place for the late response
+    timedOut: boolean;
+    waiters: LCTCommandWaiter[];
+}
+
+/**
+ * Command queue keeping up to `windowSize` commands in flight on the transport
+ *
+ * Keyed (coalescable) commands may overtake each other but never a command
+ * without key, which acts as barrier. Only one command per key is in flight,
+ * further commands with that key wait in the queue and are coalesced there.
+ */
+export class LCTCommandPipeline {
+
+    private queue: LCTCommand[] = [];
+    private inFlight: LCTCommand[] = [];
+    private awaitingResponse: LCTCommand[] = [];
+    private nextTag = 1;
+    private opened: Promise<void> | undefined;
+    private closed = false;
+    private statistics = new LCTPipelineStatistics();
+
+    constructor(private transport: ILCTTransport, private windowSize = 4, private responseTimeoutMs = 2000) {}
+
+    /**
+     * Queue command for sending
+     *
+     * @returns Promise resolving with the response (if expected) when the command
+     *          or the command superseding it completed
+     */
+    public submit(buffer: Buffer, options: LCTCommandOptions = {}): Promise<Buffer | undefined> {
+        if (this.closed) {
+            return Promise.reject(Error('LCTCommandPipeline: closed'));
+        }
+        if (this.opened === undefined) {
+            this.opened = this.transport.open(response => this.onResponse(response));
+        }
+        return new Promise<Buffer | undefined>((resolve, reject) => {
+            this.statistics.submitted += 1;
+            const queued = this.findCoalescable(options);
+            if (queued !== undefined) {
+                queued.buffer = buffer;
+                queued.waiters.push({ resolve, reject });
+                this.statistics.coalesced += 1;
+                return;
+            }
+            this.queue.push({
+                tag: this.nextTag++,
+                buffer: buffer,
+                coalesceKey: options.coalesceKey,
+                expectResponse: options.expectResponse === true,
+                written: false,
+                response: undefined,
+                responseTimeout: undefined,
+                timedOut: false,
+                waiters: [{ resolve, reject }]
+            });
+            this.opened.then(() => this.pump(), err => this.failAll(err));
+        });
+    }
+
+    /**
+     * Reject everything not completed and close the transport
+     */
+    public async close(): Promise<void> {
+        if (this.closed) {
+            return;
+        }
+        this.closed = true;
+        this.failAll(Error('LCTCommandPipeline: closed'));
+        if (this.opened !== undefined) {
+            try { await this.opened; await this.transport.close(); } catch (err) {}
+        }
+    }
+
+    public getStatistics(): LCTPipelineStatistics {
+        return Object.assign(new LCTPipelineStatistics(), this.statistics);
+    }
+
+    private findCoalescable(options: LCTCommandOptions): LCTCommand | undefined {
+        if (options.coalesceKey === undefined || options.expectResponse) {
+            return undefined;
+        }
+        for (let i = this.queue.length - 1; i >= 0; --i) {
+            if (this.queue[i].coalesceKey === undefined) {
+                // Do not move a state change across a barrier
+                return undefined;
+            }
+            if (this.queue[i].coalesceKey === options.coalesceKey) {
+                return this.queue[i];
+            }
+        }
+        return undefined;
+    }
+
+    private pump(): void {
+        let index = 0;
+        while (!this.closed && this.inFlight.length < this.windowSize && index < this.queue.length) {
+            const command = this.queue[index];
+            if (command.coalesceKey === undefined) {
+                if (index > 0) {
+                    break;
+                }
+            } else if (this.inFlight.some(other => other.coalesceKey === command.coalesceKey)) {
+                index += 1;
+                continue;
+            }
+            this.queue.splice(index, 1);
+            this.send(command);
+        }
+    }
+
+    private send(command: LCTCommand): void {
+        this.inFlight.push(command);
+        this.statistics.sent += 1;
+        this.statistics.maxInFlight = Math.max(this.statistics.maxInFlight, this.inFlight.length);
+        if (command.expectResponse) {
+            // Registered before writing, the notification can overtake the write acknowledge
+            this.awaitingResponse.push(command);
+            command.responseTimeout = setTimeout(() => this.onResponseTimeout(command), this.responseTimeoutMs);
+        }
+        this.transport.write(command.buffer).then(() => {
+            command.written = true;
+            if (!command.expectResponse || command.response !== undefined) {
+                this.complete(command);
+            }
+        }, err => {
+            this.removeFrom(this.awaitingResponse, command);
+            this.complete(command, err === undefined ? Error('LCTCommandPipeline: write failed') : err);
+        });
+    }
+
+    /**
+     * Responses carry no tag and are matched in order. A timed out command
+     * stays in line for another timeout period, so that its late response is
+     * dropped instead of being taken for the response of the next command.
+     */
+    private onResponseTimeout(command: LCTCommand): void {
+        command.timedOut = true;
+        this.complete(command, Error('LCTCommandPipeline: response timeout for command ' + command.tag));
+        command.responseTimeout = setTimeout(() => {
+            this.removeFrom(this.awaitingResponse, command);
+        }, this.responseTimeoutMs);
+    }
+
+    private onResponse(response: Buffer): void {
+        const command = this.awaitingResponse.shift();
+        if (command === undefined) {
+            return;
+        }
+        if (command.timedOut) {
+            clearTimeout(command.responseTimeout);
+            this.statistics.lateResponses += 1;
+            return;
+        }
+        command.response = response;
+        if (command.written) {
+            this.complete(command);
+        }
+    }
+
+    private complete(command: LCTCommand, error?: any): void {
+        if (!this.removeFrom(this.inFlight, command)) {
+            return;
+        }
+        if (command.responseTimeout !== undefined) {
+            clearTimeout(command.responseTimeout);
+        }
+        if (error === undefined) {
+            this.statistics.completed += command.waiters.length;
+            command.waiters.forEach(waiter => waiter.resolve(command.response));
+        } else {
+            this.statistics.failed += command.waiters.length;
+            command.waiters.forEach(waiter => waiter.reject(error));
+        }
+        this.pump();
+    }
+
+    private failAll(error: any): void {
+        const commands = this.inFlight.concat(this.queue);
+        for (const command of this.awaitingResponse.filter(waiting => waiting.timedOut)) {
+            clearTimeout(command.responseTimeout);
+        }
+        this.queue = [];
+        this.inFlight = [];
+        this.awaitingResponse = [];
+        for (const command of commands) {
+            if (command.responseTimeout !== undefined) {
+                clearTimeout(command.responseTimeout);
+            }
+            this.statistics.failed += command.waiters.length;
+            command.waiters.forEach(waiter => waiter.reject(error));
+        }
+    }
+
+    private removeFrom(list: LCTCommand[], command: LCTCommand): boolean {
+        const index = list.indexOf(command);
+        if (index === -1) {
+            return false;
+        }
+        list.splice(index, 1);
+        return true;
+    }
+}
+
+/**
+ * Transport answering like a LCT21001 after a configurable latency, for
+ * measurements without hardware. Writes are processed one after the other by
+ * the simulated device, acknowledges and responses arrive after `latencyMs`.
+ */
+export class LCTMockTransport implements ILCTTransport {
+
+    public writes: Buffer[] = [];
+    private listener: ((buffer: Buffer) => void) | undefined;
+    private deviceBusyUntil = 0;
+
+    constructor(public latencyMs = 30, public processingMs = 2, public firmwareVersion = 'V1.0.0') {}
+
+    public async open(listener: (buffer: Buffer) => void): Promise<void> {
+        this.listener = listener;
+    }
+
+    public write(buffer: Buffer): Promise<void> {
+        const now = Date.now();
+        this.deviceBusyUntil = Math.max(now + this.latencyMs / 2, this.deviceBusyUntil) + this.processingMs;
+        const ackDelay = this.deviceBusyUntil - now + this.latencyMs / 2;
+        return new Promise<void>(resolve => setTimeout(() => {
+            this.writes.push(buffer);
+            if (buffer.length === 2 && buffer[0] === 0x73 && buffer[1] === 0x77 && this.listener !== undefined) {
+                this.listener(Buffer.from(this.firmwareVersion));
+            }
+            resolve();
+        }, ackDelay));
+    }
+
+    public async close(): Promise<void> {
+        this.listener = undefined;
+    }
+}
@@ -0,0 +1,136 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Throughput of the LCT21001 command pipeline against the mock transport
+ *
+ * Replays what the aquaris dialog produces: a full state update (rgb, fan,
+ * pump) every `--update` ms and held slider/button repeats changing the fan
+ * target every `--repeat` ms. The serial mode reproduces the previous
+ * behaviour of one command on the link at a time without coalescing.
+ *
+ * Usage: npm run bench-lct-pipeline -- [--latency=30] [--window=4] [--duration=5000] [--json]
+ */
+import { LCTCommandPipeline, LCTMockTransport, LCTCommandOptions } from '../LCTCommandPipeline';
+import { percentile, parseArgs } from '../../service-app/benchmarks/BenchStats';
+
+// Command layout as written by LCT21001
+const CMD_FAN = 0x1b;
+const CMD_PUMP = 0x1c;
+const CMD_RGB = 0x1e;
+
+function command(cmd: number, a: number, b = 0, c = 0, d = 0): Buffer {
+    return Buffer.from([0xfe, cmd, 0x01, a, b, c, d, 0xef]);
+}
+
+interface RunResult {
+    mode: string;
+    submitted: number;
+    sentOnLink: number;
+    coalesced: number;
+    failed: number;
+    maxInFlight: number;
+    commandsPerSecond: number;
+    latencyP50Ms: number;
+    latencyP95Ms: number;
+    latencyP99Ms: number;
+    fwVersionMs: number;
+}
+
+async function run(mode: string, windowSize: number, coalesce: boolean, args: { [key: string]: string }): Promise<RunResult> {
+    const transport = new LCTMockTransport(Number(args.latency), Number(args.processing));
+    const pipeline = new LCTCommandPipeline(transport, windowSize);
+    const latencies: number[] = [];
+    const pending: Promise<any>[] = [];
+    const durationMs = Number(args.duration);
+
+    const submit = (buffer: Buffer, options: LCTCommandOptions) => {
+        const start = Date.now();
+        if (!coalesce) {
+            options = { expectResponse: options.expectResponse };
+        }
+        const promise = pipeline.submit(buffer, options).then(() => { latencies.push(Date.now() - start); });
+        pending.push(promise.catch(() => {}));
+        return promise;
+    };
+
+    let fanTarget = 30;
+    const repeatTimer = setInterval(() => {
+        fanTarget = fanTarget >= 100 ? 30 : fanTarget + 1;
+        submit(command(CMD_FAN, fanTarget), { coalesceKey: 'fan' });
+    }, Number(args.repeat));
+    const updateTimer = setInterval(() => {
+        submit(command(CMD_RGB, 0xff, 0x00, 0x00, 0x00), { coalesceKey: 'rgb' });
+        submit(command(CMD_FAN, fanTarget), { coalesceKey: 'fan' });
+        submit(command(CMD_PUMP, 60, 0x03), { coalesceKey: 'pump' });
+    }, Number(args.update));
+
+    const started = Date.now();
+    await new Promise(resolve => setTimeout(resolve, durationMs));
+    clearInterval(repeatTimer);
+    clearInterval(updateTimer);
+    // Read behind whatever is still queued, as when opening the dialog during a slider drag
+    const fwStart = Date.now();
+    await submit(Buffer.from([0x73, 0x77]), { expectResponse: true });
+    const fwVersionMs = Date.now() - fwStart;
+    await Promise.all(pending);
+    const elapsedMs = Date.now() - started;
+    await pipeline.close();
+
+    const statistics = pipeline.getStatistics();
+    return {
+        mode,
+        submitted: statistics.submitted,
+        sentOnLink: statistics.sent,
+        coalesced: statistics.coalesced,
+        failed: statistics.failed,
+        maxInFlight: statistics.maxInFlight,
+        commandsPerSecond: statistics.completed / elapsedMs * 1000,
+        latencyP50Ms: percentile(latencies, 50),
+        latencyP95Ms: percentile(latencies, 95),
+        latencyP99Ms: percentile(latencies, 99),
+        fwVersionMs
+    };
+}
+
+async function main() {
+    const args = parseArgs({ latency: '30', processing: '2', window: '4', duration: '5000', repeat: '20', update: '3000' });
+    const results = [
+        await run('serial', 1, false, args),
+        await run('pipelined', Number(args.window), true, args)
+    ];
+
+    if (args.json === 'true') {
+        console.log(JSON.stringify(results, null, 2));
+        return;
+    }
+    console.log(`LCT21001 pipeline, link latency ${args.latency} ms, fan repeat every ${args.repeat} ms, full update every ${args.update} ms`);
+    for (const result of results) {
+        console.log(`${result.mode.padEnd(10)} submitted ${result.submitted}, sent ${result.sentOnLink}, coalesced ${result.coalesced}, ` +
+                    `failed ${result.failed}, max in flight ${result.maxInFlight}`);
+        console.log(`${''.padEnd(10)} ${result.commandsPerSecond.toFixed(1)} commands/s, completion latency ` +
+                    `p50 ${result.latencyP50Ms} ms p95 ${result.latencyP95Ms} ms p99 ${result.latencyP99Ms} ms, ` +
+                    `firmware version read ${result.fwVersionMs} ms`);
+    }
+}
+
+main().catch(err => {
+    console.error(err);
+    process.exit(1);
+});
@@ -22,6 +22,8 @@ import * as child_process from 'child_process';
 import * as fs from 'fs';
 import * as os from 'os';
 import { TccDBusController } from '../common/classes/TccDBusController';
+import { TelemetryPageClient } from '../common/classes/TelemetryPageClient';
+import { TccPaths } from '../common/classes/TccPaths';
 import { TccProfile } from '../common/models/TccProfile';
 import { TccTray } from './TccTray';
 import { UserConfig } from './UserConfig';
@@ -57,6 +59,8 @@ let primeWindow: Electron.BrowserWindow;
 
 const tray: TccTray = new TccTray(path.join(__dirname, '../../data/dist-data/tuxedo-control-center_256.png'));
 let tccDBus: TccDBusController;
+let telemetryPage: TelemetryPageClient;
+let trayProfileGenerations: string;
 
 const watchOption = process.argv.includes('--watch');
 const trayOnlyOption = process.argv.includes('--tray');
@@ -123,6 +127,7 @@ app.whenReady().then( async () => {
         if (!success) { console.log('Failed to register global shortcut'); }
     }
     tccDBus = new TccDBusController();
+    telemetryPage = new TelemetryPageClient(tccDBus, () => require(TccPaths.TUXEDO_IO_API_FILE));
     startDbusAndInit();
 });
 
@@ -235,7 +240,11 @@ async function initMain() {
     });
 
     const profilesCheckInterval = 4000;
-    setInterval(async () => { updateTrayProfiles(tccDBus); }, profilesCheckInterval);
+    setInterval(async () => {
+        if (await trayProfilesChanged()) {
+            updateTrayProfiles(tccDBus);
+        }
+    }, profilesCheckInterval);
 }
 
 app.on('will-quit', async (event) => {
@@ -834,6 +843,23 @@ async function fnLockStatus(tccDBus: TccDBusController) {
     return await tccDBus.getFnLockStatus();
 }
 
+/**
+ * Checks the profile generation counters of the telemetry page
+ *
+ * @returns True if the profiles changed or it is not known
+ */
+async function trayProfilesChanged(): Promise<boolean> {
+    const telemetry = await telemetryPage.read();
+    if (telemetry === undefined) {
+        trayProfileGenerations = undefined;
+        return true;
+    }
+    const generations = telemetry.profileGeneration + '/' + telemetry.profilesGeneration;
+    const changed = generations !== trayProfileGenerations;
+    trayProfileGenerations = generations;
+    return changed;
+}
+
 async function updateTrayProfiles(dbus: TccDBusController) {
     try {
         const updatedActiveProfile = await getActiveProfile(dbus);
@@ -869,6 +895,8 @@ async function updateDeviceState(dev: LCT21001, current: AquarisState, next: Aqu
                 let updateLed = false;
                 let updateFan = false;
                 let updatePump = false;
+                // Sent pipelined, led, fan and pump do not wait for each other
+                const writes: Promise<void>[] = [];
 
                 updateLed = overrideCheck ||
                             current.red !== next.red || current.green !== next.green || current.blue !== next.blue ||
@@ -881,9 +909,9 @@ async function updateDeviceState(dev: LCT21001, current: AquarisState, next: Aqu
                     current.ledOn = next.ledOn;
                     if (next.deviceUUID !== 'demo') {
                         if (next.ledOn) {
-                            await dev.writeRGB(next.red, next.green, next.blue, next.ledMode);
+                            writes.push(dev.writeRGB(next.red, next.green, next.blue, next.ledMode));
                         } else {
-                            await dev.writeRGBOff();
+                            writes.push(dev.writeRGBOff());
                         }
                     }
                 }
@@ -895,9 +923,9 @@ async function updateDeviceState(dev: LCT21001, current: AquarisState, next: Aqu
                     current.fanOn = next.fanOn;
                     if (next.deviceUUID !== 'demo') {
                         if (next.fanOn) {
-                            await dev.writeFanMode(next.fanDutyCycle);
+                            writes.push(dev.writeFanMode(next.fanDutyCycle));
                         } else {
-                            await dev.writeFanOff();
+                            writes.push(dev.writeFanOff());
                         }
                     }
                 }
@@ -910,12 +938,13 @@ async function updateDeviceState(dev: LCT21001, current: AquarisState, next: Aqu
                     current.pumpOn = next.pumpOn;
                     if (next.deviceUUID !== 'demo') {
                         if (next.pumpOn) {
-                            await dev.writePumpMode(next.pumpDutyCycle, next.pumpVoltage);
+                            writes.push(dev.writePumpMode(next.pumpDutyCycle, next.pumpVoltage));
                         } else {
-                            await dev.writePumpOff();
+                            writes.push(dev.writePumpOff());
                         }
                     }
                 }
+                await Promise.all(writes);
                 overrideCheck = false;
                 updatedSomething = updateLed || updateFan || updatePump;
             } while (updatedSomething);
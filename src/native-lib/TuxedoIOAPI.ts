@@ -32,6 +32,12 @@ export interface ITuxedoIOAPI {
      */
     wmiAvailable(): boolean;
 
+    /**
+     * Probe all capabilities of the tuxedo-io interface at once
+     * @returns Descriptor, only partly filled if tuxedo-io is not available
+     */
+    probeCapabilities(): TuxedoIOCapabilities;
+
     /**
      * Enable/disable manual mode set (needed on some devices)
      * @returns True if call succeeded, false otherwise
@@ -75,6 +81,17 @@ export interface ITuxedoIOAPI {
      * @returns True if call succeeded, false otherwise
      */
     getFanTemperature(fanNumber: number, fanTemperatureCelcius: ObjWrapper<number>): boolean;
+    /**
+     * Read all fans and TDPs at once, with a single ioctl on modules
+     * supporting the batch read. Unavailable values are -1.
+     * @returns True if call succeeded, false otherwise
+     */
+    getDeviceTelemetry(telemetry: DeviceTelemetry): boolean;
+    /**
+     * Whether the module reads all fans and TDPs with a single ioctl. If not
+     * getDeviceTelemetry() is as costly as all single reads together.
+     */
+    getTelemetryBatchSupported(): boolean;
     /**
      * Set webcam switch
      * @returns True if call succeeded, false otherwise
@@ -90,6 +107,91 @@ export interface ITuxedoIOAPI {
      * @returns Array of output port names
      */
      getOutputPorts(): Array<Array<string>>;
+    /**
+     * Get the DRM connectors from sysfs including parsed EDID, cached until
+     * a drm uevent arrives
+     * @returns Catalog, generation increases when the content changed
+     */
+    getDrmCatalog(): DrmCatalog;
+    /**
+     * Get statistics of the process wide device access serialization,
+     * shared by all threads loading the module
+     * @returns Acquisitions, contention and calls from this environment
+     */
+    getDeviceArbiterStats(): DeviceArbiterStats;
+    /**
+     * Write a list of sysfs attributes with as few syscalls as possible (io_uring
+     * if available). Writes between two barriers may complete in any order.
+     * @param results Filled with 0 or the errno of each write
+     * @returns True if all writes succeeded, false otherwise
+     */
+    sysFsWriteBatch(writes: SysFsWrite[], results: number[]): boolean;
+
+    /**
+     * Start the shared scheduler timer (timerfd on the event loop), replaces
+     * a previously started one. Also sets the timer slack of the main thread.
+     * @param callback Called on the event loop when the armed deadline expired
+     * @param slackMs Allowed lateness the kernel may use to batch expiries
+     * @returns True if call succeeded, false otherwise
+     */
+    schedulerStart(callback: () => void, slackMs: number): boolean;
+    /**
+     * Arm the scheduler timer, replaces the previous deadline
+     * @param deadlineMs Absolute CLOCK_MONOTONIC time in milliseconds
+     * @returns True if call succeeded, false otherwise
+     */
+    schedulerArm(deadlineMs: number): boolean;
+    /**
+     * Stop the scheduler timer and release the callback
+     */
+    schedulerStop(): void;
+    /**
+     * @returns Wakeup statistics, undefined if not started
+     */
+    schedulerGetStats(): SchedulerTimerStats;
+
+    /**
+     * Start watching sysfs attributes for kernel side changes (sysfs_notify,
+     * epoll on the event loop), replaces a previously started watcher
+     * @param callback Called on the event loop with the attributes whose
+     *                 content changed
+     * @returns True if call succeeded, false otherwise
+     */
+    sysFsWatcherStart(callback: (changes: SysFsAttributeChange[]) => void): boolean;
+    /**
+     * Add an attribute to the started watcher, read once to arm it
+     * @returns Id of the attribute, -1 if it can not be watched (missing,
+     *          not on sysfs or watcher not started)
+     */
+    sysFsWatcherAdd(path: string): number;
+    /**
+     * @returns True if the attribute was watched, false otherwise
+     */
+    sysFsWatcherRemove(id: number): boolean;
+    /**
+     * Stop the watcher, closes all attributes and releases the callback
+     */
+    sysFsWatcherStop(): void;
+    /**
+     * @returns Notification statistics, undefined if not started
+     */
+    sysFsWatcherGetStats(): SysFsWatcherStats;
+
+    /**
+     * Set the state the cpu reconciler keeps the attributes at, next tick
+     * verifies all of them
+     */
+    cpuReconcilerSetDesired(attributes: CpuDesiredAttribute[]): void;
+    /**
+     * Verify global attributes and a rotating subset of cores, reapplies
+     * drifted attributes
+     * @returns Drifts found, empty if no desired state is set
+     */
+    cpuReconcilerTick(coresPerTick: number): CpuAttributeDrift[];
+    /**
+     * @returns Drift statistics, undefined if no desired state was set
+     */
+    cpuReconcilerGetStats(): CpuReconcilerStats;
     /**
      *  Get list of available ODM performance profiles
      *  @returns True if call succeeded, false otherwise
@@ -105,6 +207,104 @@ export interface ITuxedoIOAPI {
      *  @returns True if call succeeded, false otherwise
      */
     getDefaultODMPerformanceProfile(profileName: ObjWrapper<string>): boolean;
+    /**
+     * Start (or restart) native sampling and classification of system load
+     * @returns True if call succeeded, false otherwise
+     */
+    loadMonitorStart(config: LoadMonitorConfig): boolean;
+    /**
+     * Stop load sampling
+     */
+    loadMonitorStop(): void;
+    /**
+     * Get current load phase
+     * @returns State or undefined if not started or no complete sample yet
+     */
+    loadMonitorGetState(): LoadMonitorState;
+    /**
+     * Start (or restart) native sampling of the thermal_throttle counters and
+     * core frequencies, detecting throttle episodes
+     * @returns False if the cpu offers no throttle counters
+     */
+    throttleMonitorStart(config: ThrottleMonitorConfig): boolean;
+    /**
+     * Stop throttle sampling, statistics are discarded
+     */
+    throttleMonitorStop(): void;
+    /**
+     * Set the profile names recorded with following throttle episodes, kept
+     * across monitor restarts
+     */
+    throttleMonitorSetProfiles(tccProfile: string, odmProfile: string): void;
+    /**
+     * Get throttle episode statistics
+     * @returns Statistics or undefined if not started
+     */
+    throttleMonitorGetStats(): ThrottleMonitorStats;
+    /**
+     * Serve the registered gauges and the native I/O statistics in the
+     * OpenMetrics text format on a unix socket (mode 0660), replacing a
+     * running exporter. Scrapes are answered from a native thread and never
+     * read the hardware.
+     * @returns True if the socket is listening, false otherwise
+     */
+    metricsExporterStart(socketPath: string): boolean;
+    /**
+     * Stop serving and remove the socket
+     */
+    metricsExporterStop(): void;
+    /**
+     * Register a gauge, registering the same name and labels again returns
+     * the same slot. Registered gauges survive exporter restarts.
+     * @returns Slot for metricsSet, -1 if the name or a label name is invalid
+     */
+    metricsRegisterGauge(name: string, help: string, labels?: { [label: string]: string }): number;
+    /**
+     * Set the value of a gauge, undefined or NaN omits it from scrapes
+     */
+    metricsSet(slot: number, value: number): void;
+    /**
+     * Get scrape statistics
+     * @returns Statistics or undefined if not started
+     */
+    metricsExporterGetStats(): MetricsExporterStats;
+    /**
+     * Create the shared telemetry page as an anonymous memfd, replacing a
+     * previous one
+     * @returns True if created, false otherwise
+     */
+    telemetryPageCreate(): boolean;
+    /**
+     * Read only descriptor of the telemetry page to hand to clients over
+     * DBus, stays owned by the addon
+     * @returns Descriptor or -1 if the page is not created
+     */
+    telemetryPageGetClientFd(): number;
+    /**
+     * Remove the telemetry page, open readers notice on their next read
+     */
+    telemetryPageDestroy(): void;
+    /**
+     * Publish a snapshot to the telemetry page, updateTime is set natively
+     */
+    telemetryPagePublish(data: TelemetryPageData): void;
+    /**
+     * Map a telemetry page received from tccd for reading, takes ownership
+     * of the descriptor
+     * @returns True if mapped, false if not a sealed page or of an
+     *          incompatible version
+     */
+    telemetryPageOpen(fd: number): boolean;
+    /**
+     * Unmap the telemetry page
+     */
+    telemetryPageClose(): void;
+    /**
+     * Take a consistent snapshot of the mapped telemetry page without
+     * involving tccd
+     * @returns Snapshot or undefined if not open or the page is gone
+     */
+    telemetryPageRead(): TelemetryPageData;
     /**
      *  Get TDP info array of available configurable options
      *  @returns True if call succeeded, false otherwise
@@ -116,6 +316,69 @@ export interface ITuxedoIOAPI {
      *  @returns True if call succeeded, false otherwise
      */
     setTDPValues(tdpValues: Number[]): boolean;
+    /**
+     *  Run one step of the TDP autotuner, adjusting the TDP values towards the
+     *  temperature (and optional fan speed) ceiling of the config
+     *  @returns The decision taken or undefined if TDP control is not available
+     */
+    tdpAutotunerStep(config: TDPAutotunerConfig): TDPAutotunerDecision;
+    /**
+     *  Drop autotuner state and decision history
+     */
+    tdpAutotunerReset(): void;
+    /**
+     *  Get the most recent autotuner decisions, oldest first
+     */
+    tdpAutotunerGetDecisions(): TDPAutotunerDecision[];
+
+    /**
+     * Start (or restart) the per-key LED frame engine on the given led class
+     * device paths, one per key in key order
+     * @returns True if call succeeded, false if no key could be opened
+     */
+    ledEngineStart(ledPaths: string[], framesPerSecond: number): boolean;
+    /**
+     * Stop the LED frame engine and close all keys
+     */
+    ledEngineStop(): void;
+    /**
+     * Set base frame as flat array of red, green, blue values per key
+     * @param brightness Written to all keys with the frame, omit to keep it
+     * @returns True if call succeeded, false if engine not started
+     */
+    ledEngineSetFrame(colors: number[], brightness?: number): boolean;
+    /**
+     * Set animation applied to the base frame
+     * @returns True if call succeeded, false otherwise
+     */
+    ledEngineSetAnimation(animation: 'none' | 'breathe' | 'wave', periodMs: number): boolean;
+    /**
+     * Get write statistics of the LED frame engine
+     * @returns Statistics or undefined if engine not started
+     */
+    ledEngineGetStats(): LedEngineStats;
+
+    /**
+     * Check if the simulated EC is used instead of the tuxedo_io device,
+     * enabled by TUXEDO_IO_SIMULATION=<clevo|uniwill> when loading the module
+     * @returns True if simulation is active, false otherwise
+     */
+    simulationActive(): boolean;
+    /**
+     * Set the temperature reported for the specified fan by the simulated EC
+     * @returns True if call succeeded, false otherwise
+     */
+    simSetTemperature(fanNumber: number, temperatureCelcius: number): boolean;
+    /**
+     * Set latency added to every ioctl of the simulated EC
+     * @returns True if call succeeded, false otherwise
+     */
+    simSetIoctlLatency(latencyMicroseconds: number): boolean;
+    /**
+     * Get and clear the log of write ioctls received by the simulated EC
+     * @returns Write records in order of arrival
+     */
+    simTakeWriteLog(): SimWriteRecord[];
 }
 
 
@@ -132,6 +395,352 @@ export class TDPInfo {
     descriptor: string;
 }
 
+export class DeviceTelemetry {
+    fans: { speedPercent: number, temperature: number }[] = [];
+    tdps: { current: number, min: number, max: number }[] = [];
+    // Whether the module answered the batch read
+    batched = false;
+}
+
+export class LoadMonitorConfig {
+    /**
+     * Load in percent entering (and leaving minus hysteresis) the heavy phase
+     */
+    heavyThreshold?: number;
+    /**
+     * Mean load in percent of the busiest core entering (and leaving minus
+     * hysteresis) the heavy phase, catches single threaded workloads
+     */
+    coreHeavyThreshold?: number;
+    /**
+     * Load in percent of busiest core or gpu below which the machine is idle
+     */
+    idleThreshold?: number;
+    hysteresis?: number;
+    windowSamples?: number;
+    heavyDwellMs?: number;
+    burstyDwellMs?: number;
+    idleDwellMs?: number;
+    sampleIntervalMs?: number;
+    /**
+     * gpu_busy_percent attribute, optional
+     */
+    gpuBusyPath?: string;
+}
+
+export class LoadMonitorState {
+    phase: 'idle' | 'bursty' | 'heavy';
+    /**
+     * Classification of the current window, becomes the phase after the dwell time
+     */
+    candidate: 'idle' | 'bursty' | 'heavy';
+    phaseSinceMs: number;
+    switches: number;
+    meanLoad: number;
+    meanCoreLoad: number;
+    cpuBusy: number;
+    maxCoreBusy: number;
+    gpuBusy: number;
+}
+
+export class ThrottleMonitorConfig {
+    sampleIntervalMs?: number;
+    /**
+     * Samples without counter increase ending an episode
+     */
+    quietSamples?: number;
+}
+
+export class ThrottleEpisode {
+    /**
+     * Start as unix time in ms
+     */
+    startTime: number;
+    durationMs: number;
+    ongoing: boolean;
+    cores: number[];
+    coreEvents: number;
+    packageEvents: number;
+    /**
+     * Lowest scaling_cur_freq of an affected core in percent of its max, -1 if unknown
+     */
+    minFreqPercent: number;
+    /**
+     * Highest fan sensor temperature during the episode
+     */
+    maxTemperature: number;
+    /**
+     * Device state at the start of the episode
+     */
+    fanSpeedPercent: number[];
+    fanTemperature: number[];
+    tdpValues: number[];
+    tccProfile: string;
+    odmProfile: string;
+}
+
+export class ThrottleMonitorStats {
+    episodes: number;
+    episodesLastHour: number;
+    totalDurationMs: number;
+    longestDurationMs: number;
+    monitoredCores: number;
+    /**
+     * Last episodes, oldest first, including an ongoing one
+     */
+    recent: ThrottleEpisode[];
+}
+
+export class MetricsExporterStats {
+    scrapes: number;
+    lastRenderMs: number;
+}
+
+export class TelemetryPageFan {
+    /**
+     * Time of the last fan update in ms
+     */
+    timestamp: number;
+    temperature: number;
+    speed: number;
+}
+
+/**
+ * Telemetry page contents, unknown values are -1
+ */
+export class TelemetryPageData {
+    updateTime?: number;
+    updateCount: number;
+    /**
+     * Generation counters, incremented when the active profile, the profile
+     * list or the settings change
+     */
+    profileGeneration: number;
+    profilesGeneration: number;
+    settingsGeneration: number;
+    fans: TelemetryPageFan[];
+    cpuPower: number;
+    cpuPowerLimit: number;
+    iGpuPower: number;
+    iGpuTemperature: number;
+    dGpuPower: number;
+    activeProfileId: string;
+    odmProfile: string;
+    /**
+     * Incremented when rarely changing device state (capabilities, webcam,
+     * prime, keyboard backlight, ODM limits, display modes) changes
+     */
+    stateGeneration: number;
+    iGpuCoreFrequency: number;
+    iGpuMaxCoreFrequency: number;
+    iGpuVendor: string;
+    dGpuCoreFrequency: number;
+    dGpuMaxCoreFrequency: number;
+    dGpuMaxPowerLimit: number;
+    dGpuEnforcedPowerLimit: number;
+    /**
+     * 1 or 0, -1 if not reported
+     */
+    dGpuD0MetricsUsage: number;
+    sensorDataCollection: number;
+    /**
+     * Profile state of the power supply, e.g. 'power_ac'
+     */
+    powerState: string;
+}
+
+export class TDPAutotunerConfig {
+    targetTemperature: number;
+    /**
+     * Degrees below the target before limits are raised again, default 5
+     */
+    temperatureHysteresis?: number;
+    /**
+     * Fan speed ceiling in percent, 0 for none
+     */
+    maxFanSpeedPercent?: number;
+    /**
+     * Watts per increase, decreases take twice the step, default 2
+     */
+    stepWatts?: number;
+    minChangeIntervalMs?: number;
+}
+
+export class TDPAutotunerDecision {
+    timestampMs: number;
+    /**
+     * Undefined if package power is not available
+     */
+    packagePowerW: number;
+    temperature: number;
+    fanSpeedPercent: number;
+    action: 'hold' | 'decrease' | 'increase';
+    reason: string;
+    tdpValues: number[];
+}
+
+export class TuxedoIOCapabilities {
+    moduleVersion: string;
+    wmiAvailable: boolean;
+    activeInterface: string;
+    model: string;
+    nrFans: number;
+    fansMinSpeed: number;
+    fansOffAvailable: boolean;
+    webcamSwitchAvailable: boolean;
+    odmProfiles: string[];
+    odmDefaultProfile: string;
+    tdps: { descriptor: string, min: number, max: number }[];
+}
+
+export class LedEngineStats {
+    keys: number;
+    framesRendered: number;
+    keysWritten: number;
+    keysSkipped: number;
+    writeErrors: number;
+}
+
+export class DeviceArbiterStats {
+    acquisitions: number;
+    contended: number;
+    waitTimeMs: number;
+    /**
+     * Device calls made from the calling environment (thread)
+     */
+    environmentCalls: number;
+}
+
+export class EdidTiming {
+    width: number;
+    height: number;
+    refreshRate: number;
+    interlaced: boolean;
+    /**
+     * Preferred (native) mode of the display
+     */
+    preferred: boolean;
+}
+
+export class EdidInfo {
+    manufacturer: string;
+    productCode: number;
+    monitorName: string;
+    timings: EdidTiming[];
+}
+
+export class DrmConnector {
+    card: number;
+    /**
+     * Connector name without card prefix, e.g. "eDP-1"
+     */
+    name: string;
+    status: string;
+    enabled: boolean;
+    /**
+     * Mode names as listed by the kernel, e.g. "1920x1080"
+     */
+    modes: string[];
+    /**
+     * Undefined if no (valid) EDID is available
+     */
+    edid?: EdidInfo;
+}
+
+export class DrmCatalog {
+    generation: number;
+    scans: number;
+    connectors: DrmConnector[];
+}
+
+export class SysFsWrite {
+    path: string;
+    value: string;
+    /**
+     * Start only after all previous writes of the batch completed
+     */
+    barrier?: boolean;
+}
+
+export class SchedulerTimerStats {
+    wakeups: number;
+    wakeupsLastMinute: number;
+    maxLatenessMs: number;
+    meanLatenessMs: number;
+    timerSlackMs: number;
+}
+
+export class SysFsAttributeChange {
+    id: number;
+    path: string;
+    /**
+     * Content without trailing newline, empty if not readable
+     */
+    value: string;
+}
+
+export class SysFsWatcherStats {
+    attributes: number;
+    wakeups: number;
+    /**
+     * Notifications including those without a content change
+     */
+    notifications: number;
+    changes: number;
+}
+
+export class CpuDesiredAttribute {
+    /**
+     * Logical core, -1 for attributes not belonging to a core
+     */
+    core: number;
+    path: string;
+    value: string;
+}
+
+export class CpuAttributeDrift {
+    path: string;
+    expected: string;
+    /**
+     * Read value, empty if not readable
+     */
+    actual: string;
+    reapplied: boolean;
+    /**
+     * Errno of the reapply write, 0 on success
+     */
+    error: number;
+}
+
+export class CpuReconcilerStats {
+    cores: number;
+    ticks: number;
+    attributesChecked: number;
+    drifts: number;
+    reapplied: number;
+    reapplyErrors: number;
+    /**
+     * Attributes given up on since reapplying did not stick, counted once
+     * each and not verified anymore
+     */
+    unenforceable: number;
+    fullScans: number;
+    driftsByAttribute: { [attribute: string]: number };
+}
+
+export class SimWriteRecord {
+    /**
+     * CLOCK_MONOTONIC timestamp in ms, same time base as process.hrtime()
+     */
+    timestampMs: number;
+    request: number;
+    argument: number;
+    /**
+     * Speed of each fan after the write was applied
+     */
+    fanSpeedPercent: number[];
+}
+
 export class ObjWrapper<T> {
     value: T;
 }
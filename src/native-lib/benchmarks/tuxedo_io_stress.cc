@@ -0,0 +1,354 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Concurrency stress and throughput benchmark of the device layer
+ *
+ * Runs a mix of all TuxedoIOAPI operations from N threads against the
+ * simulated EC, every operation in its own DeviceSession like the addon does.
+ * Reports aggregate throughput and latency percentiles per thread count and
+ * verifies the fan speed writes seen by the EC against the order the writes
+ * were issued in:
+ *  - torn write: a write changed the speed of a fan it was not meant for
+ *    (e.g. the packed W_CL_FANSPEED argument built from stale speeds)
+ *  - lost update: the written speed of the target fan did not land, or the
+ *    number of EC writes does not match the successful calls
+ *
+ * Usage: npm run bench-io-stress -- [--platform=clevo|uniwill] [--threads=1,2,4,8]
+ *        [--duration=2000] [--latency=0] [--writes=30] [--json]
+ *
+ * --latency adds a per ioctl delay in µs to the simulated EC, --writes is the
+ * percentage of write operations in the mix. Exits with 1 if any write was torn
+ * or lost. Build with --tsan=1 (npm run bench-io-stress-tsan) to run under
+ * ThreadSanitizer.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include "tuxedo_io_sim.hh"
+#include "tuxedo_io_arbiter.hh"
+
+struct FanWrite {
+    uint64_t sequence;
+    int fanNr;
+    int speedPercent;
+};
+
+struct ThreadContext {
+    int index;
+    int nrFans;
+    std::mt19937 random;
+    std::vector<uint32_t> latenciesNs;
+    std::vector<FanWrite> fanWrites;
+    uint64_t failedOps;
+};
+
+// Order of the fan speed writes, only modified while the device session is held
+static uint64_t fanWriteSequence = 0;
+
+typedef bool (*Operation)(TuxedoIOAPI &io, ThreadContext &context);
+
+static bool OpFanWrite(TuxedoIOAPI &io, ThreadContext &context) {
+    // Threads keep to their own fan where possible, neighbouring fans are
+    // written concurrently which is what exposes read-modify-write races
+    int fanNr = context.index % context.nrFans;
+    int speedPercent = context.random() % 101;
+    if (!io.SetFanSpeedPercent(fanNr, speedPercent)) {
+        return false;
+    }
+    context.fanWrites.push_back(FanWrite { fanWriteSequence++, fanNr, speedPercent });
+    return true;
+}
+
+static const Operation writeOperations[] = {
+    OpFanWrite,
+    OpFanWrite,
+    OpFanWrite,
+    [](TuxedoIOAPI &io, ThreadContext &context) { return io.SetFansAuto(); },
+    [](TuxedoIOAPI &io, ThreadContext &context) { return io.SetEnableModeSet(context.random() % 2 == 0); },
+    [](TuxedoIOAPI &io, ThreadContext &context) { io.SetWebcam(context.random() % 2 == 0); return true; },
+    [](TuxedoIOAPI &io, ThreadContext &context) {
+        std::vector<std::string> profiles;
+        if (!io.GetAvailableODMPerformanceProfiles(profiles) || profiles.empty()) { return true; }
+        return io.SetODMPerformanceProfile(profiles[context.random() % profiles.size()]);
+    },
+    [](TuxedoIOAPI &io, ThreadContext &context) {
+        int nrTDPs = 0, min = 0, max = 0;
+        io.GetNumberTDPs(nrTDPs);
+        if (nrTDPs == 0) { return true; }
+        int tdpIndex = context.random() % nrTDPs;
+        if (!io.GetTDPMin(tdpIndex, min) || !io.GetTDPMax(tdpIndex, max) || max < min) { return false; }
+        return io.SetTDP(tdpIndex, min + context.random() % (max - min + 1));
+    }
+};
+
+static const Operation readOperations[] = {
+    [](TuxedoIOAPI &io, ThreadContext &context) { return io.WmiAvailable(); },
+    [](TuxedoIOAPI &io, ThreadContext &context) { std::string version; return io.GetModuleVersion(version); },
+    [](TuxedoIOAPI &io, ThreadContext &context) { bool identified; return io.Identify(identified) && identified; },
+    [](TuxedoIOAPI &io, ThreadContext &context) { std::string id; return io.DeviceInterfaceIdStr(id); },
+    [](TuxedoIOAPI &io, ThreadContext &context) { std::string id; io.DeviceModelIdStr(id); return true; },
+    [](TuxedoIOAPI &io, ThreadContext &context) { int nrFans; return io.GetNumberFans(nrFans); },
+    [](TuxedoIOAPI &io, ThreadContext &context) { int speed; return io.GetFanSpeedPercent(context.random() % context.nrFans, speed); },
+    [](TuxedoIOAPI &io, ThreadContext &context) { int temp; io.GetFanTemperature(context.random() % context.nrFans, temp); return true; },
+    [](TuxedoIOAPI &io, ThreadContext &context) { int minSpeed; return io.GetFansMinSpeed(minSpeed); },
+    [](TuxedoIOAPI &io, ThreadContext &context) { bool offAvailable; return io.GetFansOffAvailable(offAvailable); },
+    [](TuxedoIOAPI &io, ThreadContext &context) { bool status; io.GetWebcam(status); return true; },
+    [](TuxedoIOAPI &io, ThreadContext &context) { std::vector<std::string> profiles; io.GetAvailableODMPerformanceProfiles(profiles); return true; },
+    [](TuxedoIOAPI &io, ThreadContext &context) { std::string profile; io.GetDefaultODMPerformanceProfile(profile); return true; },
+    [](TuxedoIOAPI &io, ThreadContext &context) { std::vector<std::string> descriptors; io.GetTDPDescriptors(descriptors); return true; },
+    [](TuxedoIOAPI &io, ThreadContext &context) { int value; io.GetTDP(context.random() % 3, value); return true; }
+};
+
+struct RoundResult {
+    int threads;
+    uint64_t ops;
+    uint64_t failedOps;
+    double durationS;
+    double p50Us, p99Us, p999Us, maxUs;
+    double contendedPercent;
+    uint64_t fanWrites;
+    uint64_t tornWrites;
+    uint64_t lostUpdates;
+};
+
+static double PercentileUs(const std::vector<uint32_t> &sorted, double p) {
+    if (sorted.empty()) { return 0; }
+    std::size_t index = std::min(sorted.size() - 1, (std::size_t) std::max(0.0, std::ceil(p / 100.0 * sorted.size()) - 1));
+    return sorted[index] / 1e3;
+}
+
+static bool IsFanSpeedWrite(unsigned long request) {
+    return request == W_CL_FANSPEED || request == W_UW_FANSPEED || request == W_UW_FANSPEED2;
+}
+
+/**
+ * Replay the issued fan writes in session order against the EC write log
+ */
+static void VerifyFanWrites(SimulatedIO &sim, const std::vector<ThreadContext> &contexts,
+                            const int initialSpeeds[], int nrFans, RoundResult &result) {
+    std::vector<FanWrite> issued;
+    for (const ThreadContext &context : contexts) {
+        issued.insert(issued.end(), context.fanWrites.begin(), context.fanWrites.end());
+    }
+    std::sort(issued.begin(), issued.end(), [](const FanWrite &a, const FanWrite &b) { return a.sequence < b.sequence; });
+
+    std::vector<SimulatedIO::WriteRecord> records;
+    for (const SimulatedIO::WriteRecord &record : sim.TakeWriteLog()) {
+        if (IsFanSpeedWrite(record.request)) {
+            records.push_back(record);
+        }
+    }
+
+    result.fanWrites = issued.size();
+    result.tornWrites = 0;
+    result.lostUpdates = issued.size() > records.size() ? issued.size() - records.size() : 0;
+
+    int expected[SimulatedIO::NR_FANS];
+    std::copy(initialSpeeds, initialSpeeds + SimulatedIO::NR_FANS, expected);
+    for (std::size_t i = 0; i < std::min(issued.size(), records.size()); ++i) {
+        expected[issued[i].fanNr] = issued[i].speedPercent;
+        bool torn = false;
+        for (int fan = 0; fan < nrFans; ++fan) {
+            if (records[i].fanSpeedPercent[fan] == expected[fan]) {
+                continue;
+            }
+            if (fan == issued[i].fanNr) {
+                result.lostUpdates++;
+            } else {
+                torn = true;
+            }
+            // Continue from what the EC has to not count follow-up differences
+            expected[fan] = records[i].fanSpeedPercent[fan];
+        }
+        if (torn) {
+            result.tornWrites++;
+        }
+    }
+
+    for (int fan = 0; fan < nrFans; ++fan) {
+        if (sim.GetFanSpeedPercent(fan) != expected[fan]) {
+            result.lostUpdates++;
+        }
+    }
+}
+
+static RoundResult RunRound(SimulatedIO &sim, int nrThreads, int nrFans, int durationMs, int writePercent) {
+    std::vector<ThreadContext> contexts(nrThreads);
+    int initialSpeeds[SimulatedIO::NR_FANS];
+    for (int fan = 0; fan < SimulatedIO::NR_FANS; ++fan) {
+        initialSpeeds[fan] = sim.GetFanSpeedPercent(fan);
+    }
+    sim.TakeWriteLog();
+    DeviceArbiter::Statistics arbiterBefore = DeviceArbiter::Instance().GetStatistics();
+
+    std::atomic<bool> go { false };
+    std::atomic<bool> stop { false };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nrThreads; ++i) {
+        ThreadContext &context = contexts[i];
+        context.index = i;
+        context.nrFans = nrFans;
+        context.random.seed(i + 1);
+        context.failedOps = 0;
+        context.latenciesNs.reserve(1 << 16);
+        threads.push_back(std::thread([&context, &go, &stop, writePercent]() {
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            const std::size_t nrWriteOps = sizeof(writeOperations) / sizeof(writeOperations[0]);
+            const std::size_t nrReadOps = sizeof(readOperations) / sizeof(readOperations[0]);
+            while (!stop.load(std::memory_order_relaxed)) {
+                bool write = (int) (context.random() % 100) < writePercent;
+                Operation operation = write ? writeOperations[context.random() % nrWriteOps]
+                                            : readOperations[context.random() % nrReadOps];
+                auto start = std::chrono::steady_clock::now();
+                {
+                    DeviceSession session;
+                    if (!operation(session.API(), context)) {
+                        context.failedOps++;
+                    }
+                }
+                uint64_t latencyNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                context.latenciesNs.push_back((uint32_t) std::min<uint64_t>(latencyNs, UINT32_MAX));
+            }
+        }));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::milliseconds(durationMs));
+    stop.store(true);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    double durationS = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    RoundResult result = RoundResult();
+    result.threads = nrThreads;
+    result.durationS = durationS;
+    std::vector<uint32_t> latencies;
+    for (const ThreadContext &context : contexts) {
+        latencies.insert(latencies.end(), context.latenciesNs.begin(), context.latenciesNs.end());
+        result.failedOps += context.failedOps;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    result.ops = latencies.size();
+    result.p50Us = PercentileUs(latencies, 50);
+    result.p99Us = PercentileUs(latencies, 99);
+    result.p999Us = PercentileUs(latencies, 99.9);
+    result.maxUs = latencies.empty() ? 0 : latencies.back() / 1e3;
+
+    DeviceArbiter::Statistics arbiterAfter = DeviceArbiter::Instance().GetStatistics();
+    uint64_t acquisitions = arbiterAfter.acquisitions - arbiterBefore.acquisitions;
+    result.contendedPercent = acquisitions > 0 ? 100.0 * (arbiterAfter.contended - arbiterBefore.contended) / acquisitions : 0;
+
+    VerifyFanWrites(sim, contexts, initialSpeeds, nrFans, result);
+    return result;
+}
+
+static std::string GetArg(int argc, char *argv[], const std::string &name, const std::string &defaultValue) {
+    std::string prefix = "--" + name;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == prefix) {
+            return "true";
+        }
+        if (arg.compare(0, prefix.size() + 1, prefix + "=") == 0) {
+            return arg.substr(prefix.size() + 1);
+        }
+    }
+    return defaultValue;
+}
+
+int main(int argc, char *argv[]) {
+    SimulatedIO::Platform platform;
+    if (!SimulatedIO::PlatformFromString(GetArg(argc, argv, "platform", "clevo"), platform)) {
+        fprintf(stderr, "Unknown platform, use clevo or uniwill\n");
+        return 2;
+    }
+    int durationMs = atoi(GetArg(argc, argv, "duration", "2000").c_str());
+    int latencyUs = atoi(GetArg(argc, argv, "latency", "0").c_str());
+    int writePercent = atoi(GetArg(argc, argv, "writes", "30").c_str());
+    bool json = GetArg(argc, argv, "json", "false") == "true";
+    std::vector<int> threadCounts;
+    std::string threadsArg = GetArg(argc, argv, "threads", "1,2,4,8");
+    for (std::size_t position = 0; position < threadsArg.size();) {
+        std::size_t separator = threadsArg.find(',', position);
+        if (separator == std::string::npos) { separator = threadsArg.size(); }
+        int count = atoi(threadsArg.substr(position, separator - position).c_str());
+        if (count > 0) { threadCounts.push_back(count); }
+        position = separator + 1;
+    }
+
+    SimulatedIO sim(platform);
+    sim.SetIoctlLatency(std::chrono::microseconds(latencyUs));
+    TuxedoIOAPI::DeviceOverride() = &sim;
+    int nrFans = 0;
+    {
+        DeviceSession session;
+        session.API().GetNumberFans(nrFans);
+    }
+
+    std::vector<RoundResult> results;
+    for (int nrThreads : threadCounts) {
+        results.push_back(RunRound(sim, nrThreads, nrFans, durationMs, writePercent));
+    }
+    TuxedoIOAPI::DeviceOverride() = nullptr;
+
+    bool failed = false;
+    if (json) {
+        printf("[\n");
+    } else {
+        printf("platform %s, %d ms per round, %d %% writes, ioctl latency %d us\n",
+               platform == SimulatedIO::Platform::Clevo ? "clevo" : "uniwill", durationMs, writePercent, latencyUs);
+        printf("%8s %12s %10s %10s %10s %10s %11s %10s %6s %6s\n",
+               "threads", "ops/s", "p50 us", "p99 us", "p99.9 us", "max us", "contended", "fan wr", "torn", "lost");
+    }
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const RoundResult &r = results[i];
+        failed = failed || r.tornWrites > 0 || r.lostUpdates > 0;
+        if (json) {
+            printf("  { \"threads\": %d, \"ops\": %llu, \"failedOps\": %llu, \"opsPerSecond\": %.1f, "
+                   "\"latencyUs\": { \"p50\": %.2f, \"p99\": %.2f, \"p999\": %.2f, \"max\": %.2f }, "
+                   "\"contendedPercent\": %.2f, \"fanWrites\": %llu, \"tornWrites\": %llu, \"lostUpdates\": %llu }%s\n",
+                   r.threads, (unsigned long long) r.ops, (unsigned long long) r.failedOps, r.ops / r.durationS,
+                   r.p50Us, r.p99Us, r.p999Us, r.maxUs, r.contendedPercent, (unsigned long long) r.fanWrites,
+                   (unsigned long long) r.tornWrites, (unsigned long long) r.lostUpdates, i + 1 < results.size() ? "," : "");
+        } else {
+            printf("%8d %12.0f %10.2f %10.2f %10.2f %10.2f %10.1f%% %10llu %6llu %6llu\n",
+                   r.threads, r.ops / r.durationS, r.p50Us, r.p99Us, r.p999Us, r.maxUs, r.contendedPercent,
+                   (unsigned long long) r.fanWrites, (unsigned long long) r.tornWrites, (unsigned long long) r.lostUpdates);
+        }
+    }
+    if (json) {
+        printf("]\n");
+    }
+    return failed ? 1 : 0;
+}
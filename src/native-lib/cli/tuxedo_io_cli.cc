@@ -0,0 +1,438 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * tuxedo-io: command line access to the tuxedo_io device
+ *
+ * Uses the same device layer (tuxedo_io library target) as the node addon,
+ * for scripts and monitoring agents that should neither start node nor
+ * depend on tccd. Honors TUXEDO_IO_SIMULATION like the addon.
+ *
+ * Exit status: 0 success, 1 device or operation failed, 2 usage error
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
+#include <string>
+#include <vector>
+#include "tuxedo_io_runtime.hh"
+
+static const char *USAGE =
+    "Usage: tuxedo-io [--format=text|json|csv] <command>\n"
+    "\n"
+    "Commands:\n"
+    "  info                      interface, model, module version and capabilities\n"
+    "  fans                      temperature and speed of every fan\n"
+    "  tdp                       TDP values with limits\n"
+    "  profiles                  available and default ODM performance profiles\n"
+    "  webcam                    webcam switch state\n"
+    "  set fan <nr> <percent>    set a fan speed (fan control of tccd will override it)\n"
+    "  set fans-auto             return fan control to the EC\n"
+    "  set tdp <index> <value>   set a TDP value\n"
+    "  set profile <name>        set the ODM performance profile\n"
+    "  set webcam <on|off>       switch the webcam\n"
+    "  watch [--interval=1000] [--count=0]\n"
+    "                            stream fan and TDP samples (default format csv),\n"
+    "                            interval in ms, count 0 runs until interrupted\n";
+
+enum class Format { Text, Json, Csv };
+
+struct Options {
+    Format format;
+    bool formatGiven;
+    int intervalMs;
+    int count;
+    std::vector<std::string> arguments;
+};
+
+struct Sample {
+    double timestampMs;
+    std::vector<int> fanTemperature;
+    std::vector<int> fanSpeedPercent;
+    std::vector<int> tdp;
+};
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void OnStopSignal(int) {
+    stopRequested = 1;
+}
+
+static std::string JsonString(const std::string &value) {
+    std::string result = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if ((unsigned char) c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            result += escaped;
+        } else {
+            result += c;
+        }
+    }
+    return result + "\"";
+}
+
+static std::string JsonStringArray(const std::vector<std::string> &values) {
+    std::string result = "[";
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        result += (i > 0 ? ", " : "") + JsonString(values[i]);
+    }
+    return result + "]";
+}
+
+static std::string JsonIntArray(const std::vector<int> &values) {
+    std::string result = "[";
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        result += (i > 0 ? ", " : "") + std::to_string(values[i]);
+    }
+    return result + "]";
+}
+
+static bool ParseInt(const std::string &text, int &value) {
+    char *end = nullptr;
+    errno = 0;
+    long parsed = strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || errno != 0 || parsed < INT32_MIN || parsed > INT32_MAX) {
+        return false;
+    }
+    value = (int) parsed;
+    return true;
+}
+
+static bool ParseOptions(int argc, char *argv[], Options &options) {
+    options.format = Format::Text;
+    options.formatGiven = false;
+    options.intervalMs = 1000;
+    options.count = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0) {
+            options.arguments.push_back(arg);
+            continue;
+        }
+        std::size_t separator = arg.find('=');
+        std::string name = arg.substr(2, separator == std::string::npos ? std::string::npos : separator - 2);
+        std::string value = separator == std::string::npos ? "" : arg.substr(separator + 1);
+        if (name == "format") {
+            options.formatGiven = true;
+            if (value == "text") { options.format = Format::Text; }
+            else if (value == "json") { options.format = Format::Json; }
+            else if (value == "csv") { options.format = Format::Csv; }
+            else { return false; }
+        } else if (name == "interval") {
+            if (!ParseInt(value, options.intervalMs) || options.intervalMs < 10) { return false; }
+        } else if (name == "count") {
+            if (!ParseInt(value, options.count) || options.count < 0) { return false; }
+        } else {
+            return false;
+        }
+    }
+    return !options.arguments.empty();
+}
+
+static double RealtimeMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static int GetNumberFans(TuxedoIOAPI &io) {
+    int nrFans = 0;
+    return io.GetNumberFans(nrFans) ? nrFans : 0;
+}
+
+static int GetNumberTDPs(TuxedoIOAPI &io) {
+    int nrTDPs = 0;
+    return io.GetNumberTDPs(nrTDPs) ? nrTDPs : 0;
+}
+
+static void ReadSample(TuxedoIOAPI &io, int nrFans, int nrTDPs, Sample &sample) {
+    sample.timestampMs = RealtimeMs();
+    sample.fanTemperature.assign(nrFans, -1);
+    sample.fanSpeedPercent.assign(nrFans, -1);
+    sample.tdp.assign(nrTDPs, -1);
+    DeviceTelemetry telemetry;
+    if (!io.ReadTelemetry(telemetry)) {
+        return;
+    }
+    for (int fan = 0; fan < nrFans && fan < telemetry.nrFans; ++fan) {
+        sample.fanTemperature[fan] = telemetry.fanTemperature[fan];
+        sample.fanSpeedPercent[fan] = telemetry.fanSpeedPercent[fan];
+    }
+    for (int tdp = 0; tdp < nrTDPs && tdp < telemetry.nrTDPs; ++tdp) {
+        sample.tdp[tdp] = telemetry.tdp[tdp];
+    }
+}
+
+static int CommandInfo(TuxedoIOAPI &io, Format format) {
+    std::string interfaceId, modelId, moduleVersion, apiMinVersion;
+    io.DeviceInterfaceIdStr(interfaceId);
+    io.DeviceModelIdStr(modelId);
+    io.GetModuleVersion(moduleVersion);
+    io.GetModuleAPIMinVersion(apiMinVersion);
+    int nrFans = GetNumberFans(io);
+    int nrTDPs = GetNumberTDPs(io);
+    int fansMinSpeed = 0;
+    io.GetFansMinSpeed(fansMinSpeed);
+    bool fansOffAvailable = false;
+    io.GetFansOffAvailable(fansOffAvailable);
+    std::vector<std::string> tdpDescriptors;
+    io.GetTDPDescriptors(tdpDescriptors);
+
+    if (format == Format::Json) {
+        printf("{ \"interface\": %s, \"model\": %s, \"moduleVersion\": %s, \"moduleAPIMinVersion\": %s, "
+               "\"simulated\": %s, \"fans\": %d, \"fansMinSpeed\": %d, \"fansOffAvailable\": %s, \"tdps\": %s }\n",
+               JsonString(interfaceId).c_str(), JsonString(modelId).c_str(), JsonString(moduleVersion).c_str(),
+               JsonString(apiMinVersion).c_str(), TuxedoIOSimulation() != nullptr ? "true" : "false", nrFans,
+               fansMinSpeed, fansOffAvailable ? "true" : "false", JsonStringArray(tdpDescriptors).c_str());
+    } else if (format == Format::Csv) {
+        printf("interface,model,moduleVersion,fans,fansMinSpeed,fansOffAvailable,tdps\n");
+        printf("%s,%s,%s,%d,%d,%d,%d\n", interfaceId.c_str(), modelId.c_str(), moduleVersion.c_str(),
+               nrFans, fansMinSpeed, fansOffAvailable ? 1 : 0, nrTDPs);
+    } else {
+        printf("interface:        %s%s\n", interfaceId.c_str(), TuxedoIOSimulation() != nullptr ? " (simulated)" : "");
+        printf("model:            %s\n", modelId.c_str());
+        printf("module version:   %s (min %s)\n", moduleVersion.c_str(), apiMinVersion.c_str());
+        printf("fans:             %d (min speed %d %%, off %savailable)\n", nrFans, fansMinSpeed, fansOffAvailable ? "" : "not ");
+        printf("tdps:             %d\n", nrTDPs);
+        for (int i = 0; i < nrTDPs && i < (int) tdpDescriptors.size(); ++i) {
+            printf("  %d: %s\n", i, tdpDescriptors[i].c_str());
+        }
+    }
+    return 0;
+}
+
+static int CommandFans(TuxedoIOAPI &io, Format format) {
+    int nrFans = GetNumberFans(io);
+    Sample sample;
+    ReadSample(io, nrFans, 0, sample);
+    if (format == Format::Json) {
+        printf("[");
+        for (int fan = 0; fan < nrFans; ++fan) {
+            printf("%s{ \"fan\": %d, \"temperature\": %d, \"speedPercent\": %d }", fan > 0 ? ", " : "",
+                   fan, sample.fanTemperature[fan], sample.fanSpeedPercent[fan]);
+        }
+        printf("]\n");
+    } else {
+        printf(format == Format::Csv ? "fan,temperature,speedPercent\n" : "fan  temperature  speed\n");
+        for (int fan = 0; fan < nrFans; ++fan) {
+            printf(format == Format::Csv ? "%d,%d,%d\n" : "%3d  %8d °C  %3d %%\n",
+                   fan, sample.fanTemperature[fan], sample.fanSpeedPercent[fan]);
+        }
+    }
+    return 0;
+}
+
+static int CommandTDP(TuxedoIOAPI &io, Format format) {
+    DeviceTelemetry telemetry;
+    io.ReadTelemetry(telemetry);
+    int nrTDPs = telemetry.nrTDPs;
+    std::vector<std::string> descriptors;
+    io.GetTDPDescriptors(descriptors);
+    descriptors.resize(nrTDPs);
+    if (format == Format::Json) {
+        printf("[");
+    } else {
+        printf(format == Format::Csv ? "index,descriptor,value,min,max\n" : "index  value    min    max  descriptor\n");
+    }
+    for (int i = 0; i < nrTDPs; ++i) {
+        int value = telemetry.tdp[i], minValue = telemetry.tdpMin[i], maxValue = telemetry.tdpMax[i];
+        if (format == Format::Json) {
+            printf("%s{ \"index\": %d, \"descriptor\": %s, \"value\": %d, \"min\": %d, \"max\": %d }", i > 0 ? ", " : "",
+                   i, JsonString(descriptors[i]).c_str(), value, minValue, maxValue);
+        } else if (format == Format::Csv) {
+            printf("%d,%s,%d,%d,%d\n", i, descriptors[i].c_str(), value, minValue, maxValue);
+        } else {
+            printf("%5d  %5d  %5d  %5d  %s\n", i, value, minValue, maxValue, descriptors[i].c_str());
+        }
+    }
+    if (format == Format::Json) {
+        printf("]\n");
+    }
+    return 0;
+}
+
+static int CommandProfiles(TuxedoIOAPI &io, Format format) {
+    std::vector<std::string> profiles;
+    std::string defaultProfile;
+    if (!io.GetAvailableODMPerformanceProfiles(profiles)) {
+        fprintf(stderr, "ODM performance profiles not supported\n");
+        return 1;
+    }
+    io.GetDefaultODMPerformanceProfile(defaultProfile);
+    if (format == Format::Json) {
+        printf("{ \"available\": %s, \"default\": %s }\n", JsonStringArray(profiles).c_str(), JsonString(defaultProfile).c_str());
+    } else {
+        if (format == Format::Csv) {
+            printf("profile,default\n");
+        }
+        for (const std::string &profile : profiles) {
+            if (format == Format::Csv) {
+                printf("%s,%d\n", profile.c_str(), profile == defaultProfile ? 1 : 0);
+            } else {
+                printf("%s%s\n", profile.c_str(), profile == defaultProfile ? " (default)" : "");
+            }
+        }
+    }
+    return 0;
+}
+
+static int CommandWebcam(TuxedoIOAPI &io, Format format) {
+    bool status = false;
+    if (!io.GetWebcam(status)) {
+        fprintf(stderr, "Reading the webcam state failed\n");
+        return 1;
+    }
+    if (format == Format::Json) {
+        printf("{ \"webcam\": %s }\n", status ? "true" : "false");
+    } else {
+        printf("%s\n", status ? "on" : "off");
+    }
+    return 0;
+}
+
+static int CommandSet(TuxedoIOAPI &io, const std::vector<std::string> &arguments) {
+    const std::string what = arguments.size() > 1 ? arguments[1] : "";
+    int first = 0, second = 0;
+    bool result;
+    if (what == "fan" && arguments.size() == 4 && ParseInt(arguments[2], first) && ParseInt(arguments[3], second)
+        && second >= 0 && second <= 100) {
+        result = io.SetEnableModeSet(true) && io.SetFanSpeedPercent(first, second);
+    } else if (what == "fans-auto" && arguments.size() == 2) {
+        result = io.SetFansAuto();
+    } else if (what == "tdp" && arguments.size() == 4 && ParseInt(arguments[2], first) && ParseInt(arguments[3], second)) {
+        result = io.SetTDP(first, second);
+    } else if (what == "profile" && arguments.size() == 3) {
+        result = io.SetODMPerformanceProfile(arguments[2]);
+    } else if (what == "webcam" && arguments.size() == 3 && (arguments[2] == "on" || arguments[2] == "off")) {
+        result = io.SetWebcam(arguments[2] == "on");
+    } else {
+        fputs(USAGE, stderr);
+        return 2;
+    }
+    if (!result) {
+        fprintf(stderr, "Setting %s failed\n", what.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+static void PrintSample(const Sample &sample, Format format) {
+    if (format == Format::Json) {
+        // One object per line (JSON lines) so consumers can parse while streaming
+        printf("{ \"timestampMs\": %.0f, \"fanTemperature\": %s, \"fanSpeedPercent\": %s, \"tdp\": %s }\n",
+               sample.timestampMs, JsonIntArray(sample.fanTemperature).c_str(),
+               JsonIntArray(sample.fanSpeedPercent).c_str(), JsonIntArray(sample.tdp).c_str());
+        return;
+    }
+    const char *separator = format == Format::Csv ? "," : " ";
+    printf("%.0f", sample.timestampMs);
+    for (std::size_t fan = 0; fan < sample.fanTemperature.size(); ++fan) {
+        printf("%s%d%s%d", separator, sample.fanTemperature[fan], separator, sample.fanSpeedPercent[fan]);
+    }
+    for (std::size_t tdp = 0; tdp < sample.tdp.size(); ++tdp) {
+        printf("%s%d", separator, sample.tdp[tdp]);
+    }
+    printf("\n");
+}
+
+static int CommandWatch(TuxedoIOAPI &io, const Options &options) {
+    Format format = options.formatGiven ? options.format : Format::Csv;
+    int nrFans = GetNumberFans(io);
+    int nrTDPs = GetNumberTDPs(io);
+    if (format != Format::Json) {
+        const char *separator = format == Format::Csv ? "," : " ";
+        printf("timestampMs");
+        for (int fan = 0; fan < nrFans; ++fan) {
+            printf("%sfan%dTemperature%sfan%dSpeedPercent", separator, fan, separator, fan);
+        }
+        for (int tdp = 0; tdp < nrTDPs; ++tdp) {
+            printf("%stdp%d", separator, tdp);
+        }
+        printf("\n");
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = OnStopSignal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    // Absolute deadlines keep the sampling period free of drift
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    Sample sample;
+    for (int samples = 0; !stopRequested && (options.count == 0 || samples < options.count); ++samples) {
+        if (samples > 0) {
+            deadline.tv_nsec += (long) options.intervalMs % 1000 * 1000000L;
+            deadline.tv_sec += options.intervalMs / 1000 + deadline.tv_nsec / 1000000000L;
+            deadline.tv_nsec %= 1000000000L;
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+                if (stopRequested) {
+                    return 0;
+                }
+            }
+        }
+        ReadSample(io, nrFans, nrTDPs, sample);
+        PrintSample(sample, format);
+        fflush(stdout);
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        fputs(USAGE, stderr);
+        return 2;
+    }
+    const std::string &command = options.arguments[0];
+    const std::vector<std::string> commands = { "info", "fans", "tdp", "profiles", "webcam", "set", "watch" };
+    bool knownCommand = false;
+    for (const std::string &name : commands) {
+        knownCommand = knownCommand || command == name;
+    }
+    if (!knownCommand || (command != "set" && options.arguments.size() != 1)) {
+        fputs(USAGE, stderr);
+        return 2;
+    }
+
+    TuxedoIOInitRuntime();
+    DeviceSession session;
+    TuxedoIOAPI &io = session.API();
+    std::string interfaceId;
+    if (!io.WmiAvailable() || !io.DeviceInterfaceIdStr(interfaceId)) {
+        fprintf(stderr, "No tuxedo_io interface found (module not loaded or device not supported)\n");
+        return 1;
+    }
+
+    if (command == "info") { return CommandInfo(io, options.format); }
+    if (command == "fans") { return CommandFans(io, options.format); }
+    if (command == "tdp") { return CommandTDP(io, options.format); }
+    if (command == "profiles") { return CommandProfiles(io, options.format); }
+    if (command == "webcam") { return CommandWebcam(io, options.format); }
+    if (command == "set") { return CommandSet(io, options.arguments); }
+    return CommandWatch(io, options);
+}
@@ -0,0 +1,205 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * EdidParser and DrmConnectorCatalog against a fake drm tree in a temporary
+ * directory, laid out like the trees TUXEDO_IO_DRM_SYSFS points the addon to
+ *
+ * Usage: npm run test-native-lib
+ *
+ * Exits with 1 if any check failed.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include "drm_connector_catalog.hh"
+
+static int failedChecks = 0;
+
+#define CHECK(condition) \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        ++failedChecks; \
+    }
+
+static void WriteFile(const std::string &path, const std::string &content) {
+    std::ofstream file(path, std::ios::binary);
+    file << content;
+}
+
+/**
+ * Base block of a "BOE" panel with a 1920x1080 60 Hz preferred mode and a
+ * monitor name descriptor
+ */
+static std::vector<uint8_t> CreateEdid() {
+    std::vector<uint8_t> edid(128, 0);
+    const uint8_t header[] = { 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00 };
+    memcpy(&edid[0], header, sizeof(header));
+    // B O E packed in 5 bit letters
+    edid[8] = 0x09;
+    edid[9] = 0xe5;
+    edid[10] = 0x47;
+    edid[11] = 0x07;
+    edid[18] = 1;
+    edid[19] = 4;
+    // Unused standard timings
+    for (int offset = 38; offset < 54; ++offset) {
+        edid[offset] = 0x01;
+    }
+    // 148.5 MHz, 1920 + 280 x 1080 + 45
+    const uint8_t preferred[] = { 0x02, 0x3a, 0x80, 0x18, 0x71, 0x38, 0x2d, 0x40 };
+    memcpy(&edid[54], preferred, sizeof(preferred));
+    const uint8_t name[] = { 0x00, 0x00, 0x00, 0xfc, 0x00, 'T', 'E', 'S', 'T', ' ', 'P', 'A', 'N', 'E', 'L', '\n', ' ', ' ' };
+    memcpy(&edid[72], name, sizeof(name));
+    uint8_t sum = 0;
+    for (int i = 0; i < 127; ++i) {
+        sum += edid[i];
+    }
+    edid[127] = (uint8_t) (0x100 - sum);
+    return edid;
+}
+
+static void CreateConnector(const std::string &root, const std::string &name, const std::vector<uint8_t> &edid) {
+    std::string base = root + "/" + name;
+    mkdir(base.c_str(), 0755);
+    WriteFile(base + "/status", "connected\n");
+    WriteFile(base + "/enabled", "enabled\n");
+    WriteFile(base + "/modes", "1920x1080\n1280x720\n");
+    WriteFile(base + "/edid", std::string(edid.begin(), edid.end()));
+}
+
+static const DrmConnector *FindConnector(DrmConnectorCatalog &catalog, const std::string &name) {
+    for (const DrmConnector &connector : catalog.GetConnectors()) {
+        if (connector.name == name) {
+            return &connector;
+        }
+    }
+    return nullptr;
+}
+
+static void TestValidEdid() {
+    EdidInfo info;
+    CHECK(EdidParser::Parse(CreateEdid(), info));
+    CHECK(info.manufacturer == "BOE");
+    CHECK(info.productCode == 0x0747);
+    CHECK(info.monitorName == "TEST PANEL");
+    CHECK(info.timings.size() == 1);
+    if (info.timings.size() == 1) {
+        CHECK(info.timings[0].width == 1920);
+        CHECK(info.timings[0].height == 1080);
+        CHECK(info.timings[0].refreshRate == 60.0);
+        CHECK(info.timings[0].preferred);
+        CHECK(!info.timings[0].interlaced);
+    }
+}
+
+static void TestTruncatedEdid() {
+    std::vector<uint8_t> edid = CreateEdid();
+    edid.resize(100);
+    EdidInfo info;
+    CHECK(!EdidParser::Parse(edid, info));
+
+    // Announced extension block missing, the base block is still used
+    edid = CreateEdid();
+    edid[126] = 1;
+    edid[127] -= 1;
+    CHECK(EdidParser::Parse(edid, info));
+    CHECK(info.timings.size() == 1);
+}
+
+static void TestBadChecksum() {
+    std::vector<uint8_t> edid = CreateEdid();
+    edid[127] ^= 0x01;
+    EdidInfo info;
+    CHECK(!EdidParser::Parse(edid, info));
+}
+
+static void TestHotplug(const std::string &root) {
+    std::string drmPath = root + "/drm";
+    mkdir(drmPath.c_str(), 0755);
+    // Card itself is not a connector
+    mkdir((drmPath + "/card0").c_str(), 0755);
+    CreateConnector(drmPath, "card0-eDP-1", CreateEdid());
+
+    DrmConnectorCatalog catalog(drmPath);
+    const std::vector<DrmConnector> &connectors = catalog.GetConnectors();
+    CHECK(connectors.size() == 1);
+    if (connectors.size() == 1) {
+        CHECK(connectors[0].card == 0);
+        CHECK(connectors[0].name == "eDP-1");
+        CHECK(connectors[0].status == "connected");
+        CHECK(connectors[0].enabled);
+        CHECK(connectors[0].modes.size() == 2);
+        CHECK(connectors[0].hasEdid);
+        CHECK(connectors[0].edid.monitorName == "TEST PANEL");
+    }
+    CHECK(catalog.GetGeneration() == 1);
+
+    // Kept until the owner sees a uevent
+    std::vector<uint8_t> truncated = CreateEdid();
+    truncated.resize(64);
+    CreateConnector(drmPath, "card0-HDMI-A-1", truncated);
+    CHECK(catalog.GetConnectors().size() == 1);
+    CHECK(catalog.GetScans() == 1);
+
+    catalog.Invalidate();
+    CHECK(catalog.GetConnectors().size() == 2);
+    CHECK(catalog.GetGeneration() == 2);
+    const DrmConnector *hdmi = FindConnector(catalog, "HDMI-A-1");
+    CHECK(hdmi != nullptr && !hdmi->hasEdid);
+
+    // Rescan without changes keeps the generation
+    catalog.Invalidate();
+    CHECK(catalog.GetConnectors().size() == 2);
+    CHECK(catalog.GetGeneration() == 2);
+    CHECK(catalog.GetScans() == 3);
+
+    WriteFile(drmPath + "/card0-HDMI-A-1/status", "disconnected\n");
+    catalog.Invalidate();
+    hdmi = FindConnector(catalog, "HDMI-A-1");
+    CHECK(hdmi != nullptr && hdmi->status == "disconnected");
+    CHECK(catalog.GetGeneration() == 3);
+}
+
+int main(int argc, char *argv[]) {
+    char rootTemplate[] = "/tmp/drm_connector_catalog_test.XXXXXX";
+    if (mkdtemp(rootTemplate) == nullptr) {
+        perror("mkdtemp");
+        return 2;
+    }
+    std::string root = rootTemplate;
+
+    TestValidEdid();
+    TestTruncatedEdid();
+    TestBadChecksum();
+    TestHotplug(root);
+
+    std::string removeCommand = "rm -rf '" + root + "'";
+    if (system(removeCommand.c_str()) != 0) {
+        fprintf(stderr, "Failed to remove %s\n", root.c_str());
+    }
+
+    printf("drm_connector_catalog_test: %s\n", failedChecks == 0 ? "ok" : "failed");
+    return failedChecks == 0 ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * LedFrameEngine against a fake leds tree in a temporary directory
+ *
+ * Usage: npm run test-native-lib
+ *
+ * The attributes are regular files here, which pwrite does not truncate.
+ * All values written by the tests have the same width so the files stay
+ * readable. Exits with 1 if any check failed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include "led_frame_engine.hh"
+
+static int failedChecks = 0;
+
+#define CHECK(condition) \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        ++failedChecks; \
+    }
+
+static std::string ReadFile(const std::string &path) {
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+static void WriteFile(const std::string &path, const std::string &content) {
+    std::ofstream file(path);
+    file << content;
+}
+
+/**
+ * One led class device per key, the first one with the buffer_input control
+ */
+static std::vector<std::string> CreateLedsTree(const std::string &root, int nrKeys, bool withAttributes) {
+    std::vector<std::string> ledPaths;
+    mkdir(root.c_str(), 0755);
+    for (int i = 0; i < nrKeys; ++i) {
+        std::string ledPath = root + "/rgb:kbd_backlight_" + std::to_string(i);
+        mkdir(ledPath.c_str(), 0755);
+        if (withAttributes) {
+            WriteFile(ledPath + "/multi_intensity", "000 000 000");
+            WriteFile(ledPath + "/brightness", "000");
+        }
+        ledPaths.push_back(ledPath);
+    }
+    mkdir((ledPaths[0] + "/device").c_str(), 0755);
+    mkdir((ledPaths[0] + "/device/controls").c_str(), 0755);
+    WriteFile(ledPaths[0] + "/device/controls/buffer_input", "0");
+    return ledPaths;
+}
+
+static bool WaitForFrames(LedFrameEngine &engine, uint64_t framesRendered) {
+    for (int i = 0; i < 200; ++i) {
+        if (engine.GetStatistics().framesRendered >= framesRendered) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return false;
+}
+
+static void TestMissingAttributes(const std::string &root) {
+    std::vector<std::string> ledPaths = CreateLedsTree(root + "/missing", 3, false);
+    LedFrameEngine engine(ledPaths);
+    CHECK(engine.NumberKeys() == 3);
+    CHECK(engine.NumberOpenKeys() == 0);
+}
+
+static void TestChangedKeysOnly(const std::string &root) {
+    std::vector<std::string> ledPaths = CreateLedsTree(root + "/diff", 3, true);
+    LedFrameEngine engine(ledPaths);
+    engine.SetFrameRate(1000);
+    CHECK(engine.NumberOpenKeys() == 3);
+
+    engine.SetFrame({ { 100, 110, 120 }, { 130, 140, 150 }, { 160, 170, 180 } });
+    CHECK(WaitForFrames(engine, 1));
+    CHECK(ReadFile(ledPaths[0] + "/multi_intensity") == "100 110 120");
+    CHECK(ReadFile(ledPaths[2] + "/multi_intensity") == "160 170 180");
+    CHECK(ReadFile(ledPaths[0] + "/device/controls/buffer_input") == "0");
+    CHECK(engine.GetStatistics().keysWritten == 3);
+
+    engine.SetFrame({ { 100, 110, 120 }, { 200, 210, 220 }, { 160, 170, 180 } });
+    CHECK(WaitForFrames(engine, 2));
+    CHECK(ReadFile(ledPaths[1] + "/multi_intensity") == "200 210 220");
+    CHECK(engine.GetStatistics().keysWritten == 4);
+    CHECK(engine.GetStatistics().keysSkipped == 2);
+    CHECK(engine.GetStatistics().writeErrors == 0);
+}
+
+static void TestBrightnessDuringAnimation(const std::string &root) {
+    std::vector<std::string> ledPaths = CreateLedsTree(root + "/brightness", 2, true);
+    LedFrameEngine engine(ledPaths);
+    engine.SetFrameRate(1000);
+
+    engine.SetFrame({ { 255, 255, 255 }, { 255, 255, 255 } }, 100);
+    CHECK(WaitForFrames(engine, 1));
+    CHECK(ReadFile(ledPaths[0] + "/brightness") == "100");
+    CHECK(ReadFile(ledPaths[1] + "/brightness") == "100");
+
+    engine.SetAnimation(LedFrameEngine::Animation::Breathe, 1000);
+    uint64_t framesRendered = engine.GetStatistics().framesRendered;
+    engine.SetFrame({ { 255, 255, 255 }, { 255, 255, 255 } }, 200);
+    CHECK(WaitForFrames(engine, framesRendered + 2));
+    CHECK(ReadFile(ledPaths[0] + "/brightness") == "200");
+    CHECK(ReadFile(ledPaths[1] + "/brightness") == "200");
+    CHECK(engine.GetStatistics().writeErrors == 0);
+}
+
+int main(int argc, char *argv[]) {
+    char rootTemplate[] = "/tmp/led_frame_engine_test.XXXXXX";
+    if (mkdtemp(rootTemplate) == nullptr) {
+        perror("mkdtemp");
+        return 2;
+    }
+    std::string root = rootTemplate;
+
+    TestMissingAttributes(root);
+    TestChangedKeysOnly(root);
+    TestBrightnessDuringAnimation(root);
+
+    std::string removeCommand = "rm -rf '" + root + "'";
+    if (system(removeCommand.c_str()) != 0) {
+        fprintf(stderr, "Failed to remove %s\n", root.c_str());
+    }
+
+    printf("led_frame_engine_test: %s\n", failedChecks == 0 ? "ok" : "failed");
+    return failedChecks == 0 ? 0 : 1;
+}
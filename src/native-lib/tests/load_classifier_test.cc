@@ -0,0 +1,145 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * LoadClassifier phase, dwell time and hysteresis transitions, one table row
+ * per sample with the expected phase and candidate afterwards
+ *
+ * Usage: npm run test-native-lib
+ *
+ * Exits with 1 if any check failed.
+ */
+#include <stdio.h>
+#include <vector>
+#include "load_classifier.hh"
+
+static int failedChecks = 0;
+
+struct Step {
+    double cpuBusy;
+    double maxCoreBusy;
+    double gpuBusy;
+    uint64_t nowMs;
+    LoadPhase phase;
+    LoadPhase candidate;
+};
+
+struct Scenario {
+    const char *name;
+    std::size_t windowSamples;
+    std::vector<Step> steps;
+    uint64_t switches;
+};
+
+static const LoadPhase Idle = LoadPhase::Idle;
+static const LoadPhase Bursty = LoadPhase::Bursty;
+static const LoadPhase Heavy = LoadPhase::Heavy;
+
+// Thresholds: heavy 70, core heavy 90, idle 10, hysteresis 15
+static const std::vector<Scenario> scenarios = {
+    { "heavy after its dwell time", 1, {
+        { 5, 8, -1, 0, Idle, Idle },
+        { 80, 95, -1, 1000, Idle, Heavy },
+        { 80, 95, -1, 2000, Idle, Heavy },
+        { 80, 95, -1, 3000, Heavy, Heavy }
+    }, 1 },
+    { "load between the thresholds is bursty", 1, {
+        { 60, 80, -1, 0, Bursty, Bursty }
+    }, 0 },
+    { "hysteresis holds heavy", 1, {
+        { 80, 95, -1, 0, Heavy, Heavy },
+        { 60, 80, -1, 1000, Heavy, Heavy },
+        { 50, 70, -1, 2000, Heavy, Bursty },
+        { 50, 70, -1, 3000, Heavy, Bursty },
+        { 50, 70, -1, 4000, Bursty, Bursty }
+    }, 1 },
+    { "dwell time restarts when the candidate flaps", 1, {
+        { 80, 95, -1, 0, Heavy, Heavy },
+        { 50, 70, -1, 1000, Heavy, Bursty },
+        { 80, 95, -1, 2000, Heavy, Heavy },
+        { 50, 70, -1, 3000, Heavy, Bursty },
+        { 50, 70, -1, 4000, Heavy, Bursty },
+        { 50, 70, -1, 5000, Bursty, Bursty }
+    }, 1 },
+    { "single saturated core is heavy", 1, {
+        { 8, 100, -1, 0, Heavy, Heavy },
+        { 7, 80, -1, 1000, Heavy, Heavy },
+        { 7, 70, -1, 2000, Heavy, Bursty },
+        { 7, 70, -1, 4000, Bursty, Bursty }
+    }, 1 },
+    { "gpu load is heavy", 1, {
+        { 5, 8, 85, 0, Heavy, Heavy }
+    }, 0 },
+    { "hysteresis holds idle", 1, {
+        { 3, 5, -1, 0, Idle, Idle },
+        { 15, 20, -1, 1000, Idle, Idle },
+        { 15, 30, -1, 2000, Idle, Bursty },
+        { 15, 30, -1, 3000, Idle, Bursty },
+        { 15, 30, -1, 4000, Bursty, Bursty }
+    }, 1 },
+    { "idle waits for its own dwell time", 1, {
+        { 50, 70, -1, 0, Bursty, Bursty },
+        { 3, 5, -1, 1000, Bursty, Idle },
+        { 3, 5, -1, 3000, Bursty, Idle },
+        { 3, 5, -1, 4000, Idle, Idle }
+    }, 1 },
+    { "window mean delays heavy", 3, {
+        { 5, 8, -1, 0, Idle, Idle },
+        { 100, 100, -1, 1000, Idle, Bursty },
+        { 100, 100, -1, 2000, Idle, Bursty },
+        { 100, 100, -1, 3000, Idle, Heavy },
+        { 100, 100, -1, 5000, Heavy, Heavy }
+    }, 1 }
+};
+
+static void RunScenario(const Scenario &scenario) {
+    LoadClassifier::Config config;
+    config.windowSamples = scenario.windowSamples;
+    config.heavyDwellMs = 2000;
+    config.burstyDwellMs = 2000;
+    config.idleDwellMs = 3000;
+    LoadClassifier classifier;
+    classifier.SetConfig(config);
+
+    for (std::size_t i = 0; i < scenario.steps.size(); ++i) {
+        const Step &step = scenario.steps[i];
+        classifier.AddSample(LoadSample { step.cpuBusy, step.maxCoreBusy, step.gpuBusy, 8 }, step.nowMs);
+        const LoadClassifier::State &state = classifier.GetState();
+        if (state.phase != step.phase || state.candidate != step.candidate) {
+            fprintf(stderr, "%s, step %zu: phase %s, candidate %s, expected %s, %s\n", scenario.name, i,
+                    LoadClassifier::PhaseToString(state.phase), LoadClassifier::PhaseToString(state.candidate),
+                    LoadClassifier::PhaseToString(step.phase), LoadClassifier::PhaseToString(step.candidate));
+            ++failedChecks;
+        }
+    }
+    if (classifier.GetState().switches != scenario.switches) {
+        fprintf(stderr, "%s: %llu switches, expected %llu\n", scenario.name,
+                (unsigned long long) classifier.GetState().switches, (unsigned long long) scenario.switches);
+        ++failedChecks;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    for (const Scenario &scenario : scenarios) {
+        RunScenario(scenario);
+    }
+
+    printf("load_classifier_test: %s\n", failedChecks == 0 ? "ok" : "failed");
+    return failedChecks == 0 ? 0 : 1;
+}
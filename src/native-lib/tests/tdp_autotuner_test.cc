@@ -0,0 +1,177 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * TDPAutotuner steps on a simulated uniwill EC (TDPs 25/35/45 W, maxima
+ * 45/60/90 W) without package power, which counts as power limited
+ *
+ * Usage: npm run test-native-lib
+ *
+ * Exits with 1 if any check failed.
+ */
+#include <stdio.h>
+#include <vector>
+#include "tuxedo_io_sim.hh"
+#include "tdp_autotuner.hh"
+
+static int failedChecks = 0;
+
+#define CHECK(condition) \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        ++failedChecks; \
+    }
+
+static const char *NO_RAPL_PATH = "/nonexistent/intel-rapl:0";
+
+struct StepCase {
+    const char *name;
+    int temperatureHysteresis;
+    int stepWatts;
+    int temperature;
+    TDPAutotuner::Action action;
+    std::vector<int> tdpValues;
+};
+
+// Target temperature 85 in all cases
+static const std::vector<StepCase> stepCases = {
+    { "above target steps down twice the step", 5, 2, 90, TDPAutotuner::Action::Decrease, { 21, 31, 41 } },
+    { "at target holds", 5, 2, 85, TDPAutotuner::Action::Hold, { 25, 35, 45 } },
+    { "within hysteresis holds", 5, 2, 81, TDPAutotuner::Action::Hold, { 25, 35, 45 } },
+    { "at hysteresis edge holds", 5, 2, 80, TDPAutotuner::Action::Hold, { 25, 35, 45 } },
+    { "below hysteresis steps up", 5, 2, 79, TDPAutotuner::Action::Increase, { 27, 37, 47 } },
+    { "wider hysteresis holds", 10, 2, 79, TDPAutotuner::Action::Hold, { 25, 35, 45 } },
+    { "larger step up", 5, 5, 70, TDPAutotuner::Action::Increase, { 30, 40, 50 } },
+    { "larger step down", 5, 5, 95, TDPAutotuner::Action::Decrease, { 15, 25, 35 } }
+};
+
+static TDPAutotuner::Config TestConfig(int temperatureHysteresis, int stepWatts) {
+    TDPAutotuner::Config config;
+    config.targetTemperature = 85;
+    config.temperatureHysteresis = temperatureHysteresis;
+    config.stepWatts = stepWatts;
+    config.minChangeIntervalMs = 0;
+    return config;
+}
+
+static std::vector<int> DeviceTDPs(TuxedoIOAPI &api) {
+    std::vector<int> values(3, -1);
+    for (int i = 0; i < 3; ++i) {
+        api.GetTDP(i, values[i]);
+    }
+    return values;
+}
+
+static void TestStepCases() {
+    for (const StepCase &stepCase : stepCases) {
+        SimulatedIO sim(SimulatedIO::Platform::Uniwill);
+        sim.SetTemperature(0, stepCase.temperature);
+        TuxedoIOAPI api(sim);
+        TDPAutotuner autotuner(NO_RAPL_PATH);
+        autotuner.SetConfig(TestConfig(stepCase.temperatureHysteresis, stepCase.stepWatts));
+
+        TDPAutotuner::Decision decision;
+        bool result = autotuner.Step(api, decision);
+        std::vector<int> device = DeviceTDPs(api);
+        if (!result || decision.action != stepCase.action || decision.tdpValues != stepCase.tdpValues
+                || device != stepCase.tdpValues) {
+            fprintf(stderr, "%s: %s to %d/%d/%d W (%s), device at %d/%d/%d W\n", stepCase.name,
+                    TDPAutotuner::ActionToString(decision.action),
+                    decision.tdpValues.size() == 3 ? decision.tdpValues[0] : -1,
+                    decision.tdpValues.size() == 3 ? decision.tdpValues[1] : -1,
+                    decision.tdpValues.size() == 3 ? decision.tdpValues[2] : -1,
+                    decision.reason.c_str(), device[0], device[1], device[2]);
+            ++failedChecks;
+        }
+    }
+}
+
+static void TestHysteresisBand() {
+    SimulatedIO sim(SimulatedIO::Platform::Uniwill);
+    TuxedoIOAPI api(sim);
+    TDPAutotuner autotuner(NO_RAPL_PATH);
+    autotuner.SetConfig(TestConfig(5, 2));
+    TDPAutotuner::Decision decision;
+
+    // Hot, cooling down into the band holds the lowered limits
+    sim.SetTemperature(0, 88);
+    CHECK(autotuner.Step(api, decision) && decision.action == TDPAutotuner::Action::Decrease);
+    sim.SetTemperature(0, 83);
+    CHECK(autotuner.Step(api, decision) && decision.action == TDPAutotuner::Action::Hold);
+    CHECK(decision.reason == "within hysteresis");
+    CHECK(DeviceTDPs(api) == std::vector<int>({ 21, 31, 41 }));
+
+    // Only leaving the band below raises them again
+    sim.SetTemperature(0, 78);
+    CHECK(autotuner.Step(api, decision) && decision.action == TDPAutotuner::Action::Increase);
+    CHECK(DeviceTDPs(api) == std::vector<int>({ 23, 33, 43 }));
+    CHECK(autotuner.GetDecisions().size() == 3);
+}
+
+static void TestLimits() {
+    SimulatedIO sim(SimulatedIO::Platform::Uniwill);
+    TuxedoIOAPI api(sim);
+    TDPAutotuner autotuner(NO_RAPL_PATH);
+    autotuner.SetConfig(TestConfig(5, 2));
+    TDPAutotuner::Decision decision;
+
+    api.SetTDP(0, 44);
+    api.SetTDP(1, 60);
+    api.SetTDP(2, 90);
+    sim.SetTemperature(0, 60);
+    // Clamped to the maximum of each limit
+    CHECK(autotuner.Step(api, decision) && decision.action == TDPAutotuner::Action::Increase);
+    CHECK(DeviceTDPs(api) == std::vector<int>({ 45, 60, 90 }));
+    CHECK(autotuner.Step(api, decision) && decision.action == TDPAutotuner::Action::Hold);
+    CHECK(decision.reason == "thermal headroom, at limit");
+
+    api.SetTDP(0, 6);
+    api.SetTDP(1, 5);
+    api.SetTDP(2, 5);
+    sim.SetTemperature(0, 95);
+    // Clamped to the minimum, the longer term limits stay above the shorter term ones
+    CHECK(autotuner.Step(api, decision) && decision.action == TDPAutotuner::Action::Decrease);
+    CHECK(DeviceTDPs(api) == std::vector<int>({ 5, 5, 5 }));
+}
+
+static void TestRateLimit() {
+    SimulatedIO sim(SimulatedIO::Platform::Uniwill);
+    TuxedoIOAPI api(sim);
+    TDPAutotuner autotuner(NO_RAPL_PATH);
+    TDPAutotuner::Config config = TestConfig(5, 2);
+    config.minChangeIntervalMs = 60000;
+    autotuner.SetConfig(config);
+    TDPAutotuner::Decision decision;
+
+    sim.SetTemperature(0, 90);
+    CHECK(autotuner.Step(api, decision) && decision.action == TDPAutotuner::Action::Decrease);
+    CHECK(autotuner.Step(api, decision) && decision.action == TDPAutotuner::Action::Hold);
+    CHECK(decision.reason == "temperature above target, rate limited");
+    CHECK(DeviceTDPs(api) == std::vector<int>({ 21, 31, 41 }));
+}
+
+int main(int argc, char *argv[]) {
+    TestStepCases();
+    TestHysteresisBand();
+    TestLimits();
+    TestRateLimit();
+
+    printf("tdp_autotuner_test: %s\n", failedChecks == 0 ? "ok" : "failed");
+    return failedChecks == 0 ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * TuxedoIOAPI::ReadTelemetry on a simulated uniwill EC: batch groups the
+ * module leaves out are read per field, useless batch replies revoke the
+ * batch support
+ *
+ * Usage: npm run test-native-lib
+ *
+ * Exits with 1 if any check failed.
+ */
+#include <stdio.h>
+#include "tuxedo_io_sim.hh"
+
+static int failedChecks = 0;
+
+#define CHECK(condition) \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        ++failedChecks; \
+    }
+
+static void SetTemperatures(SimulatedIO &sim) {
+    sim.SetTemperature(0, 55);
+    sim.SetTemperature(1, 61);
+}
+
+/**
+ * Values of the simulated EC, however they were read
+ */
+static void CheckValues(const DeviceTelemetry &telemetry) {
+    CHECK(telemetry.nrFans == 2);
+    CHECK(telemetry.fanTemperature[0] == 55);
+    CHECK(telemetry.fanTemperature[1] == 61);
+    CHECK(telemetry.fanSpeedPercent[0] == 0);
+    CHECK(telemetry.nrTDPs == 3);
+    CHECK(telemetry.tdp[0] == 25 && telemetry.tdp[2] == 45);
+    CHECK(telemetry.tdpMin[1] == 5);
+    CHECK(telemetry.tdpMax[2] == 90);
+}
+
+static void TestPartialValidMask() {
+    SimulatedIO sim(SimulatedIO::Platform::Uniwill, MOD_TELEMETRY_MIN_VERSION);
+    sim.SetTelemetryGroups(TUXEDO_IO_TELEMETRY_FAN_SPEED | TUXEDO_IO_TELEMETRY_TDP);
+    SetTemperatures(sim);
+    TuxedoIOAPI api(sim);
+
+    DeviceTelemetry telemetry;
+    CHECK(api.ReadTelemetry(telemetry));
+    CheckValues(telemetry);
+    CHECK(telemetry.batchedGroups == (TUXEDO_IO_TELEMETRY_FAN_SPEED | TUXEDO_IO_TELEMETRY_TDP));
+    CHECK(sim.GetIoctlCount(R_TELEMETRY) == 1);
+    // Batched groups are not read again
+    CHECK(sim.GetIoctlCount(R_UW_FANSPEED) == 0);
+    CHECK(sim.GetIoctlCount(R_UW_TDP0) == 0);
+    // Missing ones come from the single ioctls
+    CHECK(sim.GetIoctlCount(R_UW_FAN_TEMP) == 1);
+    CHECK(sim.GetIoctlCount(R_UW_TDP0_MIN) == 1);
+    CHECK(api.TelemetryBatchSupported());
+}
+
+static void TestNothingValid() {
+    SimulatedIO sim(SimulatedIO::Platform::Uniwill, MOD_TELEMETRY_MIN_VERSION);
+    sim.SetTelemetryGroups(0);
+    SetTemperatures(sim);
+    TuxedoIOAPI api(sim);
+
+    DeviceTelemetry telemetry;
+    CHECK(api.ReadTelemetry(telemetry));
+    CheckValues(telemetry);
+    CHECK(telemetry.batchedGroups == 0);
+    CHECK(sim.GetIoctlCount(R_UW_FANSPEED) == 1);
+    CHECK(!api.TelemetryBatchSupported());
+
+    CHECK(api.ReadTelemetry(telemetry));
+    CheckValues(telemetry);
+    CHECK(sim.GetIoctlCount(R_TELEMETRY) == 1);
+}
+
+static void TestModuleReplaced() {
+    SimulatedIO sim(SimulatedIO::Platform::Uniwill, MOD_TELEMETRY_MIN_VERSION);
+    SetTemperatures(sim);
+    TuxedoIOAPI api(sim);
+
+    DeviceTelemetry telemetry;
+    CHECK(api.ReadTelemetry(telemetry));
+    CheckValues(telemetry);
+    CHECK(telemetry.batchedGroups != 0);
+    CHECK(sim.GetIoctlCount(R_UW_FAN_TEMP) == 0);
+
+    // Older module without R_TELEMETRY answers ENOTTY
+    sim.SetModuleVersion("0.2.0");
+    CHECK(api.ReadTelemetry(telemetry));
+    CheckValues(telemetry);
+    CHECK(telemetry.batchedGroups == 0);
+    CHECK(sim.GetIoctlCount(R_UW_FAN_TEMP) == 1);
+    CHECK(!api.TelemetryBatchSupported());
+
+    CHECK(api.ReadTelemetry(telemetry));
+    CHECK(sim.GetIoctlCount(R_TELEMETRY) == 2);
+}
+
+static void TestOldModule() {
+    SimulatedIO sim(SimulatedIO::Platform::Uniwill, "0.2.9");
+    SetTemperatures(sim);
+    TuxedoIOAPI api(sim);
+
+    CHECK(!api.TelemetryBatchSupported());
+    DeviceTelemetry telemetry;
+    CHECK(api.ReadTelemetry(telemetry));
+    CheckValues(telemetry);
+    CHECK(telemetry.batchedGroups == 0);
+    CHECK(sim.GetIoctlCount(R_TELEMETRY) == 0);
+    CHECK(sim.GetIoctlCount(R_UW_FAN_TEMP) == 1);
+}
+
+int main(int argc, char *argv[]) {
+    TestPartialValidMask();
+    TestNothingValid();
+    TestModuleReplaced();
+    TestOldModule();
+
+    printf("telemetry_fallback_test: %s\n", failedChecks == 0 ? "ok" : "failed");
+    return failedChecks == 0 ? 0 : 1;
+}
@@ -0,0 +1,200 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * ThrottleDetector episode logic and ThrottleMonitor against a fake cpu tree
+ * in a temporary directory
+ *
+ * Usage: npm run test-native-lib
+ *
+ * Exits with 1 if any check failed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include "throttle_monitor.hh"
+
+static int failedChecks = 0;
+
+#define CHECK(condition) \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        ++failedChecks; \
+    }
+
+static void WriteFile(const std::string &path, const std::string &content) {
+    std::ofstream file(path);
+    file << content;
+}
+
+static std::vector<ThrottleCoreSample> Samples(uint64_t core0, uint64_t core1, uint64_t package, int freqPercent = -1) {
+    return {
+        { 0, core0, package, freqPercent },
+        { 1, core1, package, freqPercent }
+    };
+}
+
+static void TestCounterDeltas() {
+    ThrottleDetector detector(2, 100);
+    typedef ThrottleDetector::SampleResult Result;
+
+    // Nothing to compare the first sample with
+    CHECK(detector.AddSample(Samples(10, 20, 30), 0, 0) == Result::Quiet);
+    CHECK(detector.AddSample(Samples(10, 20, 30), 100, 0) == Result::Quiet);
+    CHECK(detector.GetStatistics().episodes == 0);
+
+    CHECK(detector.AddSample(Samples(10, 23, 30, 60), 200, 0) == Result::EpisodeStarted);
+    // Package counter is shared by the cores and counted once
+    CHECK(detector.AddSample(Samples(11, 23, 35, 40), 300, 0) == Result::Throttling);
+    ThrottleDetector::Statistics statistics = detector.GetStatistics();
+    CHECK(statistics.episodes == 1);
+    CHECK(statistics.recent.size() == 1);
+    if (statistics.recent.size() == 1) {
+        const ThrottleDetector::Episode &episode = statistics.recent[0];
+        CHECK(episode.ongoing);
+        CHECK(episode.coreEvents == 4);
+        CHECK(episode.packageEvents == 5);
+        CHECK(episode.cores == std::vector<int>({ 0, 1 }));
+        CHECK(episode.minFreqPercent == 40);
+        CHECK(episode.durationMs == 200);
+    }
+
+    // Ends after two quiet samples, the duration stops at the last throttling one
+    CHECK(detector.AddSample(Samples(11, 23, 35), 400, 0) == Result::Quiet);
+    CHECK(detector.GetStatistics().recent[0].ongoing);
+    CHECK(detector.AddSample(Samples(11, 23, 35), 500, 0) == Result::Quiet);
+    statistics = detector.GetStatistics();
+    CHECK(statistics.recent.size() == 1 && !statistics.recent[0].ongoing);
+    CHECK(statistics.totalDurationMs == 200);
+    CHECK(statistics.longestDurationMs == 200);
+
+    // Counters restarting after the core was offline are no throttling
+    CHECK(detector.AddSample(Samples(0, 0, 0), 600, 0) == Result::Quiet);
+    CHECK(detector.GetStatistics().episodes == 1);
+}
+
+static void TestQuietSampleResets() {
+    ThrottleDetector detector(2, 100);
+    typedef ThrottleDetector::SampleResult Result;
+
+    detector.AddSample(Samples(0, 0, 0), 0, 0);
+    CHECK(detector.AddSample(Samples(1, 0, 0), 100, 0) == Result::EpisodeStarted);
+    CHECK(detector.AddSample(Samples(1, 0, 0), 200, 0) == Result::Quiet);
+    // Throttling again before quietSamples continues the episode
+    CHECK(detector.AddSample(Samples(2, 0, 0), 300, 0) == Result::Throttling);
+    CHECK(detector.AddSample(Samples(2, 0, 0), 400, 0) == Result::Quiet);
+    CHECK(detector.AddSample(Samples(2, 0, 0), 500, 0) == Result::Quiet);
+    ThrottleDetector::Statistics statistics = detector.GetStatistics();
+    CHECK(statistics.episodes == 1);
+    CHECK(statistics.totalDurationMs == 300);
+    CHECK(statistics.recent.size() == 1 && statistics.recent[0].coreEvents == 2);
+
+    // Peak temperature from the context updates while throttling
+    CHECK(detector.AddSample(Samples(3, 0, 0), 600, 0) == Result::EpisodeStarted);
+    ThrottleContext context;
+    context.fanTemperature = { 80, 75 };
+    context.tccProfile = "Test";
+    detector.UpdateContext(context, true);
+    CHECK(detector.AddSample(Samples(4, 0, 0), 700, 0) == Result::Throttling);
+    context.fanTemperature = { 92 };
+    context.tccProfile = "Other";
+    detector.UpdateContext(context, false);
+    statistics = detector.GetStatistics();
+    CHECK(statistics.episodes == 2);
+    CHECK(statistics.recent.size() == 2);
+    if (statistics.recent.size() == 2) {
+        CHECK(statistics.recent[1].maxTemperature == 92);
+        CHECK(statistics.recent[1].context.tccProfile == "Test");
+    }
+}
+
+static void CreateCore(const std::string &cpuPath, int core, bool withThermalThrottle) {
+    std::string corePath = cpuPath + "/cpu" + std::to_string(core);
+    mkdir(corePath.c_str(), 0755);
+    if (withThermalThrottle) {
+        mkdir((corePath + "/thermal_throttle").c_str(), 0755);
+        WriteFile(corePath + "/thermal_throttle/core_throttle_count", "0\n");
+        WriteFile(corePath + "/thermal_throttle/package_throttle_count", "0\n");
+    }
+}
+
+template<typename Condition>
+static bool WaitFor(Condition condition) {
+    for (int i = 0; i < 200; ++i) {
+        if (condition()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return false;
+}
+
+static void TestCoreComingOnline(const std::string &root) {
+    std::string cpuPath = root + "/cpu";
+    mkdir(cpuPath.c_str(), 0755);
+    CreateCore(cpuPath, 0, true);
+    // Offline at start, no thermal_throttle group
+    CreateCore(cpuPath, 1, false);
+    WriteFile(cpuPath + "/online", "0\n");
+
+    ThrottleMonitor::Config config;
+    config.sampleIntervalMs = 5;
+    config.quietSamples = 1;
+    ThrottleMonitor monitor(config, [](ThrottleContext &) {}, cpuPath);
+    CHECK(monitor.Available());
+    CHECK(WaitFor([&monitor]() { return monitor.GetStatistics().monitoredCores == 1; }));
+
+    CreateCore(cpuPath, 1, true);
+    WriteFile(cpuPath + "/online", "0-1\n");
+    CHECK(WaitFor([&monitor]() { return monitor.GetStatistics().monitoredCores == 2; }));
+
+    // Let a sample of the new core be taken before it throttles
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    WriteFile(cpuPath + "/cpu1/thermal_throttle/core_throttle_count", "3\n");
+    CHECK(WaitFor([&monitor]() { return monitor.GetStatistics().episodes == 1; }));
+    ThrottleDetector::Statistics statistics = monitor.GetStatistics();
+    CHECK(statistics.recent.size() == 1 && statistics.recent[0].cores == std::vector<int>({ 1 }));
+}
+
+int main(int argc, char *argv[]) {
+    char rootTemplate[] = "/tmp/throttle_monitor_test.XXXXXX";
+    if (mkdtemp(rootTemplate) == nullptr) {
+        perror("mkdtemp");
+        return 2;
+    }
+    std::string root = rootTemplate;
+
+    TestCounterDeltas();
+    TestQuietSampleResets();
+    TestCoreComingOnline(root);
+
+    std::string removeCommand = "rm -rf '" + root + "'";
+    if (system(removeCommand.c_str()) != 0) {
+        fprintf(stderr, "Failed to remove %s\n", root.c_str());
+    }
+
+    printf("throttle_monitor_test: %s\n", failedChecks == 0 ? "ok" : "failed");
+    return failedChecks == 0 ? 0 : 1;
+}
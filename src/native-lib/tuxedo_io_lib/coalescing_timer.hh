@@ -0,0 +1,147 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/timerfd.h>
+#include <deque>
+
+/**
+ * Wakeup source for a scheduler running on an event loop
+ *
+ * A timerfd armed with absolute CLOCK_MONOTONIC deadlines, so deadlines on
+ * a common timeline do not drift with the time spent handling a wakeup. The
+ * descriptor is polled by the event loop, Acknowledge is called when it
+ * becomes readable. Counts wakeups and how late they arrived.
+ */
+class CoalescingTimer {
+public:
+    struct Statistics {
+        uint64_t wakeups;
+        uint64_t wakeupsLastMinute;
+        uint64_t maxLatenessNs;
+        uint64_t totalLatenessNs;
+    };
+
+    CoalescingTimer() {
+        fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        statistics = Statistics { 0, 0, 0, 0 };
+    }
+
+    ~CoalescingTimer() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    bool Valid() const {
+        return fd >= 0;
+    }
+
+    int GetFd() const {
+        return fd;
+    }
+
+    /**
+     * @param deadlineNs Absolute CLOCK_MONOTONIC time, a deadline in the past
+     *                   expires immediately
+     */
+    bool Arm(uint64_t deadlineNs) {
+        struct itimerspec spec = {};
+        // An all zero value would disarm
+        if (deadlineNs == 0) { deadlineNs = 1; }
+        spec.it_value.tv_sec = deadlineNs / 1000000000ull;
+        spec.it_value.tv_nsec = deadlineNs % 1000000000ull;
+        armedDeadlineNs = deadlineNs;
+        return timerfd_settime(fd, TFD_TIMER_ABSTIME, &spec, nullptr) == 0;
+    }
+
+    bool Disarm() {
+        struct itimerspec spec = {};
+        armedDeadlineNs = 0;
+        return timerfd_settime(fd, 0, &spec, nullptr) == 0;
+    }
+
+    /**
+     * Consume the expiration
+     *
+     * @returns False on spurious wakeups (nothing expired)
+     */
+    bool Acknowledge() {
+        uint64_t expirations = 0;
+        if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations) || expirations == 0) {
+            return false;
+        }
+        uint64_t nowNs = MonotonicNs();
+        statistics.wakeups++;
+        if (armedDeadlineNs != 0 && nowNs > armedDeadlineNs) {
+            uint64_t latenessNs = nowNs - armedDeadlineNs;
+            statistics.totalLatenessNs += latenessNs;
+            if (latenessNs > statistics.maxLatenessNs) {
+                statistics.maxLatenessNs = latenessNs;
+            }
+        }
+        armedDeadlineNs = 0;
+        wakeupTimes.push_back(nowNs);
+        PruneWakeups(nowNs);
+        return true;
+    }
+
+    Statistics GetStatistics() {
+        PruneWakeups(MonotonicNs());
+        statistics.wakeupsLastMinute = wakeupTimes.size();
+        return statistics;
+    }
+
+    /**
+     * Allowed lateness of the calling thread's timers (including the event
+     * loop's poll timeout), lets the kernel batch their expiry with others
+     */
+    static bool SetTimerSlack(uint64_t slackNs) {
+        return prctl(PR_SET_TIMERSLACK, slackNs > 0 ? slackNs : 1, 0, 0, 0) == 0;
+    }
+
+    static uint64_t GetTimerSlack() {
+        int result = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+        return result < 0 ? 0 : (uint64_t) result;
+    }
+
+    static uint64_t MonotonicNs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    }
+
+private:
+    static const uint64_t MINUTE_NS = 60ull * 1000000000ull;
+
+    int fd = -1;
+    uint64_t armedDeadlineNs = 0;
+    Statistics statistics;
+    std::deque<uint64_t> wakeupTimes;
+
+    void PruneWakeups(uint64_t nowNs) {
+        while (!wakeupTimes.empty() && nowNs - wakeupTimes.front() > MINUTE_NS) {
+            wakeupTimes.pop_front();
+        }
+    }
+};
@@ -0,0 +1,259 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+#include "sysfs_batch_writer.hh"
+
+/**
+ * Keeps sysfs attributes of the logical cores at a desired state
+ *
+ * Each tick verifies the global attributes and the attributes of a rotating
+ * subset of cores, so the cost per tick does not grow with the number of
+ * cores. Only attributes that drifted from the desired value are written
+ * again. A change of the online cores mask (hotplug, suspend/resume) makes
+ * the next tick verify all cores. Attributes that drift again right after
+ * being reapplied a few times in a row are reported and counted once, after
+ * that they are neither verified nor written until the desired state is set
+ * again.
+ */
+class CpuStateReconciler {
+public:
+    struct Attribute {
+        // Logical core, -1 for attributes not belonging to a core
+        int core;
+        std::string path;
+        std::string value;
+    };
+
+    struct Drift {
+        std::string path;
+        std::string expected;
+        // Read value, empty if not readable
+        std::string actual;
+        bool reapplied;
+        int error;
+    };
+
+    struct Statistics {
+        uint64_t ticks;
+        uint64_t attributesChecked;
+        uint64_t drifts;
+        uint64_t reapplied;
+        uint64_t reapplyErrors;
+        uint64_t unenforceable;
+        uint64_t fullScans;
+        // Drifts per attribute name (e.g. scaling_governor)
+        std::map<std::string, uint64_t> driftsByAttribute;
+    };
+
+    static const int MAX_REAPPLY_STREAK = 3;
+
+    CpuStateReconciler(const std::string &onlineMaskPath = "/sys/devices/system/cpu/online")
+        : onlineMaskPath(onlineMaskPath) {
+        statistics = Statistics { 0, 0, 0, 0, 0, 0, 0, std::map<std::string, uint64_t>() };
+    }
+
+    ~CpuStateReconciler() {
+        for (auto &entry : files) {
+            close(entry.second);
+        }
+    }
+
+    /**
+     * Replace the desired state, the next tick verifies everything
+     */
+    void SetDesired(const std::vector<Attribute> &attributes) {
+        globalAttributes.clear();
+        coreAttributes.clear();
+        coreOrder.clear();
+        for (const Attribute &attribute : attributes) {
+            Entry entry { attribute, 0, false };
+            if (attribute.core < 0) {
+                globalAttributes.push_back(entry);
+            } else {
+                if (coreAttributes.find(attribute.core) == coreAttributes.end()) {
+                    coreOrder.push_back(attribute.core);
+                }
+                coreAttributes[attribute.core].push_back(entry);
+            }
+        }
+        std::sort(coreOrder.begin(), coreOrder.end());
+        nextCore = 0;
+        fullScanPending = true;
+    }
+
+    std::size_t NumberCores() const {
+        return coreOrder.size();
+    }
+
+    /**
+     * Verify global attributes and the next coresPerTick cores
+     *
+     * @param writer Used to reapply drifted attributes
+     * @param drifts Filled with the drifts found in this tick
+     */
+    void Tick(SysFsBatchWriter &writer, unsigned coresPerTick, std::vector<Drift> &drifts) {
+        drifts.clear();
+        statistics.ticks++;
+
+        std::string onlineMask;
+        if (ReadAttribute(onlineMaskPath, onlineMask)) {
+            if (onlineMask != lastOnlineMask) {
+                fullScanPending = !lastOnlineMask.empty() || fullScanPending;
+                lastOnlineMask = onlineMask;
+            }
+        }
+
+        std::vector<Entry *> toCheck;
+        for (Entry &entry : globalAttributes) {
+            toCheck.push_back(&entry);
+        }
+        std::size_t nrCores = coreOrder.size();
+        std::size_t count = fullScanPending ? nrCores : std::min<std::size_t>(coresPerTick, nrCores);
+        if (fullScanPending) {
+            statistics.fullScans++;
+            fullScanPending = false;
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            int core = coreOrder[(nextCore + i) % nrCores];
+            for (Entry &entry : coreAttributes[core]) {
+                toCheck.push_back(&entry);
+            }
+        }
+        if (nrCores > 0) {
+            nextCore = (nextCore + count) % nrCores;
+        }
+
+        std::vector<SysFsWrite> writes;
+        std::vector<std::size_t> writeDrifts;
+        for (Entry *entry : toCheck) {
+            if (entry->unenforceable) {
+                continue;
+            }
+            statistics.attributesChecked++;
+            std::string actual;
+            bool readable = ReadAttribute(entry->attribute.path, actual);
+            if (readable && actual == entry->attribute.value) {
+                entry->reapplyStreak = 0;
+                continue;
+            }
+
+            statistics.drifts++;
+            statistics.driftsByAttribute[AttributeName(entry->attribute.path)]++;
+            Drift drift { entry->attribute.path, entry->attribute.value, readable ? actual : "", false, 0 };
+            if (entry->reapplyStreak >= MAX_REAPPLY_STREAK) {
+                // Does not stick (e.g. limited by firmware), stop fighting it
+                statistics.unenforceable++;
+                entry->unenforceable = true;
+            } else {
+                entry->reapplyStreak++;
+                drift.reapplied = true;
+                // Keep the order of the desired state, e.g. min before max frequency
+                writes.push_back(SysFsWrite { entry->attribute.path, entry->attribute.value, true, 0 });
+                writeDrifts.push_back(drifts.size());
+            }
+            drifts.push_back(drift);
+        }
+
+        if (!writes.empty()) {
+            writer.Write(writes);
+            for (std::size_t i = 0; i < writes.size(); ++i) {
+                drifts[writeDrifts[i]].error = writes[i].error;
+                if (writes[i].error == 0) {
+                    statistics.reapplied++;
+                } else {
+                    statistics.reapplyErrors++;
+                }
+            }
+        }
+    }
+
+    const Statistics &GetStatistics() const {
+        return statistics;
+    }
+
+private:
+    struct Entry {
+        Attribute attribute;
+        int reapplyStreak;
+        // Set once reapplying did not stick, skipped from then on
+        bool unenforceable;
+    };
+
+    std::string onlineMaskPath;
+    std::string lastOnlineMask;
+    std::vector<Entry> globalAttributes;
+    std::unordered_map<int, std::vector<Entry>> coreAttributes;
+    std::vector<int> coreOrder;
+    std::size_t nextCore = 0;
+    bool fullScanPending = true;
+    Statistics statistics;
+    std::unordered_map<std::string, int> files;
+
+    static std::string AttributeName(const std::string &path) {
+        std::size_t separator = path.find_last_of('/');
+        return separator == std::string::npos ? path : path.substr(separator + 1);
+    }
+
+    /**
+     * Read attribute through a cached descriptor, sysfs regenerates the
+     * content on every read from offset 0
+     */
+    bool ReadAttribute(const std::string &path, std::string &value) {
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            auto entry = files.find(path);
+            int fd;
+            bool cached = entry != files.end();
+            if (cached) {
+                fd = entry->second;
+            } else {
+                fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0) {
+                    return false;
+                }
+                files[path] = fd;
+            }
+            char buffer[4096];
+            ssize_t length = pread(fd, buffer, sizeof(buffer) - 1, 0);
+            if (length >= 0) {
+                while (length > 0 && (buffer[length - 1] == '\n' || buffer[length - 1] == ' ')) {
+                    length--;
+                }
+                value.assign(buffer, length);
+                return true;
+            }
+            // Attribute removed and recreated (core offline and back), reopen once
+            close(fd);
+            files.erase(path);
+            if (!cached) {
+                return false;
+            }
+        }
+        return false;
+    }
+};
@@ -0,0 +1,276 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <dirent.h>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <algorithm>
+
+struct EdidTiming {
+    int width;
+    int height;
+    double refreshRate;
+    bool interlaced;
+    bool preferred;
+};
+
+struct EdidInfo {
+    // PNP id, e.g. "BOE"
+    std::string manufacturer;
+    int productCode;
+    std::string monitorName;
+    std::vector<EdidTiming> timings;
+};
+
+struct DrmConnector {
+    int card;
+    // Connector name without card prefix, e.g. "eDP-1"
+    std::string name;
+    std::string status;
+    bool enabled;
+    // Mode names as listed by the kernel, e.g. "1920x1080"
+    std::vector<std::string> modes;
+    bool hasEdid;
+    EdidInfo edid;
+};
+
+/**
+ * Parses the base block and CTA-861 extension blocks of an EDID
+ *
+ * Collects the detailed timing descriptors (the first one of the base block
+ * is the preferred mode) and the standard timings. An EDID with a bad base
+ * block checksum is rejected, extension blocks with a bad checksum are skipped.
+ */
+class EdidParser {
+public:
+    static bool Parse(const std::vector<uint8_t> &edid, EdidInfo &info) {
+        static const uint8_t header[] = { 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00 };
+        if (edid.size() < EDID_BLOCK_SIZE || !std::equal(header, header + sizeof(header), edid.begin())
+                || !ChecksumValid(&edid[0])) {
+            return false;
+        }
+        info.timings.clear();
+        info.monitorName.clear();
+
+        uint16_t manufacturer = (edid[8] << 8) | edid[9];
+        info.manufacturer.clear();
+        for (int shift = 10; shift >= 0; shift -= 5) {
+            info.manufacturer += (char) ('A' + ((manufacturer >> shift) & 0x1f) - 1);
+        }
+        info.productCode = edid[10] | (edid[11] << 8);
+
+        for (std::size_t offset = 54; offset < 126; offset += DESCRIPTOR_SIZE) {
+            ParseDescriptor(&edid[offset], info, offset == 54);
+        }
+
+        for (std::size_t offset = 38; offset < 54; offset += 2) {
+            ParseStandardTiming(edid[offset], edid[offset + 1], info);
+        }
+
+        std::size_t extensions = edid[126];
+        for (std::size_t block = 1; block <= extensions && (block + 1) * EDID_BLOCK_SIZE <= edid.size(); ++block) {
+            const uint8_t *data = &edid[block * EDID_BLOCK_SIZE];
+            // CTA-861 extension, detailed timings start at the offset in byte 2
+            if (data[0] != 0x02 || data[2] < 4 || !ChecksumValid(data)) {
+                continue;
+            }
+            for (std::size_t offset = data[2]; offset + DESCRIPTOR_SIZE <= 127; offset += DESCRIPTOR_SIZE) {
+                if (data[offset] == 0 && data[offset + 1] == 0) {
+                    break;
+                }
+                ParseDescriptor(&data[offset], info, false);
+            }
+        }
+        return true;
+    }
+
+private:
+    static const std::size_t EDID_BLOCK_SIZE = 128;
+    static const std::size_t DESCRIPTOR_SIZE = 18;
+
+    static bool ChecksumValid(const uint8_t *block) {
+        uint8_t sum = 0;
+        for (std::size_t i = 0; i < EDID_BLOCK_SIZE; ++i) {
+            sum += block[i];
+        }
+        return sum == 0;
+    }
+
+    static void ParseDescriptor(const uint8_t *descriptor, EdidInfo &info, bool preferred) {
+        int pixelClock10kHz = descriptor[0] | (descriptor[1] << 8);
+        if (pixelClock10kHz == 0) {
+            // Display descriptor, 0xfc is the monitor name
+            if (descriptor[3] == 0xfc) {
+                std::string name((const char *) &descriptor[5], 13);
+                name = name.substr(0, name.find('\n'));
+                name.erase(name.find_last_not_of(' ') + 1);
+                info.monitorName = name;
+            }
+            return;
+        }
+        int hActive = descriptor[2] | ((descriptor[4] & 0xf0) << 4);
+        int hBlank = descriptor[3] | ((descriptor[4] & 0x0f) << 8);
+        int vActive = descriptor[5] | ((descriptor[7] & 0xf0) << 4);
+        int vBlank = descriptor[6] | ((descriptor[7] & 0x0f) << 8);
+        bool interlaced = descriptor[17] & 0x80;
+        if (hActive + hBlank == 0 || vActive + vBlank == 0) {
+            return;
+        }
+        double refreshRate = pixelClock10kHz * 10000.0 / ((hActive + hBlank) * (double) (vActive + vBlank));
+        AddTiming(info, EdidTiming { hActive, interlaced ? vActive * 2 : vActive, Round(refreshRate), interlaced, preferred });
+    }
+
+    static void ParseStandardTiming(uint8_t first, uint8_t second, EdidInfo &info) {
+        if ((first == 0x01 && second == 0x01) || first == 0x00) {
+            return;
+        }
+        int width = (first + 31) * 8;
+        int height;
+        switch (second >> 6) {
+            case 0: height = width * 10 / 16; break;
+            case 1: height = width * 3 / 4; break;
+            case 2: height = width * 4 / 5; break;
+            default: height = width * 9 / 16; break;
+        }
+        AddTiming(info, EdidTiming { width, height, (double) ((second & 0x3f) + 60), false, false });
+    }
+
+    static void AddTiming(EdidInfo &info, const EdidTiming &timing) {
+        for (const EdidTiming &existing : info.timings) {
+            if (existing.width == timing.width && existing.height == timing.height
+                    && std::fabs(existing.refreshRate - timing.refreshRate) < 0.5) {
+                return;
+            }
+        }
+        info.timings.push_back(timing);
+    }
+
+    static double Round(double value) {
+        return std::round(value * 100.0) / 100.0;
+    }
+};
+
+/**
+ * Catalog of the DRM connectors in sysfs (/sys/class/drm/card*-*)
+ *
+ * Scanned on first use and kept until invalidated, the owner invalidates it
+ * on drm uevents (hotplug, mode changes).
+ */
+class DrmConnectorCatalog {
+public:
+    DrmConnectorCatalog(const std::string &drmPath = "/sys/class/drm") : drmPath(drmPath) { }
+
+    const std::vector<DrmConnector> &GetConnectors() {
+        if (!valid) {
+            Scan();
+        }
+        return connectors;
+    }
+
+    void Invalidate() {
+        valid = false;
+    }
+
+    /**
+     * Increases with each scan that changed the catalog
+     */
+    uint64_t GetGeneration() const {
+        return generation;
+    }
+
+    uint64_t GetScans() const {
+        return scans;
+    }
+
+private:
+    std::string drmPath;
+    std::vector<DrmConnector> connectors;
+    std::vector<std::string> lastContent;
+    bool valid = false;
+    uint64_t generation = 0;
+    uint64_t scans = 0;
+
+    void Scan() {
+        std::vector<std::string> names;
+        DIR *dir = opendir(drmPath.c_str());
+        if (dir != nullptr) {
+            struct dirent *entry;
+            while ((entry = readdir(dir)) != nullptr) {
+                std::string name = entry->d_name;
+                std::size_t separator = name.find('-');
+                if (name.compare(0, 4, "card") == 0 && separator != std::string::npos && separator > 4) {
+                    names.push_back(name);
+                }
+            }
+            closedir(dir);
+        }
+        std::sort(names.begin(), names.end());
+
+        std::vector<DrmConnector> newConnectors;
+        std::vector<std::string> content;
+        for (const std::string &name : names) {
+            std::string base = drmPath + "/" + name + "/";
+            DrmConnector connector;
+            std::size_t separator = name.find('-');
+            connector.card = std::atoi(name.substr(4, separator - 4).c_str());
+            connector.name = name.substr(separator + 1);
+            connector.status = ReadLine(base + "status");
+            connector.enabled = ReadLine(base + "enabled") == "enabled";
+            std::string modes = ReadFile(base + "modes");
+            std::istringstream modeStream(modes);
+            std::string mode;
+            while (std::getline(modeStream, mode)) {
+                if (!mode.empty()) {
+                    connector.modes.push_back(mode);
+                }
+            }
+            std::string edid = ReadFile(base + "edid");
+            connector.hasEdid = EdidParser::Parse(std::vector<uint8_t>(edid.begin(), edid.end()), connector.edid);
+            content.push_back(name + connector.status + (connector.enabled ? "1" : "0") + modes + edid);
+            newConnectors.push_back(connector);
+        }
+
+        connectors.swap(newConnectors);
+        if (content != lastContent) {
+            lastContent.swap(content);
+            generation++;
+        }
+        scans++;
+        valid = true;
+    }
+
+    static std::string ReadFile(const std::string &path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    static std::string ReadLine(const std::string &path) {
+        std::ifstream file(path);
+        std::string line;
+        std::getline(file, line);
+        return line;
+    }
+};
@@ -0,0 +1,299 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+
+/**
+ * Frame based output to per-key RGB keyboard LEDs (one led class device per key)
+ *
+ * Frames are rendered on an own thread with a fixed frame rate, only keys whose
+ * color changed since the last written frame are written. The multi_intensity
+ * and brightness attributes are kept open for the lifetime of the engine.
+ * Without an animation the thread sleeps until a new frame is submitted.
+ *
+ * The led class scales multi_intensity by brightness in the kernel, so the
+ * brightness is not part of every rendered frame. It is written to all keys
+ * with the next frame after it was submitted, also while an animation runs.
+ */
+class LedFrameEngine {
+public:
+    struct Color {
+        uint8_t red;
+        uint8_t green;
+        uint8_t blue;
+
+        bool operator==(const Color &other) const {
+            return red == other.red && green == other.green && blue == other.blue;
+        }
+        bool operator!=(const Color &other) const { return !(*this == other); }
+    };
+
+    enum class Animation { None, Breathe, Wave };
+
+    struct Statistics {
+        uint64_t framesRendered;
+        uint64_t keysWritten;
+        uint64_t keysSkipped;
+        uint64_t writeErrors;
+    };
+
+    /**
+     * @param ledPaths Led class device directories, one per key in key order
+     */
+    LedFrameEngine(const std::vector<std::string> &ledPaths) {
+        for (std::size_t i = 0; i < ledPaths.size(); ++i) {
+            keyFiles.push_back(open((ledPaths[i] + "/multi_intensity").c_str(), O_WRONLY | O_CLOEXEC));
+            brightnessFiles.push_back(open((ledPaths[i] + "/brightness").c_str(), O_WRONLY | O_CLOEXEC));
+        }
+        if (ledPaths.size() > 0) {
+            bufferInputFile = open((ledPaths[0] + "/device/controls/buffer_input").c_str(), O_WRONLY | O_CLOEXEC);
+        }
+        baseFrame.resize(ledPaths.size(), Color { 0, 0, 0 });
+        writtenFrame.resize(ledPaths.size(), Color { 0, 0, 0 });
+        writtenValid.resize(ledPaths.size(), false);
+        renderThread = std::thread(&LedFrameEngine::Run, this);
+    }
+
+    ~LedFrameEngine() {
+        {
+            std::lock_guard<std::mutex> lock(frameMutex);
+            running = false;
+        }
+        frameChanged.notify_one();
+        renderThread.join();
+        for (std::size_t i = 0; i < keyFiles.size(); ++i) {
+            if (keyFiles[i] >= 0) { close(keyFiles[i]); }
+            if (brightnessFiles[i] >= 0) { close(brightnessFiles[i]); }
+        }
+        if (bufferInputFile >= 0) { close(bufferInputFile); }
+    }
+
+    std::size_t NumberKeys() const {
+        return keyFiles.size();
+    }
+
+    /**
+     * Keys whose multi_intensity attribute could be opened
+     */
+    std::size_t NumberOpenKeys() const {
+        std::size_t openKeys = 0;
+        for (std::size_t i = 0; i < keyFiles.size(); ++i) {
+            if (keyFiles[i] >= 0) { ++openKeys; }
+        }
+        return openKeys;
+    }
+
+    /**
+     * Set the base frame, shown as is or modulated by the active animation.
+     * Missing keys keep their previous color.
+     *
+     * @param brightness Written to all keys with the frame, -1 to keep it
+     */
+    void SetFrame(const std::vector<Color> &frame, int brightness = -1) {
+        {
+            std::lock_guard<std::mutex> lock(frameMutex);
+            for (std::size_t i = 0; i < frame.size() && i < baseFrame.size(); ++i) {
+                baseFrame[i] = frame[i];
+            }
+            if (brightness >= 0) {
+                pendingBrightness = brightness;
+            }
+            framePending = true;
+        }
+        frameChanged.notify_one();
+    }
+
+    void SetAnimation(Animation type, unsigned periodMs) {
+        {
+            std::lock_guard<std::mutex> lock(frameMutex);
+            animation = type;
+            animationPeriodMs = periodMs > 0 ? periodMs : 1;
+            animationStartNs = MonotonicNs();
+            framePending = true;
+        }
+        frameChanged.notify_one();
+    }
+
+    void SetFrameRate(unsigned framesPerSecond) {
+        std::lock_guard<std::mutex> lock(frameMutex);
+        frameIntervalNs = 1000000000ull / (framesPerSecond > 0 ? framesPerSecond : 1);
+    }
+
+    Statistics GetStatistics() const {
+        Statistics statistics;
+        statistics.framesRendered = framesRendered.load(std::memory_order_relaxed);
+        statistics.keysWritten = keysWritten.load(std::memory_order_relaxed);
+        statistics.keysSkipped = keysSkipped.load(std::memory_order_relaxed);
+        statistics.writeErrors = writeErrors.load(std::memory_order_relaxed);
+        return statistics;
+    }
+
+private:
+    std::vector<int> keyFiles;
+    std::vector<int> brightnessFiles;
+    int bufferInputFile = -1;
+
+    std::mutex frameMutex;
+    std::condition_variable frameChanged;
+    bool running = true;
+    bool framePending = false;
+    std::vector<Color> baseFrame;
+    int pendingBrightness = -1;
+    Animation animation = Animation::None;
+    unsigned animationPeriodMs = 3000;
+    uint64_t animationStartNs = 0;
+    uint64_t frameIntervalNs = 1000000000ull / 30;
+
+    // Only accessed from the render thread
+    std::vector<Color> writtenFrame;
+    std::vector<bool> writtenValid;
+
+    std::atomic<uint64_t> framesRendered { 0 };
+    std::atomic<uint64_t> keysWritten { 0 };
+    std::atomic<uint64_t> keysSkipped { 0 };
+    std::atomic<uint64_t> writeErrors { 0 };
+
+    std::thread renderThread;
+
+    static uint64_t MonotonicNs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    }
+
+    static void SleepUntil(uint64_t deadlineNs) {
+        struct timespec ts;
+        ts.tv_sec = deadlineNs / 1000000000ull;
+        ts.tv_nsec = deadlineNs % 1000000000ull;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) { }
+    }
+
+    static Color Scale(const Color &color, double factor) {
+        return Color {
+            (uint8_t) std::lround(color.red * factor),
+            (uint8_t) std::lround(color.green * factor),
+            (uint8_t) std::lround(color.blue * factor)
+        };
+    }
+
+    void Render(std::vector<Color> &frame, Animation type, unsigned periodMs, uint64_t startNs, uint64_t nowNs) {
+        if (type == Animation::None) { return; }
+        const double pi = std::acos(-1.0);
+        double phase = (double) ((nowNs - startNs) / 1000000ull % periodMs) / periodMs;
+        for (std::size_t i = 0; i < frame.size(); ++i) {
+            double keyPhase = phase;
+            if (type == Animation::Wave) {
+                // One wave crest travelling over all keys per period
+                keyPhase -= (double) i / frame.size();
+            }
+            frame[i] = Scale(frame[i], (1.0 - std::cos(2.0 * pi * keyPhase)) / 2.0);
+        }
+    }
+
+    void Write(const std::vector<Color> &frame, int brightness) {
+        bool buffered = false;
+        if (brightness >= 0) {
+            if (bufferInputFile >= 0) {
+                pwrite(bufferInputFile, "1", 1, 0);
+                buffered = true;
+            }
+            char value[16];
+            int length = snprintf(value, sizeof(value), "%d", brightness);
+            for (std::size_t i = 0; i < brightnessFiles.size(); ++i) {
+                if (brightnessFiles[i] < 0 || pwrite(brightnessFiles[i], value, length, 0) != length) {
+                    writeErrors.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+        for (std::size_t i = 0; i < frame.size(); ++i) {
+            if (writtenValid[i] && writtenFrame[i] == frame[i]) {
+                keysSkipped.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (!buffered && bufferInputFile >= 0) {
+                // Collect all key updates of the frame in the driver before sending
+                pwrite(bufferInputFile, "1", 1, 0);
+                buffered = true;
+            }
+            char value[16];
+            int length = snprintf(value, sizeof(value), "%u %u %u", frame[i].red, frame[i].green, frame[i].blue);
+            if (keyFiles[i] >= 0 && pwrite(keyFiles[i], value, length, 0) == length) {
+                writtenFrame[i] = frame[i];
+                writtenValid[i] = true;
+                keysWritten.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                writtenValid[i] = false;
+                writeErrors.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        if (buffered) {
+            pwrite(bufferInputFile, "0", 1, 0);
+        }
+        framesRendered.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Run() {
+        uint64_t nextFrameNs = MonotonicNs();
+        std::vector<Color> frame;
+        while (true) {
+            Animation type;
+            int brightness;
+            unsigned periodMs;
+            uint64_t startNs, intervalNs;
+            {
+                std::unique_lock<std::mutex> lock(frameMutex);
+                frameChanged.wait(lock, [this]() { return !running || framePending || animation != Animation::None; });
+                if (!running) { break; }
+                framePending = false;
+                frame = baseFrame;
+                brightness = pendingBrightness;
+                pendingBrightness = -1;
+                type = animation;
+                periodMs = animationPeriodMs;
+                startNs = animationStartNs;
+                intervalNs = frameIntervalNs;
+            }
+
+            uint64_t nowNs = MonotonicNs();
+            Render(frame, type, periodMs, startNs, nowNs);
+            Write(frame, brightness);
+
+            // Pace to the frame rate, also for static frames submitted in
+            // quick succession. Drop frames instead of catching up.
+            nextFrameNs += intervalNs;
+            if (nextFrameNs < nowNs) {
+                nextFrameNs = nowNs + intervalNs;
+            }
+            SleepUntil(nextFrameNs);
+        }
+    }
+};
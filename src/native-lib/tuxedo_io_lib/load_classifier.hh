@@ -0,0 +1,307 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+
+struct LoadSample {
+    // Busy percent over all cores, of the busiest core and of the GPU (-1 if unknown)
+    double cpuBusy;
+    double maxCoreBusy;
+    double gpuBusy;
+    int nrCores;
+};
+
+/**
+ * Busy time per core from /proc/stat and GPU busy percent (amdgpu
+ * gpu_busy_percent) since the previous sample
+ */
+class LoadSampler {
+public:
+    LoadSampler(const std::string &procStatPath = "/proc/stat", const std::string &gpuBusyPath = "")
+        : procStatPath(procStatPath), gpuBusyPath(gpuBusyPath) { }
+
+    /**
+     * @returns False on the first sample or if /proc/stat is not readable
+     */
+    bool Sample(LoadSample &sample) {
+        std::vector<CpuTimes> times;
+        if (!ReadProcStat(times) || times.empty()) {
+            return false;
+        }
+        bool result = lastTimes.size() == times.size();
+        if (result) {
+            sample.cpuBusy = BusyPercent(lastTimes[0], times[0]);
+            sample.maxCoreBusy = 0;
+            for (std::size_t i = 1; i < times.size(); ++i) {
+                sample.maxCoreBusy = std::max(sample.maxCoreBusy, BusyPercent(lastTimes[i], times[i]));
+            }
+            sample.nrCores = times.size() - 1;
+            sample.gpuBusy = -1;
+            if (!gpuBusyPath.empty()) {
+                std::ifstream gpuBusyFile(gpuBusyPath);
+                int gpuBusy;
+                if (gpuBusyFile >> gpuBusy) {
+                    sample.gpuBusy = gpuBusy;
+                }
+            }
+        }
+        lastTimes.swap(times);
+        return result;
+    }
+
+private:
+    struct CpuTimes {
+        uint64_t busy;
+        uint64_t total;
+    };
+
+    std::string procStatPath;
+    std::string gpuBusyPath;
+    std::vector<CpuTimes> lastTimes;
+
+    static double BusyPercent(const CpuTimes &previous, const CpuTimes &current) {
+        if (current.total <= previous.total || current.busy < previous.busy) {
+            return 0;
+        }
+        return 100.0 * (current.busy - previous.busy) / (current.total - previous.total);
+    }
+
+    // First entry is the aggregate "cpu" line, followed by one per core
+    bool ReadProcStat(std::vector<CpuTimes> &times) {
+        FILE *file = fopen(procStatPath.c_str(), "re");
+        if (file == nullptr) {
+            return false;
+        }
+        char line[512];
+        while (fgets(line, sizeof(line), file) != nullptr && strncmp(line, "cpu", 3) == 0) {
+            unsigned long long user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
+            const char *values = strchr(line, ' ');
+            if (values == nullptr || sscanf(values, "%llu %llu %llu %llu %llu %llu %llu %llu",
+                    &user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal) < 4) {
+                continue;
+            }
+            // guest time is already accounted in user and nice
+            CpuTimes entry;
+            entry.busy = user + nice + system + irq + softirq + steal;
+            entry.total = entry.busy + idle + iowait;
+            times.push_back(entry);
+        }
+        fclose(file);
+        return true;
+    }
+};
+
+enum class LoadPhase { Idle, Bursty, Heavy };
+
+/**
+ * Classifies a stream of load samples into sustained phases
+ *
+ * Over a sliding window: heavy when the mean load (max of cpu and gpu) is
+ * above the heavy threshold or the busiest core is, on average, above the
+ * core heavy threshold (a single threaded workload hardly moves the load over
+ * all cores), idle when no core and no gpu sample exceeded the idle
+ * threshold, bursty otherwise. Leaving a phase uses relaxed thresholds
+ * (hysteresis) and a changed classification only becomes the phase after it
+ * held for the dwell time of the new phase.
+ */
+class LoadClassifier {
+public:
+    struct Config {
+        double heavyThreshold = 70;
+        double coreHeavyThreshold = 90;
+        double idleThreshold = 10;
+        double hysteresis = 15;
+        std::size_t windowSamples = 10;
+        uint64_t heavyDwellMs = 10000;
+        uint64_t burstyDwellMs = 10000;
+        uint64_t idleDwellMs = 30000;
+    };
+
+    struct State {
+        LoadPhase phase;
+        LoadPhase candidate;
+        uint64_t phaseSinceMs;
+        uint64_t switches;
+        double meanLoad;
+        double meanCoreLoad;
+        LoadSample lastSample;
+        bool valid;
+    };
+
+    LoadClassifier() {
+        state.phase = LoadPhase::Bursty;
+        state.candidate = LoadPhase::Bursty;
+        state.phaseSinceMs = 0;
+        state.switches = 0;
+        state.meanLoad = 0;
+        state.meanCoreLoad = 0;
+        state.lastSample = LoadSample { 0, 0, -1, 0 };
+        state.valid = false;
+    }
+
+    void SetConfig(const Config &newConfig) {
+        config = newConfig;
+        if (config.windowSamples < 1) { config.windowSamples = 1; }
+    }
+
+    void AddSample(const LoadSample &sample, uint64_t nowMs) {
+        window.push_back(sample);
+        while (window.size() > config.windowSamples) {
+            window.pop_front();
+        }
+        state.lastSample = sample;
+
+        double sum = 0, coreSum = 0, peak = 0;
+        for (std::size_t i = 0; i < window.size(); ++i) {
+            sum += std::max(window[i].cpuBusy, window[i].gpuBusy);
+            coreSum += window[i].maxCoreBusy;
+            peak = std::max(peak, std::max(window[i].maxCoreBusy, window[i].gpuBusy));
+        }
+        state.meanLoad = sum / window.size();
+        state.meanCoreLoad = coreSum / window.size();
+
+        double heavyThreshold = config.heavyThreshold;
+        double coreHeavyThreshold = config.coreHeavyThreshold;
+        double idleThreshold = config.idleThreshold;
+        if (state.phase == LoadPhase::Heavy) {
+            heavyThreshold -= config.hysteresis;
+            coreHeavyThreshold -= config.hysteresis;
+        }
+        if (state.phase == LoadPhase::Idle) { idleThreshold += config.hysteresis; }
+
+        LoadPhase candidate = LoadPhase::Bursty;
+        if (state.meanLoad >= heavyThreshold || state.meanCoreLoad >= coreHeavyThreshold) {
+            candidate = LoadPhase::Heavy;
+        } else if (peak < idleThreshold) {
+            candidate = LoadPhase::Idle;
+        }
+
+        if (!state.valid) {
+            // Start in whatever the first window shows
+            state.valid = true;
+            state.phase = candidate;
+            state.phaseSinceMs = nowMs;
+        }
+        if (candidate != state.candidate) {
+            state.candidate = candidate;
+            candidateSinceMs = nowMs;
+        }
+        if (candidate != state.phase && nowMs - candidateSinceMs >= DwellMs(candidate)) {
+            state.phase = candidate;
+            state.phaseSinceMs = nowMs;
+            state.switches++;
+        }
+    }
+
+    const State &GetState() const {
+        return state;
+    }
+
+    static const char *PhaseToString(LoadPhase phase) {
+        switch (phase) {
+            case LoadPhase::Idle: return "idle";
+            case LoadPhase::Heavy: return "heavy";
+            default: return "bursty";
+        }
+    }
+
+private:
+    Config config;
+    State state;
+    std::deque<LoadSample> window;
+    uint64_t candidateSinceMs = 0;
+
+    uint64_t DwellMs(LoadPhase phase) const {
+        switch (phase) {
+            case LoadPhase::Idle: return config.idleDwellMs;
+            case LoadPhase::Heavy: return config.heavyDwellMs;
+            default: return config.burstyDwellMs;
+        }
+    }
+};
+
+/**
+ * Samples load on an own thread and feeds the classifier
+ */
+class LoadMonitor {
+public:
+    LoadMonitor(const LoadClassifier::Config &config, unsigned sampleIntervalMs,
+                const std::string &gpuBusyPath = "", const std::string &procStatPath = "/proc/stat")
+        : sampler(procStatPath, gpuBusyPath), sampleIntervalMs(sampleIntervalMs > 0 ? sampleIntervalMs : 1) {
+        classifier.SetConfig(config);
+        samplingThread = std::thread(&LoadMonitor::Run, this);
+    }
+
+    ~LoadMonitor() {
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            running = false;
+        }
+        stopped.notify_one();
+        samplingThread.join();
+    }
+
+    LoadClassifier::State GetState() {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        return classifier.GetState();
+    }
+
+private:
+    LoadSampler sampler;
+    LoadClassifier classifier;
+    unsigned sampleIntervalMs;
+
+    std::mutex stateMutex;
+    std::condition_variable stopped;
+    bool running = true;
+    std::thread samplingThread;
+
+    static uint64_t MonotonicMs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t) ts.tv_sec * 1000ull + ts.tv_nsec / 1000000ull;
+    }
+
+    void Run() {
+        std::unique_lock<std::mutex> lock(stateMutex);
+        while (running) {
+            lock.unlock();
+            LoadSample sample;
+            bool sampled = sampler.Sample(sample);
+            lock.lock();
+            if (sampled) {
+                classifier.AddSample(sample, MonotonicMs());
+            }
+            stopped.wait_for(lock, std::chrono::milliseconds(sampleIntervalMs), [this]() { return !running; });
+        }
+    }
+};
@@ -0,0 +1,422 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include "tuxedo_io_api.hh"
+#include "tuxedo_io_arbiter.hh"
+
+/**
+ * Gauges in pre-registered slots, rendered in the OpenMetrics text format
+ *
+ * Values are pushed into the slots by whoever collects them, rendering only
+ * reads the slots and the native counters and never touches the hardware.
+ */
+class MetricsRegistry {
+public:
+    /**
+     * Registers a gauge, the same name and labels give the same slot
+     *
+     * @returns Slot id or -1 if the name or a label name is invalid
+     */
+    int RegisterGauge(const std::string &name, const std::string &help,
+                      const std::vector<std::pair<std::string, std::string> > &labels) {
+        if (!IsValidName(name, true)) {
+            return -1;
+        }
+        std::string labelText;
+        for (auto &label : labels) {
+            if (!IsValidName(label.first, false)) {
+                return -1;
+            }
+            labelText += (labelText.empty() ? "" : ",") + label.first + "=\"" + EscapeLabelValue(label.second) + "\"";
+        }
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        auto family = families.find(name);
+        if (family == families.end()) {
+            family = families.emplace(name, Family { help, std::vector<int>() }).first;
+        }
+        for (int slot : family->second.slots) {
+            if (slots[slot].labels == labelText) {
+                return slot;
+            }
+        }
+        slots.push_back(Slot { labelText, NAN });
+        family->second.slots.push_back(slots.size() - 1);
+        return slots.size() - 1;
+    }
+
+    /**
+     * Sets the value of a slot, NaN omits the sample (value unknown)
+     */
+    bool Set(int slot, double value) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        if (slot < 0 || slot >= (int) slots.size()) {
+            return false;
+        }
+        slots[slot].value = value;
+        return true;
+    }
+
+    /**
+     * Appends the registered gauges in OpenMetrics text format
+     */
+    void Render(std::string &out) const {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (auto &family : families) {
+            out += "# TYPE " + family.first + " gauge\n";
+            if (!family.second.help.empty()) {
+                out += "# HELP " + family.first + " " + EscapeHelp(family.second.help) + "\n";
+            }
+            for (int slot : family.second.slots) {
+                if (std::isnan(slots[slot].value)) {
+                    continue;
+                }
+                out += family.first;
+                if (!slots[slot].labels.empty()) {
+                    out += "{" + slots[slot].labels + "}";
+                }
+                out += " " + FormatValue(slots[slot].value) + "\n";
+            }
+        }
+    }
+
+    static std::string FormatValue(double value) {
+        if (std::isinf(value)) {
+            return value > 0 ? "+Inf" : "-Inf";
+        }
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.10g", value);
+        return buffer;
+    }
+
+private:
+    struct Slot {
+        std::string labels;
+        double value;
+    };
+
+    struct Family {
+        std::string help;
+        std::vector<int> slots;
+    };
+
+    static bool IsValidName(const std::string &name, bool allowColon) {
+        if (name.empty() || (name[0] >= '0' && name[0] <= '9')) {
+            return false;
+        }
+        for (char c : name) {
+            bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_'
+                || (allowColon && c == ':');
+            if (!valid) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static std::string EscapeLabelValue(const std::string &value) {
+        std::string escaped;
+        for (char c : value) {
+            if (c == '\\') {
+                escaped += "\\\\";
+            } else if (c == '"') {
+                escaped += "\\\"";
+            } else if (c == '\n') {
+                escaped += "\\n";
+            } else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+    static std::string EscapeHelp(const std::string &help) {
+        std::string escaped;
+        for (char c : help) {
+            if (c == '\\') {
+                escaped += "\\\\";
+            } else if (c == '\n') {
+                escaped += "\\n";
+            } else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+    mutable std::mutex registryMutex;
+    std::vector<Slot> slots;
+    std::map<std::string, Family> families;
+};
+
+/**
+ * Serves a snapshot of the registry and the native I/O statistics on a unix
+ * socket
+ *
+ * Every connection gets one snapshot, then the connection is closed. Clients
+ * that send an HTTP request within a short grace period (e.g. curl
+ * --unix-socket) get an HTTP/1.0 response, clients that send nothing (e.g.
+ * socat, nc -U) get the plain text. Scrapes are served one by one from a
+ * single thread.
+ */
+class MetricsExporter {
+public:
+    struct Statistics {
+        uint64_t scrapes;
+        uint64_t lastRenderNs;
+    };
+
+    explicit MetricsExporter(const MetricsRegistry &registry) : registry(registry) { }
+
+    ~MetricsExporter() {
+        Stop();
+    }
+
+    /**
+     * Binds the socket (replacing a stale one, mode 0660) and starts serving
+     *
+     * @returns false on failure with errno set
+     */
+    bool Start(const std::string &socketPath) {
+        if (serverThread.joinable()) {
+            errno = EALREADY;
+            return false;
+        }
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+            errno = ENAMETOOLONG;
+            return false;
+        }
+        strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) {
+            return false;
+        }
+        unlink(socketPath.c_str());
+        if (bind(listenFd, (struct sockaddr *) &address, sizeof(address)) < 0
+            || chmod(socketPath.c_str(), 0660) < 0
+            || listen(listenFd, 8) < 0) {
+            int error = errno;
+            CloseFds();
+            unlink(socketPath.c_str());
+            errno = error;
+            return false;
+        }
+        stopFd = eventfd(0, EFD_CLOEXEC);
+        if (stopFd < 0) {
+            int error = errno;
+            CloseFds();
+            unlink(socketPath.c_str());
+            errno = error;
+            return false;
+        }
+        path = socketPath;
+        serverThread = std::thread(&MetricsExporter::Run, this);
+        return true;
+    }
+
+    void Stop() {
+        if (!serverThread.joinable()) {
+            return;
+        }
+        uint64_t one = 1;
+        if (write(stopFd, &one, sizeof(one)) < 0) {
+            // Only fails if the counter overflows, the thread is woken anyway
+        }
+        serverThread.join();
+        CloseFds();
+        unlink(path.c_str());
+        path.clear();
+    }
+
+    bool Running() const {
+        return serverThread.joinable();
+    }
+
+    Statistics GetStatistics() const {
+        Statistics statistics;
+        statistics.scrapes = scrapes.load(std::memory_order_relaxed);
+        statistics.lastRenderNs = lastRenderNs.load(std::memory_order_relaxed);
+        return statistics;
+    }
+
+    /**
+     * Complete snapshot in OpenMetrics text format, terminated by # EOF
+     */
+    std::string Render() {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        std::string out;
+        out.reserve(4096);
+        registry.Render(out);
+        RenderNative(out);
+        out += "# EOF\n";
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        lastRenderNs.store((end.tv_sec - start.tv_sec) * 1000000000ULL + end.tv_nsec - start.tv_nsec,
+                           std::memory_order_relaxed);
+        return out;
+    }
+
+private:
+    static const int REQUEST_GRACE_MS = 50;
+    static const int SEND_TIMEOUT_S = 1;
+
+    void RenderNative(std::string &out) {
+        IOStatistics::Snapshot io = IOStatistics::Instance().GetSnapshot();
+        out += "# TYPE tuxedo_io_ioctl_duration_seconds histogram\n"
+               "# HELP tuxedo_io_ioctl_duration_seconds Duration of tuxedo_io ioctls\n";
+        uint64_t cumulative = 0;
+        for (int i = 0; i < IOStatistics::NR_BUCKETS; ++i) {
+            cumulative += io.buckets[i];
+            std::string bound = i < IOStatistics::NR_BUCKETS - 1
+                ? MetricsRegistry::FormatValue(IOStatistics::BucketBoundNs(i) / 1e9) : "+Inf";
+            out += "tuxedo_io_ioctl_duration_seconds_bucket{le=\"" + bound + "\"} " + std::to_string(cumulative) + "\n";
+        }
+        out += "tuxedo_io_ioctl_duration_seconds_sum " + MetricsRegistry::FormatValue(io.durationSumNs / 1e9) + "\n";
+        out += "tuxedo_io_ioctl_duration_seconds_count " + std::to_string(io.calls) + "\n";
+        AppendCounter(out, "tuxedo_io_ioctl_errors", "Failed tuxedo_io ioctls", std::to_string(io.errors));
+
+        DeviceArbiter::Statistics arbiter = DeviceArbiter::Instance().GetStatistics();
+        AppendCounter(out, "tuxedo_io_device_sessions", "Exclusive device sessions",
+                      std::to_string(arbiter.acquisitions));
+        AppendCounter(out, "tuxedo_io_device_sessions_contended", "Device sessions that had to wait",
+                      std::to_string(arbiter.contended));
+        AppendCounter(out, "tuxedo_io_device_wait_seconds", "Time spent waiting for the device",
+                      MetricsRegistry::FormatValue(arbiter.waitTimeNs / 1e9));
+
+        // The scrape being served is included
+        AppendCounter(out, "tuxedo_io_metrics_scrapes", "Served metrics scrapes",
+                      std::to_string(scrapes.load(std::memory_order_relaxed) + 1));
+    }
+
+    static void AppendCounter(std::string &out, const char *name, const char *help, const std::string &value) {
+        out += std::string("# TYPE ") + name + " counter\n";
+        out += std::string("# HELP ") + name + " " + help + "\n";
+        out += std::string(name) + "_total " + value + "\n";
+    }
+
+    void Run() {
+        struct pollfd fds[2];
+        fds[0].fd = listenFd;
+        fds[0].events = POLLIN;
+        fds[1].fd = stopFd;
+        fds[1].events = POLLIN;
+        while (true) {
+            fds[0].revents = 0;
+            fds[1].revents = 0;
+            if (poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            if (fds[1].revents != 0) {
+                break;
+            }
+            if (fds[0].revents & POLLIN) {
+                int clientFd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+                if (clientFd >= 0) {
+                    Serve(clientFd);
+                    close(clientFd);
+                }
+            }
+        }
+    }
+
+    void Serve(int clientFd) {
+        struct timeval sendTimeout = { SEND_TIMEOUT_S, 0 };
+        setsockopt(clientFd, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+
+        bool http = false;
+        struct pollfd client = { clientFd, POLLIN, 0 };
+        if (poll(&client, 1, REQUEST_GRACE_MS) > 0 && (client.revents & POLLIN)) {
+            char request[1024];
+            ssize_t length = recv(clientFd, request, sizeof(request), MSG_DONTWAIT);
+            http = length >= 4 && memcmp(request, "GET ", 4) == 0;
+        }
+
+        std::string body = Render();
+        std::string response;
+        if (http) {
+            response = "HTTP/1.0 200 OK\r\n"
+                       "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                       "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                       "Connection: close\r\n\r\n";
+        }
+        response += body;
+        scrapes.fetch_add(1, std::memory_order_relaxed);
+
+        size_t offset = 0;
+        while (offset < response.size()) {
+            ssize_t written = send(clientFd, response.data() + offset, response.size() - offset, MSG_NOSIGNAL);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                break;
+            }
+            offset += written;
+        }
+        shutdown(clientFd, SHUT_WR);
+    }
+
+    void CloseFds() {
+        if (listenFd >= 0) {
+            close(listenFd);
+            listenFd = -1;
+        }
+        if (stopFd >= 0) {
+            close(stopFd);
+            stopFd = -1;
+        }
+    }
+
+    const MetricsRegistry &registry;
+    std::string path;
+    int listenFd = -1;
+    int stopFd = -1;
+    std::thread serverThread;
+    std::atomic<uint64_t> scrapes { 0 };
+    std::atomic<uint64_t> lastRenderNs { 0 };
+};
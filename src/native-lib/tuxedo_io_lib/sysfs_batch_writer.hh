@@ -0,0 +1,283 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+struct SysFsWrite {
+    std::string path;
+    std::string value;
+    // Start only after all previous writes of the batch completed
+    bool barrier;
+    // Result, 0 on success or errno
+    int error;
+};
+
+/**
+ * Applies a list of sysfs writes with as few syscalls as possible
+ *
+ * Writes are submitted through io_uring in one go, writes between two
+ * barriers run concurrently. Without io_uring (old kernel, disabled by
+ * sysctl or seccomp) the writes are done one by one with pwrite. Attribute
+ * files are kept open between batches, a write failing on a cached
+ * descriptor (e.g. a cpu went offline and came back) is retried once on a
+ * freshly opened file.
+ */
+class SysFsBatchWriter {
+public:
+    SysFsBatchWriter(unsigned queueDepth = 64) {
+        SetupRing(queueDepth);
+    }
+
+    ~SysFsBatchWriter() {
+        for (auto &entry : files) {
+            close(entry.second);
+        }
+        TeardownRing();
+    }
+
+    bool UsingIOUring() const {
+        return ringFd >= 0;
+    }
+
+    /**
+     * @returns True if all writes succeeded
+     */
+    bool Write(std::vector<SysFsWrite> &writes) {
+        std::vector<int> fds(writes.size(), -1);
+        std::vector<bool> cached(writes.size(), false);
+        for (std::size_t i = 0; i < writes.size(); ++i) {
+            writes[i].error = 0;
+            bool wasCached = files.find(writes[i].path) != files.end();
+            fds[i] = GetFile(writes[i].path);
+            cached[i] = wasCached;
+            if (fds[i] < 0) {
+                writes[i].error = errno;
+            }
+        }
+
+        if (UsingIOUring()) {
+            SubmitRing(writes, fds);
+        } else {
+            for (std::size_t i = 0; i < writes.size(); ++i) {
+                if (fds[i] >= 0) {
+                    writes[i].error = WriteValue(fds[i], writes[i].value);
+                }
+            }
+        }
+
+        bool result = true;
+        for (std::size_t i = 0; i < writes.size(); ++i) {
+            if (writes[i].error != 0 && fds[i] >= 0) {
+                DropFile(writes[i].path);
+                if (cached[i]) {
+                    int fd = GetFile(writes[i].path);
+                    writes[i].error = fd >= 0 ? WriteValue(fd, writes[i].value) : errno;
+                    if (writes[i].error != 0 && fd >= 0) {
+                        DropFile(writes[i].path);
+                    }
+                }
+            }
+            if (writes[i].error != 0) {
+                result = false;
+            }
+        }
+        return result;
+    }
+
+private:
+    std::unordered_map<std::string, int> files;
+
+    int ringFd = -1;
+    unsigned ringEntries = 0;
+    void *sqRing = MAP_FAILED;
+    void *cqRing = MAP_FAILED;
+    std::size_t sqRingSize = 0;
+    std::size_t cqRingSize = 0;
+    struct io_uring_sqe *sqes = (struct io_uring_sqe *) MAP_FAILED;
+    std::size_t sqesSize = 0;
+    unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+    unsigned *cqHead, *cqTail, *cqMask;
+    struct io_uring_cqe *cqes;
+
+    int GetFile(const std::string &path) {
+        auto entry = files.find(path);
+        if (entry != files.end()) {
+            return entry->second;
+        }
+        int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            files[path] = fd;
+        }
+        return fd;
+    }
+
+    void DropFile(const std::string &path) {
+        auto entry = files.find(path);
+        if (entry != files.end()) {
+            close(entry->second);
+            files.erase(entry);
+        }
+    }
+
+    static int WriteValue(int fd, const std::string &value) {
+        ssize_t written = pwrite(fd, value.c_str(), value.size(), 0);
+        if (written < 0) {
+            return errno;
+        }
+        return (std::size_t) written == value.size() ? 0 : EIO;
+    }
+
+    void SetupRing(unsigned queueDepth) {
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        int fd = syscall(__NR_io_uring_setup, queueDepth, &params);
+        if (fd < 0) {
+            return;
+        }
+        // IORING_OP_WRITE appeared together with this feature (5.6)
+        if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+            close(fd);
+            return;
+        }
+        ringFd = fd;
+        ringEntries = params.sq_entries;
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+        cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+        sqes = (struct io_uring_sqe *) mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                            ringFd, IORING_OFF_SQES);
+        if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqes == MAP_FAILED) {
+            TeardownRing();
+            return;
+        }
+
+        char *sq = (char *) sqRing;
+        sqHead = (unsigned *) (sq + params.sq_off.head);
+        sqTail = (unsigned *) (sq + params.sq_off.tail);
+        sqMask = (unsigned *) (sq + params.sq_off.ring_mask);
+        sqArray = (unsigned *) (sq + params.sq_off.array);
+        char *cq = (char *) cqRing;
+        cqHead = (unsigned *) (cq + params.cq_off.head);
+        cqTail = (unsigned *) (cq + params.cq_off.tail);
+        cqMask = (unsigned *) (cq + params.cq_off.ring_mask);
+        cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+    }
+
+    void TeardownRing() {
+        if (sqes != MAP_FAILED) { munmap(sqes, sqesSize); sqes = (struct io_uring_sqe *) MAP_FAILED; }
+        if (cqRing != MAP_FAILED) { munmap(cqRing, cqRingSize); cqRing = MAP_FAILED; }
+        if (sqRing != MAP_FAILED) { munmap(sqRing, sqRingSize); sqRing = MAP_FAILED; }
+        if (ringFd >= 0) { close(ringFd); ringFd = -1; }
+    }
+
+    /**
+     * Submit in chunks of the ring size, each chunk completes before the next
+     * one is submitted so barriers also hold across chunks
+     */
+    void SubmitRing(std::vector<SysFsWrite> &writes, const std::vector<int> &fds) {
+        std::vector<bool> done(writes.size(), false);
+        std::size_t next = 0;
+        while (next < writes.size()) {
+            unsigned submitted = 0;
+            unsigned tail = *sqTail;
+            bool firstInChunk = true;
+            for (; next < writes.size() && submitted < ringEntries; ++next) {
+                if (fds[next] < 0) {
+                    continue;
+                }
+                unsigned index = tail & *sqMask;
+                struct io_uring_sqe *sqe = &sqes[index];
+                memset(sqe, 0, sizeof(*sqe));
+                sqe->opcode = IORING_OP_WRITE;
+                sqe->fd = fds[next];
+                sqe->addr = (uint64_t) (uintptr_t) writes[next].value.c_str();
+                sqe->len = writes[next].value.size();
+                sqe->off = 0;
+                sqe->user_data = next;
+                if (writes[next].barrier && !firstInChunk) {
+                    sqe->flags |= IOSQE_IO_DRAIN;
+                }
+                firstInChunk = false;
+                sqArray[index] = index;
+                tail++;
+                submitted++;
+            }
+            if (submitted == 0) {
+                break;
+            }
+            __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+
+            unsigned completed = 0;
+            int toSubmit = submitted;
+            while (completed < submitted) {
+                int ret = syscall(__NR_io_uring_enter, ringFd, toSubmit, submitted - completed,
+                                  IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (ret < 0 && errno != EINTR) {
+                    // Ring unusable, finish remaining entries synchronously
+                    FailRing(writes, fds, done);
+                    return;
+                }
+                if (ret > 0) {
+                    toSubmit -= std::min(ret, toSubmit);
+                }
+                unsigned head = *cqHead;
+                unsigned cqTailValue = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+                while (head != cqTailValue) {
+                    struct io_uring_cqe *cqe = &cqes[head & *cqMask];
+                    std::size_t i = (std::size_t) cqe->user_data;
+                    if (i < writes.size()) {
+                        done[i] = true;
+                        if (cqe->res < 0) {
+                            writes[i].error = -cqe->res;
+                        } else if ((std::size_t) cqe->res != writes[i].value.size()) {
+                            writes[i].error = EIO;
+                        }
+                    }
+                    head++;
+                    completed++;
+                }
+                __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+            }
+        }
+    }
+
+    void FailRing(std::vector<SysFsWrite> &writes, const std::vector<int> &fds, const std::vector<bool> &done) {
+        TeardownRing();
+        for (std::size_t i = 0; i < writes.size(); ++i) {
+            if (fds[i] >= 0 && !done[i]) {
+                writes[i].error = WriteValue(fds[i], writes[i].value);
+            }
+        }
+    }
+};
@@ -0,0 +1,189 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <string>
+#include <vector>
+#include <map>
+
+/**
+ * Wakeup source for changes of sysfs attributes signalled by the kernel
+ *
+ * Drivers signal attribute changes with sysfs_notify() (e.g. the
+ * brightness_hw_changed of LEDs on Fn-key changes or actual_brightness of
+ * backlights), which inotify does not see. An open attribute reports it as
+ * POLLPRI | POLLERR until it is read again. The attributes are collected in
+ * an epoll set, the set's descriptor is polled by the event loop and
+ * Collect is called when it becomes readable.
+ */
+class SysFsNotifyWatcher {
+public:
+    struct Change {
+        int id;
+        std::string path;
+        // Empty if the attribute could not be read (e.g. no hw change yet)
+        std::string value;
+    };
+
+    struct Statistics {
+        uint64_t wakeups;
+        uint64_t notifications;
+        uint64_t changes;
+        int attributes;
+    };
+
+    SysFsNotifyWatcher() {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        statistics = Statistics { 0, 0, 0, 0 };
+    }
+
+    ~SysFsNotifyWatcher() {
+        for (auto &entry : attributes) {
+            close(entry.second.fd);
+        }
+        if (epollFd >= 0) {
+            close(epollFd);
+        }
+    }
+
+    bool Valid() const {
+        return epollFd >= 0;
+    }
+
+    int GetFd() const {
+        return epollFd;
+    }
+
+    /**
+     * Open the attribute and read it once, the read arms the notification
+     *
+     * @returns Id of the attribute, -1 on failure with errno set (EPERM if
+     *          the file is not pollable, i.e. not on sysfs)
+     */
+    int Add(const std::string &path) {
+        int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            return -1;
+        }
+        Attribute attribute;
+        attribute.fd = fd;
+        attribute.path = path;
+        ReadValue(fd, attribute.value);
+
+        int id = nextId++;
+        struct epoll_event event = {};
+        event.events = EPOLLPRI | EPOLLERR;
+        event.data.u32 = (uint32_t) id;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            int error = errno;
+            close(fd);
+            errno = error;
+            return -1;
+        }
+        attributes[id] = attribute;
+        statistics.attributes = attributes.size();
+        return id;
+    }
+
+    bool Remove(int id) {
+        auto entry = attributes.find(id);
+        if (entry == attributes.end()) {
+            return false;
+        }
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, entry->second.fd, nullptr);
+        close(entry->second.fd);
+        attributes.erase(entry);
+        statistics.attributes = attributes.size();
+        return true;
+    }
+
+    /**
+     * Re-read the notified attributes, without blocking
+     *
+     * @returns Attributes whose content changed, drivers may notify without
+     *          an actual change
+     */
+    std::vector<Change> Collect() {
+        std::vector<Change> changes;
+        struct epoll_event events[MAX_EVENTS];
+        int count = epoll_wait(epollFd, events, MAX_EVENTS, 0);
+        if (count <= 0) {
+            return changes;
+        }
+        statistics.wakeups++;
+        for (int i = 0; i < count; ++i) {
+            auto entry = attributes.find((int) events[i].data.u32);
+            if (entry == attributes.end()) {
+                continue;
+            }
+            statistics.notifications++;
+            Attribute &attribute = entry->second;
+            std::string value;
+            // Reading from the start acknowledges the notification
+            ReadValue(attribute.fd, value);
+            if (value != attribute.value) {
+                attribute.value = value;
+                statistics.changes++;
+                changes.push_back(Change { entry->first, attribute.path, value });
+            }
+        }
+        return changes;
+    }
+
+    const Statistics &GetStatistics() const {
+        return statistics;
+    }
+
+private:
+    static const int MAX_EVENTS = 16;
+    static const size_t MAX_VALUE_LENGTH = 4096;
+
+    struct Attribute {
+        int fd;
+        std::string path;
+        std::string value;
+    };
+
+    int epollFd = -1;
+    int nextId = 0;
+    std::map<int, Attribute> attributes;
+    Statistics statistics;
+
+    static bool ReadValue(int fd, std::string &value) {
+        value.clear();
+        char buffer[MAX_VALUE_LENGTH];
+        if (lseek(fd, 0, SEEK_SET) < 0) {
+            return false;
+        }
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        if (length < 0) {
+            return false;
+        }
+        value.assign(buffer, length);
+        while (!value.empty() && (value.back() == '\n' || value.back() == ' ')) {
+            value.pop_back();
+        }
+        return true;
+    }
+};
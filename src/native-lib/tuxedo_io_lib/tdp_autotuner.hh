@@ -0,0 +1,263 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <fstream>
+#include "tuxedo_io_api.hh"
+
+/**
+ * Average package power from the intel-rapl powercap energy counter
+ */
+class RaplPowerMeter {
+public:
+    RaplPowerMeter(const std::string &raplPath = "/sys/devices/virtual/powercap/intel-rapl/intel-rapl:0")
+        : raplPath(raplPath) { }
+
+    /**
+     * @param watts Average power since the previous sample
+     * @returns False on the first sample or if the counter is not readable
+     */
+    bool Sample(double &watts) {
+        uint64_t energyUj, nowNs = MonotonicNs();
+        if (!ReadValue(raplPath + "/energy_uj", energyUj)) {
+            hasLastSample = false;
+            return false;
+        }
+        bool result = false;
+        if (hasLastSample && nowNs > lastTimeNs) {
+            uint64_t deltaUj;
+            if (energyUj >= lastEnergyUj) {
+                deltaUj = energyUj - lastEnergyUj;
+            } else {
+                // Counter wrapped
+                uint64_t maxRangeUj = 0;
+                ReadValue(raplPath + "/max_energy_range_uj", maxRangeUj);
+                deltaUj = maxRangeUj - lastEnergyUj + energyUj;
+            }
+            watts = (double) deltaUj / ((nowNs - lastTimeNs) / 1000.0);
+            result = true;
+        }
+        lastEnergyUj = energyUj;
+        lastTimeNs = nowNs;
+        hasLastSample = true;
+        return result;
+    }
+
+    static uint64_t MonotonicNs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    }
+
+private:
+    std::string raplPath;
+    bool hasLastSample = false;
+    uint64_t lastEnergyUj = 0;
+    uint64_t lastTimeNs = 0;
+
+    static bool ReadValue(const std::string &path, uint64_t &value) {
+        std::ifstream file(path);
+        return (bool) (file >> value);
+    }
+};
+
+/**
+ * Closed loop adjustment of the ODM power limits (PL1, PL2, ...)
+ *
+ * Each step compares the hottest fan sensor (and optionally the fastest fan
+ * as noise measure) against the configured ceiling. Above the ceiling all
+ * limits are lowered, below the ceiling minus hysteresis they are raised
+ * again, but only while the package actually draws close to PL1. Changes are
+ * rate limited and always stay within the limits reported by the device.
+ */
+class TDPAutotuner {
+public:
+    struct Config {
+        int targetTemperature = 85;
+        int temperatureHysteresis = 5;
+        // Noise ceiling, 0 for none
+        int maxFanSpeedPercent = 0;
+        int stepWatts = 2;
+        uint64_t minChangeIntervalMs = 15000;
+    };
+
+    enum class Action { Hold, Decrease, Increase };
+
+    struct Decision {
+        uint64_t timestampMs;
+        // NaN if not available
+        double packagePowerW;
+        int temperature;
+        int fanSpeedPercent;
+        Action action;
+        std::string reason;
+        std::vector<int> tdpValues;
+    };
+
+    static const std::size_t DECISION_HISTORY = 64;
+    static const int FAN_HYSTERESIS_PERCENT = 10;
+
+    TDPAutotuner(const std::string &raplPath = "/sys/devices/virtual/powercap/intel-rapl/intel-rapl:0")
+        : powerMeter(raplPath) { }
+
+    void SetConfig(const Config &newConfig) {
+        config = newConfig;
+        if (config.stepWatts < 1) { config.stepWatts = 1; }
+        if (config.temperatureHysteresis < 0) { config.temperatureHysteresis = 0; }
+    }
+
+    const Config &GetConfig() const {
+        return config;
+    }
+
+    /**
+     * Take one control decision and apply it
+     *
+     * @returns False if the device does not offer TDP control or sensors,
+     *          or writing the new limits failed
+     */
+    bool Step(TuxedoIOAPI &io, Decision &decision) {
+        uint64_t nowMs = RaplPowerMeter::MonotonicNs() / 1000000ull;
+        decision.timestampMs = nowMs;
+        decision.packagePowerW = NAN;
+        decision.temperature = -1;
+        decision.fanSpeedPercent = -1;
+        decision.action = Action::Hold;
+        decision.reason.clear();
+        decision.tdpValues.clear();
+
+        double watts;
+        if (powerMeter.Sample(watts)) {
+            decision.packagePowerW = watts;
+        }
+
+        DeviceTelemetry telemetry;
+        if (!io.ReadTelemetry(telemetry)) {
+            return false;
+        }
+        for (int i = 0; i < telemetry.nrFans; ++i) {
+            decision.temperature = std::max(decision.temperature, telemetry.fanTemperature[i]);
+            decision.fanSpeedPercent = std::max(decision.fanSpeedPercent, telemetry.fanSpeedPercent[i]);
+        }
+
+        int nrTDPs = telemetry.nrTDPs;
+        if (decision.temperature < 0 || nrTDPs <= 0) {
+            return false;
+        }
+        std::vector<int> current(telemetry.tdp, telemetry.tdp + nrTDPs);
+        std::vector<int> minValues(telemetry.tdpMin, telemetry.tdpMin + nrTDPs);
+        std::vector<int> maxValues(telemetry.tdpMax, telemetry.tdpMax + nrTDPs);
+        for (int i = 0; i < nrTDPs; ++i) {
+            if (current[i] < 0 || minValues[i] < 0 || maxValues[i] < 0) {
+                return false;
+            }
+        }
+        decision.tdpValues = current;
+
+        bool temperatureHigh = decision.temperature > config.targetTemperature;
+        bool fanHigh = config.maxFanSpeedPercent > 0 && decision.fanSpeedPercent > config.maxFanSpeedPercent;
+        bool cool = decision.temperature < config.targetTemperature - config.temperatureHysteresis
+            && (config.maxFanSpeedPercent <= 0
+                || decision.fanSpeedPercent < config.maxFanSpeedPercent - FAN_HYSTERESIS_PERCENT);
+        // Raising limits the package does not reach only adds overshoot later
+        bool powerLimited = std::isnan(decision.packagePowerW)
+            || decision.packagePowerW >= current[0] * POWER_LIMITED_RATIO;
+
+        int delta = 0;
+        if (temperatureHigh || fanHigh) {
+            decision.action = Action::Decrease;
+            decision.reason = temperatureHigh ? "temperature above target" : "fan speed above ceiling";
+            delta = -2 * config.stepWatts;
+        } else if (cool && powerLimited) {
+            decision.action = Action::Increase;
+            decision.reason = "thermal headroom";
+            delta = config.stepWatts;
+        } else {
+            decision.reason = cool ? "not power limited" : "within hysteresis";
+        }
+
+        if (decision.action != Action::Hold && lastChangeMs != 0
+                && nowMs - lastChangeMs < config.minChangeIntervalMs) {
+            decision.action = Action::Hold;
+            decision.reason += ", rate limited";
+            delta = 0;
+        }
+
+        std::vector<int> next(current);
+        for (int i = 0; i < nrTDPs; ++i) {
+            next[i] = std::min(maxValues[i], std::max(minValues[i], current[i] + delta));
+            // Keep the longer term limits below the shorter term ones
+            if (i > 0 && next[i] < next[i - 1]) {
+                next[i] = std::min(maxValues[i], next[i - 1]);
+            }
+        }
+
+        bool result = true;
+        if (delta != 0 && next == current) {
+            decision.action = Action::Hold;
+            decision.reason += ", at limit";
+        } else if (next != current) {
+            for (int i = 0; i < nrTDPs; ++i) {
+                if (next[i] != current[i] && !io.SetTDP(i, next[i])) {
+                    result = false;
+                }
+            }
+            if (result) {
+                decision.tdpValues = next;
+                lastChangeMs = nowMs;
+            } else {
+                decision.reason += ", write failed";
+            }
+        }
+
+        decisions.push_back(decision);
+        while (decisions.size() > DECISION_HISTORY) {
+            decisions.pop_front();
+        }
+        return result;
+    }
+
+    std::vector<Decision> GetDecisions() const {
+        return std::vector<Decision>(decisions.begin(), decisions.end());
+    }
+
+    static const char *ActionToString(Action action) {
+        switch (action) {
+            case Action::Decrease: return "decrease";
+            case Action::Increase: return "increase";
+            default: return "hold";
+        }
+    }
+
+private:
+    static constexpr double POWER_LIMITED_RATIO = 0.85;
+
+    Config config;
+    RaplPowerMeter powerMeter;
+    uint64_t lastChangeMs = 0;
+    std::deque<Decision> decisions;
+};
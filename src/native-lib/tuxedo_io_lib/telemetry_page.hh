@@ -0,0 +1,310 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include <type_traits>
+
+/**
+ * Live telemetry published by tccd, version 1 of the page layout
+ *
+ * Only append fields and bump TELEMETRY_PAGE_VERSION when the meaning of an
+ * existing field changes. Unknown values are -1.
+ */
+struct TelemetryPageData {
+    static const int MAX_FANS = 4;
+    static const int NAME_LENGTH = 64;
+
+    // Realtime ms of the last publish
+    int64_t updateTime;
+    uint64_t updateCount;
+    // Incremented on changes, readers refetch the full data over DBus
+    uint64_t profileGeneration;
+    uint64_t profilesGeneration;
+    uint64_t settingsGeneration;
+    int64_t fanTimestamp[MAX_FANS];
+    int32_t fanTemperature[MAX_FANS];
+    int32_t fanSpeed[MAX_FANS];
+    int32_t fanCount;
+    int32_t reserved;
+    double cpuPower;
+    double cpuPowerLimit;
+    double iGpuPower;
+    double iGpuTemperature;
+    double dGpuPower;
+    char activeProfileId[NAME_LENGTH];
+    char odmProfile[NAME_LENGTH];
+    // Incremented when rarely changing device state (capabilities, webcam,
+    // prime, keyboard backlight, ODM limits, display modes) changes
+    uint64_t stateGeneration;
+    double iGpuCoreFrequency;
+    double iGpuMaxCoreFrequency;
+    double dGpuCoreFrequency;
+    double dGpuMaxCoreFrequency;
+    double dGpuMaxPowerLimit;
+    double dGpuEnforcedPowerLimit;
+    // 1 or 0, -1 if not reported
+    int32_t dGpuD0MetricsUsage;
+    int32_t sensorDataCollection;
+    char iGpuVendor[NAME_LENGTH];
+    // Profile state of the power supply, e.g. "power_ac"
+    char powerState[NAME_LENGTH];
+};
+
+static_assert(std::is_trivially_copyable<TelemetryPageData>::value, "TelemetryPageData must be trivially copyable");
+static_assert(sizeof(TelemetryPageData) % sizeof(uint64_t) == 0, "TelemetryPageData must consist of whole words");
+
+/**
+ * Shared memory page with a seqlock protected TelemetryPageData
+ *
+ * The single writer makes the sequence odd, updates the data and makes it
+ * even again. Readers copy the data and retry if the sequence was odd or
+ * changed meanwhile, so they never see a torn snapshot and never block or
+ * wake the writer. All accesses are word sized atomics since the page is
+ * shared between processes.
+ */
+class TelemetryPage {
+public:
+    static const uint32_t MAGIC = 0x54434354; // "TCCT"
+    static const uint32_t VERSION = 1;
+    static const size_t PAGE_SIZE = 4096;
+
+    struct Layout {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t dataSize;
+        uint32_t reserved;
+        uint64_t sequence;
+        uint64_t data[sizeof(TelemetryPageData) / sizeof(uint64_t)];
+    };
+
+    static_assert(sizeof(Layout) <= PAGE_SIZE, "Telemetry page layout exceeds the page");
+};
+
+/**
+ * Creates the page as an anonymous memfd and publishes snapshots to it
+ *
+ * Clients get a read only descriptor of it over DBus, so the page is neither
+ * visible in the file system nor can a client map it writable. The size is
+ * sealed, a client mapping never runs past the end of the page.
+ */
+class TelemetryPageWriter {
+public:
+    ~TelemetryPageWriter() {
+        Destroy();
+    }
+
+    /**
+     * @returns false on failure with errno set
+     */
+    bool Create() {
+        Destroy();
+        int fd = memfd_create("tccd-telemetry", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if (fd < 0) {
+            return false;
+        }
+        if (ftruncate(fd, TelemetryPage::PAGE_SIZE) < 0
+            || fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0) {
+            int error = errno;
+            close(fd);
+            errno = error;
+            return false;
+        }
+        // Reopening through /proc gives a descriptor without write access
+        std::string fdPath = "/proc/self/fd/" + std::to_string(fd);
+        int readOnlyFd = open(fdPath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (readOnlyFd < 0) {
+            int error = errno;
+            close(fd);
+            errno = error;
+            return false;
+        }
+        void *mapping = mmap(nullptr, TelemetryPage::PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        int error = errno;
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            close(readOnlyFd);
+            errno = error;
+            return false;
+        }
+        page = static_cast<TelemetryPage::Layout *>(mapping);
+        page->version = TelemetryPage::VERSION;
+        page->dataSize = sizeof(TelemetryPageData);
+        page->sequence = 0;
+        // Readers check the magic last
+        __atomic_store_n(&page->magic, TelemetryPage::MAGIC, __ATOMIC_RELEASE);
+        clientFd = readOnlyFd;
+        return true;
+    }
+
+    void Destroy() {
+        if (page == nullptr) {
+            return;
+        }
+        // Mappings of readers stay valid, they see the page is orphaned
+        __atomic_store_n(&page->magic, 0, __ATOMIC_RELEASE);
+        munmap(page, TelemetryPage::PAGE_SIZE);
+        page = nullptr;
+        close(clientFd);
+        clientFd = -1;
+    }
+
+    bool Created() const {
+        return page != nullptr;
+    }
+
+    /**
+     * Read only descriptor of the page, stays owned by the writer. Passing
+     * it over DBus duplicates it into the receiving process.
+     *
+     * @returns -1 if not created
+     */
+    int ClientFd() const {
+        return clientFd;
+    }
+
+    void Publish(const TelemetryPageData &data) {
+        if (page == nullptr) {
+            return;
+        }
+        uint64_t words[sizeof(page->data) / sizeof(uint64_t)];
+        memcpy(words, &data, sizeof(words));
+
+        uint64_t sequence = __atomic_load_n(&page->sequence, __ATOMIC_RELAXED);
+        __atomic_store_n(&page->sequence, sequence + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        for (size_t i = 0; i < sizeof(words) / sizeof(uint64_t); ++i) {
+            __atomic_store_n(&page->data[i], words[i], __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&page->sequence, sequence + 2, __ATOMIC_RELEASE);
+    }
+
+private:
+    TelemetryPage::Layout *page = nullptr;
+    int clientFd = -1;
+};
+
+/**
+ * Maps a page read only and takes consistent snapshots of it
+ */
+class TelemetryPageReader {
+public:
+    ~TelemetryPageReader() {
+        Close();
+    }
+
+    /**
+     * Maps the page received from tccd, takes ownership of the descriptor
+     *
+     * Only size sealed pages are mapped, a page shrinking under the mapping
+     * would fault on read.
+     *
+     * @returns false on failure with errno set
+     */
+    bool Open(int fd) {
+        Close();
+        if (fd < 0) {
+            errno = EBADF;
+            return false;
+        }
+        struct stat status;
+        int seals = fcntl(fd, F_GET_SEALS);
+        if (fstat(fd, &status) < 0 || !S_ISREG(status.st_mode) || status.st_size < (off_t) TelemetryPage::PAGE_SIZE
+            || seals < 0 || (seals & F_SEAL_SHRINK) == 0) {
+            close(fd);
+            errno = EPERM;
+            return false;
+        }
+        void *mapping = mmap(nullptr, TelemetryPage::PAGE_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+        int error = errno;
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            errno = error;
+            return false;
+        }
+        page = static_cast<const TelemetryPage::Layout *>(mapping);
+        if (!Valid() || page->version != TelemetryPage::VERSION || page->dataSize < sizeof(TelemetryPageData)) {
+            Close();
+            errno = EPROTO;
+            return false;
+        }
+        return true;
+    }
+
+    void Close() {
+        if (page != nullptr) {
+            munmap(const_cast<TelemetryPage::Layout *>(page), TelemetryPage::PAGE_SIZE);
+            page = nullptr;
+        }
+    }
+
+    bool Opened() const {
+        return page != nullptr;
+    }
+
+    /**
+     * False once the writer destroyed the page (e.g. tccd restarted), the
+     * page has to be opened again
+     */
+    bool Valid() const {
+        return page != nullptr && __atomic_load_n(&page->magic, __ATOMIC_ACQUIRE) == TelemetryPage::MAGIC;
+    }
+
+    /**
+     * @returns false if the page is gone or no consistent snapshot was taken
+     *          within the retry limit (writer stalled mid-update)
+     */
+    bool Read(TelemetryPageData &data) const {
+        if (!Valid()) {
+            return false;
+        }
+        uint64_t words[sizeof(page->data) / sizeof(uint64_t)];
+        for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+            uint64_t sequence = __atomic_load_n(&page->sequence, __ATOMIC_ACQUIRE);
+            if ((sequence & 1) == 0) {
+                for (size_t i = 0; i < sizeof(words) / sizeof(uint64_t); ++i) {
+                    words[i] = __atomic_load_n(&page->data[i], __ATOMIC_RELAXED);
+                }
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+                if (__atomic_load_n(&page->sequence, __ATOMIC_RELAXED) == sequence) {
+                    memcpy(&data, words, sizeof(words));
+                    return true;
+                }
+            }
+            if (attempt >= SPIN_ATTEMPTS) {
+                sched_yield();
+            }
+        }
+        return false;
+    }
+
+private:
+    static const int SPIN_ATTEMPTS = 16;
+    static const int MAX_ATTEMPTS = 1000;
+
+    const TelemetryPage::Layout *page = nullptr;
+};
@@ -0,0 +1,471 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+
+/**
+ * Device state recorded when a throttle episode starts
+ */
+struct ThrottleContext {
+    std::vector<int> fanSpeedPercent;
+    std::vector<int> fanTemperature;
+    std::vector<int> tdpValues;
+    std::string tccProfile;
+    std::string odmProfile;
+};
+
+struct ThrottleCoreSample {
+    int core;
+    uint64_t coreThrottleCount;
+    uint64_t packageThrottleCount;
+    // scaling_cur_freq in percent of cpuinfo_max_freq, -1 if unknown
+    int freqPercent;
+};
+
+/**
+ * Detects throttle episodes from the thermal_throttle counters of the cores
+ *
+ * A sample where the core or package throttle count of any core increased is
+ * a throttling sample. An episode starts with the first throttling sample and
+ * ends after quietSamples samples without increase, its duration spans from
+ * the first to the last throttling sample plus one sample interval.
+ */
+class ThrottleDetector {
+public:
+    struct Episode {
+        uint64_t startMs;
+        // Wall clock time of the start for consumers outside of the process
+        double startRealtimeMs;
+        uint64_t durationMs;
+        std::vector<int> cores;
+        uint64_t coreEvents;
+        uint64_t packageEvents;
+        // Lowest frequency of an affected core while throttling, -1 if unknown
+        int minFreqPercent;
+        int maxTemperature;
+        bool ongoing;
+        ThrottleContext context;
+    };
+
+    struct Statistics {
+        uint64_t episodes;
+        uint64_t episodesLastHour;
+        uint64_t totalDurationMs;
+        uint64_t longestDurationMs;
+        int monitoredCores;
+        std::vector<Episode> recent;
+    };
+
+    ThrottleDetector(unsigned quietSamples, unsigned sampleIntervalMs, std::size_t keepEpisodes = 32)
+        : quietSamples(quietSamples > 0 ? quietSamples : 1), sampleIntervalMs(sampleIntervalMs),
+          keepEpisodes(keepEpisodes) { }
+
+    enum class SampleResult { Quiet, EpisodeStarted, Throttling };
+
+    /**
+     * @returns Whether the sample is throttling and started an episode, the
+     * caller should then record the device state with UpdateContext()
+     */
+    SampleResult AddSample(const std::vector<ThrottleCoreSample> &samples, uint64_t nowMs, double realtimeMs) {
+        monitoredCores = samples.size();
+        bool throttling = false;
+        uint64_t coreEvents = 0, packageEvents = 0;
+        std::vector<int> affected;
+        int minFreqPercent = -1;
+        for (const ThrottleCoreSample &sample : samples) {
+            auto previous = std::find_if(lastSamples.begin(), lastSamples.end(),
+                [&sample](const ThrottleCoreSample &last) { return last.core == sample.core; });
+            if (previous == lastSamples.end()) {
+                continue;
+            }
+            uint64_t coreIncrease = Increase(previous->coreThrottleCount, sample.coreThrottleCount);
+            uint64_t packageIncrease = Increase(previous->packageThrottleCount, sample.packageThrottleCount);
+            if (coreIncrease == 0 && packageIncrease == 0) {
+                continue;
+            }
+            throttling = true;
+            affected.push_back(sample.core);
+            coreEvents += coreIncrease;
+            // Every core of a package reports the same package counter
+            packageEvents = std::max(packageEvents, packageIncrease);
+            if (sample.freqPercent >= 0 && (minFreqPercent < 0 || sample.freqPercent < minFreqPercent)) {
+                minFreqPercent = sample.freqPercent;
+            }
+        }
+        lastSamples = samples;
+        while (!episodeStarts.empty() && nowMs - episodeStarts.front() > HOUR_MS) {
+            episodeStarts.pop_front();
+        }
+
+        if (!throttling) {
+            if (inEpisode && ++quietCount >= quietSamples) {
+                inEpisode = false;
+                current.ongoing = false;
+                totalDurationMs += current.durationMs;
+                longestDurationMs = std::max(longestDurationMs, current.durationMs);
+                finished.push_back(current);
+                while (finished.size() > keepEpisodes) {
+                    finished.pop_front();
+                }
+            }
+            return SampleResult::Quiet;
+        }
+
+        SampleResult result = SampleResult::Throttling;
+        if (!inEpisode) {
+            inEpisode = true;
+            current = Episode();
+            current.startMs = nowMs;
+            current.startRealtimeMs = realtimeMs;
+            current.minFreqPercent = -1;
+            current.maxTemperature = -1;
+            current.ongoing = true;
+            episodes++;
+            episodeStarts.push_back(nowMs);
+            result = SampleResult::EpisodeStarted;
+        }
+        quietCount = 0;
+        for (int core : affected) {
+            if (std::find(current.cores.begin(), current.cores.end(), core) == current.cores.end()) {
+                current.cores.push_back(core);
+            }
+        }
+        std::sort(current.cores.begin(), current.cores.end());
+        current.coreEvents += coreEvents;
+        current.packageEvents += packageEvents;
+        if (minFreqPercent >= 0 && (current.minFreqPercent < 0 || minFreqPercent < current.minFreqPercent)) {
+            current.minFreqPercent = minFreqPercent;
+        }
+        current.durationMs = nowMs - current.startMs + sampleIntervalMs;
+        return result;
+    }
+
+    /**
+     * Device state read after a throttling sample, kept as the episode
+     * context at the start and for the peak temperature afterwards
+     */
+    void UpdateContext(const ThrottleContext &context, bool episodeStart) {
+        if (!inEpisode) {
+            return;
+        }
+        if (episodeStart) {
+            current.context = context;
+        }
+        for (int temperature : context.fanTemperature) {
+            current.maxTemperature = std::max(current.maxTemperature, temperature);
+        }
+    }
+
+    Statistics GetStatistics() const {
+        Statistics statistics;
+        statistics.episodes = episodes;
+        statistics.episodesLastHour = episodeStarts.size();
+        statistics.totalDurationMs = totalDurationMs + (inEpisode ? current.durationMs : 0);
+        statistics.longestDurationMs = std::max(longestDurationMs, inEpisode ? current.durationMs : 0);
+        statistics.monitoredCores = monitoredCores;
+        statistics.recent.assign(finished.begin(), finished.end());
+        if (inEpisode) {
+            statistics.recent.push_back(current);
+        }
+        return statistics;
+    }
+
+private:
+    static const uint64_t HOUR_MS = 3600000;
+
+    unsigned quietSamples;
+    unsigned sampleIntervalMs;
+    std::size_t keepEpisodes;
+
+    std::vector<ThrottleCoreSample> lastSamples;
+    bool inEpisode = false;
+    unsigned quietCount = 0;
+    Episode current;
+    std::deque<Episode> finished;
+    std::deque<uint64_t> episodeStarts;
+    uint64_t episodes = 0;
+    uint64_t totalDurationMs = 0;
+    uint64_t longestDurationMs = 0;
+    int monitoredCores = 0;
+
+    // Counters restart from 0 when a core goes offline and online again
+    static uint64_t Increase(uint64_t previous, uint64_t current) {
+        return current > previous ? current - previous : 0;
+    }
+};
+
+/**
+ * Samples the thermal_throttle counters and scaling_cur_freq of all cores on
+ * an own thread through cached descriptors and feeds the detector
+ *
+ * The kernel removes the thermal_throttle group of a core going offline and
+ * recreates it when the core comes back. A change of the online cores mask
+ * makes the next sample rescan the cores, a failing read reopens the files
+ * of that core once.
+ *
+ * The device context of an episode is read through the readDevice callback
+ * on the sampling thread, it has to take care of device access itself.
+ */
+class ThrottleMonitor {
+public:
+    struct Config {
+        unsigned sampleIntervalMs = 1000;
+        unsigned quietSamples = 3;
+    };
+
+    /**
+     * @param readDevice Fills fans and TDPs of the context, called on the
+     * sampling thread while throttling
+     */
+    ThrottleMonitor(const Config &config, std::function<void(ThrottleContext &)> readDevice,
+                    const std::string &cpuPath = "/sys/devices/system/cpu")
+        : detector(config.quietSamples, config.sampleIntervalMs),
+          sampleIntervalMs(config.sampleIntervalMs > 0 ? config.sampleIntervalMs : 1),
+          readDevice(readDevice), cpuPath(cpuPath) {
+        onlineMaskFile = open((cpuPath + "/online").c_str(), O_RDONLY | O_CLOEXEC);
+        ReadOnlineMask(lastOnlineMask);
+        OpenCores();
+        available = !cores.empty();
+        if (available) {
+            samplingThread = std::thread(&ThrottleMonitor::Run, this);
+        }
+    }
+
+    ~ThrottleMonitor() {
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            running = false;
+        }
+        stopped.notify_one();
+        if (samplingThread.joinable()) {
+            samplingThread.join();
+        }
+        CloseCores();
+        CloseFile(onlineMaskFile);
+    }
+
+    /**
+     * False if no core offers thermal_throttle counters (non intel cpu or
+     * kernel without the interface)
+     */
+    bool Available() const {
+        return available;
+    }
+
+    void SetProfiles(const std::string &tccProfile, const std::string &odmProfile) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        this->tccProfile = tccProfile;
+        this->odmProfile = odmProfile;
+    }
+
+    ThrottleDetector::Statistics GetStatistics() {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        return detector.GetStatistics();
+    }
+
+private:
+    struct CoreFiles {
+        int core;
+        std::string path;
+        int coreCount;
+        int packageCount;
+        int curFreq;
+        uint64_t maxFreq;
+    };
+
+    ThrottleDetector detector;
+    unsigned sampleIntervalMs;
+    std::function<void(ThrottleContext &)> readDevice;
+    std::string cpuPath;
+    // Only touched by the sampling thread once it runs
+    std::vector<CoreFiles> cores;
+    int onlineMaskFile = -1;
+    std::string lastOnlineMask;
+    bool available = false;
+    std::string tccProfile;
+    std::string odmProfile;
+
+    std::mutex stateMutex;
+    std::condition_variable stopped;
+    bool running = true;
+    std::thread samplingThread;
+
+    static uint64_t MonotonicMs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t) ts.tv_sec * 1000ull + ts.tv_nsec / 1000000ull;
+    }
+
+    static double RealtimeMs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+    }
+
+    static void CloseFile(int fd) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    static bool ReadNumber(int fd, uint64_t &value) {
+        char buffer[32];
+        ssize_t length = fd >= 0 ? pread(fd, buffer, sizeof(buffer) - 1, 0) : -1;
+        if (length <= 0) {
+            return false;
+        }
+        buffer[length] = '\0';
+        value = strtoull(buffer, nullptr, 10);
+        return true;
+    }
+
+    bool ReadOnlineMask(std::string &mask) {
+        char buffer[256];
+        ssize_t length = onlineMaskFile >= 0 ? pread(onlineMaskFile, buffer, sizeof(buffer), 0) : -1;
+        if (length < 0) {
+            return false;
+        }
+        mask.assign(buffer, length);
+        return true;
+    }
+
+    /**
+     * @returns False if the core has no thermal_throttle counters (offline or
+     * not supported), the files are closed then
+     */
+    static bool OpenCore(CoreFiles &files) {
+        files.coreCount = open((files.path + "/thermal_throttle/core_throttle_count").c_str(), O_RDONLY | O_CLOEXEC);
+        files.packageCount = -1;
+        files.curFreq = -1;
+        if (files.coreCount < 0) {
+            return false;
+        }
+        files.packageCount = open((files.path + "/thermal_throttle/package_throttle_count").c_str(), O_RDONLY | O_CLOEXEC);
+        files.curFreq = open((files.path + "/cpufreq/scaling_cur_freq").c_str(), O_RDONLY | O_CLOEXEC);
+        int maxFreqFile = open((files.path + "/cpufreq/cpuinfo_max_freq").c_str(), O_RDONLY | O_CLOEXEC);
+        if (!ReadNumber(maxFreqFile, files.maxFreq)) {
+            files.maxFreq = 0;
+        }
+        CloseFile(maxFreqFile);
+        return true;
+    }
+
+    static void CloseCore(CoreFiles &files) {
+        CloseFile(files.coreCount);
+        CloseFile(files.packageCount);
+        CloseFile(files.curFreq);
+        files.coreCount = files.packageCount = files.curFreq = -1;
+    }
+
+    void CloseCores() {
+        for (CoreFiles &files : cores) {
+            CloseCore(files);
+        }
+        cores.clear();
+    }
+
+    void OpenCores() {
+        CloseCores();
+        DIR *dir = opendir(cpuPath.c_str());
+        if (dir == nullptr) {
+            return;
+        }
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            int core;
+            char trailing;
+            if (sscanf(entry->d_name, "cpu%d%c", &core, &trailing) != 1) {
+                continue;
+            }
+            CoreFiles files;
+            files.core = core;
+            files.path = cpuPath + "/" + entry->d_name;
+            if (OpenCore(files)) {
+                cores.push_back(files);
+            }
+        }
+        closedir(dir);
+        std::sort(cores.begin(), cores.end(), [](const CoreFiles &a, const CoreFiles &b) { return a.core < b.core; });
+    }
+
+    void Sample(std::vector<ThrottleCoreSample> &samples) {
+        samples.clear();
+        std::string onlineMask;
+        if (ReadOnlineMask(onlineMask) && onlineMask != lastOnlineMask) {
+            lastOnlineMask = onlineMask;
+            OpenCores();
+        }
+        for (CoreFiles &files : cores) {
+            ThrottleCoreSample sample;
+            sample.core = files.core;
+            if (!ReadNumber(files.coreCount, sample.coreThrottleCount)) {
+                // Group removed and recreated (core offline and back), reopen
+                // once, still offline cores are left out of the sample
+                CloseCore(files);
+                if (!OpenCore(files) || !ReadNumber(files.coreCount, sample.coreThrottleCount)) {
+                    continue;
+                }
+            }
+            if (!ReadNumber(files.packageCount, sample.packageThrottleCount)) {
+                sample.packageThrottleCount = 0;
+            }
+            uint64_t curFreq;
+            sample.freqPercent = files.maxFreq > 0 && ReadNumber(files.curFreq, curFreq)
+                ? (int) (curFreq * 100 / files.maxFreq) : -1;
+            samples.push_back(sample);
+        }
+    }
+
+    void Run() {
+        std::vector<ThrottleCoreSample> samples;
+        std::unique_lock<std::mutex> lock(stateMutex);
+        while (running) {
+            lock.unlock();
+            Sample(samples);
+            lock.lock();
+            ThrottleDetector::SampleResult result = detector.AddSample(samples, MonotonicMs(), RealtimeMs());
+            if (result != ThrottleDetector::SampleResult::Quiet) {
+                ThrottleContext context;
+                context.tccProfile = tccProfile;
+                context.odmProfile = odmProfile;
+                lock.unlock();
+                readDevice(context);
+                lock.lock();
+                detector.UpdateContext(context, result == ThrottleDetector::SampleResult::EpisodeStarted);
+            }
+            stopped.wait_for(lock, std::chrono::milliseconds(sampleIntervalMs), [this]() { return !running; });
+        }
+    }
+};
@@ -19,6 +19,8 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdio.h>
+#include <errno.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
@@ -26,7 +28,99 @@
 #include <vector>
 #include <map>
 #include <cmath>
+#include <algorithm>
+#include <atomic>
 #include "tuxedo_io_ioctl.h"
+#include "tuxedo_io_probes.hh"
+
+/**
+ * Compares "major.minor.patch" version strings
+ */
+static inline bool CheckMinVersionByStrings(std::string version, std::string minVersion) {
+    unsigned modVersionMajor, modVersionMinor, modVersionPatch, modAPIMinVersionMajor, modAPIMinVersionMinor, modAPIMinVersionPatch;
+    if (sscanf(version.c_str(), "%u.%u.%u", &modVersionMajor, &modVersionMinor, &modVersionPatch) < 3 ||
+            sscanf(minVersion.c_str(), "%u.%u.%u", &modAPIMinVersionMajor, &modAPIMinVersionMinor, &modAPIMinVersionPatch) < 3) {
+        return false;
+    }
+
+    if (modVersionMajor < modAPIMinVersionMajor ||
+            (modVersionMajor == modAPIMinVersionMajor && modVersionMinor < modAPIMinVersionMinor) ||
+            (modVersionMajor == modAPIMinVersionMajor && modVersionMinor == modAPIMinVersionMinor && modVersionPatch < modAPIMinVersionPatch)) {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Process wide ioctl counters and latency histogram, collected for every
+ * ioctl independent of tracing
+ */
+class IOStatistics {
+public:
+    static const int NR_BUCKETS = 10;
+
+    struct Snapshot {
+        uint64_t calls;
+        uint64_t errors;
+        uint64_t durationSumNs;
+        // Per bucket, not cumulative
+        uint64_t buckets[NR_BUCKETS];
+    };
+
+    static IOStatistics &Instance() {
+        static IOStatistics statistics;
+        return statistics;
+    }
+
+    /**
+     * Upper bound of a bucket in ns, the last bucket is unbounded
+     */
+    static uint64_t BucketBoundNs(int bucket) {
+        static const uint64_t bounds[NR_BUCKETS - 1] = {
+            10000, 25000, 50000, 100000, 250000, 500000, 1000000, 5000000, 25000000
+        };
+        return bucket < NR_BUCKETS - 1 ? bounds[bucket] : UINT64_MAX;
+    }
+
+    void Record(uint64_t durationNs, bool failed) {
+        int bucket = 0;
+        while (durationNs > BucketBoundNs(bucket)) {
+            bucket++;
+        }
+        buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        durationSumNs.fetch_add(durationNs, std::memory_order_relaxed);
+        if (failed) {
+            errors.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    Snapshot GetSnapshot() const {
+        Snapshot snapshot;
+        snapshot.calls = 0;
+        for (int i = 0; i < NR_BUCKETS; ++i) {
+            snapshot.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+            snapshot.calls += snapshot.buckets[i];
+        }
+        snapshot.errors = errors.load(std::memory_order_relaxed);
+        snapshot.durationSumNs = durationSumNs.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+private:
+    IOStatistics() {
+        for (int i = 0; i < NR_BUCKETS; ++i) {
+            buckets[i] = 0;
+        }
+    }
+    IOStatistics(const IOStatistics &) = delete;
+    IOStatistics &operator=(const IOStatistics &) = delete;
+
+    // Calls are the sum of the buckets so a snapshot is always consistent
+    std::atomic<uint64_t> buckets[NR_BUCKETS];
+    std::atomic<uint64_t> errors { 0 };
+    std::atomic<uint64_t> durationSumNs { 0 };
+};
 
 class IO {
 public:
@@ -34,45 +128,127 @@ public:
         OpenDevice(file);
     }
 
-    ~IO() {
+    virtual ~IO() {
         CloseDevice();
     }
 
-    bool IOAvailable() {
+    virtual bool IOAvailable() {
         return _fileHandle >= 0;
     }
 
     bool IoctlCall(unsigned long request) {
         if (!IOAvailable()) return false;
-        int result = ioctl(_fileHandle, request);
+        int result = ProbedIoctl(request, nullptr);
         return result >= 0;
     }
 
     bool IoctlCall(unsigned long request, int &argument) {
         if (!IOAvailable()) return false;
-        int result = ioctl(_fileHandle, request, &argument);
+        int result = ProbedIoctl(request, &argument);
         return result >= 0;
     }
 
     bool IoctlCall(unsigned long request, std::string &argument, size_t buffer_length) {
         if (!IOAvailable()) return false;
-        char *buffer = new char[buffer_length];
-        int result = ioctl(_fileHandle, request, buffer);
+        char *buffer = new char[buffer_length]();
+        int result = ProbedIoctl(request, buffer);
+        buffer[buffer_length - 1] = '\0';
         argument.clear();
         argument.append(buffer);
         delete[] buffer;
         return result >= 0;
     }
 
+    bool IoctlCall(unsigned long request, struct tuxedo_io_telemetry &argument) {
+        if (!IOAvailable()) return false;
+        int result = ProbedIoctl(request, &argument);
+        return result >= 0;
+    }
+
+    enum TelemetrySupportState { TELEMETRY_UNKNOWN, TELEMETRY_BATCH, TELEMETRY_PER_FIELD };
+
+    /**
+     * Whether the module answers R_TELEMETRY. Shared by all IOs on the
+     * device file since they talk to the same module, simulated IOs keep
+     * their own.
+     */
+    virtual std::atomic<int> &TelemetrySupport() {
+        static std::atomic<int> support { TELEMETRY_UNKNOWN };
+        return support;
+    }
+
+protected:
+    /**
+     * Constructor for implementations not backed by a device file
+     */
+    IO() { }
+
+    /**
+     * Single point all ioctls go through, overridden by simulated devices
+     */
+    virtual int Ioctl(unsigned long request, void *argument) {
+        if (argument == nullptr) {
+            return ioctl(_fileHandle, request);
+        } else {
+            return ioctl(_fileHandle, request, argument);
+        }
+    }
+
 private:
     int _fileHandle = -1;
 
+    int ProbedIoctl(unsigned long request, void *argument) {
+        TUXEDO_IO_PROBE1(ioctl_entry, request);
+        uint64_t startNs = TuxedoIOProbeClockNs();
+        int result = Ioctl(request, argument);
+        int error = result < 0 ? errno : 0;
+        uint64_t durationNs = TuxedoIOProbeClockNs() - startNs;
+        IOStatistics::Instance().Record(durationNs, result < 0);
+        TUXEDO_IO_PROBE4(ioctl_exit, request, result, error, durationNs);
+        errno = error;
+        return result;
+    }
+
     void OpenDevice(const char *file) {
         _fileHandle = open(file, O_RDWR);
+        int error = _fileHandle < 0 ? errno : 0;
+        TUXEDO_IO_PROBE3(device_open, file, _fileHandle, error);
     }
 
     void CloseDevice() {
-        close(_fileHandle);
+        if (_fileHandle >= 0) {
+            close(_fileHandle);
+        }
+    }
+};
+
+/**
+ * All fans and TDPs of one refresh, unavailable values are -1
+ */
+struct DeviceTelemetry {
+    static const int MAX_FANS = TUXEDO_IO_TELEMETRY_MAX_FANS;
+    static const int MAX_TDPS = TUXEDO_IO_TELEMETRY_MAX_TDPS;
+
+    int nrFans = 0;
+    int fanSpeedPercent[MAX_FANS];
+    int fanTemperature[MAX_FANS];
+    int nrTDPs = 0;
+    int tdp[MAX_TDPS];
+    int tdpMin[MAX_TDPS];
+    int tdpMax[MAX_TDPS];
+    // TUXEDO_IO_TELEMETRY_* groups taken from the batch read
+    uint32_t batchedGroups = 0;
+
+    DeviceTelemetry() {
+        for (int i = 0; i < MAX_FANS; ++i) {
+            fanSpeedPercent[i] = -1;
+            fanTemperature[i] = -1;
+        }
+        for (int i = 0; i < MAX_TDPS; ++i) {
+            tdp[i] = -1;
+            tdpMin[i] = -1;
+            tdpMax[i] = -1;
+        }
     }
 };
 
@@ -104,8 +280,63 @@ public:
     virtual bool SetTDP(const int tdpIndex, const int tdpValue) = 0;
     virtual bool GetTDP(const int tdpIndex, int &tdpValue) = 0;
 
+    /**
+     * Reads all fans and TDPs. Groups marked valid in batch are taken from
+     * it, everything else is read with the getters above.
+     *
+     * @param batch Result of R_TELEMETRY, nullptr if the module has none
+     */
+    virtual bool ReadTelemetry(DeviceTelemetry &telemetry, const struct tuxedo_io_telemetry *batch) {
+        telemetry = DeviceTelemetry();
+        uint32_t valid = batch != nullptr ? batch->valid : 0;
+
+        if (!GetNumberFans(telemetry.nrFans)) { return false; }
+        telemetry.nrFans = std::min(telemetry.nrFans, (int) DeviceTelemetry::MAX_FANS);
+        for (int i = 0; i < telemetry.nrFans; ++i) {
+            if (valid & TUXEDO_IO_TELEMETRY_FAN_SPEED) {
+                telemetry.fanSpeedPercent[i] = FanSpeedRawToPercent(batch->fan_speed[i]);
+            } else if (!GetFanSpeedPercent(i, telemetry.fanSpeedPercent[i])) {
+                telemetry.fanSpeedPercent[i] = -1;
+            }
+            if (valid & TUXEDO_IO_TELEMETRY_FAN_TEMP) {
+                telemetry.fanTemperature[i] = FanTemperatureValid(batch->fan_temp[i]) ? batch->fan_temp[i] : -1;
+            } else if (!GetFanTemperature(i, telemetry.fanTemperature[i])) {
+                telemetry.fanTemperature[i] = -1;
+            }
+        }
+
+        if (valid & TUXEDO_IO_TELEMETRY_TDP) {
+            telemetry.nrTDPs = std::max(0, std::min(batch->nr_tdps, (int32_t) DeviceTelemetry::MAX_TDPS));
+        } else if (!GetNumberTDPs(telemetry.nrTDPs)) {
+            telemetry.nrTDPs = 0;
+        }
+        for (int i = 0; i < telemetry.nrTDPs; ++i) {
+            if (valid & TUXEDO_IO_TELEMETRY_TDP) {
+                telemetry.tdp[i] = batch->tdp[i];
+            } else if (!GetTDP(i, telemetry.tdp[i])) {
+                telemetry.tdp[i] = -1;
+            }
+            if (valid & TUXEDO_IO_TELEMETRY_TDP_LIMITS) {
+                telemetry.tdpMin[i] = batch->tdp_min[i];
+                telemetry.tdpMax[i] = batch->tdp_max[i];
+            } else {
+                if (!GetTDPMin(i, telemetry.tdpMin[i])) { telemetry.tdpMin[i] = -1; }
+                if (!GetTDPMax(i, telemetry.tdpMax[i])) { telemetry.tdpMax[i] = -1; }
+            }
+        }
+
+        telemetry.batchedGroups = valid;
+        return true;
+    }
+
 protected:
     IO *io;
+
+    /**
+     * Decoding of the raw values shared by the getters and the batch read
+     */
+    virtual int FanSpeedRawToPercent(int fanSpeedRaw) { return fanSpeedRaw; }
+    virtual bool FanTemperatureValid(int temperatureCelcius) { return true; }
 };
 
 class ClevoDevice : public DeviceInterface {
@@ -182,7 +413,7 @@ public:
         int fanSpeedRaw;
         int ret = GetFanSpeedRaw(fanNr, fanSpeedRaw);
         if (!ret) { return false; }
-        fanSpeedPercent = std::round((fanSpeedRaw / (float) MAX_FAN_SPEED) * 100);
+        fanSpeedPercent = FanSpeedRawToPercent(fanSpeedRaw);
         return ret;
     }
 
@@ -194,8 +425,7 @@ public:
         //int fanTemp1 = (int8_t) ((fanInfo >> 0x08) & 0xff);
         int fanTemp2 = (int8_t) ((fanInfo >> 0x10) & 0xff);
         temperatureCelcius = fanTemp2;
-        // If a fan is not available a low value is read out
-        if (fanTemp2 <= 1) { ret = false; }
+        if (!FanTemperatureValid(fanTemp2)) { ret = false; }
         return ret;
     }
 
@@ -242,6 +472,16 @@ public:
     virtual bool SetTDP(const int tdpIndex, int tdpValue) { return false; }
     virtual bool GetTDP(const int tdpIndex, int &tdpValue) { return false; }
 
+protected:
+    virtual int FanSpeedRawToPercent(int fanSpeedRaw) {
+        return std::round((fanSpeedRaw / (float) MAX_FAN_SPEED) * 100);
+    }
+
+    virtual bool FanTemperatureValid(int temperatureCelcius) {
+        // If a fan is not available a low value is read out
+        return temperatureCelcius > 1;
+    }
+
 private:
     const int MAX_FAN_SPEED = 0xff;
     const std::string PERF_PROF_STR_QUIET = "quiet";
@@ -368,7 +608,7 @@ public:
                 break;
         }
 
-        fanSpeedPercent = (int) std::round(fanSpeedRaw * 100.0 / MAX_FAN_SPEED);
+        fanSpeedPercent = FanSpeedRawToPercent(fanSpeedRaw);
 
         return result;
     }
@@ -391,8 +631,7 @@ public:
 
         temperatureCelcius = temp;
 
-        // Also use known set value (0x00) from tccwmi to detect no temp/fan
-        if (temp == 0) result = false;
+        if (!FanTemperatureValid(temp)) result = false;
 
         return result;
     }
@@ -520,6 +759,16 @@ public:
         return io->IoctlCall(ioctl_tdp_get[tdpIndex], tdpValue);
     }
 
+protected:
+    virtual int FanSpeedRawToPercent(int fanSpeedRaw) {
+        return (int) std::round(fanSpeedRaw * 100.0 / MAX_FAN_SPEED);
+    }
+
+    virtual bool FanTemperatureValid(int temperatureCelcius) {
+        // Also use known set value (0x00) from tccwmi to detect no temp/fan
+        return temperatureCelcius != 0;
+    }
+
 private:
     const int MAX_FAN_SPEED = 0xc8;
     const std::string PERF_PROF_STR_BALANCED = "power_save";
@@ -555,34 +804,38 @@ private:
 
 class TuxedoIOAPI : public DeviceInterface {
 public:
-    IO io = IO(TUXEDO_IO_DEVICE_FILE);
+    TuxedoIOAPI() : TuxedoIOAPI(DeviceOverride() != nullptr ? DeviceOverride() : new IO(TUXEDO_IO_DEVICE_FILE),
+                                DeviceOverride() == nullptr) { }
 
-    TuxedoIOAPI() : DeviceInterface(io) {
-        devices.push_back(new ClevoDevice(io));
-        devices.push_back(new UniwillDevice(io));
+    /**
+     * Use an existing IO (for example a simulated EC), ownership stays with the caller
+     */
+    explicit TuxedoIOAPI(IO &io) : TuxedoIOAPI(&io, false) { }
 
-        for (std::size_t i = 0; i < devices.size(); ++i) {
-            bool status, identified;
-            status = devices[i]->Identify(identified);
-            if (status && identified) {
-                activeInterface = devices[i];
-                break;
-            }
-        }
+    /**
+     * Process wide IO used by default constructed instances instead of
+     * opening TUXEDO_IO_DEVICE_FILE. Set to nullptr to use the device again.
+     */
+    static IO *&DeviceOverride() {
+        static IO *overrideIO = nullptr;
+        return overrideIO;
     }
 
     ~TuxedoIOAPI() {
         for (std::size_t i = 0; i < devices.size(); ++i) {
             delete devices[i];
         }
+        if (ownsIO) {
+            delete io;
+        }
     }
 
     bool WmiAvailable() {
-        return io.IOAvailable();
+        return io->IOAvailable();
     }
 
     bool GetModuleVersion(std::string &version) {
-        return io.IoctlCall(R_MOD_VERSION, version, 20);
+        return io->IoctlCall(R_MOD_VERSION, version, 20);
     }
 
     bool GetModuleAPIMinVersion(std::string &version) {
@@ -646,19 +899,21 @@ public:
         }
     }
     virtual bool SetFansAuto() {
+        bool result = false;
         if (activeInterface) {
-            return activeInterface->SetFansAuto();
-        } else {
-            return false;
+            result = activeInterface->SetFansAuto();
         }
+        TUXEDO_IO_PROBE1(fans_auto, result);
+        return result;
     }
 
     virtual bool SetFanSpeedPercent(const int fanNr, const int fanSpeedPercent) {
+        bool result = false;
         if (activeInterface) {
-            return activeInterface->SetFanSpeedPercent(fanNr, fanSpeedPercent);
-        } else {
-            return false;
+            result = activeInterface->SetFanSpeedPercent(fanNr, fanSpeedPercent);
         }
+        TUXEDO_IO_PROBE3(fan_set, fanNr, fanSpeedPercent, result);
+        return result;
     }
 
     virtual bool GetFanSpeedPercent(const int fanNr, int &fanSpeedPercent) {
@@ -763,7 +1018,76 @@ public:
         }
     }
 
+    virtual bool ReadTelemetry(DeviceTelemetry &telemetry, const struct tuxedo_io_telemetry *batch) {
+        if (activeInterface) {
+            return activeInterface->ReadTelemetry(telemetry, batch);
+        } else {
+            return false;
+        }
+    }
+
+    /**
+     * Whether the module answers R_TELEMETRY, decided once per module by its
+     * version and revoked on the first reply that is of no use.
+     */
+    bool TelemetryBatchSupported() {
+        std::atomic<int> &support = io->TelemetrySupport();
+        if (support == IO::TELEMETRY_UNKNOWN) {
+            std::string moduleVersion;
+            if (GetModuleVersion(moduleVersion)) {
+                support = CheckMinVersionByStrings(moduleVersion, MOD_TELEMETRY_MIN_VERSION)
+                    ? IO::TELEMETRY_BATCH : IO::TELEMETRY_PER_FIELD;
+            }
+        }
+        return support == IO::TELEMETRY_BATCH;
+    }
+
+    /**
+     * Reads all fans and TDPs with one R_TELEMETRY on modules that have it
+     * and with the single ioctls otherwise.
+     */
+    bool ReadTelemetry(DeviceTelemetry &telemetry) {
+        if (!activeInterface) {
+            return false;
+        }
+
+        struct tuxedo_io_telemetry batch = {};
+        bool batchRead = false;
+        if (TelemetryBatchSupported()) {
+            batch.version = TUXEDO_IO_TELEMETRY_VERSION;
+            batch.size = sizeof(batch);
+            batchRead = io->IoctlCall(R_TELEMETRY, batch);
+            if (!batchRead && errno == ENOTTY) {
+                // Module was replaced by an older one
+                io->TelemetrySupport() = IO::TELEMETRY_PER_FIELD;
+            } else if (batchRead && (batch.valid == 0 || batch.version == 0
+                    || batch.version > TUXEDO_IO_TELEMETRY_VERSION)) {
+                // Nothing batched for this interface or a layout not known
+                // here, the extra ioctl would only add to the per field reads
+                io->TelemetrySupport() = IO::TELEMETRY_PER_FIELD;
+                batchRead = false;
+            }
+        }
+        return activeInterface->ReadTelemetry(telemetry, batchRead ? &batch : nullptr);
+    }
+
 private:
     std::vector<DeviceInterface *> devices;
     DeviceInterface *activeInterface { nullptr };
+    bool ownsIO;
+
+    TuxedoIOAPI(IO *io, bool ownsIO) : DeviceInterface(*io), ownsIO(ownsIO) {
+        devices.push_back(new ClevoDevice(*io));
+        devices.push_back(new UniwillDevice(*io));
+
+        for (std::size_t i = 0; i < devices.size(); ++i) {
+            bool status, identified;
+            status = devices[i]->Identify(identified);
+            TUXEDO_IO_PROBE3(device_identify, i, status, status && identified);
+            if (status && identified) {
+                activeInterface = devices[i];
+                break;
+            }
+        }
+    }
 };
@@ -0,0 +1,95 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include "tuxedo_io_api.hh"
+
+/**
+ * Process wide owner of access to the tuxedo_io device
+ *
+ * Several API calls are composed of multiple ioctls (e.g. the read-modify-write
+ * of the packed clevo fan speed), the arbiter serializes complete operations
+ * across all threads and node environments of the process.
+ */
+class DeviceArbiter {
+public:
+    struct Statistics {
+        uint64_t acquisitions;
+        uint64_t contended;
+        uint64_t waitTimeNs;
+    };
+
+    static DeviceArbiter &Instance() {
+        static DeviceArbiter arbiter;
+        return arbiter;
+    }
+
+    std::unique_lock<std::mutex> Acquire() {
+        std::unique_lock<std::mutex> lock(deviceMutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            auto waitStart = std::chrono::steady_clock::now();
+            lock.lock();
+            contended.fetch_add(1, std::memory_order_relaxed);
+            waitTimeNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - waitStart).count(), std::memory_order_relaxed);
+        }
+        acquisitions.fetch_add(1, std::memory_order_relaxed);
+        return lock;
+    }
+
+    Statistics GetStatistics() const {
+        Statistics statistics;
+        statistics.acquisitions = acquisitions.load(std::memory_order_relaxed);
+        statistics.contended = contended.load(std::memory_order_relaxed);
+        statistics.waitTimeNs = waitTimeNs.load(std::memory_order_relaxed);
+        return statistics;
+    }
+
+private:
+    DeviceArbiter() { }
+    DeviceArbiter(const DeviceArbiter &) = delete;
+    DeviceArbiter &operator=(const DeviceArbiter &) = delete;
+
+    std::mutex deviceMutex;
+    std::atomic<uint64_t> acquisitions { 0 };
+    std::atomic<uint64_t> contended { 0 };
+    std::atomic<uint64_t> waitTimeNs { 0 };
+};
+
+/**
+ * Exclusive use of the device for the lifetime of the object
+ */
+class DeviceSession {
+public:
+    DeviceSession() : lock(DeviceArbiter::Instance().Acquire()) { }
+
+    TuxedoIOAPI &API() {
+        return api;
+    }
+
+private:
+    // Declaration order matters, the lock has to be held before the API
+    // identifies the device and released after it is closed
+    std::unique_lock<std::mutex> lock;
+    TuxedoIOAPI api;
+};
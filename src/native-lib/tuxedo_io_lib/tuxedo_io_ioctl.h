@@ -28,6 +28,7 @@
 #define MAGIC_WRITE_UW	IOCTL_MAGIC + 4
 
 #define MOD_API_MIN_VERSION "0.2.6" // IMPORTANT: Needs to be updated when a new ioctl is added
+#define MOD_TELEMETRY_MIN_VERSION "0.3.0" // Optional R_TELEMETRY, older modules are read per field
 
 // General
 #define R_MOD_VERSION		_IOR(IOCTL_MAGIC, 0x00, char*)
@@ -35,6 +36,48 @@
 #define R_HWCHECK_CL		_IOR(IOCTL_MAGIC, 0x05, int32_t*)
 #define R_HWCHECK_UW		_IOR(IOCTL_MAGIC, 0x06, int32_t*)
 
+/**
+ * Batch read of the values otherwise read one ioctl each
+ *
+ * The caller sets version and size, the module fills at most size bytes
+ * of the newest layout it knows that is not newer than version, sets version
+ * to that layout and marks the filled groups in valid. Groups the active
+ * interface can not read in one go stay unmarked and are read with the
+ * single ioctls. Values have the same encoding as the corresponding single
+ * ioctls (raw fan speed, fan temp2 / fan temp, TDPs in watts).
+ *
+ * New fields are only appended, the ioctl number does not change.
+ *
+ * The ioctl number and MOD_TELEMETRY_MIN_VERSION are not yet taken in
+ * tuxedo-drivers and have to follow whatever the module side is merged with.
+ */
+#define TUXEDO_IO_TELEMETRY_VERSION	1
+#define TUXEDO_IO_TELEMETRY_MAX_FANS	4
+#define TUXEDO_IO_TELEMETRY_MAX_TDPS	3
+
+#define TUXEDO_IO_TELEMETRY_FAN_SPEED	(1 << 0)
+#define TUXEDO_IO_TELEMETRY_FAN_TEMP	(1 << 1)
+#define TUXEDO_IO_TELEMETRY_TDP		(1 << 2)
+#define TUXEDO_IO_TELEMETRY_TDP_LIMITS	(1 << 3)
+#define TUXEDO_IO_TELEMETRY_MODE	(1 << 4)
+
+struct tuxedo_io_telemetry {
+	uint32_t version;
+	uint32_t size;
+	uint32_t valid;
+	int32_t nr_fans;
+	int32_t fan_speed[TUXEDO_IO_TELEMETRY_MAX_FANS];
+	int32_t fan_temp[TUXEDO_IO_TELEMETRY_MAX_FANS];
+	int32_t nr_tdps;
+	int32_t tdp[TUXEDO_IO_TELEMETRY_MAX_TDPS];
+	int32_t tdp_min[TUXEDO_IO_TELEMETRY_MAX_TDPS];
+	int32_t tdp_max[TUXEDO_IO_TELEMETRY_MAX_TDPS];
+	int32_t mode;
+	int32_t mode_enable;
+};
+
+#define R_TELEMETRY		_IOWR(IOCTL_MAGIC, 0x10, struct tuxedo_io_telemetry*)
+
 /**
  * Clevo interface
  */
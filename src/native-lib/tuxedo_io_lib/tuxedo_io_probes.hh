@@ -0,0 +1,97 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/**
+ * USDT probes of provider "tuxedo_io"
+ *
+ *  ioctl_entry(request)
+ *  ioctl_exit(request, result, errno, durationNs)
+ *  device_open(path, fd, errno)
+ *  device_identify(interfaceIndex, status, identified)   0: clevo, 1: uniwill
+ *  fan_set(fanNr, speedPercent, result)
+ *  fans_auto(result)
+ *  napi_entry(name)
+ *  napi_exit(name, durationNs)
+ *
+ * A probe site is a single nop while nothing is attached. Durations of
+ * ioctl_exit are always measured (see IOStatistics), the others only while a
+ * tracer enabled the probe through its semaphore (bpftrace does), otherwise
+ * 0 is passed. Examples:
+ *
+ *  bpftrace -p $(pidof tccd) -e 'usdt:*:tuxedo_io:ioctl_exit { @[arg0] = hist(arg3); }'
+ *  bpftrace -p $(pidof tccd) -e 'usdt:*:tuxedo_io:napi_entry { @[str(arg0)] = count(); }'
+ *  perf probe -x TuxedoIOAPI.node sdt_tuxedo_io:ioctl_entry
+ *
+ * Probes are compiled in when <sys/sdt.h> (systemtap-sdt-dev) is available at
+ * build time and TUXEDO_IO_NO_PROBES is not defined.
+ */
+
+#include <stdint.h>
+#include <time.h>
+
+#if !defined(TUXEDO_IO_NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define TUXEDO_IO_PROBES 1
+#endif
+#endif
+
+#ifdef TUXEDO_IO_PROBES
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+// Incremented by tracers attaching to the probe, referenced from the probe note
+#define TUXEDO_IO_SEMAPHORE(name) \
+    __extension__ static volatile unsigned short tuxedo_io_##name##_semaphore \
+    __attribute__((used)) __attribute__((section(".probes"))) = 0
+
+#define TUXEDO_IO_PROBE_ENABLED(name) __builtin_expect(tuxedo_io_##name##_semaphore != 0, 0)
+#define TUXEDO_IO_PROBE1(name, a1) STAP_PROBE1(tuxedo_io, name, a1)
+#define TUXEDO_IO_PROBE2(name, a1, a2) STAP_PROBE2(tuxedo_io, name, a1, a2)
+#define TUXEDO_IO_PROBE3(name, a1, a2, a3) STAP_PROBE3(tuxedo_io, name, a1, a2, a3)
+#define TUXEDO_IO_PROBE4(name, a1, a2, a3, a4) STAP_PROBE4(tuxedo_io, name, a1, a2, a3, a4)
+
+#else
+
+#define TUXEDO_IO_SEMAPHORE(name) static_assert(true, "")
+#define TUXEDO_IO_PROBE_ENABLED(name) false
+// Arguments are only named (unevaluated) to not leave them unused
+#define TUXEDO_IO_PROBE1(name, a1) do { (void) sizeof(a1); } while (0)
+#define TUXEDO_IO_PROBE2(name, a1, a2) do { (void) sizeof(a1); (void) sizeof(a2); } while (0)
+#define TUXEDO_IO_PROBE3(name, a1, a2, a3) do { (void) sizeof(a1); (void) sizeof(a2); (void) sizeof(a3); } while (0)
+#define TUXEDO_IO_PROBE4(name, a1, a2, a3, a4) do { (void) sizeof(a1); (void) sizeof(a2); (void) sizeof(a3); (void) sizeof(a4); } while (0)
+
+#endif
+
+// Every probe needs its semaphore when compiled with semaphores
+TUXEDO_IO_SEMAPHORE(ioctl_entry);
+TUXEDO_IO_SEMAPHORE(ioctl_exit);
+TUXEDO_IO_SEMAPHORE(device_open);
+TUXEDO_IO_SEMAPHORE(device_identify);
+TUXEDO_IO_SEMAPHORE(fan_set);
+TUXEDO_IO_SEMAPHORE(fans_auto);
+TUXEDO_IO_SEMAPHORE(napi_entry);
+TUXEDO_IO_SEMAPHORE(napi_exit);
+
+static inline uint64_t TuxedoIOProbeClockNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
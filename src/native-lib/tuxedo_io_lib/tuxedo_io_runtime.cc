@@ -0,0 +1,45 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstdlib>
+#include <mutex>
+#include "tuxedo_io_runtime.hh"
+
+static SimulatedIO *simulatedIO = nullptr;
+static std::once_flag runtimeInitFlag;
+
+SimulatedIO *TuxedoIOInitRuntime() {
+    std::call_once(runtimeInitFlag, []() {
+        const char *simulation = std::getenv("TUXEDO_IO_SIMULATION");
+        SimulatedIO::Platform platform;
+        if (simulation != nullptr && SimulatedIO::PlatformFromString(simulation, platform)) {
+            const char *moduleVersion = std::getenv("TUXEDO_IO_SIMULATION_VERSION");
+            simulatedIO = new SimulatedIO(platform, moduleVersion != nullptr ? moduleVersion : MOD_API_MIN_VERSION);
+            const char *telemetryGroups = std::getenv("TUXEDO_IO_SIMULATION_TELEMETRY");
+            if (telemetryGroups != nullptr) {
+                simulatedIO->SetTelemetryGroups(std::strtoul(telemetryGroups, nullptr, 0));
+            }
+            TuxedoIOAPI::DeviceOverride() = simulatedIO;
+        }
+    });
+    return simulatedIO;
+}
+
+SimulatedIO *TuxedoIOSimulation() {
+    return TuxedoIOInitRuntime();
+}
@@ -0,0 +1,41 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "tuxedo_io_api.hh"
+#include "tuxedo_io_arbiter.hh"
+#include "tuxedo_io_sim.hh"
+
+/**
+ * Process wide setup of the tuxedo_io library (static library target
+ * "tuxedo_io"), shared by the node addon and the tuxedo-io CLI
+ *
+ * Installs the simulated EC as device override when TUXEDO_IO_SIMULATION is
+ * set to clevo or uniwill (TUXEDO_IO_SIMULATION_VERSION sets the reported
+ * module version). Only the first call has an effect, safe to call from any
+ * thread.
+ *
+ * Returns the simulated EC or nullptr when the real device is used
+ */
+SimulatedIO *TuxedoIOInitRuntime();
+
+/**
+ * Simulated EC installed by TuxedoIOInitRuntime() or nullptr
+ */
+SimulatedIO *TuxedoIOSimulation();
@@ -0,0 +1,360 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include "tuxedo_io_api.hh"
+
+/**
+ * In-process model of the tuxedo_io EC interface. Answers the same ioctls
+ * as the kernel module for either the clevo or the uniwill interface so that
+ * the complete stack above IO can run without hardware.
+ *
+ * Modules from MOD_TELEMETRY_MIN_VERSION on answer R_TELEMETRY for the
+ * groups set with SetTelemetryGroups(), older ones only the single ioctls.
+ *
+ * Every write ioctl is recorded with a CLOCK_MONOTONIC timestamp (same clock
+ * as process.hrtime() in node) together with the resulting fan speeds.
+ */
+class SimulatedIO : public IO {
+public:
+    enum class Platform { Clevo, Uniwill };
+
+    static const int NR_FANS = 3;
+
+    struct WriteRecord {
+        uint64_t timestampNs;
+        unsigned long request;
+        int32_t argument;
+        int fanSpeedPercent[NR_FANS];
+    };
+
+    SimulatedIO(Platform platform, std::string moduleVersion = MOD_API_MIN_VERSION)
+        : platform(platform), moduleVersion(moduleVersion) {
+        for (int i = 0; i < NR_FANS; ++i) {
+            fanSpeedRaw[i] = 0;
+            fanTemperature[i] = 40;
+        }
+        if (platform == Platform::Uniwill) {
+            // Uniwill devices only expose two fans
+            fanTemperature[2] = 0;
+        }
+    }
+
+    virtual bool IOAvailable() {
+        return available;
+    }
+
+    static bool PlatformFromString(const std::string &name, Platform &platform) {
+        if (name == "clevo") {
+            platform = Platform::Clevo;
+        } else if (name == "uniwill") {
+            platform = Platform::Uniwill;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    Platform GetPlatform() const {
+        return platform;
+    }
+
+    void SetAvailable(bool status) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        available = status;
+    }
+
+    /**
+     * Latency added to every ioctl, the EC is accessed serialized like the real one
+     */
+    void SetIoctlLatency(std::chrono::microseconds latency) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        ioctlLatency = latency;
+    }
+
+    bool SetTemperature(const int fanNr, const int temperatureCelcius) {
+        if (fanNr < 0 || fanNr >= NR_FANS) { return false; }
+        std::lock_guard<std::mutex> lock(stateMutex);
+        fanTemperature[fanNr] = temperatureCelcius;
+        return true;
+    }
+
+    int GetFanSpeedPercent(const int fanNr) {
+        if (fanNr < 0 || fanNr >= NR_FANS) { return -1; }
+        std::lock_guard<std::mutex> lock(stateMutex);
+        return RawToPercent(fanSpeedRaw[fanNr]);
+    }
+
+    /**
+     * Returns all writes since the last call and clears the log
+     */
+    std::vector<WriteRecord> TakeWriteLog() {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        std::vector<WriteRecord> log;
+        log.swap(writeLog);
+        return log;
+    }
+
+    /**
+     * TUXEDO_IO_TELEMETRY_* groups filled by R_TELEMETRY, groups the
+     * interface has no values for are never filled
+     */
+    void SetTelemetryGroups(uint32_t groups) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        telemetryGroups = groups;
+    }
+
+    virtual std::atomic<int> &TelemetrySupport() {
+        return telemetrySupport;
+    }
+
+    uint64_t GetIoctlCount() {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        return ioctlCount;
+    }
+
+    /**
+     * Number of calls of one ioctl request
+     */
+    uint64_t GetIoctlCount(unsigned long request) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        auto count = requestCounts.find(request);
+        return count != requestCounts.end() ? count->second : 0;
+    }
+
+    /**
+     * Reported from now on, e.g. to simulate the module being replaced
+     */
+    void SetModuleVersion(const std::string &version) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        moduleVersion = version;
+    }
+
+    static uint64_t MonotonicNs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    }
+
+protected:
+    virtual int Ioctl(unsigned long request, void *argument) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        ++ioctlCount;
+        ++requestCounts[request];
+        if (ioctlLatency.count() > 0) {
+            std::this_thread::sleep_for(ioctlLatency);
+        }
+        int32_t *value = static_cast<int32_t *>(argument);
+
+        if (request == R_MOD_VERSION) {
+            return CopyString(argument, moduleVersion, 20);
+        } else if (request == R_HWCHECK_CL) {
+            *value = platform == Platform::Clevo ? 1 : 0;
+            return 0;
+        } else if (request == R_HWCHECK_UW) {
+            *value = platform == Platform::Uniwill ? 1 : 0;
+            return 0;
+        } else if (request == R_TELEMETRY && CheckMinVersionByStrings(moduleVersion, MOD_TELEMETRY_MIN_VERSION)) {
+            return ReadTelemetry(*static_cast<struct tuxedo_io_telemetry *>(argument));
+        }
+
+        int result = platform == Platform::Clevo ? ClevoIoctl(request, value, argument)
+                                                 : UniwillIoctl(request, value);
+        if (result >= 0 && _IOC_DIR(request) != _IOC_READ) {
+            RecordWrite(request, value != nullptr ? *value : 0);
+        }
+        return result;
+    }
+
+private:
+    Platform platform;
+    std::string moduleVersion;
+    bool available = true;
+    std::chrono::microseconds ioctlLatency { 0 };
+    uint32_t telemetryGroups = TUXEDO_IO_TELEMETRY_FAN_SPEED | TUXEDO_IO_TELEMETRY_FAN_TEMP
+        | TUXEDO_IO_TELEMETRY_TDP | TUXEDO_IO_TELEMETRY_TDP_LIMITS | TUXEDO_IO_TELEMETRY_MODE;
+    std::atomic<int> telemetrySupport { TELEMETRY_UNKNOWN };
+
+    std::mutex stateMutex;
+    int fanSpeedRaw[NR_FANS];
+    int fanTemperature[NR_FANS];
+    bool fansAuto = true;
+    bool modeEnabled = false;
+    int webcam = 1;
+    int performanceProfile = 0;
+    int tdp[3] = { 25, 35, 45 };
+    const int tdpMin[3] = { 5, 5, 5 };
+    const int tdpMax[3] = { 45, 60, 90 };
+
+    uint64_t ioctlCount = 0;
+    std::map<unsigned long, uint64_t> requestCounts;
+    std::vector<WriteRecord> writeLog;
+
+    int MaxFanSpeedRaw() const {
+        return platform == Platform::Clevo ? 0xff : 0xc8;
+    }
+
+    int RawToPercent(int raw) const {
+        return (int) std::round(raw * 100.0 / MaxFanSpeedRaw());
+    }
+
+    static int CopyString(void *argument, const std::string &str, size_t bufferLength) {
+        strncpy(static_cast<char *>(argument), str.c_str(), bufferLength - 1);
+        return 0;
+    }
+
+    void RecordWrite(unsigned long request, int32_t argument) {
+        WriteRecord record;
+        record.timestampNs = MonotonicNs();
+        record.request = request;
+        record.argument = argument;
+        for (int i = 0; i < NR_FANS; ++i) {
+            record.fanSpeedPercent[i] = RawToPercent(fanSpeedRaw[i]);
+        }
+        writeLog.push_back(record);
+    }
+
+    int ReadTelemetry(struct tuxedo_io_telemetry &telemetry) {
+        if (telemetry.version < 1 || telemetry.size < sizeof(struct tuxedo_io_telemetry)) {
+            errno = EINVAL;
+            return -1;
+        }
+        uint32_t groups = telemetryGroups;
+        telemetry.version = 1;
+        telemetry.valid = 0;
+        telemetry.nr_fans = platform == Platform::Clevo ? 3 : 2;
+        for (int i = 0; i < telemetry.nr_fans; ++i) {
+            telemetry.fan_speed[i] = fanSpeedRaw[i];
+            telemetry.fan_temp[i] = platform == Platform::Clevo ? (int8_t) fanTemperature[i] : fanTemperature[i];
+        }
+        telemetry.valid |= groups & (TUXEDO_IO_TELEMETRY_FAN_SPEED | TUXEDO_IO_TELEMETRY_FAN_TEMP);
+        if (platform == Platform::Uniwill) {
+            telemetry.nr_tdps = 3;
+            for (int i = 0; i < 3; ++i) {
+                telemetry.tdp[i] = tdp[i];
+                telemetry.tdp_min[i] = tdpMin[i];
+                telemetry.tdp_max[i] = tdpMax[i];
+            }
+            telemetry.mode = 0;
+            telemetry.mode_enable = modeEnabled ? 1 : 0;
+            telemetry.valid |= groups & (TUXEDO_IO_TELEMETRY_TDP | TUXEDO_IO_TELEMETRY_TDP_LIMITS | TUXEDO_IO_TELEMETRY_MODE);
+        }
+        return 0;
+    }
+
+    int ClevoIoctl(unsigned long request, int32_t *value, void *argument) {
+        if (request == R_CL_HW_IF_STR) {
+            return CopyString(argument, "clevo_acpi", 50);
+        } else if (request == R_CL_FANINFO1 || request == R_CL_FANINFO2 || request == R_CL_FANINFO3) {
+            int fanNr = request == R_CL_FANINFO1 ? 0 : (request == R_CL_FANINFO2 ? 1 : 2);
+            int temp = fanTemperature[fanNr] & 0xff;
+            *value = (fanSpeedRaw[fanNr] & 0xff) | (temp << 0x08) | (temp << 0x10);
+        } else if (request == R_CL_WEBCAM_SW) {
+            *value = webcam;
+        } else if (request == W_CL_FANSPEED) {
+            for (int i = 0; i < NR_FANS; ++i) {
+                fanSpeedRaw[i] = (*value >> (i * 8)) & 0xff;
+            }
+            fansAuto = false;
+        } else if (request == W_CL_FANAUTO) {
+            fansAuto = true;
+        } else if (request == W_CL_WEBCAM_SW) {
+            webcam = *value;
+        } else if (request == W_CL_PERF_PROFILE) {
+            performanceProfile = *value;
+        } else {
+            errno = ENOTTY;
+            return -1;
+        }
+        return 0;
+    }
+
+    int UniwillIoctl(unsigned long request, int32_t *value) {
+        const unsigned long tdpGet[] = { R_UW_TDP0, R_UW_TDP1, R_UW_TDP2 };
+        const unsigned long tdpGetMin[] = { R_UW_TDP0_MIN, R_UW_TDP1_MIN, R_UW_TDP2_MIN };
+        const unsigned long tdpGetMax[] = { R_UW_TDP0_MAX, R_UW_TDP1_MAX, R_UW_TDP2_MAX };
+        const unsigned long tdpSet[] = { W_UW_TDP0, W_UW_TDP1, W_UW_TDP2 };
+        for (int i = 0; i < 3; ++i) {
+            if (request == tdpGet[i]) {
+                *value = tdp[i];
+                return 0;
+            } else if (request == tdpGetMin[i]) {
+                *value = tdpMin[i];
+                return 0;
+            } else if (request == tdpGetMax[i]) {
+                *value = tdpMax[i];
+                return 0;
+            } else if (request == tdpSet[i]) {
+                if (*value < tdpMin[i] || *value > tdpMax[i]) {
+                    errno = EINVAL;
+                    return -1;
+                }
+                tdp[i] = *value;
+                return 0;
+            }
+        }
+
+        if (request == R_UW_MODEL_ID) {
+            *value = 0x13;
+        } else if (request == R_UW_FANSPEED) {
+            *value = fanSpeedRaw[0];
+        } else if (request == R_UW_FANSPEED2) {
+            *value = fanSpeedRaw[1];
+        } else if (request == R_UW_FAN_TEMP) {
+            *value = fanTemperature[0];
+        } else if (request == R_UW_FAN_TEMP2) {
+            *value = fanTemperature[1];
+        } else if (request == R_UW_MODE_ENABLE) {
+            *value = modeEnabled ? 1 : 0;
+        } else if (request == R_UW_FANS_OFF_AVAILABLE) {
+            *value = 1;
+        } else if (request == R_UW_FANS_MIN_SPEED) {
+            *value = 20;
+        } else if (request == R_UW_PROFS_AVAILABLE) {
+            *value = 3;
+        } else if (request == W_UW_FANSPEED || request == W_UW_FANSPEED2) {
+            if (*value < 0 || *value > MaxFanSpeedRaw()) {
+                errno = EINVAL;
+                return -1;
+            }
+            fanSpeedRaw[request == W_UW_FANSPEED ? 0 : 1] = *value;
+            fansAuto = false;
+        } else if (request == W_UW_MODE_ENABLE) {
+            modeEnabled = *value != 0;
+        } else if (request == W_UW_FANAUTO) {
+            fansAuto = true;
+        } else if (request == W_UW_PERF_PROF) {
+            performanceProfile = *value;
+        } else {
+            errno = ENOTTY;
+            return -1;
+        }
+        return 0;
+    }
+};
@@ -17,16 +17,146 @@
  * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include <napi.h>
+#include <uv.h>
 #include <string>
 #include <cmath>
 #include <libudev.h>
 #include <vector>
+#include <cstdlib>
+#include <mutex>
+#include <memory>
 #include "tuxedo_io_lib/tuxedo_io_api.hh"
+#include "tuxedo_io_lib/led_frame_engine.hh"
+#include "tuxedo_io_lib/tdp_autotuner.hh"
+#include "tuxedo_io_lib/load_classifier.hh"
+#include "tuxedo_io_lib/throttle_monitor.hh"
+#include "tuxedo_io_lib/sysfs_batch_writer.hh"
+#include "tuxedo_io_lib/cpu_state_reconciler.hh"
+#include "tuxedo_io_lib/drm_connector_catalog.hh"
+#include "tuxedo_io_lib/coalescing_timer.hh"
+#include "tuxedo_io_lib/sysfs_notify_watcher.hh"
+#include "tuxedo_io_lib/metrics_exporter.hh"
+#include "tuxedo_io_lib/telemetry_page.hh"
+#include "tuxedo_io_lib/tuxedo_io_runtime.hh"
 
 using namespace Napi;
 
+/**
+ * State of the addon per node environment (main thread and each worker_thread
+ * loading the module), released when the environment is torn down. Device
+ * access itself is process wide and goes through the DeviceArbiter.
+ */
+struct AddonData {
+    uint64_t deviceCalls = 0;
+    std::unique_ptr<LedFrameEngine> ledFrameEngine;
+    std::unique_ptr<TDPAutotuner> tdpAutotuner;
+    std::unique_ptr<LoadMonitor> loadMonitor;
+    std::unique_ptr<ThrottleMonitor> throttleMonitor;
+    std::string throttleTccProfile;
+    std::string throttleOdmProfile;
+    // Declared before the exporter which renders it
+    MetricsRegistry metricsRegistry;
+    std::unique_ptr<MetricsExporter> metricsExporter;
+    TelemetryPageWriter telemetryPageWriter;
+    TelemetryPageReader telemetryPageReader;
+    std::unique_ptr<SysFsBatchWriter> sysFsBatchWriter;
+    std::unique_ptr<CpuStateReconciler> cpuStateReconciler;
+    std::unique_ptr<DrmConnectorCatalog> drmCatalog;
+    struct udev *udev = nullptr;
+    struct udev_monitor *drmMonitor = nullptr;
+    std::unique_ptr<CoalescingTimer> schedulerTimer;
+    uv_poll_t *schedulerPoll = nullptr;
+    FunctionReference schedulerCallback;
+    std::unique_ptr<SysFsNotifyWatcher> sysFsWatcher;
+    uv_poll_t *sysFsWatcherPoll = nullptr;
+    FunctionReference sysFsWatcherCallback;
+
+    ~AddonData() {
+        StopScheduler();
+        StopSysFsWatcher();
+        if (drmMonitor != nullptr) { udev_monitor_unref(drmMonitor); }
+        if (udev != nullptr) { udev_unref(udev); }
+    }
+
+    void StopScheduler() {
+        if (schedulerPoll != nullptr) {
+            uv_poll_stop(schedulerPoll);
+            uv_close(reinterpret_cast<uv_handle_t *>(schedulerPoll), [](uv_handle_t *handle) {
+                delete reinterpret_cast<uv_poll_t *>(handle);
+            });
+            schedulerPoll = nullptr;
+        }
+        schedulerTimer.reset();
+        schedulerCallback.Reset();
+    }
+
+    void StopSysFsWatcher() {
+        if (sysFsWatcherPoll != nullptr) {
+            uv_poll_stop(sysFsWatcherPoll);
+            uv_close(reinterpret_cast<uv_handle_t *>(sysFsWatcherPoll), [](uv_handle_t *handle) {
+                delete reinterpret_cast<uv_poll_t *>(handle);
+            });
+            sysFsWatcherPoll = nullptr;
+        }
+        sysFsWatcher.reset();
+        sysFsWatcherCallback.Reset();
+    }
+};
+
+static void FinalizeAddonData(napi_env env, void *data, void *hint) {
+    delete static_cast<AddonData *>(data);
+}
+
+static AddonData *GetAddonData(napi_env env) {
+    void *data = nullptr;
+    napi_get_instance_data(env, &data);
+    return static_cast<AddonData *>(data);
+}
+
+/**
+ * Arbitrated device access on behalf of a node environment
+ */
+class EnvDeviceSession : public DeviceSession {
+public:
+    EnvDeviceSession(napi_env env) {
+        AddonData *addonData = GetAddonData(env);
+        if (addonData != nullptr) {
+            addonData->deviceCalls++;
+        }
+    }
+};
+
+/**
+ * napi_entry/napi_exit probes around a call into the addon
+ */
+class NapiCallProbe {
+public:
+    NapiCallProbe(const char *name) : name(name) {
+        TUXEDO_IO_PROBE1(napi_entry, name);
+        startNs = TUXEDO_IO_PROBE_ENABLED(napi_exit) ? TuxedoIOProbeClockNs() : 0;
+    }
+
+    ~NapiCallProbe() {
+        uint64_t durationNs = startNs != 0 ? TuxedoIOProbeClockNs() - startNs : 0;
+        TUXEDO_IO_PROBE2(napi_exit, name, durationNs);
+    }
+
+private:
+    const char *name;
+    uint64_t startNs;
+};
+
+template <typename Callback>
+static Function TracedFunction(Env env, const char *name, Callback callback) {
+    return Function::New(env, [name, callback](const CallbackInfo &info) -> decltype(callback(info)) {
+        NapiCallProbe probe(name);
+        return callback(info);
+    }, name);
+}
+
 Boolean GetModuleInfo(const CallbackInfo &info) {
-    TuxedoIOAPI io;
+    EnvDeviceSession session(info.Env());
+    TuxedoIOAPI &io = session.API();
     if (info.Length() != 1 || !info[0].IsObject()) { throw Napi::Error::New(info.Env(), "GetModuleInfo - invalid argument"); }
 
     Object moduleInfo = info[0].As<Object>();
@@ -49,73 +179,140 @@ Boolean GetModuleInfo(const CallbackInfo &info) {
     return Boolean::New(info.Env(), result);
 }
 
-static inline bool CheckMinVersionByStrings(std::string version, std::string minVersion) {
-    unsigned modVersionMajor, modVersionMinor, modVersionPatch, modAPIMinVersionMajor, modAPIMinVersionMinor, modAPIMinVersionPatch;
-    if (sscanf(version.c_str(), "%u.%u.%u", &modVersionMajor, &modVersionMinor, &modVersionPatch) < 3 ||
-            sscanf(minVersion.c_str(), "%u.%u.%u", &modAPIMinVersionMajor, &modAPIMinVersionMinor, &modAPIMinVersionPatch) < 3) {
-        return false;
-    }
-
-    if (modVersionMajor < modAPIMinVersionMajor ||
-            (modVersionMajor == modAPIMinVersionMajor && modVersionMinor < modAPIMinVersionMinor) ||
-            (modVersionMajor == modAPIMinVersionMajor && modVersionMinor == modAPIMinVersionMinor && modVersionPatch < modAPIMinVersionPatch)) {
-        return false;
-    }
+static bool CheckWmiAvailable(TuxedoIOAPI &io) {
+    std::string modVersion, modAPIMinVersion;
 
-    return true;
+    return io.GetModuleVersion(modVersion) &&
+           io.GetModuleAPIMinVersion(modAPIMinVersion) &&
+           CheckMinVersionByStrings(modVersion, modAPIMinVersion) &&
+           io.WmiAvailable();
 }
 
 Boolean WmiAvailable(const CallbackInfo &info) {
-    TuxedoIOAPI io;
+    EnvDeviceSession session(info.Env());
+    TuxedoIOAPI &io = session.API();
 
-    std::string modVersion, modAPIMinVersion;
-
-    bool availability = io.GetModuleVersion(modVersion) &&
-                        io.GetModuleAPIMinVersion(modAPIMinVersion) &&
-                        CheckMinVersionByStrings(modVersion, modAPIMinVersion) &&
-                        io.WmiAvailable();
+    bool availability = CheckWmiAvailable(io);
 
     return Boolean::New(info.Env(), availability);
 }
 
+/**
+ * Collects everything the daemon needs to know about the tuxedo_io interface
+ * on start within one device session
+ */
+Object ProbeCapabilities(const CallbackInfo &info) {
+    EnvDeviceSession session(info.Env());
+    TuxedoIOAPI &io = session.API();
+    Object capabilities = Object::New(info.Env());
+
+    std::string moduleVersion;
+    io.GetModuleVersion(moduleVersion);
+    bool wmiAvailable = CheckWmiAvailable(io);
+    capabilities.Set("moduleVersion", moduleVersion);
+    capabilities.Set("wmiAvailable", wmiAvailable);
+
+    std::string activeInterface;
+    if (!io.DeviceInterfaceIdStr(activeInterface)) {
+        activeInterface = "inactive";
+    }
+    capabilities.Set("activeInterface", activeInterface);
+    std::string model;
+    io.DeviceModelIdStr(model);
+    capabilities.Set("model", model);
+
+    int nrFans = 0, fansMinSpeed = 0;
+    bool fansOffAvailable = true;
+    if (wmiAvailable) {
+        io.GetNumberFans(nrFans);
+        io.GetFansMinSpeed(fansMinSpeed);
+        io.GetFansOffAvailable(fansOffAvailable);
+    }
+    capabilities.Set("nrFans", nrFans);
+    capabilities.Set("fansMinSpeed", fansMinSpeed);
+    capabilities.Set("fansOffAvailable", fansOffAvailable);
+
+    bool webcamStatus;
+    capabilities.Set("webcamSwitchAvailable", wmiAvailable && io.GetWebcam(webcamStatus));
+
+    std::vector<std::string> profiles;
+    std::string defaultProfile;
+    if (wmiAvailable && io.GetAvailableODMPerformanceProfiles(profiles)) {
+        io.GetDefaultODMPerformanceProfile(defaultProfile);
+    }
+    Array odmProfiles = Array::New(info.Env());
+    for (std::size_t i = 0; i < profiles.size(); ++i) {
+        odmProfiles.Set(i, profiles[i]);
+    }
+    capabilities.Set("odmProfiles", odmProfiles);
+    capabilities.Set("odmDefaultProfile", defaultProfile);
+
+    int nrTDPs = 0;
+    std::vector<std::string> tdpDescriptors;
+    if (wmiAvailable) {
+        io.GetTDPDescriptors(tdpDescriptors);
+        io.GetNumberTDPs(nrTDPs);
+    }
+    Array tdps = Array::New(info.Env());
+    for (int i = 0; i < nrTDPs && i < (int) tdpDescriptors.size(); ++i) {
+        Object tdp = Object::New(info.Env());
+        int minValue = 0, maxValue = 0;
+        io.GetTDPMin(i, minValue);
+        io.GetTDPMax(i, maxValue);
+        tdp.Set("descriptor", tdpDescriptors[i]);
+        tdp.Set("min", minValue);
+        tdp.Set("max", maxValue);
+        tdps.Set(i, tdp);
+    }
+    capabilities.Set("tdps", tdps);
+
+    return capabilities;
+}
+
 Boolean SetEnableModeSet(const CallbackInfo &info) {
     if (info.Length() != 1 || !info[0].IsBoolean()) { throw Napi::Error::New(info.Env(), "SetEnableModeSet - invalid argument"); }
-    TuxedoIOAPI io;
+    EnvDeviceSession session(info.Env());
+    TuxedoIOAPI &io = session.API();
     bool enabled = info[0].As<Boolean>();
     bool result = io.SetEnableModeSet(enabled);
     return Boolean::New(info.Env(), result);
 }
 
 Number GetFansMinSpeed(const CallbackInfo &info) {
-    TuxedoIOAPI io;
+    EnvDeviceSession session(info.Env());
+    TuxedoIOAPI &io = session.API();
     int minSpeed = 0;
     io.GetFansMinSpeed(minSpeed);
     return Number::New(info.Env(), minSpeed);
 }
 
 Boolean GetFansOffAvailable(const CallbackInfo &info) {
-    TuxedoIOAPI io;
+    EnvDeviceSession session(info.Env());
+    TuxedoIOAPI &io = session.API();
     bool offAvailable = true;
     io.GetFansOffAvailable(offAvailable);
     return Boolean::New(info.Env(), offAvailable);
 }
 
 Number GetNumberFans(const CallbackInfo &info) {
-    TuxedoIOAPI io;
+    EnvDeviceSession session(info.Env());
+    TuxedoIOAPI &io = session.API();
     int nrFans = 0;
     io.GetNumberFans(nrFans);
     return Number::New(info.Env(), nrFans);
 }
 
 Boolean SetFansAuto(const CallbackInfo &info) {
-    TuxedoIOAPI io;
+    EnvDeviceSession session(info.Env());
+    TuxedoIOAPI &io = session.API();
     bool result = io.SetFansAuto();
     return Boolean::New(info.Env(), result);
 }
 
 Boolean SetFanSpeedPercent(const CallbackInfo &info) {
     if (info.Length() != 2 || !info[0].IsNumber() || !info[1].IsNumber()) { throw Napi::Error::New(info.Env(), "SetFanSpeedPercent - invalid argument"); }
-    TuxedoIOAPI io;
+    EnvDeviceSession session(info.Env());
+    TuxedoIOAPI &io = session.API();
 
     int fanNumber = info[0].As<Number>();
     int fanSpeedPercent = info[1].As<Number>();
@@ -125,7 +322,8 @@ Boolean SetFanSpeedPercent(const CallbackInfo &info) {
 
 Boolean GetFanSpeedPercent(const CallbackInfo &info) {
     if (info.Length() != 2 || !info[0].IsNumber() || !info[1].IsObject()) { throw Napi::Error::New(info.Env(), "GetFanSpeedPercent - invalid argument"); }
-    TuxedoIOAPI io;
+    EnvDeviceSession session(info.Env());
+    TuxedoIOAPI &io = session.API();
     int fanNumber = info[0].As<Number>();
     int fanSpeedPercent;
     bool result = io.GetFanSpeedPercent(fanNumber, fanSpeedPercent);
@@ -136,7 +334,8 @@ Boolean GetFanSpeedPercent(const CallbackInfo &info) {
 
 Boolean GetFanTemperature(const CallbackInfo &info) {
     if (info.Length() != 2 || !info[0].IsNumber() || !info[1].IsObject()) { throw Napi::Error::New(info.Env(), "GetFanTemperature - invalid argument"); }
-    TuxedoIOAPI io;
+    EnvDeviceSession session(info.Env());
+    TuxedoIOAPI &io = session.API();
     int fanNumber = info[0].As<Number>();
     int temperatureCelcius;
     bool result = io.GetFanTemperature(fanNumber, temperatureCelcius);
@@ -145,8 +344,42 @@ Boolean GetFanTemperature(const CallbackInfo &info) {
     return Boolean::New(info.Env(), result);
 }
 
+Boolean GetDeviceTelemetry(const CallbackInfo &info) {
+    if (info.Length() != 1 || !info[0].IsObject()) { throw Napi::Error::New(info.Env(), "GetDeviceTelemetry - invalid argument"); }
+    EnvDeviceSession session(info.Env());
+    TuxedoIOAPI &io = session.API();
+    DeviceTelemetry telemetry;
+    bool result = io.ReadTelemetry(telemetry);
+    Object telemetryObject = info[0].As<Object>();
+    Array fans = Array::New(info.Env());
+    for (int i = 0; i < telemetry.nrFans; ++i) {
+        Object fan = Object::New(info.Env());
+        fan.Set("speedPercent", telemetry.fanSpeedPercent[i]);
+        fan.Set("temperature", telemetry.fanTemperature[i]);
+        fans[i] = fan;
+    }
+    Array tdps = Array::New(info.Env());
+    for (int i = 0; i < telemetry.nrTDPs; ++i) {
+        Object tdp = Object::New(info.Env());
+        tdp.Set("current", telemetry.tdp[i]);
+        tdp.Set("min", telemetry.tdpMin[i]);
+        tdp.Set("max", telemetry.tdpMax[i]);
+        tdps[i] = tdp;
+    }
+    telemetryObject.Set("fans", fans);
+    telemetryObject.Set("tdps", tdps);
+    telemetryObject.Set("batched", telemetry.batchedGroups != 0);
+    return Boolean::New(info.Env(), result);
+}
+
+Boolean GetTelemetryBatchSupported(const CallbackInfo &info) {
+    EnvDeviceSession session(info.Env());
+    return Boolean::New(info.Env(), session.API().TelemetryBatchSupported());
+}
+
 Boolean SetWebcamStatus(const CallbackInfo &info) {
-    TuxedoIOAPI io;
+    EnvDeviceSession session(info.Env());
+    TuxedoIOAPI &io = session.API();
     if (info.Length() != 1 || !info[0].IsBoolean()) { throw Napi::Error::New(info.Env(), "SetWebcamStatus - invalid argument"); }
     bool status = info[0].As<Boolean>();
     bool result = io.SetWebcam(status);
@@ -155,7 +388,8 @@ Boolean SetWebcamStatus(const CallbackInfo &info) {
 
 Boolean GetWebcamStatus(const CallbackInfo &info) {
     if (info.Length() != 1 || !info[0].IsObject()) { throw Napi::Error::New(info.Env(), "GetWebcamStatus - invalid argument"); }
-    TuxedoIOAPI io;
+    EnvDeviceSession session(info.Env());
+    TuxedoIOAPI &io = session.API();
     bool status = false;
     bool result = io.GetWebcam(status);
     Object objWrapper = info[0].As<Object>();
@@ -204,9 +438,89 @@ Array GetOutputPorts(const CallbackInfo &info) {
     return result;
 }
 
+/**
+ * Connector catalog of the environment, rescanned only after drm uevents.
+ * Without udev monitor every call rescans.
+ */
+static DrmConnectorCatalog &GetEnvDrmCatalog(napi_env env) {
+    AddonData *addonData = GetAddonData(env);
+    if (!addonData->drmCatalog) {
+        // Alternative sysfs tree for tests
+        const char *drmPath = std::getenv("TUXEDO_IO_DRM_SYSFS");
+        addonData->drmCatalog.reset(new DrmConnectorCatalog(drmPath != nullptr ? drmPath : "/sys/class/drm"));
+        addonData->udev = udev_new();
+        if (addonData->udev != nullptr) {
+            addonData->drmMonitor = udev_monitor_new_from_netlink(addonData->udev, "udev");
+            if (addonData->drmMonitor != nullptr
+                    && (udev_monitor_filter_add_match_subsystem_devtype(addonData->drmMonitor, "drm", nullptr) < 0
+                        || udev_monitor_enable_receiving(addonData->drmMonitor) < 0)) {
+                udev_monitor_unref(addonData->drmMonitor);
+                addonData->drmMonitor = nullptr;
+            }
+        }
+        return *addonData->drmCatalog;
+    }
+
+    if (addonData->drmMonitor == nullptr) {
+        addonData->drmCatalog->Invalidate();
+    } else {
+        // Monitor socket is non blocking, drain pending events
+        struct udev_device *device;
+        while ((device = udev_monitor_receive_device(addonData->drmMonitor)) != nullptr) {
+            addonData->drmCatalog->Invalidate();
+            udev_device_unref(device);
+        }
+    }
+    return *addonData->drmCatalog;
+}
+
+Object GetDrmCatalog(const CallbackInfo &info) {
+    DrmConnectorCatalog &catalog = GetEnvDrmCatalog(info.Env());
+    const std::vector<DrmConnector> &connectors = catalog.GetConnectors();
+    Object result = Object::New(info.Env());
+    result.Set("generation", (double) catalog.GetGeneration());
+    result.Set("scans", (double) catalog.GetScans());
+    Array connectorsArray = Array::New(info.Env());
+    for (std::size_t i = 0; i < connectors.size(); ++i) {
+        Object connector = Object::New(info.Env());
+        connector.Set("card", connectors[i].card);
+        connector.Set("name", connectors[i].name);
+        connector.Set("status", connectors[i].status);
+        connector.Set("enabled", connectors[i].enabled);
+        Array modes = Array::New(info.Env());
+        for (std::size_t m = 0; m < connectors[i].modes.size(); ++m) {
+            modes.Set(m, connectors[i].modes[m]);
+        }
+        connector.Set("modes", modes);
+        if (connectors[i].hasEdid) {
+            const EdidInfo &edid = connectors[i].edid;
+            Object edidObject = Object::New(info.Env());
+            edidObject.Set("manufacturer", edid.manufacturer);
+            edidObject.Set("productCode", edid.productCode);
+            edidObject.Set("monitorName", edid.monitorName);
+            Array timings = Array::New(info.Env());
+            for (std::size_t t = 0; t < edid.timings.size(); ++t) {
+                Object timing = Object::New(info.Env());
+                timing.Set("width", edid.timings[t].width);
+                timing.Set("height", edid.timings[t].height);
+                timing.Set("refreshRate", edid.timings[t].refreshRate);
+                timing.Set("interlaced", edid.timings[t].interlaced);
+                timing.Set("preferred", edid.timings[t].preferred);
+                timings.Set(t, timing);
+            }
+            edidObject.Set("timings", timings);
+            connector.Set("edid", edidObject);
+        }
+        connectorsArray.Set(i, connector);
+    }
+    result.Set("connectors", connectorsArray);
+    return result;
+}
+
 Boolean GetAvailableODMPerformanceProfiles(const CallbackInfo &info) {
     if (info.Length() != 1 || !info[0].IsObject()) { throw Napi::Error::New(info.Env(), "GetAvailableODMPerformanceProfiles - invalid argument"); }
-    TuxedoIOAPI io;
+    EnvDeviceSession session(info.Env());
+    TuxedoIOAPI &io = session.API();
     Object objWrapper = info[0].As<Object>();
     std::vector<std::string> profiles;
     bool result = io.GetAvailableODMPerformanceProfiles(profiles);
@@ -221,7 +535,8 @@ Boolean GetAvailableODMPerformanceProfiles(const CallbackInfo &info) {
 Boolean SetODMPerformanceProfile(const CallbackInfo &info) {
     if (info.Length() != 1 || !info[0].IsString()) { throw Napi::Error::New(info.Env(), "SetODMPerformanceProfile - invalid argument"); }
     std::string performanceProfile = info[0].As<String>();
-    TuxedoIOAPI io;
+    EnvDeviceSession session(info.Env());
+    TuxedoIOAPI &io = session.API();
     bool result = io.SetODMPerformanceProfile(performanceProfile);
     return Boolean::New(info.Env(), result);
 }
@@ -229,7 +544,8 @@ Boolean SetODMPerformanceProfile(const CallbackInfo &info) {
 Boolean GetDefaultODMPerformanceProfile(const CallbackInfo &info) {
     if (info.Length() != 1 || !info[0].IsObject()) { throw Napi::Error::New(info.Env(), "GetDefaultODMPerformanceProfile - invalid argument"); }
     Object objWrapper = info[0].As<Object>();
-    TuxedoIOAPI io;
+    EnvDeviceSession session(info.Env());
+    TuxedoIOAPI &io = session.API();
     std::string profileName;
     bool result = io.GetDefaultODMPerformanceProfile(profileName);
     objWrapper.Set("value", profileName);
@@ -239,7 +555,8 @@ Boolean GetDefaultODMPerformanceProfile(const CallbackInfo &info) {
 Boolean GetTDPInfo(const CallbackInfo &info) {
     if (info.Length() != 1 || !info[0].IsArray()) { throw Napi::Error::New(info.Env(), "GetTDPInfo - invalid argument"); }
     Array tdpArray = info[0].As<Array>();
-    TuxedoIOAPI io;
+    EnvDeviceSession session(info.Env());
+    TuxedoIOAPI &io = session.API();
     bool result;
     int nrTDPs = 0;
     std::vector<std::string> tdpDescriptors;
@@ -262,7 +579,8 @@ Boolean GetTDPInfo(const CallbackInfo &info) {
 
 Boolean SetTDPValues(const CallbackInfo &info) {
     if (info.Length() != 1 || !info[0].IsArray()) { throw Napi::Error::New(info.Env(), "SetTDP - invalid argument"); }
-    TuxedoIOAPI io;
+    EnvDeviceSession session(info.Env());
+    TuxedoIOAPI &io = session.API();
     Array tdpValues = info[0].As<Array>();
     int nrInputs = tdpValues.Length();
     bool result;
@@ -279,37 +597,858 @@ Boolean SetTDPValues(const CallbackInfo &info) {
     return Boolean::New(info.Env(), result);
 }
 
+static int GetIntProperty(Object object, const char *name, int defaultValue) {
+    if (!object.Has(name) || !object.Get(name).IsNumber()) {
+        return defaultValue;
+    }
+    return object.Get(name).As<Number>();
+}
+
+static double GetDoubleProperty(Object object, const char *name, double defaultValue) {
+    if (!object.Has(name) || !object.Get(name).IsNumber()) {
+        return defaultValue;
+    }
+    return object.Get(name).As<Number>();
+}
+
+static Object TDPAutotunerDecisionToObject(Env env, const TDPAutotuner::Decision &decision) {
+    Object result = Object::New(env);
+    result.Set("timestampMs", (double) decision.timestampMs);
+    if (std::isnan(decision.packagePowerW)) {
+        result.Set("packagePowerW", env.Undefined());
+    } else {
+        result.Set("packagePowerW", decision.packagePowerW);
+    }
+    result.Set("temperature", decision.temperature);
+    result.Set("fanSpeedPercent", decision.fanSpeedPercent);
+    result.Set("action", TDPAutotuner::ActionToString(decision.action));
+    result.Set("reason", decision.reason);
+    Array tdpValues = Array::New(env);
+    for (std::size_t i = 0; i < decision.tdpValues.size(); ++i) {
+        tdpValues.Set(i, decision.tdpValues[i]);
+    }
+    result.Set("tdpValues", tdpValues);
+    return result;
+}
+
+Value TDPAutotunerStep(const CallbackInfo &info) {
+    if (info.Length() != 1 || !info[0].IsObject()) { throw Napi::Error::New(info.Env(), "TDPAutotunerStep - invalid argument"); }
+    Object configObject = info[0].As<Object>();
+    AddonData *addonData = GetAddonData(info.Env());
+    if (!addonData->tdpAutotuner) {
+        addonData->tdpAutotuner.reset(new TDPAutotuner());
+    }
+    TDPAutotuner::Config config;
+    config.targetTemperature = GetIntProperty(configObject, "targetTemperature", config.targetTemperature);
+    config.temperatureHysteresis = GetIntProperty(configObject, "temperatureHysteresis", config.temperatureHysteresis);
+    config.maxFanSpeedPercent = GetIntProperty(configObject, "maxFanSpeedPercent", config.maxFanSpeedPercent);
+    config.stepWatts = GetIntProperty(configObject, "stepWatts", config.stepWatts);
+    config.minChangeIntervalMs = GetIntProperty(configObject, "minChangeIntervalMs", (int) config.minChangeIntervalMs);
+    addonData->tdpAutotuner->SetConfig(config);
+
+    EnvDeviceSession session(info.Env());
+    TDPAutotuner::Decision decision;
+    if (!addonData->tdpAutotuner->Step(session.API(), decision) && decision.tdpValues.empty()) {
+        return info.Env().Undefined();
+    }
+    return TDPAutotunerDecisionToObject(info.Env(), decision);
+}
+
+void TDPAutotunerReset(const CallbackInfo &info) {
+    GetAddonData(info.Env())->tdpAutotuner.reset();
+}
+
+Array TDPAutotunerGetDecisions(const CallbackInfo &info) {
+    Array result = Array::New(info.Env());
+    TDPAutotuner *autotuner = GetAddonData(info.Env())->tdpAutotuner.get();
+    if (autotuner != nullptr) {
+        std::vector<TDPAutotuner::Decision> decisions = autotuner->GetDecisions();
+        for (std::size_t i = 0; i < decisions.size(); ++i) {
+            result.Set(i, TDPAutotunerDecisionToObject(info.Env(), decisions[i]));
+        }
+    }
+    return result;
+}
+
+Boolean LoadMonitorStart(const CallbackInfo &info) {
+    if (info.Length() != 1 || !info[0].IsObject()) { throw Napi::Error::New(info.Env(), "LoadMonitorStart - invalid argument"); }
+    Object configObject = info[0].As<Object>();
+    LoadClassifier::Config config;
+    config.heavyThreshold = GetIntProperty(configObject, "heavyThreshold", config.heavyThreshold);
+    config.coreHeavyThreshold = GetIntProperty(configObject, "coreHeavyThreshold", config.coreHeavyThreshold);
+    config.idleThreshold = GetIntProperty(configObject, "idleThreshold", config.idleThreshold);
+    config.hysteresis = GetIntProperty(configObject, "hysteresis", config.hysteresis);
+    config.windowSamples = GetIntProperty(configObject, "windowSamples", config.windowSamples);
+    config.heavyDwellMs = GetIntProperty(configObject, "heavyDwellMs", config.heavyDwellMs);
+    config.burstyDwellMs = GetIntProperty(configObject, "burstyDwellMs", config.burstyDwellMs);
+    config.idleDwellMs = GetIntProperty(configObject, "idleDwellMs", config.idleDwellMs);
+    int sampleIntervalMs = GetIntProperty(configObject, "sampleIntervalMs", 1000);
+    std::string gpuBusyPath;
+    if (configObject.Has("gpuBusyPath") && configObject.Get("gpuBusyPath").IsString()) {
+        gpuBusyPath = configObject.Get("gpuBusyPath").As<String>();
+    }
+    AddonData *addonData = GetAddonData(info.Env());
+    addonData->loadMonitor.reset();
+    addonData->loadMonitor.reset(new LoadMonitor(config, sampleIntervalMs, gpuBusyPath));
+    return Boolean::New(info.Env(), true);
+}
+
+void LoadMonitorStop(const CallbackInfo &info) {
+    GetAddonData(info.Env())->loadMonitor.reset();
+}
+
+Value LoadMonitorGetState(const CallbackInfo &info) {
+    LoadMonitor *monitor = GetAddonData(info.Env())->loadMonitor.get();
+    if (monitor == nullptr) { return info.Env().Undefined(); }
+    LoadClassifier::State state = monitor->GetState();
+    if (!state.valid) { return info.Env().Undefined(); }
+    Object result = Object::New(info.Env());
+    result.Set("phase", LoadClassifier::PhaseToString(state.phase));
+    result.Set("candidate", LoadClassifier::PhaseToString(state.candidate));
+    result.Set("phaseSinceMs", (double) state.phaseSinceMs);
+    result.Set("switches", (double) state.switches);
+    result.Set("meanLoad", state.meanLoad);
+    result.Set("meanCoreLoad", state.meanCoreLoad);
+    result.Set("cpuBusy", state.lastSample.cpuBusy);
+    result.Set("maxCoreBusy", state.lastSample.maxCoreBusy);
+    result.Set("gpuBusy", state.lastSample.gpuBusy);
+    return result;
+}
+
+static void ReadThrottleContext(ThrottleContext &context) {
+    // Runs on the monitor thread, outside of any node environment
+    DeviceSession session;
+    DeviceTelemetry telemetry;
+    if (!session.API().ReadTelemetry(telemetry)) {
+        return;
+    }
+    context.fanSpeedPercent.assign(telemetry.fanSpeedPercent, telemetry.fanSpeedPercent + telemetry.nrFans);
+    context.fanTemperature.assign(telemetry.fanTemperature, telemetry.fanTemperature + telemetry.nrFans);
+    context.tdpValues.assign(telemetry.tdp, telemetry.tdp + telemetry.nrTDPs);
+}
+
+static Array IntVectorToArray(Env env, const std::vector<int> &values) {
+    Array result = Array::New(env);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        result.Set(i, values[i]);
+    }
+    return result;
+}
+
+Boolean ThrottleMonitorStart(const CallbackInfo &info) {
+    if (info.Length() != 1 || !info[0].IsObject()) { throw Napi::Error::New(info.Env(), "ThrottleMonitorStart - invalid argument"); }
+    Object configObject = info[0].As<Object>();
+    ThrottleMonitor::Config config;
+    config.sampleIntervalMs = GetIntProperty(configObject, "sampleIntervalMs", config.sampleIntervalMs);
+    config.quietSamples = GetIntProperty(configObject, "quietSamples", config.quietSamples);
+    AddonData *addonData = GetAddonData(info.Env());
+    addonData->throttleMonitor.reset();
+    std::unique_ptr<ThrottleMonitor> monitor(new ThrottleMonitor(config, ReadThrottleContext));
+    if (!monitor->Available()) {
+        return Boolean::New(info.Env(), false);
+    }
+    monitor->SetProfiles(addonData->throttleTccProfile, addonData->throttleOdmProfile);
+    addonData->throttleMonitor = std::move(monitor);
+    return Boolean::New(info.Env(), true);
+}
+
+void ThrottleMonitorStop(const CallbackInfo &info) {
+    GetAddonData(info.Env())->throttleMonitor.reset();
+}
+
+void ThrottleMonitorSetProfiles(const CallbackInfo &info) {
+    if (info.Length() != 2 || !info[0].IsString() || !info[1].IsString()) { throw Napi::Error::New(info.Env(), "ThrottleMonitorSetProfiles - invalid argument"); }
+    AddonData *addonData = GetAddonData(info.Env());
+    addonData->throttleTccProfile = info[0].As<String>();
+    addonData->throttleOdmProfile = info[1].As<String>();
+    if (addonData->throttleMonitor) {
+        addonData->throttleMonitor->SetProfiles(addonData->throttleTccProfile, addonData->throttleOdmProfile);
+    }
+}
+
+Value ThrottleMonitorGetStats(const CallbackInfo &info) {
+    ThrottleMonitor *monitor = GetAddonData(info.Env())->throttleMonitor.get();
+    if (monitor == nullptr) { return info.Env().Undefined(); }
+    ThrottleDetector::Statistics statistics = monitor->GetStatistics();
+    Object result = Object::New(info.Env());
+    result.Set("episodes", (double) statistics.episodes);
+    result.Set("episodesLastHour", (double) statistics.episodesLastHour);
+    result.Set("totalDurationMs", (double) statistics.totalDurationMs);
+    result.Set("longestDurationMs", (double) statistics.longestDurationMs);
+    result.Set("monitoredCores", statistics.monitoredCores);
+    Array recent = Array::New(info.Env());
+    for (std::size_t i = 0; i < statistics.recent.size(); ++i) {
+        const ThrottleDetector::Episode &episode = statistics.recent[i];
+        Object entry = Object::New(info.Env());
+        entry.Set("startTime", episode.startRealtimeMs);
+        entry.Set("durationMs", (double) episode.durationMs);
+        entry.Set("ongoing", episode.ongoing);
+        entry.Set("cores", IntVectorToArray(info.Env(), episode.cores));
+        entry.Set("coreEvents", (double) episode.coreEvents);
+        entry.Set("packageEvents", (double) episode.packageEvents);
+        entry.Set("minFreqPercent", episode.minFreqPercent);
+        entry.Set("maxTemperature", episode.maxTemperature);
+        entry.Set("fanSpeedPercent", IntVectorToArray(info.Env(), episode.context.fanSpeedPercent));
+        entry.Set("fanTemperature", IntVectorToArray(info.Env(), episode.context.fanTemperature));
+        entry.Set("tdpValues", IntVectorToArray(info.Env(), episode.context.tdpValues));
+        entry.Set("tccProfile", episode.context.tccProfile);
+        entry.Set("odmProfile", episode.context.odmProfile);
+        recent.Set(i, entry);
+    }
+    result.Set("recent", recent);
+    return result;
+}
+
+Boolean MetricsExporterStart(const CallbackInfo &info) {
+    if (info.Length() != 1 || !info[0].IsString()) { throw Napi::Error::New(info.Env(), "MetricsExporterStart - invalid argument"); }
+    AddonData *addonData = GetAddonData(info.Env());
+    addonData->metricsExporter.reset();
+    std::unique_ptr<MetricsExporter> exporter(new MetricsExporter(addonData->metricsRegistry));
+    if (!exporter->Start(info[0].As<String>())) {
+        return Boolean::New(info.Env(), false);
+    }
+    addonData->metricsExporter = std::move(exporter);
+    return Boolean::New(info.Env(), true);
+}
+
+void MetricsExporterStop(const CallbackInfo &info) {
+    GetAddonData(info.Env())->metricsExporter.reset();
+}
+
+Number MetricsRegisterGauge(const CallbackInfo &info) {
+    bool hasLabels = info.Length() > 2 && !info[2].IsUndefined();
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString() || (hasLabels && !info[2].IsObject())) {
+        throw Napi::Error::New(info.Env(), "MetricsRegisterGauge - invalid argument");
+    }
+    std::vector<std::pair<std::string, std::string> > labels;
+    if (hasLabels) {
+        Object labelObject = info[2].As<Object>();
+        Array labelNames = labelObject.GetPropertyNames();
+        for (uint32_t i = 0; i < labelNames.Length(); ++i) {
+            std::string labelName = labelNames.Get(i).As<String>();
+            labels.push_back(std::make_pair(labelName, labelObject.Get(labelName).ToString().Utf8Value()));
+        }
+    }
+    int slot = GetAddonData(info.Env())->metricsRegistry.RegisterGauge(
+        info[0].As<String>(), info[1].As<String>(), labels);
+    return Number::New(info.Env(), slot);
+}
+
+void MetricsSet(const CallbackInfo &info) {
+    if (info.Length() != 2 || !info[0].IsNumber() || !(info[1].IsNumber() || info[1].IsUndefined())) {
+        throw Napi::Error::New(info.Env(), "MetricsSet - invalid argument");
+    }
+    double value = info[1].IsNumber() ? info[1].As<Number>().DoubleValue() : NAN;
+    GetAddonData(info.Env())->metricsRegistry.Set(info[0].As<Number>().Int32Value(), value);
+}
+
+Value MetricsExporterGetStats(const CallbackInfo &info) {
+    MetricsExporter *exporter = GetAddonData(info.Env())->metricsExporter.get();
+    if (exporter == nullptr) { return info.Env().Undefined(); }
+    MetricsExporter::Statistics statistics = exporter->GetStatistics();
+    Object result = Object::New(info.Env());
+    result.Set("scrapes", (double) statistics.scrapes);
+    result.Set("lastRenderMs", statistics.lastRenderNs / 1e6);
+    return result;
+}
+
+Boolean TelemetryPageCreate(const CallbackInfo &info) {
+    return Boolean::New(info.Env(), GetAddonData(info.Env())->telemetryPageWriter.Create());
+}
+
+Number TelemetryPageGetClientFd(const CallbackInfo &info) {
+    return Number::New(info.Env(), GetAddonData(info.Env())->telemetryPageWriter.ClientFd());
+}
+
+void TelemetryPageDestroy(const CallbackInfo &info) {
+    GetAddonData(info.Env())->telemetryPageWriter.Destroy();
+}
+
+static void CopyName(char *target, std::size_t length, Object object, const char *name) {
+    std::string value = object.Has(name) && object.Get(name).IsString() ? object.Get(name).As<String>() : std::string();
+    strncpy(target, value.c_str(), length - 1);
+    target[length - 1] = '\0';
+}
+
+void TelemetryPagePublish(const CallbackInfo &info) {
+    if (info.Length() != 1 || !info[0].IsObject()) { throw Napi::Error::New(info.Env(), "TelemetryPagePublish - invalid argument"); }
+    Object dataObject = info[0].As<Object>();
+    TelemetryPageWriter &writer = GetAddonData(info.Env())->telemetryPageWriter;
+    if (!writer.Created()) { return; }
+
+    TelemetryPageData data;
+    memset(&data, 0, sizeof(data));
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    data.updateTime = now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+    data.updateCount = (uint64_t) GetDoubleProperty(dataObject, "updateCount", 0);
+    data.profileGeneration = (uint64_t) GetDoubleProperty(dataObject, "profileGeneration", 0);
+    data.profilesGeneration = (uint64_t) GetDoubleProperty(dataObject, "profilesGeneration", 0);
+    data.settingsGeneration = (uint64_t) GetDoubleProperty(dataObject, "settingsGeneration", 0);
+    if (dataObject.Has("fans") && dataObject.Get("fans").IsArray()) {
+        Array fans = dataObject.Get("fans").As<Array>();
+        data.fanCount = std::min<int>(fans.Length(), TelemetryPageData::MAX_FANS);
+        for (int i = 0; i < data.fanCount; ++i) {
+            Object fan = fans.Get(i).As<Object>();
+            data.fanTimestamp[i] = (int64_t) GetDoubleProperty(fan, "timestamp", 0);
+            data.fanTemperature[i] = GetIntProperty(fan, "temperature", -1);
+            data.fanSpeed[i] = GetIntProperty(fan, "speed", -1);
+        }
+    }
+    data.cpuPower = GetDoubleProperty(dataObject, "cpuPower", -1);
+    data.cpuPowerLimit = GetDoubleProperty(dataObject, "cpuPowerLimit", -1);
+    data.iGpuPower = GetDoubleProperty(dataObject, "iGpuPower", -1);
+    data.iGpuTemperature = GetDoubleProperty(dataObject, "iGpuTemperature", -1);
+    data.dGpuPower = GetDoubleProperty(dataObject, "dGpuPower", -1);
+    CopyName(data.activeProfileId, sizeof(data.activeProfileId), dataObject, "activeProfileId");
+    CopyName(data.odmProfile, sizeof(data.odmProfile), dataObject, "odmProfile");
+    data.stateGeneration = (uint64_t) GetDoubleProperty(dataObject, "stateGeneration", 0);
+    data.iGpuCoreFrequency = GetDoubleProperty(dataObject, "iGpuCoreFrequency", -1);
+    data.iGpuMaxCoreFrequency = GetDoubleProperty(dataObject, "iGpuMaxCoreFrequency", -1);
+    data.dGpuCoreFrequency = GetDoubleProperty(dataObject, "dGpuCoreFrequency", -1);
+    data.dGpuMaxCoreFrequency = GetDoubleProperty(dataObject, "dGpuMaxCoreFrequency", -1);
+    data.dGpuMaxPowerLimit = GetDoubleProperty(dataObject, "dGpuMaxPowerLimit", -1);
+    data.dGpuEnforcedPowerLimit = GetDoubleProperty(dataObject, "dGpuEnforcedPowerLimit", -1);
+    data.dGpuD0MetricsUsage = GetIntProperty(dataObject, "dGpuD0MetricsUsage", -1);
+    data.sensorDataCollection = GetIntProperty(dataObject, "sensorDataCollection", -1);
+    CopyName(data.iGpuVendor, sizeof(data.iGpuVendor), dataObject, "iGpuVendor");
+    CopyName(data.powerState, sizeof(data.powerState), dataObject, "powerState");
+    writer.Publish(data);
+}
+
+Boolean TelemetryPageOpen(const CallbackInfo &info) {
+    if (info.Length() != 1 || !info[0].IsNumber()) { throw Napi::Error::New(info.Env(), "TelemetryPageOpen - invalid argument"); }
+    return Boolean::New(info.Env(), GetAddonData(info.Env())->telemetryPageReader.Open(info[0].As<Number>().Int32Value()));
+}
+
+void TelemetryPageClose(const CallbackInfo &info) {
+    GetAddonData(info.Env())->telemetryPageReader.Close();
+}
+
+Value TelemetryPageRead(const CallbackInfo &info) {
+    TelemetryPageData data;
+    if (!GetAddonData(info.Env())->telemetryPageReader.Read(data)) {
+        return info.Env().Undefined();
+    }
+    Env env = info.Env();
+    Object result = Object::New(env);
+    result.Set("updateTime", (double) data.updateTime);
+    result.Set("updateCount", (double) data.updateCount);
+    result.Set("profileGeneration", (double) data.profileGeneration);
+    result.Set("profilesGeneration", (double) data.profilesGeneration);
+    result.Set("settingsGeneration", (double) data.settingsGeneration);
+    Array fans = Array::New(env);
+    for (int i = 0; i < std::min<int>(data.fanCount, TelemetryPageData::MAX_FANS); ++i) {
+        Object fan = Object::New(env);
+        fan.Set("timestamp", (double) data.fanTimestamp[i]);
+        fan.Set("temperature", data.fanTemperature[i]);
+        fan.Set("speed", data.fanSpeed[i]);
+        fans.Set(i, fan);
+    }
+    result.Set("fans", fans);
+    result.Set("cpuPower", data.cpuPower);
+    result.Set("cpuPowerLimit", data.cpuPowerLimit);
+    result.Set("iGpuPower", data.iGpuPower);
+    result.Set("iGpuTemperature", data.iGpuTemperature);
+    result.Set("dGpuPower", data.dGpuPower);
+    result.Set("activeProfileId", std::string(data.activeProfileId, strnlen(data.activeProfileId, sizeof(data.activeProfileId))));
+    result.Set("odmProfile", std::string(data.odmProfile, strnlen(data.odmProfile, sizeof(data.odmProfile))));
+    result.Set("stateGeneration", (double) data.stateGeneration);
+    result.Set("iGpuCoreFrequency", data.iGpuCoreFrequency);
+    result.Set("iGpuMaxCoreFrequency", data.iGpuMaxCoreFrequency);
+    result.Set("dGpuCoreFrequency", data.dGpuCoreFrequency);
+    result.Set("dGpuMaxCoreFrequency", data.dGpuMaxCoreFrequency);
+    result.Set("dGpuMaxPowerLimit", data.dGpuMaxPowerLimit);
+    result.Set("dGpuEnforcedPowerLimit", data.dGpuEnforcedPowerLimit);
+    result.Set("dGpuD0MetricsUsage", data.dGpuD0MetricsUsage);
+    result.Set("sensorDataCollection", data.sensorDataCollection);
+    result.Set("iGpuVendor", std::string(data.iGpuVendor, strnlen(data.iGpuVendor, sizeof(data.iGpuVendor))));
+    result.Set("powerState", std::string(data.powerState, strnlen(data.powerState, sizeof(data.powerState))));
+    return result;
+}
+
+Object GetDeviceArbiterStats(const CallbackInfo &info) {
+    DeviceArbiter::Statistics statistics = DeviceArbiter::Instance().GetStatistics();
+    Object stats = Object::New(info.Env());
+    stats.Set("acquisitions", (double) statistics.acquisitions);
+    stats.Set("contended", (double) statistics.contended);
+    stats.Set("waitTimeMs", statistics.waitTimeNs / 1e6);
+    AddonData *addonData = GetAddonData(info.Env());
+    stats.Set("environmentCalls", addonData != nullptr ? (double) addonData->deviceCalls : 0.0);
+    return stats;
+}
+
+// Simulated EC, only present when TUXEDO_IO_SIMULATION=<clevo|uniwill> is set on load
+// shared by all environments like the real device (see tuxedo_io_runtime.hh)
+Boolean SimulationActive(const CallbackInfo &info) {
+    return Boolean::New(info.Env(), TuxedoIOSimulation() != nullptr);
+}
+
+Boolean SimSetTemperature(const CallbackInfo &info) {
+    if (info.Length() != 2 || !info[0].IsNumber() || !info[1].IsNumber()) { throw Napi::Error::New(info.Env(), "SimSetTemperature - invalid argument"); }
+    SimulatedIO *simulatedIO = TuxedoIOSimulation();
+    if (simulatedIO == nullptr) { return Boolean::New(info.Env(), false); }
+    int fanNumber = info[0].As<Number>();
+    int temperatureCelcius = info[1].As<Number>();
+    return Boolean::New(info.Env(), simulatedIO->SetTemperature(fanNumber, temperatureCelcius));
+}
+
+Boolean SimSetIoctlLatency(const CallbackInfo &info) {
+    if (info.Length() != 1 || !info[0].IsNumber()) { throw Napi::Error::New(info.Env(), "SimSetIoctlLatency - invalid argument"); }
+    SimulatedIO *simulatedIO = TuxedoIOSimulation();
+    if (simulatedIO == nullptr) { return Boolean::New(info.Env(), false); }
+    int64_t latencyMicroseconds = info[0].As<Number>();
+    simulatedIO->SetIoctlLatency(std::chrono::microseconds(latencyMicroseconds));
+    return Boolean::New(info.Env(), true);
+}
+
+Array SimTakeWriteLog(const CallbackInfo &info) {
+    Array log = Array::New(info.Env());
+    SimulatedIO *simulatedIO = TuxedoIOSimulation();
+    if (simulatedIO == nullptr) { return log; }
+    std::vector<SimulatedIO::WriteRecord> records = simulatedIO->TakeWriteLog();
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        Object record = Object::New(info.Env());
+        // Milliseconds on the CLOCK_MONOTONIC time base of process.hrtime()
+        record.Set("timestampMs", records[i].timestampNs / 1e6);
+        record.Set("request", (double) records[i].request);
+        record.Set("argument", records[i].argument);
+        Array speeds = Array::New(info.Env());
+        for (int fan = 0; fan < SimulatedIO::NR_FANS; ++fan) {
+            speeds.Set(fan, records[i].fanSpeedPercent[fan]);
+        }
+        record.Set("fanSpeedPercent", speeds);
+        log.Set(i, record);
+    }
+    return log;
+}
+
+Boolean LedEngineStart(const CallbackInfo &info) {
+    if (info.Length() != 2 || !info[0].IsArray() || !info[1].IsNumber()) { throw Napi::Error::New(info.Env(), "LedEngineStart - invalid argument"); }
+    AddonData *addonData = GetAddonData(info.Env());
+    Array ledPathsArray = info[0].As<Array>();
+    std::vector<std::string> ledPaths;
+    for (uint32_t i = 0; i < ledPathsArray.Length(); ++i) {
+        if (!ledPathsArray.Get(i).IsString()) { throw Napi::Error::New(info.Env(), "LedEngineStart - invalid array element type"); }
+        ledPaths.push_back(ledPathsArray.Get(i).As<String>());
+    }
+    int framesPerSecond = info[1].As<Number>();
+    // Replacing an engine stops its render thread first
+    addonData->ledFrameEngine.reset();
+    addonData->ledFrameEngine.reset(new LedFrameEngine(ledPaths));
+    if (addonData->ledFrameEngine->NumberOpenKeys() == 0) {
+        // Nothing to write to, leave the keys to the caller
+        addonData->ledFrameEngine.reset();
+        return Boolean::New(info.Env(), false);
+    }
+    addonData->ledFrameEngine->SetFrameRate(framesPerSecond);
+    return Boolean::New(info.Env(), true);
+}
+
+void LedEngineStop(const CallbackInfo &info) {
+    GetAddonData(info.Env())->ledFrameEngine.reset();
+}
+
+Boolean LedEngineSetFrame(const CallbackInfo &info) {
+    if (info.Length() < 1 || info.Length() > 2 || !info[0].IsArray()
+        || (info.Length() == 2 && !info[1].IsNumber() && !info[1].IsUndefined())) { throw Napi::Error::New(info.Env(), "LedEngineSetFrame - invalid argument"); }
+    LedFrameEngine *engine = GetAddonData(info.Env())->ledFrameEngine.get();
+    if (engine == nullptr) { return Boolean::New(info.Env(), false); }
+    Array colors = info[0].As<Array>();
+    std::vector<LedFrameEngine::Color> frame(colors.Length() / 3);
+    for (std::size_t i = 0; i < frame.size(); ++i) {
+        uint32_t rgb[3];
+        for (int c = 0; c < 3; ++c) {
+            napi_status apiStatus = napi_get_value_uint32(info.Env(), colors.Get(i * 3 + c), &rgb[c]);
+            if (apiStatus != napi_ok) {
+                throw Napi::Error::New(info.Env(), "LedEngineSetFrame - invalid array element type");
+            }
+        }
+        frame[i] = LedFrameEngine::Color { (uint8_t) rgb[0], (uint8_t) rgb[1], (uint8_t) rgb[2] };
+    }
+    int brightness = info.Length() == 2 && info[1].IsNumber() ? info[1].As<Number>().Int32Value() : -1;
+    engine->SetFrame(frame, brightness);
+    return Boolean::New(info.Env(), true);
+}
+
+Boolean LedEngineSetAnimation(const CallbackInfo &info) {
+    if (info.Length() != 2 || !info[0].IsString() || !info[1].IsNumber()) { throw Napi::Error::New(info.Env(), "LedEngineSetAnimation - invalid argument"); }
+    LedFrameEngine *engine = GetAddonData(info.Env())->ledFrameEngine.get();
+    if (engine == nullptr) { return Boolean::New(info.Env(), false); }
+    std::string name = info[0].As<String>();
+    int periodMs = info[1].As<Number>();
+    LedFrameEngine::Animation animation;
+    if (name == "none") {
+        animation = LedFrameEngine::Animation::None;
+    } else if (name == "breathe") {
+        animation = LedFrameEngine::Animation::Breathe;
+    } else if (name == "wave") {
+        animation = LedFrameEngine::Animation::Wave;
+    } else {
+        return Boolean::New(info.Env(), false);
+    }
+    engine->SetAnimation(animation, periodMs > 0 ? periodMs : 1);
+    return Boolean::New(info.Env(), true);
+}
+
+Value LedEngineGetStats(const CallbackInfo &info) {
+    LedFrameEngine *engine = GetAddonData(info.Env())->ledFrameEngine.get();
+    if (engine == nullptr) { return info.Env().Undefined(); }
+    LedFrameEngine::Statistics statistics = engine->GetStatistics();
+    Object stats = Object::New(info.Env());
+    stats.Set("keys", (double) engine->NumberKeys());
+    stats.Set("framesRendered", (double) statistics.framesRendered);
+    stats.Set("keysWritten", (double) statistics.keysWritten);
+    stats.Set("keysSkipped", (double) statistics.keysSkipped);
+    stats.Set("writeErrors", (double) statistics.writeErrors);
+    return stats;
+}
+
+static SysFsBatchWriter &GetSysFsBatchWriter(napi_env env) {
+    AddonData *addonData = GetAddonData(env);
+    if (!addonData->sysFsBatchWriter) {
+        addonData->sysFsBatchWriter.reset(new SysFsBatchWriter());
+    }
+    return *addonData->sysFsBatchWriter;
+}
+
+Boolean SysFsWriteBatch(const CallbackInfo &info) {
+    if (info.Length() != 2 || !info[0].IsArray() || !info[1].IsArray()) { throw Napi::Error::New(info.Env(), "SysFsWriteBatch - invalid argument"); }
+    Array writesArray = info[0].As<Array>();
+    Array results = info[1].As<Array>();
+    std::vector<SysFsWrite> writes(writesArray.Length());
+    for (uint32_t i = 0; i < writesArray.Length(); ++i) {
+        Value entry = writesArray.Get(i);
+        if (!entry.IsObject()) { throw Napi::Error::New(info.Env(), "SysFsWriteBatch - invalid array element type"); }
+        Object write = entry.As<Object>();
+        if (!write.Get("path").IsString() || !write.Get("value").IsString()) {
+            throw Napi::Error::New(info.Env(), "SysFsWriteBatch - invalid array element type");
+        }
+        writes[i].path = write.Get("path").As<String>();
+        writes[i].value = write.Get("value").As<String>();
+        writes[i].barrier = write.Get("barrier").IsBoolean() && write.Get("barrier").As<Boolean>().Value();
+        writes[i].error = 0;
+    }
+    bool result = GetSysFsBatchWriter(info.Env()).Write(writes);
+    for (std::size_t i = 0; i < writes.size(); ++i) {
+        results.Set(i, writes[i].error);
+    }
+    return Boolean::New(info.Env(), result);
+}
+
+void CpuReconcilerSetDesired(const CallbackInfo &info) {
+    if (info.Length() != 1 || !info[0].IsArray()) { throw Napi::Error::New(info.Env(), "CpuReconcilerSetDesired - invalid argument"); }
+    Array attributesArray = info[0].As<Array>();
+    std::vector<CpuStateReconciler::Attribute> attributes(attributesArray.Length());
+    for (uint32_t i = 0; i < attributesArray.Length(); ++i) {
+        Value entry = attributesArray.Get(i);
+        if (!entry.IsObject()) { throw Napi::Error::New(info.Env(), "CpuReconcilerSetDesired - invalid array element type"); }
+        Object attribute = entry.As<Object>();
+        if (!attribute.Get("path").IsString() || !attribute.Get("value").IsString()) {
+            throw Napi::Error::New(info.Env(), "CpuReconcilerSetDesired - invalid array element type");
+        }
+        attributes[i].core = GetIntProperty(attribute, "core", -1);
+        attributes[i].path = attribute.Get("path").As<String>();
+        attributes[i].value = attribute.Get("value").As<String>();
+    }
+    AddonData *addonData = GetAddonData(info.Env());
+    if (!addonData->cpuStateReconciler) {
+        addonData->cpuStateReconciler.reset(new CpuStateReconciler());
+    }
+    addonData->cpuStateReconciler->SetDesired(attributes);
+}
+
+Array CpuReconcilerTick(const CallbackInfo &info) {
+    if (info.Length() != 1 || !info[0].IsNumber()) { throw Napi::Error::New(info.Env(), "CpuReconcilerTick - invalid argument"); }
+    Array result = Array::New(info.Env());
+    AddonData *addonData = GetAddonData(info.Env());
+    if (!addonData->cpuStateReconciler) { return result; }
+    int coresPerTick = info[0].As<Number>();
+    std::vector<CpuStateReconciler::Drift> drifts;
+    addonData->cpuStateReconciler->Tick(GetSysFsBatchWriter(info.Env()), coresPerTick > 0 ? coresPerTick : 1, drifts);
+    for (std::size_t i = 0; i < drifts.size(); ++i) {
+        Object drift = Object::New(info.Env());
+        drift.Set("path", drifts[i].path);
+        drift.Set("expected", drifts[i].expected);
+        drift.Set("actual", drifts[i].actual);
+        drift.Set("reapplied", drifts[i].reapplied);
+        drift.Set("error", drifts[i].error);
+        result.Set(i, drift);
+    }
+    return result;
+}
+
+Value CpuReconcilerGetStats(const CallbackInfo &info) {
+    AddonData *addonData = GetAddonData(info.Env());
+    if (!addonData->cpuStateReconciler) { return info.Env().Undefined(); }
+    const CpuStateReconciler::Statistics &statistics = addonData->cpuStateReconciler->GetStatistics();
+    Object stats = Object::New(info.Env());
+    stats.Set("cores", (double) addonData->cpuStateReconciler->NumberCores());
+    stats.Set("ticks", (double) statistics.ticks);
+    stats.Set("attributesChecked", (double) statistics.attributesChecked);
+    stats.Set("drifts", (double) statistics.drifts);
+    stats.Set("reapplied", (double) statistics.reapplied);
+    stats.Set("reapplyErrors", (double) statistics.reapplyErrors);
+    stats.Set("unenforceable", (double) statistics.unenforceable);
+    stats.Set("fullScans", (double) statistics.fullScans);
+    Object driftsByAttribute = Object::New(info.Env());
+    for (const auto &entry : statistics.driftsByAttribute) {
+        driftsByAttribute.Set(entry.first, (double) entry.second);
+    }
+    stats.Set("driftsByAttribute", driftsByAttribute);
+    return stats;
+}
+
+static void SchedulerPollCallback(uv_poll_t *handle, int status, int events) {
+    AddonData *addonData = static_cast<AddonData *>(handle->data);
+    if (status < 0 || !addonData->schedulerTimer || !addonData->schedulerTimer->Acknowledge()
+            || addonData->schedulerCallback.IsEmpty()) {
+        return;
+    }
+    Napi::Env env = addonData->schedulerCallback.Env();
+    HandleScope scope(env);
+    try {
+        addonData->schedulerCallback.MakeCallback(env.Global(), {});
+    } catch (const Napi::Error &err) {
+        // Nothing on the stack to throw to, same handling as any uncaught exception
+        napi_fatal_exception(env, err.Value());
+    }
+}
+
+Boolean SchedulerStart(const CallbackInfo &info) {
+    if (info.Length() != 2 || !info[0].IsFunction() || !info[1].IsNumber()) { throw Napi::Error::New(info.Env(), "SchedulerStart - invalid argument"); }
+    AddonData *addonData = GetAddonData(info.Env());
+    addonData->StopScheduler();
+
+    std::unique_ptr<CoalescingTimer> timer(new CoalescingTimer());
+    uv_loop_t *loop = nullptr;
+    if (!timer->Valid() || napi_get_uv_event_loop(info.Env(), &loop) != napi_ok) {
+        return Boolean::New(info.Env(), false);
+    }
+    uv_poll_t *poll = new uv_poll_t;
+    if (uv_poll_init(loop, poll, timer->GetFd()) != 0) {
+        delete poll;
+        return Boolean::New(info.Env(), false);
+    }
+    poll->data = addonData;
+    uv_poll_start(poll, UV_READABLE, SchedulerPollCallback);
+
+    addonData->schedulerTimer = std::move(timer);
+    addonData->schedulerPoll = poll;
+    addonData->schedulerCallback = Persistent(info[0].As<Function>());
+
+    double slackMs = info[1].As<Number>();
+    CoalescingTimer::SetTimerSlack((uint64_t) (slackMs * 1e6));
+    return Boolean::New(info.Env(), true);
+}
+
+Boolean SchedulerArm(const CallbackInfo &info) {
+    if (info.Length() != 1 || !info[0].IsNumber()) { throw Napi::Error::New(info.Env(), "SchedulerArm - invalid argument"); }
+    CoalescingTimer *timer = GetAddonData(info.Env())->schedulerTimer.get();
+    if (timer == nullptr) { return Boolean::New(info.Env(), false); }
+    double deadlineMs = info[0].As<Number>();
+    return Boolean::New(info.Env(), timer->Arm(deadlineMs > 0 ? (uint64_t) (deadlineMs * 1e6) : 0));
+}
+
+void SchedulerStop(const CallbackInfo &info) {
+    GetAddonData(info.Env())->StopScheduler();
+}
+
+Value SchedulerGetStats(const CallbackInfo &info) {
+    CoalescingTimer *timer = GetAddonData(info.Env())->schedulerTimer.get();
+    if (timer == nullptr) { return info.Env().Undefined(); }
+    CoalescingTimer::Statistics statistics = timer->GetStatistics();
+    Object stats = Object::New(info.Env());
+    stats.Set("wakeups", (double) statistics.wakeups);
+    stats.Set("wakeupsLastMinute", (double) statistics.wakeupsLastMinute);
+    stats.Set("maxLatenessMs", statistics.maxLatenessNs / 1e6);
+    stats.Set("meanLatenessMs", statistics.wakeups > 0 ? statistics.totalLatenessNs / 1e6 / statistics.wakeups : 0.0);
+    stats.Set("timerSlackMs", CoalescingTimer::GetTimerSlack() / 1e6);
+    return stats;
+}
+
+static void SysFsWatcherPollCallback(uv_poll_t *handle, int status, int events) {
+    AddonData *addonData = static_cast<AddonData *>(handle->data);
+    if (status < 0 || !addonData->sysFsWatcher || addonData->sysFsWatcherCallback.IsEmpty()) {
+        return;
+    }
+    std::vector<SysFsNotifyWatcher::Change> changes = addonData->sysFsWatcher->Collect();
+    if (changes.empty()) {
+        return;
+    }
+    Napi::Env env = addonData->sysFsWatcherCallback.Env();
+    HandleScope scope(env);
+    Array result = Array::New(env, changes.size());
+    for (std::size_t i = 0; i < changes.size(); ++i) {
+        Object change = Object::New(env);
+        change.Set("id", changes[i].id);
+        change.Set("path", changes[i].path);
+        change.Set("value", changes[i].value);
+        result.Set(i, change);
+    }
+    try {
+        addonData->sysFsWatcherCallback.MakeCallback(env.Global(), { result });
+    } catch (const Napi::Error &err) {
+        napi_fatal_exception(env, err.Value());
+    }
+}
+
+Boolean SysFsWatcherStart(const CallbackInfo &info) {
+    if (info.Length() != 1 || !info[0].IsFunction()) { throw Napi::Error::New(info.Env(), "SysFsWatcherStart - invalid argument"); }
+    AddonData *addonData = GetAddonData(info.Env());
+    addonData->StopSysFsWatcher();
+
+    std::unique_ptr<SysFsNotifyWatcher> watcher(new SysFsNotifyWatcher());
+    uv_loop_t *loop = nullptr;
+    if (!watcher->Valid() || napi_get_uv_event_loop(info.Env(), &loop) != napi_ok) {
+        return Boolean::New(info.Env(), false);
+    }
+    uv_poll_t *poll = new uv_poll_t;
+    if (uv_poll_init(loop, poll, watcher->GetFd()) != 0) {
+        delete poll;
+        return Boolean::New(info.Env(), false);
+    }
+    poll->data = addonData;
+    uv_poll_start(poll, UV_READABLE, SysFsWatcherPollCallback);
+
+    addonData->sysFsWatcher = std::move(watcher);
+    addonData->sysFsWatcherPoll = poll;
+    addonData->sysFsWatcherCallback = Persistent(info[0].As<Function>());
+    return Boolean::New(info.Env(), true);
+}
+
+Number SysFsWatcherAdd(const CallbackInfo &info) {
+    if (info.Length() != 1 || !info[0].IsString()) { throw Napi::Error::New(info.Env(), "SysFsWatcherAdd - invalid argument"); }
+    SysFsNotifyWatcher *watcher = GetAddonData(info.Env())->sysFsWatcher.get();
+    if (watcher == nullptr) { return Number::New(info.Env(), -1); }
+    return Number::New(info.Env(), watcher->Add(info[0].As<String>()));
+}
+
+Boolean SysFsWatcherRemove(const CallbackInfo &info) {
+    if (info.Length() != 1 || !info[0].IsNumber()) { throw Napi::Error::New(info.Env(), "SysFsWatcherRemove - invalid argument"); }
+    SysFsNotifyWatcher *watcher = GetAddonData(info.Env())->sysFsWatcher.get();
+    if (watcher == nullptr) { return Boolean::New(info.Env(), false); }
+    return Boolean::New(info.Env(), watcher->Remove(info[0].As<Number>().Int32Value()));
+}
+
+void SysFsWatcherStop(const CallbackInfo &info) {
+    GetAddonData(info.Env())->StopSysFsWatcher();
+}
+
+Value SysFsWatcherGetStats(const CallbackInfo &info) {
+    SysFsNotifyWatcher *watcher = GetAddonData(info.Env())->sysFsWatcher.get();
+    if (watcher == nullptr) { return info.Env().Undefined(); }
+    const SysFsNotifyWatcher::Statistics &statistics = watcher->GetStatistics();
+    Object stats = Object::New(info.Env());
+    stats.Set("attributes", statistics.attributes);
+    stats.Set("wakeups", (double) statistics.wakeups);
+    stats.Set("notifications", (double) statistics.notifications);
+    stats.Set("changes", (double) statistics.changes);
+    return stats;
+}
+
 Object Init(Env env, Object exports) {
+    TuxedoIOInitRuntime();
+    napi_set_instance_data(env, new AddonData(), FinalizeAddonData, nullptr);
+
     // General
-    exports.Set(String::New(env, "getModuleInfo"), Function::New(env, GetModuleInfo));
-    exports.Set(String::New(env, "wmiAvailable"), Function::New(env, WmiAvailable));
+    exports.Set(String::New(env, "getModuleInfo"), TracedFunction(env, "getModuleInfo", GetModuleInfo));
+    exports.Set(String::New(env, "wmiAvailable"), TracedFunction(env, "wmiAvailable", WmiAvailable));
+    exports.Set(String::New(env, "probeCapabilities"), TracedFunction(env, "probeCapabilities", ProbeCapabilities));
+
+    exports.Set(String::New(env, "setEnableModeSet"), TracedFunction(env, "setEnableModeSet", SetEnableModeSet));
+    exports.Set(String::New(env, "getOutputPorts"), TracedFunction(env, "getOutputPorts", GetOutputPorts));
+    exports.Set(String::New(env, "getDrmCatalog"), TracedFunction(env, "getDrmCatalog", GetDrmCatalog));
+    exports.Set(String::New(env, "getDeviceArbiterStats"), TracedFunction(env, "getDeviceArbiterStats", GetDeviceArbiterStats));
+    exports.Set(String::New(env, "sysFsWriteBatch"), TracedFunction(env, "sysFsWriteBatch", SysFsWriteBatch));
 
-    exports.Set(String::New(env, "setEnableModeSet"), Function::New(env, SetEnableModeSet));
-    exports.Set(String::New(env, "getOutputPorts"), Function::New(env, GetOutputPorts));
+    // Scheduling
+    exports.Set(String::New(env, "schedulerStart"), TracedFunction(env, "schedulerStart", SchedulerStart));
+    exports.Set(String::New(env, "schedulerArm"), TracedFunction(env, "schedulerArm", SchedulerArm));
+    exports.Set(String::New(env, "schedulerStop"), TracedFunction(env, "schedulerStop", SchedulerStop));
+    exports.Set(String::New(env, "schedulerGetStats"), TracedFunction(env, "schedulerGetStats", SchedulerGetStats));
+    exports.Set(String::New(env, "sysFsWatcherStart"), TracedFunction(env, "sysFsWatcherStart", SysFsWatcherStart));
+    exports.Set(String::New(env, "sysFsWatcherAdd"), TracedFunction(env, "sysFsWatcherAdd", SysFsWatcherAdd));
+    exports.Set(String::New(env, "sysFsWatcherRemove"), TracedFunction(env, "sysFsWatcherRemove", SysFsWatcherRemove));
+    exports.Set(String::New(env, "sysFsWatcherStop"), TracedFunction(env, "sysFsWatcherStop", SysFsWatcherStop));
+    exports.Set(String::New(env, "sysFsWatcherGetStats"), TracedFunction(env, "sysFsWatcherGetStats", SysFsWatcherGetStats));
+
+    // CPU
+    exports.Set(String::New(env, "cpuReconcilerSetDesired"), TracedFunction(env, "cpuReconcilerSetDesired", CpuReconcilerSetDesired));
+    exports.Set(String::New(env, "cpuReconcilerTick"), TracedFunction(env, "cpuReconcilerTick", CpuReconcilerTick));
+    exports.Set(String::New(env, "cpuReconcilerGetStats"), TracedFunction(env, "cpuReconcilerGetStats", CpuReconcilerGetStats));
 
     // Fan control
-    exports.Set(String::New(env, "getFansMinSpeed"), Function::New(env, GetFansMinSpeed));
-    exports.Set(String::New(env, "getFansOffAvailable"), Function::New(env, GetFansOffAvailable));
-    exports.Set(String::New(env, "getNumberFans"), Function::New(env, GetNumberFans));
-    exports.Set(String::New(env, "setFansAuto"), Function::New(env, SetFansAuto));
-    exports.Set(String::New(env, "setFanSpeedPercent"), Function::New(env, SetFanSpeedPercent));
-    exports.Set(String::New(env, "getFanSpeedPercent"), Function::New(env, GetFanSpeedPercent));
-    exports.Set(String::New(env, "getFanTemperature"), Function::New(env, GetFanTemperature));
+    exports.Set(String::New(env, "getFansMinSpeed"), TracedFunction(env, "getFansMinSpeed", GetFansMinSpeed));
+    exports.Set(String::New(env, "getFansOffAvailable"), TracedFunction(env, "getFansOffAvailable", GetFansOffAvailable));
+    exports.Set(String::New(env, "getNumberFans"), TracedFunction(env, "getNumberFans", GetNumberFans));
+    exports.Set(String::New(env, "setFansAuto"), TracedFunction(env, "setFansAuto", SetFansAuto));
+    exports.Set(String::New(env, "setFanSpeedPercent"), TracedFunction(env, "setFanSpeedPercent", SetFanSpeedPercent));
+    exports.Set(String::New(env, "getFanSpeedPercent"), TracedFunction(env, "getFanSpeedPercent", GetFanSpeedPercent));
+    exports.Set(String::New(env, "getFanTemperature"), TracedFunction(env, "getFanTemperature", GetFanTemperature));
+    exports.Set(String::New(env, "getDeviceTelemetry"), TracedFunction(env, "getDeviceTelemetry", GetDeviceTelemetry));
+    exports.Set(String::New(env, "getTelemetryBatchSupported"), TracedFunction(env, "getTelemetryBatchSupported", GetTelemetryBatchSupported));
 
     // Webcam
-    exports.Set(String::New(env, "setWebcamStatus"), Function::New(env, SetWebcamStatus));
-    exports.Set(String::New(env, "getWebcamStatus"), Function::New(env, GetWebcamStatus));
+    exports.Set(String::New(env, "setWebcamStatus"), TracedFunction(env, "setWebcamStatus", SetWebcamStatus));
+    exports.Set(String::New(env, "getWebcamStatus"), TracedFunction(env, "getWebcamStatus", GetWebcamStatus));
 
     // ODM Profiles
-    exports.Set(String::New(env, "getAvailableODMPerformanceProfiles"), Function::New(env, GetAvailableODMPerformanceProfiles));
-    exports.Set(String::New(env, "setODMPerformanceProfile"), Function::New(env, SetODMPerformanceProfile));
-    exports.Set(String::New(env, "getDefaultODMPerformanceProfile"), Function::New(env, GetDefaultODMPerformanceProfile));
+    exports.Set(String::New(env, "getAvailableODMPerformanceProfiles"), TracedFunction(env, "getAvailableODMPerformanceProfiles", GetAvailableODMPerformanceProfiles));
+    exports.Set(String::New(env, "setODMPerformanceProfile"), TracedFunction(env, "setODMPerformanceProfile", SetODMPerformanceProfile));
+    exports.Set(String::New(env, "getDefaultODMPerformanceProfile"), TracedFunction(env, "getDefaultODMPerformanceProfile", GetDefaultODMPerformanceProfile));
+
+    // Load monitor (automatic ODM profile)
+    exports.Set(String::New(env, "loadMonitorStart"), TracedFunction(env, "loadMonitorStart", LoadMonitorStart));
+    exports.Set(String::New(env, "loadMonitorStop"), TracedFunction(env, "loadMonitorStop", LoadMonitorStop));
+    exports.Set(String::New(env, "loadMonitorGetState"), TracedFunction(env, "loadMonitorGetState", LoadMonitorGetState));
+
+    // Throttle monitor
+    exports.Set(String::New(env, "throttleMonitorStart"), TracedFunction(env, "throttleMonitorStart", ThrottleMonitorStart));
+    exports.Set(String::New(env, "throttleMonitorStop"), TracedFunction(env, "throttleMonitorStop", ThrottleMonitorStop));
+    exports.Set(String::New(env, "throttleMonitorSetProfiles"), TracedFunction(env, "throttleMonitorSetProfiles", ThrottleMonitorSetProfiles));
+    exports.Set(String::New(env, "throttleMonitorGetStats"), TracedFunction(env, "throttleMonitorGetStats", ThrottleMonitorGetStats));
+
+    // Metrics
+    exports.Set(String::New(env, "metricsExporterStart"), TracedFunction(env, "metricsExporterStart", MetricsExporterStart));
+    exports.Set(String::New(env, "metricsExporterStop"), TracedFunction(env, "metricsExporterStop", MetricsExporterStop));
+    exports.Set(String::New(env, "metricsRegisterGauge"), TracedFunction(env, "metricsRegisterGauge", MetricsRegisterGauge));
+    exports.Set(String::New(env, "metricsSet"), TracedFunction(env, "metricsSet", MetricsSet));
+    exports.Set(String::New(env, "metricsExporterGetStats"), TracedFunction(env, "metricsExporterGetStats", MetricsExporterGetStats));
+
+    // Telemetry page
+    exports.Set(String::New(env, "telemetryPageCreate"), TracedFunction(env, "telemetryPageCreate", TelemetryPageCreate));
+    exports.Set(String::New(env, "telemetryPageGetClientFd"), TracedFunction(env, "telemetryPageGetClientFd", TelemetryPageGetClientFd));
+    exports.Set(String::New(env, "telemetryPageDestroy"), TracedFunction(env, "telemetryPageDestroy", TelemetryPageDestroy));
+    exports.Set(String::New(env, "telemetryPagePublish"), TracedFunction(env, "telemetryPagePublish", TelemetryPagePublish));
+    exports.Set(String::New(env, "telemetryPageOpen"), TracedFunction(env, "telemetryPageOpen", TelemetryPageOpen));
+    exports.Set(String::New(env, "telemetryPageClose"), TracedFunction(env, "telemetryPageClose", TelemetryPageClose));
+    exports.Set(String::New(env, "telemetryPageRead"), TracedFunction(env, "telemetryPageRead", TelemetryPageRead));
 
     // TDP Control
-    exports.Set(String::New(env, "getTDPInfo"), Function::New(env, GetTDPInfo));
-    exports.Set(String::New(env, "setTDPValues"), Function::New(env, SetTDPValues));
+    exports.Set(String::New(env, "getTDPInfo"), TracedFunction(env, "getTDPInfo", GetTDPInfo));
+    exports.Set(String::New(env, "setTDPValues"), TracedFunction(env, "setTDPValues", SetTDPValues));
+    exports.Set(String::New(env, "tdpAutotunerStep"), TracedFunction(env, "tdpAutotunerStep", TDPAutotunerStep));
+    exports.Set(String::New(env, "tdpAutotunerReset"), TracedFunction(env, "tdpAutotunerReset", TDPAutotunerReset));
+    exports.Set(String::New(env, "tdpAutotunerGetDecisions"), TracedFunction(env, "tdpAutotunerGetDecisions", TDPAutotunerGetDecisions));
+
+    // Keyboard backlight
+    exports.Set(String::New(env, "ledEngineStart"), TracedFunction(env, "ledEngineStart", LedEngineStart));
+    exports.Set(String::New(env, "ledEngineStop"), TracedFunction(env, "ledEngineStop", LedEngineStop));
+    exports.Set(String::New(env, "ledEngineSetFrame"), TracedFunction(env, "ledEngineSetFrame", LedEngineSetFrame));
+    exports.Set(String::New(env, "ledEngineSetAnimation"), TracedFunction(env, "ledEngineSetAnimation", LedEngineSetAnimation));
+    exports.Set(String::New(env, "ledEngineGetStats"), TracedFunction(env, "ledEngineGetStats", LedEngineGetStats));
+
+    // Simulation
+    exports.Set(String::New(env, "simulationActive"), TracedFunction(env, "simulationActive", SimulationActive));
+    exports.Set(String::New(env, "simSetTemperature"), TracedFunction(env, "simSetTemperature", SimSetTemperature));
+    exports.Set(String::New(env, "simSetIoctlLatency"), TracedFunction(env, "simSetIoctlLatency", SimSetIoctlLatency));
+    exports.Set(String::New(env, "simTakeWriteLog"), TracedFunction(env, "simTakeWriteLog", SimTakeWriteLog));
 
     return exports;
 }
 
-NODE_API_MODULE(TuxedoIOAPI, Init);
+// Context aware registration, the module can be loaded from worker_threads
+NAPI_MODULE_INIT() {
+    return Init(Env(env), Object(env, exports));
+}
@@ -359,6 +359,9 @@ export class CpuDashboardComponent implements OnInit, OnDestroy {
                     ),
                     tap((profile) => {
                         this.activeProfile = profile;
+                        // Governor, frequency limits and online cores
+                        // follow the profile
+                        this.sysfs.refreshCpuInfo();
                         this.isCustomProfile =
                             this.config.getCustomProfileById(
                                 this.activeProfile.id
@@ -61,10 +61,16 @@ export class StateService implements OnDestroy {
       this.currentSettings = newSettings;
     }));
 
-    this.pollActiveState();
-    this.updateInterval = setInterval(() => {
-      this.pollActiveState();
-    }, 500);
+    // State published by tccd on the telemetry page, otherwise determined
+    // locally
+    this.subscriptions.add(this.tccdbus.powerState.subscribe(powerState => {
+      if (powerState !== undefined) {
+        this.stopPolling();
+        this.setActiveState(powerState as ProfileStates);
+      } else {
+        this.startPolling();
+      }
+    }));
 
     this.stateInputMap
       .set(ProfileStates.AC.toString(), {
@@ -104,8 +110,28 @@ export class StateService implements OnDestroy {
             .map(entry => entry[0]);
   }
 
+  private startPolling(): void {
+    if (this.updateInterval !== undefined) {
+      return;
+    }
+    this.pollActiveState();
+    this.updateInterval = setInterval(() => {
+      this.pollActiveState();
+    }, 500);
+  }
+
+  private stopPolling(): void {
+    if (this.updateInterval !== undefined) {
+      clearInterval(this.updateInterval);
+      this.updateInterval = undefined;
+    }
+  }
+
   private pollActiveState(): void {
-    const newState = determineState();
+    this.setActiveState(determineState());
+  }
+
+  private setActiveState(newState: ProfileStates): void {
     if (newState !== this.activeState) {
       this.activeState = newState;
       this.stateSubject.next(newState);
@@ -114,8 +140,6 @@ export class StateService implements OnDestroy {
 
   ngOnDestroy() {
     this.subscriptions.unsubscribe();
-    if (this.updateInterval) {
-      clearInterval(this.updateInterval);
-    }
+    this.stopPolling();
   }
 }
@@ -46,28 +46,32 @@ export class SysFsService implements OnDestroy {
       this.displayBacklightControllers.push(new DisplayBacklightController(displayBacklightControllerBasepath, driverName));
     }
 
-    this.periodicUpdate();
+    this.generalCpuInfo = new BehaviorSubject(this.getGeneralCpuInfo());
+    this.logicalCoreInfo = new BehaviorSubject(this.getLogicalCoreInfo());
+    this.pstateInfo = new BehaviorSubject(this.getPstateInfo());
     this.updateInterval = setInterval(() => { this.periodicUpdate(); }, this.updatePeriodMs);
   }
 
-  private periodicUpdate(): void {
-    if (this.generalCpuInfo === undefined) {
-      this.generalCpuInfo = new BehaviorSubject(this.getGeneralCpuInfo());
-    } else {
-      this.generalCpuInfo.next(this.getGeneralCpuInfo());
-    }
-
-    if (this.logicalCoreInfo === undefined) {
-      this.logicalCoreInfo = new BehaviorSubject(this.getLogicalCoreInfo());
-    } else {
-      this.logicalCoreInfo.next(this.getLogicalCoreInfo());
-    }
+  /**
+   * Reads the CPU info again, call when it changed, e.g. after a profile
+   * switch. Otherwise only the current frequencies are updated.
+   */
+  public refreshCpuInfo(): void {
+    this.generalCpuInfo.next(this.getGeneralCpuInfo());
+    this.logicalCoreInfo.next(this.getLogicalCoreInfo());
+    this.pstateInfo.next(this.getPstateInfo());
+  }
 
-    if (this.pstateInfo === undefined) {
-      this.pstateInfo = new BehaviorSubject(this.getPstateInfo());
-    } else {
-      this.pstateInfo.next(this.getPstateInfo());
+  private periodicUpdate(): void {
+    // Nobody shows the frequencies, spare the sysfs reads
+    if (this.logicalCoreInfo.observers.length === 0) {
+      return;
     }
+    const coreInfoList = this.logicalCoreInfo.value.map(coreInfo => {
+      const core = this.cpu.cores.find(cpuCore => cpuCore.coreIndex === coreInfo.index);
+      return core !== undefined ? { ...coreInfo, scalingCurFreq: core.scalingCurFreq.readValueNT() } : coreInfo;
+    });
+    this.logicalCoreInfo.next(coreInfoList);
   }
 
   ngOnDestroy() {
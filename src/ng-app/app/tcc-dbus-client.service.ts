@@ -23,11 +23,13 @@ import { FanData } from '../../service-app/classes/TccDBusInterface';
 import { ITccProfile, TccProfile } from '../../common/models/TccProfile';
 import { UtilsService } from './utils.service';
 import { ITccSettings, KeyboardBacklightCapabilitiesInterface, KeyboardBacklightStateInterface } from '../../common/models/TccSettings';
-import { TDPInfo } from '../../native-lib/TuxedoIOAPI';
+import { TDPInfo, TelemetryPageData } from '../../native-lib/TuxedoIOAPI';
 import { ICpuPower } from 'src/common/models/TccPowerSettings';
 import { IdGpuInfo, IiGpuInfo } from 'src/common/models/TccGpuValues';
 import { IDisplayFreqRes } from '../../common/models/DisplayFreqRes';
 import { TUXEDODevice } from 'src/common/models/DefaultProfiles';
+import { TelemetryPageClient } from '../../common/classes/TelemetryPageClient';
+import { TccPaths } from '../../common/classes/TccPaths';
 
 export interface IDBusFanData {
   cpu: FanData;
@@ -41,11 +43,21 @@ export interface IDBusFanData {
 export class TccDBusClientService implements OnDestroy {
 
   private tccDBusInterface: TccDBusController;
+  private telemetryPage: TelemetryPageClient;
+  private telemetryGenerations: string;
+  private telemetryStateGeneration: number;
+  // tccd publishes every second, older pages mean it stopped
+  private telemetryMaxAgeMs = 3000;
+  private sensorDataCollectionRequested = false;
+  private lastSensorDataCollectionRenew = 0;
+  // tccd stops collecting 10 s after the last renewal
+  private sensorDataCollectionRenewMs = 5000;
   private isAvailable: boolean;
   private timeout: NodeJS.Timeout;
   private updateInterval = 500;
 
   public available = new Subject<boolean>();
+  public telemetryPageAvailable = new BehaviorSubject<boolean>(false);
   public tuxedoWmiAvailable = new BehaviorSubject<boolean>(true);
   public fanHwmonAvailable = new BehaviorSubject<boolean>(true);
   public dataLoaded = false;
@@ -85,6 +97,10 @@ export class TccDBusClientService implements OnDestroy {
   public sensorDataCollectionStatus = new BehaviorSubject<boolean>(undefined);
 
   public primeState = new BehaviorSubject<string>(undefined);
+  /**
+   * Power supply state as seen by tccd, undefined without the telemetry page
+   */
+  public powerState = new BehaviorSubject<string>(undefined);
 
   public displayModes = new BehaviorSubject<IDisplayFreqRes>(undefined);
   public isX11 = new BehaviorSubject<boolean>(undefined);
@@ -97,6 +113,9 @@ export class TccDBusClientService implements OnDestroy {
 
   constructor(private utils: UtilsService) {
     this.tccDBusInterface = new TccDBusController();
+    // Renderer require, bypassing the bundler
+    this.telemetryPage = new TelemetryPageClient(this.tccDBusInterface,
+      () => (window as any).require(TccPaths.TUXEDO_IO_API_FILE));
     this.periodicUpdate();
     this.timeout = setInterval(() => { this.periodicUpdate(); }, this.updateInterval);
   }
@@ -106,38 +125,125 @@ export class TccDBusClientService implements OnDestroy {
     if (this.timeout !== undefined) {
       clearInterval(this.timeout);
     }
+    this.telemetryPage.close();
     this.tccDBusInterface.disconnect();
   }
   
-  private async periodicUpdate() {
+  /**
+   * @param forceRefetch Fetch profiles, settings and device state even if the
+   *                     telemetry page reports no change
+   */
+  private async periodicUpdate(forceRefetch = false) {
     const previousValue = this.isAvailable;
-    // Check if still available
+    let telemetry: TelemetryPageData;
     if (this.isAvailable) {
-      this.isAvailable = await this.tccDBusInterface.dbusAvailable();
+      // A fresh telemetry page shows tccd is alive, no need to ask over DBus
+      telemetry = await this.readTelemetryPage();
+      if (telemetry === undefined) {
+        this.isAvailable = await this.tccDBusInterface.dbusAvailable();
+      }
     } else {
       // If not available try to init again
       this.isAvailable = await this.tccDBusInterface.init();
+      if (this.isAvailable) {
+        telemetry = await this.readTelemetryPage();
+      }
     }
     // Publish availability as necessary
     if (this.isAvailable !== previousValue) { this.available.next(this.isAvailable); }
+    const telemetryPageAvailable = this.isAvailable && telemetry !== undefined;
+    if (telemetryPageAvailable !== this.telemetryPageAvailable.value) {
+      this.telemetryPageAvailable.next(telemetryPageAvailable);
+    }
 
     if (!this.isAvailable) {
         return;
     }
 
-    // Read and publish data (note: atm polled)
-    const wmiAvailability = await this.tccDBusInterface.tuxedoWmiAvailable();
-    this.tuxedoWmiAvailable.next(wmiAvailability);
+    // Live values from the telemetry page if available, saves the round-trips
+    if (telemetry !== undefined) {
+        this.publishTelemetry(telemetry);
+    } else {
+        await this.updateLiveValues();
+    }
 
-    const fanHwmonAvailability = await this.tccDBusInterface.fanHwmonAvailable();
-    this.fanHwmonAvailable.next(fanHwmonAvailability)
+    // Everything else only changes rarely, with the telemetry page it is only
+    // fetched when its generation counters changed
+    if (forceRefetch || telemetry === undefined || telemetry.stateGeneration !== this.telemetryStateGeneration) {
+        this.telemetryStateGeneration = telemetry !== undefined ? telemetry.stateGeneration : undefined;
+        await this.updateDeviceState();
+    }
+
+    const generations = telemetry !== undefined
+        ? [ telemetry.profileGeneration, telemetry.profilesGeneration, telemetry.settingsGeneration ].join('/')
+        : undefined;
+    if (forceRefetch || generations === undefined || generations !== this.telemetryGenerations) {
+        this.telemetryGenerations = generations;
+        await this.updateProfilesAndSettings();
+    }
+  }
+
+  /**
+   * Telemetry page snapshot, undefined if not available or if tccd stopped
+   * publishing
+   */
+  private async readTelemetryPage(): Promise<TelemetryPageData> {
+    const telemetry = await this.telemetryPage.read();
+    if (telemetry === undefined || Date.now() - telemetry.updateTime > this.telemetryMaxAgeMs) {
+        return undefined;
+    }
+    return telemetry;
+  }
+
+  private publishTelemetry(telemetry: TelemetryPageData) {
+    const fans = [ new FanData(), new FanData(), new FanData() ];
+    for (let i = 0; i < Math.min(fans.length, telemetry.fans.length); ++i) {
+      if (telemetry.fans[i].timestamp !== 0) {
+        fans[i].temp.set(telemetry.fans[i].timestamp, telemetry.fans[i].temperature);
+        fans[i].speed.set(telemetry.fans[i].timestamp, telemetry.fans[i].speed);
+      }
+    }
+    this.fanData.next({ cpu: fans[0], gpu1: fans[1], gpu2: fans[2] });
+
+    this.cpuPower.next({ powerDraw: telemetry.cpuPower, maxPowerLimit: telemetry.cpuPowerLimit });
+    this.iGpuInfo.next({
+        temp: telemetry.iGpuTemperature,
+        coreFrequency: telemetry.iGpuCoreFrequency,
+        maxCoreFrequency: telemetry.iGpuMaxCoreFrequency,
+        powerDraw: telemetry.iGpuPower,
+        vendor: telemetry.iGpuVendor
+    });
+    this.dGpuInfo.next({
+        coreFrequency: telemetry.dGpuCoreFrequency,
+        maxCoreFrequency: telemetry.dGpuMaxCoreFrequency,
+        powerDraw: telemetry.dGpuPower,
+        maxPowerLimit: telemetry.dGpuMaxPowerLimit,
+        enforcedPowerLimit: telemetry.dGpuEnforcedPowerLimit,
+        d0MetricsUsage: telemetry.dGpuD0MetricsUsage !== -1 ? telemetry.dGpuD0MetricsUsage === 1 : undefined
+    });
+
+    const sensorDataCollectionStatus = telemetry.sensorDataCollection === 1;
+    this.sensorDataCollectionStatus.next(sensorDataCollectionStatus);
+    // Reading the GPU values over DBus kept the collection alive, renew it
+    // explicitly instead while it is wanted
+    if (sensorDataCollectionStatus && this.sensorDataCollectionRequested
+        && Date.now() - this.lastSensorDataCollectionRenew >= this.sensorDataCollectionRenewMs) {
+        this.lastSensorDataCollectionRenew = Date.now();
+        this.tccDBusInterface.setSensorDataCollectionStatus(true);
+    }
+
+    const powerState = telemetry.powerState !== '' ? telemetry.powerState : undefined;
+    if (powerState !== this.powerState.value) {
+        this.powerState.next(powerState);
+    }
+  }
 
-    const fanData: IDBusFanData = {
-      cpu: await this.tccDBusInterface.getFanDataCPU(),
-      gpu1: await this.tccDBusInterface.getFanDataGPU1(),
-      gpu2: await this.tccDBusInterface.getFanDataGPU2()
-    };
-    this.fanData.next(fanData);
+  private async updateLiveValues() {
+    this.fanData.next({
+        cpu: await this.tccDBusInterface.getFanDataCPU(),
+        gpu1: await this.tccDBusInterface.getFanDataGPU1(),
+        gpu2: await this.tccDBusInterface.getFanDataGPU2()
+    });
 
     const dGpuInfoValuesJSON = await this.tccDBusInterface.getDGpuInfoValuesJSON();
     const iGpuInfoValuesJSON = await this.tccDBusInterface.getIGpuInfoValuesJSON();
@@ -150,27 +256,36 @@ export class TccDBusClientService implements OnDestroy {
         this.iGpuInfo.next(JSON.parse(iGpuInfoValuesJSON));
     }
 
+    this.sensorDataCollectionStatus.next(await this.tccDBusInterface.getSensorDataCollectionStatus());
+
+    const cpuPowerValuesJSON = await this.tccDBusInterface.getCpuPowerValuesJSON();
+    if (cpuPowerValuesJSON) {
+        this.cpuPower.next(JSON.parse(cpuPowerValuesJSON));
+    }
+
+    if (this.powerState.value !== undefined) {
+        this.powerState.next(undefined);
+    }
+  }
+
+  private async updateDeviceState() {
+    const wmiAvailability = await this.tccDBusInterface.tuxedoWmiAvailable();
+    this.tuxedoWmiAvailable.next(wmiAvailability);
+
+    const fanHwmonAvailability = await this.tccDBusInterface.fanHwmonAvailable();
+    this.fanHwmonAvailable.next(fanHwmonAvailability)
+
     const deviceJSON = await this.tccDBusInterface.getDeviceJSON();
     if (deviceJSON) {
         this.device = JSON.parse(deviceJSON);
     }
 
-    
-
-    this.sensorDataCollectionStatus.next(await this.tccDBusInterface.getSensorDataCollectionStatus())
-
     this.chargingProfilesAvailable.next(
         await this.tccDBusInterface.getChargingProfilesAvailable()
     );
     
     this.primeState.next(await this.tccDBusInterface.getPrimeState())
 
-
-    const cpuPowerValuesJSON = await this.tccDBusInterface.getCpuPowerValuesJSON();
-    if (cpuPowerValuesJSON) {
-        this.cpuPower.next(JSON.parse(cpuPowerValuesJSON));
-    }
-
     this.webcamSWAvailable.next(await this.tccDBusInterface.webcamSWAvailable());
     this.webcamSWStatus.next(await this.tccDBusInterface.getWebcamSWStatus());
 
@@ -180,6 +295,49 @@ export class TccDBusClientService implements OnDestroy {
     this.odmProfilesAvailable.next(nextODMProfilesAvailable !== undefined ? nextODMProfilesAvailable : []);
     const nextODMPowerLimits = await this.tccDBusInterface.odmPowerLimits();
     this.odmPowerLimits.next(nextODMPowerLimits !== undefined ? nextODMPowerLimits : []);
+
+    const displayModesJSON: string = await this.tccDBusInterface.getDisplayModesJSON();
+    if(displayModesJSON !== undefined)
+    {
+        try
+        {
+            this.displayModes.next(JSON.parse(displayModesJSON));
+        } 
+        catch (err)
+        {
+            console.log('tcc-dbus-client.service: unexpected error parsing display modes => ' + err);
+        }
+    }
+    else
+    {
+        this.displayModes.next(undefined);
+    }
+    const isX11 = await this.tccDBusInterface.getIsX11();
+    this.isX11.next(isX11);
+
+    const keyboardBacklightCapabilitiesJSON: string = await this.tccDBusInterface.getKeyboardBacklightCapabilitiesJSON();
+    if (keyboardBacklightCapabilitiesJSON !== undefined) {
+        try {
+            this.keyboardBacklightCapabilities.next(JSON.parse(keyboardBacklightCapabilitiesJSON));
+        } catch { console.log('tcc-dbus-client.service: unexpected error parsing keyboard backlight capabilities'); }
+    }
+
+    const keyboardBacklightStatesJSON: string = await this.tccDBusInterface.getKeyboardBacklightStatesJSON();
+    if (keyboardBacklightStatesJSON !== undefined) {
+        try {
+            this.keyboardBacklightStates.next(JSON.parse(keyboardBacklightStatesJSON));
+        } catch { console.log('tcc-dbus-client.service: unexpected error parsing keyboard backlight states'); }
+    }
+
+    this.fansMinSpeed.next(await this.tccDBusInterface.getFansMinSpeed());
+    this.fansOffAvailable.next(await this.tccDBusInterface.getFansOffAvailable());
+
+    this.nvidiaPowerCTRLDefaultPowerLimit.next(await this.tccDBusInterface.getNVIDIAPowerCTRLDefaultPowerLimit());
+    this.nvidiaPowerCTRLMaxPowerLimit.next(await this.tccDBusInterface.getNVIDIAPowerCTRLMaxPowerLimit());
+    this.nvidiaPowerCTRLAvailable.next(await this.tccDBusInterface.getNVIDIAPowerCTRLAvailable());
+  }
+
+  private async updateProfilesAndSettings() {
     // Retrieve and parse profiles
     const activeProfileJSON: string = await this.tccDBusInterface.getActiveProfileJSON();
     if (activeProfileJSON !== undefined) {
@@ -227,45 +385,6 @@ export class TccDBusClientService implements OnDestroy {
             }
         } catch (err) { console.log('tcc-dbus-client.service: unexpected error parsing settings => ' + err); }
     }
-    const displayModesJSON: string = await this.tccDBusInterface.getDisplayModesJSON();
-    if(displayModesJSON !== undefined)
-    {
-        try
-        {
-            this.displayModes.next(JSON.parse(displayModesJSON));
-        } 
-        catch (err)
-        {
-            console.log('tcc-dbus-client.service: unexpected error parsing display modes => ' + err);
-        }
-    }
-    else
-    {
-        this.displayModes.next(undefined);
-    }
-    const isX11 = await this.tccDBusInterface.getIsX11();
-    this.isX11.next(isX11);
-
-    const keyboardBacklightCapabilitiesJSON: string = await this.tccDBusInterface.getKeyboardBacklightCapabilitiesJSON();
-    if (keyboardBacklightCapabilitiesJSON !== undefined) {
-        try {
-            this.keyboardBacklightCapabilities.next(JSON.parse(keyboardBacklightCapabilitiesJSON));
-        } catch { console.log('tcc-dbus-client.service: unexpected error parsing keyboard backlight capabilities'); }
-    }
-
-    const keyboardBacklightStatesJSON: string = await this.tccDBusInterface.getKeyboardBacklightStatesJSON();
-    if (keyboardBacklightStatesJSON !== undefined) {
-        try {
-            this.keyboardBacklightStates.next(JSON.parse(keyboardBacklightStatesJSON));
-        } catch { console.log('tcc-dbus-client.service: unexpected error parsing keyboard backlight states'); }
-    }
-
-    this.fansMinSpeed.next(await this.tccDBusInterface.getFansMinSpeed());
-    this.fansOffAvailable.next(await this.tccDBusInterface.getFansOffAvailable());
-
-    this.nvidiaPowerCTRLDefaultPowerLimit.next(await this.tccDBusInterface.getNVIDIAPowerCTRLDefaultPowerLimit());
-    this.nvidiaPowerCTRLMaxPowerLimit.next(await this.tccDBusInterface.getNVIDIAPowerCTRLMaxPowerLimit());
-    this.nvidiaPowerCTRLAvailable.next(await this.tccDBusInterface.getNVIDIAPowerCTRLAvailable());
   }
 
   public setKeyboardBacklightStates(keyboardBacklightStates: Array<KeyboardBacklightStateInterface>) {
@@ -273,7 +392,7 @@ export class TccDBusClientService implements OnDestroy {
   }
 
   public async triggerUpdate() {
-    await this.periodicUpdate();
+    await this.periodicUpdate(true);
   }
 
   public async setTempProfile(profileName: string) {
@@ -287,6 +406,8 @@ export class TccDBusClientService implements OnDestroy {
   }
 
   public async setSensorDataCollectionStatus(status: boolean): Promise<void> {
+    this.sensorDataCollectionRequested = status;
+    this.lastSensorDataCollectionRenew = Date.now();
     await this.tccDBusInterface.dbusAvailable() && await this.tccDBusInterface.setSensorDataCollectionStatus(status)
   }
 
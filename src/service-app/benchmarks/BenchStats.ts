@@ -0,0 +1,46 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Helpers shared by all benchmarks, without dependencies on the daemon or
+ * the native addon
+ */
+export function percentile(values: number[], p: number): number {
+    if (values.length === 0) {
+        return NaN;
+    }
+    const sorted = Array.from(values).sort((a, b) => a - b);
+    const index = Math.min(sorted.length - 1, Math.max(0, Math.ceil(p / 100 * sorted.length) - 1));
+    return sorted[index];
+}
+
+export function delay(ms: number): Promise<void> {
+    return new Promise(resolve => setTimeout(resolve, ms));
+}
+
+export function parseArgs(defaults: { [key: string]: string }): { [key: string]: string } {
+    const args = Object.assign({}, defaults);
+    for (const arg of process.argv.slice(2)) {
+        const match = arg.match(/^--([^=]+)(?:=(.*))?$/);
+        if (match) {
+            args[match[1]] = match[2] === undefined ? 'true' : match[2];
+        }
+    }
+    return args;
+}
@@ -0,0 +1,138 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import { TuxedoControlCenterDaemon } from '../classes/TuxedoControlCenterDaemon';
+import { TccDBusData } from '../classes/TccDBusInterface';
+import { ITccProfile } from '../../common/models/TccProfile';
+import { ITccSettings, ProfileStates } from '../../common/models/TccSettings';
+import { ITccFanProfile, defaultFanProfiles } from '../../common/models/TccFanTable';
+import { defaultCustomProfile } from '../../common/models/DefaultProfiles';
+import { ITccAutosave, defaultAutosave } from '../../common/models/TccAutosave';
+import { TuxedoIOAPI as ioAPI } from '../../native-lib/TuxedoIOAPI';
+import { CapabilityCache } from '../classes/CapabilityCache';
+import { SysFsNotifyWatcher } from '../classes/SysFsNotifyWatcher';
+import { IProfileSwitchReport } from '../classes/ProfileSwitchTrace';
+import * as os from 'os';
+import * as path from 'path';
+
+// Kept apart from the daemon stand-ins so that benchmarks without the native addon can use them
+export { percentile, delay, parseArgs } from './BenchStats';
+
+export function requireSimulation(): void {
+    if (!ioAPI.simulationActive()) {
+        console.log('Simulated EC not active, run with TUXEDO_IO_SIMULATION=<clevo|uniwill>');
+        process.exit(1);
+    }
+}
+
+/**
+ * Stdout line prefix of the reports idle-daemon.ts sends to idle-cost.ts
+ */
+export const IDLE_REPORT_PREFIX = 'IDLE-BENCH ';
+
+export interface IIdleDaemonReport {
+    pid: number;
+    spawns: { [command: string]: number };
+    fsCalls: { [call: string]: number };
+    deviceSessions: number;
+    schedulerWakeups: number;
+    workerErrors: number;
+}
+
+/**
+ * Stdout line prefix of the reports profile-switch-daemon.ts sends to
+ * profile-switch-latency.ts
+ */
+export const SWITCH_REPORT_PREFIX = 'SWITCH-BENCH ';
+
+export interface ISwitchWrite {
+    kind: 'sysfs' | 'ec';
+    // Path or ioctl request
+    target: string;
+    // Worker whose start issued the write, undefined if not attributable
+    worker: string;
+    // Relative to the DBus call
+    atMs: number;
+}
+
+export interface ISwitchRunReport {
+    switchReport: IProfileSwitchReport;
+    // Request time recorded by tccd relative to the DBus call
+    callOffsetMs: number;
+    writes: ISwitchWrite[];
+    done: boolean;
+    errors?: string[];
+}
+
+/**
+ * Minimal stand-in for the daemon providing what workers access on the
+ * tccd object without loading config files, dbus or the other workers
+ */
+export class SimulatedDaemon {
+    public settings = { fanControlEnabled: true } as ITccSettings;
+    public dbusData = new TccDBusData(3);
+    public activeProfile: ITccProfile = JSON.parse(JSON.stringify(defaultCustomProfile));
+    public autosave: ITccAutosave = Object.assign({}, defaultAutosave);
+    public log: string[] = [];
+    public capabilityCache = new CapabilityCache(path.join(os.tmpdir(), 'tccd-bench-capabilities'));
+    public sysFsWatcher = new SysFsNotifyWatcher(ioAPI, (line: string) => this.logLine(line));
+
+    constructor() {
+        this.capabilityCache.load();
+    }
+
+    public logLine(text: string): void {
+        this.log.push(text);
+    }
+
+    public getCurrentProfile(): ITccProfile {
+        return this.activeProfile;
+    }
+
+    public getCurrentFanProfile(chosenProfile?: ITccProfile): ITccFanProfile {
+        if (chosenProfile === undefined) {
+            chosenProfile = this.getCurrentProfile();
+        }
+        const fanProfile = defaultFanProfiles.find(profile => profile.name === chosenProfile.fan.fanProfile);
+        return fanProfile !== undefined ? fanProfile : defaultFanProfiles.find(profile => profile.name === 'Balanced');
+    }
+
+    public identifyDevice(): undefined {
+        return undefined;
+    }
+
+    public setCurrentProfileById(id: string): boolean {
+        return id === this.activeProfile.id;
+    }
+
+    public setCurrentProfileByName(name: string): boolean {
+        return name === this.activeProfile.name;
+    }
+
+    public getProfileState(): ProfileStates {
+        return ProfileStates.AC;
+    }
+
+    public updateDBusActiveProfileData(): void { }
+    public saveSettings(): void { }
+    public startWorkers(): void { }
+
+    public asDaemon(): TuxedoControlCenterDaemon {
+        return this as unknown as TuxedoControlCenterDaemon;
+    }
+}
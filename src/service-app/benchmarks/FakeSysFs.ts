@@ -0,0 +1,102 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import * as fs from 'fs';
+import * as path from 'path';
+
+export interface IFakeSysFsOptions {
+    cores: number;
+    onAC: boolean;
+}
+
+/**
+ * Writes a sysfs tree of a typical intel_pstate laptop below root (root
+ * itself takes the place of /sys) covering what the workers read
+ */
+export function createFakeSysFs(root: string, options: IFakeSysFsOptions = { cores: 8, onAC: true }): void {
+    const write = (relativePath: string, value: string | number) => {
+        const filePath = path.join(root, relativePath);
+        fs.mkdirSync(path.dirname(filePath), { recursive: true });
+        fs.writeFileSync(filePath, value + '\n');
+    };
+    const cores = '0-' + (options.cores - 1);
+
+    const cpu = 'devices/system/cpu';
+    write(cpu + '/online', cores);
+    write(cpu + '/possible', cores);
+    write(cpu + '/present', cores);
+    write(cpu + '/offline', '');
+    write(cpu + '/kernel_max', 8191);
+    write(cpu + '/intel_pstate/status', 'active');
+    write(cpu + '/intel_pstate/no_turbo', 0);
+    write(cpu + '/intel_pstate/max_perf_pct', 100);
+    write(cpu + '/intel_pstate/min_perf_pct', 9);
+    for (let core = 0; core < options.cores; ++core) {
+        const corePath = cpu + '/cpu' + core;
+        if (core > 0) {
+            write(corePath + '/online', 1);
+        }
+        write(corePath + '/cpufreq/scaling_driver', 'intel_pstate');
+        write(corePath + '/cpufreq/scaling_governor', 'powersave');
+        write(corePath + '/cpufreq/scaling_available_governors', 'performance powersave');
+        write(corePath + '/cpufreq/scaling_cur_freq', 800000);
+        write(corePath + '/cpufreq/scaling_min_freq', 400000);
+        write(corePath + '/cpufreq/scaling_max_freq', 4700000);
+        write(corePath + '/cpufreq/cpuinfo_min_freq', 400000);
+        write(corePath + '/cpufreq/cpuinfo_max_freq', 4700000);
+        write(corePath + '/cpufreq/energy_performance_preference', 'balance_performance');
+        write(corePath + '/cpufreq/energy_performance_available_preferences',
+            'default performance balance_performance balance_power power');
+        write(corePath + '/topology/core_id', core >> 1);
+        write(corePath + '/topology/physical_package_id', 0);
+        write(corePath + '/topology/core_siblings_list', cores);
+        write(corePath + '/topology/thread_siblings_list', (core & ~1) + ',' + (core | 1));
+    }
+
+    write('class/power_supply/AC/type', 'Mains');
+    write('class/power_supply/AC/online', options.onAC ? 1 : 0);
+    write('class/power_supply/BAT0/type', 'Battery');
+    write('class/power_supply/BAT0/status', options.onAC ? 'Charging' : 'Discharging');
+    write('class/power_supply/BAT0/capacity', 80);
+
+    write('class/backlight/intel_backlight/type', 'raw');
+    write('class/backlight/intel_backlight/max_brightness', 1000);
+    write('class/backlight/intel_backlight/brightness', 500);
+    write('class/backlight/intel_backlight/actual_brightness', 500);
+
+    write('class/drm/card0/dev', '226:0');
+    write('class/drm/card0-eDP-1/status', 'connected');
+    write('class/drm/card0-eDP-1/enabled', 'enabled');
+    write('class/drm/card0-eDP-1/modes', '1920x1200');
+    write('class/drm/card0-eDP-1/edid', '');
+
+    write('class/dmi/id/sys_vendor', 'TUXEDO');
+    write('class/dmi/id/board_vendor', 'TUXEDO');
+    write('class/dmi/id/board_name', 'BENCH');
+    write('class/dmi/id/product_sku', 'BENCH');
+
+    const rapl = 'devices/virtual/powercap/intel-rapl/intel-rapl:0';
+    write(rapl + '/name', 'package-0');
+    write(rapl + '/energy_uj', 123456789);
+    write(rapl + '/max_energy_range_uj', 262143328850);
+    write(rapl + '/constraint_0_name', 'long_term');
+    write(rapl + '/constraint_0_power_limit_uw', 45000000);
+    write(rapl + '/constraint_0_max_power_uw', 45000000);
+    write(rapl + '/intel-rapl:0:1/name', 'uncore');
+    write(rapl + '/intel-rapl:0:1/energy_uj', 1234567);
+}
@@ -0,0 +1,284 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * End-to-end fan control loop latency harness
+ *
+ * Runs the real FanControlWorker against the simulated tuxedo_io EC, injects
+ * temperature steps and ramps and evaluates the timestamped fan speed writes
+ * seen by the EC.
+ *
+ * Usage: [TUXEDO_IO_SIMULATION=clevo] npm run bench-control-loop -- [--runs=5] [--tick=50] [--json]
+ *
+ * The worker runs on the WorkerScheduler and native timer of the daemon.
+ * --tick compresses the worker interval (1000 ms in the daemon), the
+ * scheduler grid and slack are scaled by the same factor. Latencies are
+ * reported in ms and in worker ticks, the lateness of every timer wakeup
+ * against its deadline as timer jitter.
+ */
+import { FanControlWorker } from '../classes/FanControlWorker';
+import { TuxedoIOAPI as ioAPI, SimWriteRecord } from '../../native-lib/TuxedoIOAPI';
+import { SimulatedDaemon, percentile, parseArgs, requireSimulation } from './BenchUtils';
+import { WorkerScheduler, ISchedulerTimer, ISchedulableWorker, NativeSchedulerTimer, TimeoutSchedulerTimer, monotonicMs } from '../classes/WorkerScheduler';
+
+interface IScenario {
+    name: string;
+    settleTemperature: number;
+    /**
+     * Temperature to apply at a tick counted from the start of the scenario
+     */
+    temperatureAt: (tick: number) => number;
+    measureTicks: number;
+}
+
+interface IRunResult {
+    firstResponseMs: number;
+    settledMs: number;
+    overshootPercent: number;
+    writes: number;
+    // Timer wakeups after their deadline
+    latenessMs: number[];
+}
+
+/**
+ * Records the lateness of each wakeup against the deadline it was armed for
+ */
+class DeadlineRecordingTimer implements ISchedulerTimer {
+    public latenessMs: number[] = [];
+    private deadlineMs: number;
+
+    constructor(private timer: ISchedulerTimer) {}
+
+    public start(callback: () => void, slackMs: number): boolean {
+        return this.timer.start(() => {
+            this.latenessMs.push(monotonicMs() - this.deadlineMs);
+            callback();
+        }, slackMs);
+    }
+
+    public arm(deadlineMs: number): void {
+        this.deadlineMs = deadlineMs;
+        this.timer.arm(deadlineMs);
+    }
+
+    public stop(): void {
+        this.timer.stop();
+    }
+
+    public getStats() {
+        return this.timer.getStats();
+    }
+}
+
+/**
+ * Worker as seen by the scheduler, with its intervals compressed, running a
+ * fixed number of ticks
+ */
+class ScaledWorker implements ISchedulableWorker {
+    private ticks = 0;
+
+    constructor(
+        private worker: FanControlWorker,
+        private scale: number,
+        private ticksToRun: number,
+        private onTick: (tick: number) => void,
+        private onDone: () => void) {}
+
+    public work(): void {
+        if (this.ticks >= this.ticksToRun) {
+            return;
+        }
+        this.onTick(this.ticks);
+        this.worker.work();
+        if (++this.ticks === this.ticksToRun) {
+            this.onDone();
+        }
+    }
+
+    public getNextInterval(): number {
+        return this.worker.getNextInterval() * this.scale;
+    }
+}
+
+const scenarios: IScenario[] = [
+    {
+        name: 'step-up 45->85',
+        settleTemperature: 45,
+        temperatureAt: tick => 85,
+        measureTicks: 60
+    },
+    {
+        name: 'step-down 85->45',
+        settleTemperature: 85,
+        temperatureAt: tick => 45,
+        measureTicks: 90
+    },
+    {
+        name: 'ramp 45->90/10 ticks',
+        settleTemperature: 45,
+        temperatureAt: tick => Math.min(90, 45 + tick * 4.5),
+        measureTicks: 60
+    }
+];
+
+const SETTLE_TICKS = 15;
+
+function setTemperature(nrFans: number, temperature: number): void {
+    for (let i = 0; i < nrFans; ++i) {
+        ioAPI.simSetTemperature(i, Math.round(temperature));
+    }
+}
+
+/**
+ * Runs the worker on a scheduler until it worked the given number of ticks
+ *
+ * @returns Lateness of the timer wakeups
+ */
+function runTicks(worker: FanControlWorker, ticks: number, tickMs: number, onTick: (tick: number) => void = () => {}): Promise<number[]> {
+    const scale = tickMs / worker.timeout;
+    const logLine = (line: string) => console.log(line);
+    let timer = new DeadlineRecordingTimer(new NativeSchedulerTimer(ioAPI));
+    let scheduler = new WorkerScheduler(timer, logLine, monotonicMs,
+        WorkerScheduler.GRID_MS * scale, WorkerScheduler.SLACK_MS * scale);
+    if (!scheduler.start()) {
+        timer = new DeadlineRecordingTimer(new TimeoutSchedulerTimer());
+        scheduler = new WorkerScheduler(timer, logLine, monotonicMs,
+            WorkerScheduler.GRID_MS * scale, WorkerScheduler.SLACK_MS * scale);
+        scheduler.start();
+    }
+    return new Promise(resolve => {
+        scheduler.add(new ScaledWorker(worker, scale, ticks, onTick, () => {
+            scheduler.stop();
+            resolve(timer.latenessMs);
+        }));
+    });
+}
+
+function evaluate(startMs: number, initialSpeed: number, log: SimWriteRecord[], latenessMs: number[]): IRunResult {
+    const speeds = log.map(record => record.fanSpeedPercent[0]);
+    const finalSpeed = speeds.length > 0 ? speeds[speeds.length - 1] : initialSpeed;
+    const delta = finalSpeed - initialSpeed;
+    const tolerance = Math.max(2, Math.abs(delta) * 0.05);
+
+    const firstResponse = log.find(record => record.fanSpeedPercent[0] !== initialSpeed);
+    let settledIndex = log.length - 1;
+    while (settledIndex > 0 && Math.abs(speeds[settledIndex - 1] - finalSpeed) <= tolerance) {
+        --settledIndex;
+    }
+
+    let overshoot = 0;
+    if (delta > 0) {
+        overshoot = Math.max(0, Math.max(...speeds) - finalSpeed);
+    } else if (delta < 0) {
+        overshoot = Math.max(0, finalSpeed - Math.min(...speeds));
+    }
+
+    return {
+        firstResponseMs: firstResponse !== undefined ? firstResponse.timestampMs - startMs : NaN,
+        settledMs: delta !== 0 && settledIndex >= 0 ? log[settledIndex].timestampMs - startMs : NaN,
+        overshootPercent: overshoot,
+        writes: log.length,
+        latenessMs
+    };
+}
+
+async function runScenario(scenario: IScenario, tickMs: number): Promise<IRunResult> {
+    const tccd = new SimulatedDaemon();
+    const worker = new FanControlWorker(tccd.asDaemon());
+    worker.updateProfile(tccd.activeProfile);
+    // onStart() is not run on purpose, it looks for hwmon interfaces on the
+    // host which would bypass the simulated EC
+    const nrFans = ioAPI.getNumberFans();
+
+    setTemperature(nrFans, scenario.settleTemperature);
+    await runTicks(worker, SETTLE_TICKS, tickMs);
+    const settleLog = ioAPI.simTakeWriteLog();
+    const initialSpeed = settleLog.length > 0 ? settleLog[settleLog.length - 1].fanSpeedPercent[0] : 0;
+
+    // Measured from the injection on the first tick
+    let startMs: number;
+    const latenessMs = await runTicks(worker, scenario.measureTicks, tickMs, tick => {
+        if (tick === 0) {
+            startMs = monotonicMs();
+        }
+        setTemperature(nrFans, scenario.temperatureAt(tick));
+    });
+    return evaluate(startMs, initialSpeed, ioAPI.simTakeWriteLog(), latenessMs);
+}
+
+function formatMs(value: number, tickMs: number): string {
+    if (isNaN(value)) {
+        return '-'.padStart(18);
+    }
+    return (value.toFixed(1) + ' ms (' + (value / tickMs).toFixed(1) + 't)').padStart(18);
+}
+
+async function main() {
+    const args = parseArgs({ runs: '5', tick: '50', json: 'false' });
+    requireSimulation();
+
+    const runs = parseInt(args.runs, 10);
+    const tickMs = parseInt(args.tick, 10);
+    const report = [];
+
+    for (const scenario of scenarios) {
+        const results: IRunResult[] = [];
+        for (let run = 0; run < runs; ++run) {
+            results.push(await runScenario(scenario, tickMs));
+        }
+        const firstResponse = results.map(r => r.firstResponseMs).filter(v => !isNaN(v));
+        const settled = results.map(r => r.settledMs).filter(v => !isNaN(v));
+        const lateness = results.reduce((all, r) => all.concat(r.latenessMs), [] as number[]);
+        report.push({
+            scenario: scenario.name,
+            runs,
+            tickMs,
+            firstResponseMs: { p50: percentile(firstResponse, 50), p95: percentile(firstResponse, 95), p99: percentile(firstResponse, 99) },
+            settledMs: { p50: percentile(settled, 50), p95: percentile(settled, 95), p99: percentile(settled, 99) },
+            timerLatenessMs: { p50: percentile(lateness, 50), p95: percentile(lateness, 95), p99: percentile(lateness, 99),
+                max: Math.max(...lateness) },
+            overshootPercentMax: Math.max(...results.map(r => r.overshootPercent)),
+            writesPerRun: results.reduce((sum, r) => sum + r.writes, 0) / results.length,
+            writesPerTick: results.reduce((sum, r) => sum + r.writes, 0) / results.length / scenario.measureTicks
+        });
+    }
+
+    if (args.json === 'true') {
+        console.log(JSON.stringify(report, null, 2));
+        return;
+    }
+
+    for (const entry of report) {
+        console.log(entry.scenario + ' (' + entry.runs + ' runs, tick ' + entry.tickMs + ' ms)');
+        console.log('    first response   p50 ' + formatMs(entry.firstResponseMs.p50, tickMs)
+            + '  p95 ' + formatMs(entry.firstResponseMs.p95, tickMs) + '  p99 ' + formatMs(entry.firstResponseMs.p99, tickMs));
+        console.log('    settled          p50 ' + formatMs(entry.settledMs.p50, tickMs)
+            + '  p95 ' + formatMs(entry.settledMs.p95, tickMs) + '  p99 ' + formatMs(entry.settledMs.p99, tickMs));
+        console.log('    timer lateness   p50 ' + formatMs(entry.timerLatenessMs.p50, tickMs)
+            + '  p95 ' + formatMs(entry.timerLatenessMs.p95, tickMs) + '  p99 ' + formatMs(entry.timerLatenessMs.p99, tickMs)
+            + '  max ' + formatMs(entry.timerLatenessMs.max, tickMs));
+        console.log('    overshoot max    ' + entry.overshootPercentMax + ' %');
+        console.log('    writes           ' + entry.writesPerRun.toFixed(1) + ' per run, ' + entry.writesPerTick.toFixed(2) + ' per tick');
+    }
+}
+
+main().catch(err => {
+    console.log(err);
+    process.exit(1);
+});
@@ -0,0 +1,289 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Daemon idle cost benchmark
+ *
+ * Runs the daemon workers (idle-daemon.ts) in a user and mount namespace with
+ * a fake /sys bind mounted over the real one and the simulated tuxedo_io EC,
+ * so nothing on the host is touched. After the warmup the process is sampled
+ * from /proc for the given duration and the cost is reported per hour:
+ * wakeups (scheduler and kernel runqueue), CPU time, context switches, read
+ * and write syscalls, process spawns, memory and device sessions.
+ *
+ * Usage: npm run bench-idle-cost -- [--duration=60] [--warmup=5] [--strace]
+ *        [--json] [--save-baseline] [--baseline=<file>] [--tolerance=20]
+ *
+ * Without --save-baseline the result is compared to the baseline file (if it
+ * exists) and the run fails if a metric exceeds it by more than --tolerance
+ * percent. --strace attaches strace -c for a per syscall breakdown, which
+ * itself inflates the CPU time.
+ */
+import * as child_process from 'child_process';
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+import { createFakeSysFs } from './FakeSysFs';
+import { IIdleDaemonReport, IDLE_REPORT_PREFIX, delay, parseArgs } from './BenchUtils';
+
+interface IProcSample {
+    cpuMs: number;
+    voluntaryCtxtSwitches: number;
+    nonvoluntaryCtxtSwitches: number;
+    readSyscalls: number;
+    writeSyscalls: number;
+    runqueueWakeups: number;
+    mainThreadWakeups: number;
+    rssKb: number;
+    peakRssKb: number;
+}
+
+type IdleMetrics = { [metric: string]: number };
+
+const args = parseArgs({
+    duration: '60',
+    warmup: '5',
+    tolerance: '20',
+    baseline: path.join(__dirname, 'idle-cost-baseline.json')
+});
+
+function readProc(pid: number, file: string): string {
+    return fs.readFileSync('/proc/' + pid + '/' + file).toString();
+}
+
+function statusValue(status: string, key: string): number {
+    const match = status.match(new RegExp('^' + key + ':\\s+(\\d+)', 'm'));
+    return match ? parseInt(match[1], 10) : 0;
+}
+
+/**
+ * Run count of a task from schedstat (run time, wait time, timeslices), that
+ * is how often it was put on a CPU
+ */
+function schedRuns(pid: number, task: string): number {
+    try {
+        return parseInt(readProc(pid, 'task/' + task + '/schedstat').split(' ')[2], 10);
+    } catch (err) {
+        return 0;
+    }
+}
+
+export function sampleProcess(pid: number): IProcSample {
+    // Fields after the command name, which may contain spaces
+    const stat = readProc(pid, 'stat');
+    const statFields = stat.substring(stat.lastIndexOf(')') + 2).split(' ');
+    const ticksPerSecond = 100;
+    const cpuTicks = parseInt(statFields[11], 10) + parseInt(statFields[12], 10);
+
+    const status = readProc(pid, 'status');
+    let io = '';
+    try {
+        io = readProc(pid, 'io');
+    } catch (err) { }
+
+    let runqueueWakeups = 0;
+    for (const task of fs.readdirSync('/proc/' + pid + '/task')) {
+        runqueueWakeups += schedRuns(pid, task);
+    }
+
+    return {
+        cpuMs: cpuTicks * 1000 / ticksPerSecond,
+        voluntaryCtxtSwitches: statusValue(status, 'voluntary_ctxt_switches'),
+        nonvoluntaryCtxtSwitches: statusValue(status, 'nonvoluntary_ctxt_switches'),
+        readSyscalls: statusValue(io, 'syscr'),
+        writeSyscalls: statusValue(io, 'syscw'),
+        runqueueWakeups,
+        mainThreadWakeups: schedRuns(pid, String(pid)),
+        rssKb: statusValue(status, 'VmRSS'),
+        peakRssKb: statusValue(status, 'VmHWM')
+    };
+}
+
+/**
+ * Parses the summary table written by strace -c
+ */
+export function parseStraceSummary(summary: string): { [syscall: string]: number } {
+    const calls: { [syscall: string]: number } = {};
+    for (const line of summary.split('\n')) {
+        const fields = line.trim().split(/\s+/);
+        // % time, seconds, usecs/call, calls, [errors,] syscall
+        if (fields.length < 5 || !/^\d+(\.\d+)?$/.test(fields[0]) || fields[fields.length - 1] === 'total') {
+            continue;
+        }
+        calls[fields[fields.length - 1]] = parseInt(fields[3], 10);
+    }
+    return calls;
+}
+
+const simulation = process.env.TUXEDO_IO_SIMULATION || 'clevo';
+
+function spawnDaemon(fakeSys: string): child_process.ChildProcess {
+    const tsNode = path.join(process.cwd(), 'node_modules', '.bin', 'ts-node');
+    const daemonArgs = [ path.join(__dirname, 'idle-daemon.ts'), '--warmup=' + parseFloat(args.warmup) * 1000 ];
+    const env = Object.assign({}, process.env, {
+        TUXEDO_IO_SIMULATION: simulation
+    });
+    const mountSys = 'mount --bind "$0" /sys && exec "$@"';
+    return child_process.spawn('unshare', [ '--user', '--map-root-user', '--mount', 'sh', '-c', mountSys, fakeSys, tsNode ].concat(daemonArgs),
+        { env, stdio: [ 'ignore', 'pipe', 'inherit' ] });
+}
+
+function waitForReport(daemon: child_process.ChildProcess, timeoutMs: number): Promise<any> {
+    return new Promise((resolve, reject) => {
+        let buffer = '';
+        const timer = setTimeout(() => {
+            daemon.stdout.removeListener('data', onData);
+            reject(new Error('No report from idle daemon within ' + timeoutMs + ' ms'));
+        }, timeoutMs);
+        const onData = (data: Buffer) => {
+            buffer += data.toString();
+            let newline: number;
+            while ((newline = buffer.indexOf('\n')) >= 0) {
+                const line = buffer.substring(0, newline);
+                buffer = buffer.substring(newline + 1);
+                if (line.startsWith(IDLE_REPORT_PREFIX)) {
+                    clearTimeout(timer);
+                    daemon.stdout.removeListener('data', onData);
+                    resolve(JSON.parse(line.substring(IDLE_REPORT_PREFIX.length)));
+                    return;
+                }
+            }
+        };
+        daemon.stdout.on('data', onData);
+        daemon.once('exit', code => {
+            clearTimeout(timer);
+            reject(new Error('Idle daemon exited with ' + code));
+        });
+    });
+}
+
+function compareToBaseline(metrics: IdleMetrics, baseline: IdleMetrics, tolerancePercent: number): string[] {
+    const regressions: string[] = [];
+    for (const metric of Object.keys(baseline)) {
+        if (metrics[metric] === undefined) {
+            continue;
+        }
+        // Absolute slack of one unit so near zero baselines do not flap
+        const limit = baseline[metric] * (1 + tolerancePercent / 100) + 1;
+        if (metrics[metric] > limit) {
+            regressions.push(metric + ': ' + metrics[metric].toFixed(1) + ' > ' + baseline[metric].toFixed(1) + ' +' + tolerancePercent + '%');
+        }
+    }
+    return regressions;
+}
+
+async function main() {
+    const durationMs = parseFloat(args.duration) * 1000;
+
+    const fakeSys = fs.mkdtempSync(path.join(os.tmpdir(), 'tcc-idle-sys-'));
+    createFakeSysFs(fakeSys);
+
+    const daemon = spawnDaemon(fakeSys);
+    let ready: { pid: number };
+    try {
+        ready = await waitForReport(daemon, parseFloat(args.warmup) * 1000 + 60000);
+    } catch (err) {
+        console.log(err.message + ' (unshare needs unprivileged user namespaces)');
+        daemon.kill('SIGKILL');
+        process.exit(1);
+    }
+
+    let strace: child_process.ChildProcess;
+    const straceOutput = path.join(fakeSys, 'strace.txt');
+    if (args.strace === 'true') {
+        strace = child_process.spawn('strace', [ '-f', '-c', '-o', straceOutput, '-p', String(ready.pid) ], { stdio: 'ignore' });
+    }
+
+    const start = sampleProcess(ready.pid);
+    const startMs = Date.now();
+    await delay(durationMs);
+    const end = sampleProcess(ready.pid);
+    const elapsedMs = Date.now() - startMs;
+
+    let syscalls: { [syscall: string]: number };
+    if (strace !== undefined) {
+        const straceExit = new Promise(resolve => strace.once('exit', resolve));
+        strace.kill('SIGINT');
+        await straceExit;
+        try {
+            syscalls = parseStraceSummary(fs.readFileSync(straceOutput).toString());
+        } catch (err) { }
+    }
+
+    const reportPromise = waitForReport(daemon, 10000);
+    daemon.kill('SIGTERM');
+    const report: IIdleDaemonReport = await reportPromise;
+    fs.rmSync(fakeSys, { recursive: true, force: true });
+
+    const perHour = (value: number) => value * 3600000 / elapsedMs;
+    const spawns = Object.keys(report.spawns).reduce((sum, command) => sum + report.spawns[command], 0);
+    const fsCalls = Object.keys(report.fsCalls).reduce((sum, call) => sum + report.fsCalls[call], 0);
+    const metrics: IdleMetrics = {
+        schedulerWakeupsPerHour: perHour(report.schedulerWakeups),
+        runqueueWakeupsPerHour: perHour(end.runqueueWakeups - start.runqueueWakeups),
+        mainThreadWakeupsPerHour: perHour(end.mainThreadWakeups - start.mainThreadWakeups),
+        cpuMsPerHour: perHour(end.cpuMs - start.cpuMs),
+        contextSwitchesPerHour: perHour(end.voluntaryCtxtSwitches - start.voluntaryCtxtSwitches
+            + end.nonvoluntaryCtxtSwitches - start.nonvoluntaryCtxtSwitches),
+        readSyscallsPerHour: perHour(end.readSyscalls - start.readSyscalls),
+        writeSyscallsPerHour: perHour(end.writeSyscalls - start.writeSyscalls),
+        spawnsPerHour: perHour(spawns),
+        fsCallsPerHour: perHour(fsCalls),
+        deviceSessionsPerHour: perHour(report.deviceSessions),
+        rssKb: end.rssKb,
+        rssGrowthKb: end.rssKb - start.rssKb
+    };
+    if (syscalls !== undefined) {
+        metrics.syscallsPerHour = perHour(Object.keys(syscalls).reduce((sum, name) => sum + syscalls[name], 0));
+    }
+
+    let regressions: string[] = [];
+    let baselineUsed = false;
+    if (args['save-baseline'] === 'true') {
+        fs.writeFileSync(args.baseline, JSON.stringify(metrics, null, 4) + '\n');
+    } else if (fs.existsSync(args.baseline)) {
+        baselineUsed = true;
+        regressions = compareToBaseline(metrics, JSON.parse(fs.readFileSync(args.baseline).toString()), parseFloat(args.tolerance));
+    }
+
+    if (args.json === 'true') {
+        console.log(JSON.stringify({ elapsedMs, metrics, spawns: report.spawns, fsCalls: report.fsCalls, syscalls,
+            workerErrors: report.workerErrors, regressions }, null, 4));
+    } else {
+        console.log('Idle cost over ' + (elapsedMs / 1000).toFixed(0) + ' s, normalized per hour (simulation: ' + simulation + ')');
+        for (const metric of Object.keys(metrics)) {
+            console.log('  ' + metric.padEnd(28) + metrics[metric].toFixed(1));
+        }
+        const perCommand = Object.keys(report.spawns).map(command => command + ' ' + report.spawns[command]);
+        console.log('  spawned commands: ' + (perCommand.length > 0 ? perCommand.join(', ') : 'none'));
+        if (syscalls !== undefined) {
+            const top = Object.keys(syscalls).sort((a, b) => syscalls[b] - syscalls[a]).slice(0, 10);
+            console.log('  top syscalls: ' + top.map(name => name + ' ' + syscalls[name]).join(', '));
+        }
+        if (report.workerErrors > 0) {
+            console.log('  worker errors: ' + report.workerErrors);
+        }
+        if (baselineUsed) {
+            console.log(regressions.length > 0 ? 'Regressions against baseline:\n  ' + regressions.join('\n  ') : 'Within baseline');
+        }
+    }
+    process.exit(regressions.length > 0 ? 1 : 0);
+}
+
+main();
@@ -0,0 +1,122 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Measured process of the idle cost benchmark, started by idle-cost.ts
+ *
+ * Runs the daemon workers on the shared scheduler like tccd does, without
+ * dbus and listeners. Counts process spawns and synchronous fs calls in
+ * process. After the warmup it reports its pid and resets the counters, on
+ * SIGTERM it reports the counters and exits. Reports are single stdout lines
+ * prefixed with IDLE_REPORT_PREFIX.
+ */
+import * as child_process from 'child_process';
+import * as fs from 'fs';
+import { SimulatedDaemon, IIdleDaemonReport, IDLE_REPORT_PREFIX, delay, parseArgs } from './BenchUtils';
+import { DaemonWorkerGraph } from '../classes/DaemonWorkerGraph';
+import { WorkerScheduler, NativeSchedulerTimer, TimeoutSchedulerTimer } from '../classes/WorkerScheduler';
+import { defaultSettings } from '../../common/models/TccSettings';
+import { TuxedoIOAPI as ioAPI } from '../../native-lib/TuxedoIOAPI';
+
+let spawns: { [command: string]: number } = {};
+let fsCalls: { [call: string]: number } = {};
+
+function countCalls(module: object, names: string[], counter: (name: string, args: any[]) => void): void {
+    for (const name of names) {
+        const original = module[name];
+        if (typeof original !== 'function') {
+            continue;
+        }
+        module[name] = function (...args: any[]) {
+            counter(name, args);
+            return original.apply(this, args);
+        };
+    }
+}
+
+function report(data: object): void {
+    process.stdout.write(IDLE_REPORT_PREFIX + JSON.stringify(data) + '\n');
+}
+
+async function main() {
+    const args = parseArgs({ warmup: '5000' });
+
+    countCalls(child_process, [ 'exec', 'execSync', 'execFile', 'execFileSync', 'spawn', 'spawnSync' ], (name, callArgs) => {
+        const command = String(callArgs[0]).trim().split(/\s+/)[0];
+        spawns[command] = (spawns[command] || 0) + 1;
+    });
+    countCalls(fs, [ 'readFileSync', 'writeFileSync', 'existsSync', 'readdirSync', 'statSync', 'readlinkSync' ], (name) => {
+        fsCalls[name] = (fsCalls[name] || 0) + 1;
+    });
+
+    const tccd = new SimulatedDaemon();
+    tccd.settings = Object.assign(JSON.parse(JSON.stringify(defaultSettings)), { fanControlEnabled: true });
+    const daemon = tccd.asDaemon();
+    let workerErrors = 0;
+    const logLine = (line: string) => {
+        if (line.startsWith('Failed')) {
+            workerErrors++;
+        }
+    };
+    tccd.logLine = logLine;
+
+    // Workers of tccd, without TccDBusService
+    const workerGraph = new DaemonWorkerGraph(daemon);
+    workerGraph.addDaemonWorkers();
+    const workers = workerGraph.workers;
+    await workerGraph.createStartup(() => tccd.getCurrentProfile(), logLine).run();
+
+    let scheduler = new WorkerScheduler(new NativeSchedulerTimer(ioAPI), logLine);
+    if (!scheduler.start()) {
+        scheduler = new WorkerScheduler(new TimeoutSchedulerTimer(), logLine);
+        scheduler.start();
+    }
+    for (const worker of workers) {
+        scheduler.add(worker);
+    }
+
+    await delay(parseInt(args.warmup, 10));
+
+    spawns = {};
+    fsCalls = {};
+    workerErrors = 0;
+    const deviceSessionsStart = ioAPI.getDeviceArbiterStats().acquisitions;
+    const wakeupsStart = scheduler.getStats().wakeups;
+    report({ ready: true, pid: process.pid });
+
+    process.on('SIGTERM', () => {
+        scheduler.stop();
+        const result: IIdleDaemonReport = {
+            pid: process.pid,
+            spawns,
+            fsCalls,
+            deviceSessions: ioAPI.getDeviceArbiterStats().acquisitions - deviceSessionsStart,
+            schedulerWakeups: scheduler.getStats().wakeups - wakeupsStart,
+            workerErrors
+        };
+        report(result);
+        ioAPI.telemetryPageDestroy();
+        process.exit(0);
+    });
+}
+
+main().catch(err => {
+    console.log(err);
+    process.exit(1);
+});
@@ -0,0 +1,222 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Measured process of the profile switch benchmark, started by
+ * profile-switch-latency.ts
+ *
+ * Runs the daemon workers of DaemonWorkerGraph like tccd and switches
+ * between two profiles through TccDBusInterface.SetTempProfileById like a
+ * client does. Every sysfs write and every write ioctl of the simulated EC
+ * is timestamped and attributed to the worker whose start issued it. Each
+ * switch is reported as a single stdout line prefixed with
+ * SWITCH_REPORT_PREFIX, the last line has done set.
+ */
+import * as fs from 'fs';
+import { SimulatedDaemon, ISwitchRunReport, ISwitchWrite, SWITCH_REPORT_PREFIX, delay, parseArgs } from './BenchUtils';
+import { DaemonWorkerGraph } from '../classes/DaemonWorkerGraph';
+import { IWorkerStartupReport } from '../classes/WorkerStartup';
+import { IProfileSwitchRequest, IProfileSwitchReport, createProfileSwitchReport } from '../classes/ProfileSwitchTrace';
+import { TccDBusInterface, TccDBusOptions } from '../classes/TccDBusInterface';
+import { monotonicMs } from '../classes/WorkerScheduler';
+import { defaultSettings } from '../../common/models/TccSettings';
+import { ITccProfile } from '../../common/models/TccProfile';
+import { defaultCustomProfile } from '../../common/models/DefaultProfiles';
+import { TuxedoIOAPI as ioAPI, TDPInfo } from '../../native-lib/TuxedoIOAPI';
+
+interface IWorkerWindow {
+    name: string;
+    beginMs: number;
+    endMs: number;
+}
+
+let sysFsWrites: { timestampMs: number, path: string, worker: string }[] = [];
+let runningWorker: string;
+
+function recordWrites(module: object, names: string[]): void {
+    for (const name of names) {
+        const original = module[name];
+        if (typeof original !== 'function') {
+            continue;
+        }
+        module[name] = function (...args: any[]) {
+            sysFsWrites.push({ timestampMs: monotonicMs(), path: String(args[0]), worker: runningWorker });
+            return original.apply(this, args);
+        };
+    }
+}
+
+/**
+ * Simulated daemon starting the workers of tccd, without TccDBusService
+ */
+class SwitchingDaemon extends SimulatedDaemon {
+    public workerGraph: DaemonWorkerGraph;
+    public profiles: ITccProfile[] = [];
+    public windows: IWorkerWindow[] = [];
+    public lastSwitch: Promise<IProfileSwitchReport>;
+
+    public createWorkers(): void {
+        this.workerGraph = new DaemonWorkerGraph(this.asDaemon());
+        this.workerGraph.addDaemonWorkers();
+    }
+
+    public setCurrentProfileById(id: string): boolean {
+        const profile = this.profiles.find(candidate => candidate.id === id);
+        if (profile !== undefined) {
+            this.activeProfile = profile;
+        }
+        return profile !== undefined;
+    }
+
+    public startWorkers(profileSwitch?: IProfileSwitchRequest): Promise<IWorkerStartupReport> {
+        const startup = this.workerGraph.createStartup(() => this.getCurrentProfile(), (line: string) => this.logLine(line),
+            (name, start) => () => {
+                const window: IWorkerWindow = { name, beginMs: monotonicMs(), endMs: undefined };
+                this.windows.push(window);
+                runningWorker = name;
+                try {
+                    return start();
+                } finally {
+                    runningWorker = undefined;
+                    window.endMs = monotonicMs();
+                }
+            });
+        // Like tccd, fans are controlled right after the critical workers started
+        const run = startup.run(() => this.workerGraph.fanWorker.work());
+        if (profileSwitch !== undefined) {
+            this.lastSwitch = run.then(report => createProfileSwitchReport(profileSwitch, report));
+        }
+        return run;
+    }
+}
+
+/**
+ * Worker whose synchronous start section contains the timestamp, writes of
+ * asynchronous continuations are not attributed
+ */
+function workerAt(windows: IWorkerWindow[], timestampMs: number): string {
+    const window = windows.find(candidate => timestampMs >= candidate.beginMs && timestampMs <= candidate.endMs);
+    return window !== undefined ? window.name : undefined;
+}
+
+function createProfiles(): ITccProfile[] {
+    const base: ITccProfile = JSON.parse(JSON.stringify(defaultCustomProfile));
+    const odmProfiles: string[] = [];
+    ioAPI.getAvailableODMPerformanceProfiles(odmProfiles);
+    const tdpInfo: TDPInfo[] = [];
+    ioAPI.getTDPInfo(tdpInfo);
+
+    // Differing in everything the workers apply on a switch
+    const a: ITccProfile = Object.assign(JSON.parse(JSON.stringify(base)), { id: 'bench-a', name: 'Bench A' });
+    a.cpu.energyPerformancePreference = 'balance_performance';
+    a.cpu.noTurbo = false;
+    a.fan.fanProfile = 'Balanced';
+    a.display.useBrightness = true;
+    a.display.brightness = 80;
+    a.odmProfile = { name: odmProfiles[0] };
+    a.odmPowerLimits = { tdpValues: tdpInfo.map(tdp => tdp.max) };
+
+    const b: ITccProfile = Object.assign(JSON.parse(JSON.stringify(base)), { id: 'bench-b', name: 'Bench B' });
+    b.cpu.energyPerformancePreference = 'power';
+    b.cpu.noTurbo = true;
+    b.cpu.scalingMaxFrequency = 2000000;
+    b.fan.fanProfile = 'Quiet';
+    b.display.useBrightness = true;
+    b.display.brightness = 40;
+    b.odmProfile = { name: odmProfiles[odmProfiles.length - 1] };
+    b.odmPowerLimits = { tdpValues: tdpInfo.map(tdp => tdp.min) };
+    return [ a, b ];
+}
+
+function report(data: ISwitchRunReport): void {
+    process.stdout.write(SWITCH_REPORT_PREFIX + JSON.stringify(data) + '\n');
+}
+
+async function main() {
+    const args = parseArgs({ switches: '20', pause: '200' });
+
+    recordWrites(fs, [ 'writeFileSync', 'appendFileSync', 'writeFile', 'appendFile' ]);
+    recordWrites(fs.promises, [ 'writeFile', 'appendFile' ]);
+
+    const tccd = new SwitchingDaemon();
+    tccd.settings = Object.assign(JSON.parse(JSON.stringify(defaultSettings)), { fanControlEnabled: true });
+    tccd.profiles = createProfiles();
+    tccd.activeProfile = tccd.profiles[0];
+    tccd.settings.stateMap = { power_ac: tccd.profiles[0].id, power_bat: tccd.profiles[0].id };
+    tccd.createWorkers();
+    const stateWorker = tccd.workerGraph.stateWorker;
+
+    const options = new TccDBusOptions();
+    options.triggerStateCheck = async (trigger?: string) => {
+        if (trigger !== undefined) {
+            stateWorker.requestProfileSwitch(trigger);
+        }
+        stateWorker.work();
+    };
+    const dbusInterface = new TccDBusInterface(tccd.dbusData, options);
+
+    await tccd.startWorkers();
+    await delay(parseInt(args.pause, 10));
+
+    const switches = parseInt(args.switches, 10);
+    for (let i = 0; i < switches; ++i) {
+        const profile = tccd.profiles[(i + 1) % tccd.profiles.length];
+        sysFsWrites = [];
+        tccd.windows = [];
+        tccd.lastSwitch = undefined;
+        ioAPI.simTakeWriteLog();
+
+        const callMs = monotonicMs();
+        dbusInterface.SetTempProfileById(profile.id);
+        if (tccd.lastSwitch === undefined) {
+            tccd.logLine('Failed switching to ' + profile.id + ', no worker start');
+            continue;
+        }
+        const switchReport = await tccd.lastSwitch;
+        // Asynchronous writes issued after the start returned
+        await delay(parseInt(args.pause, 10));
+
+        const writes: ISwitchWrite[] = sysFsWrites.map(write => ({
+            kind: 'sysfs',
+            target: write.path,
+            worker: write.worker !== undefined ? write.worker : workerAt(tccd.windows, write.timestampMs),
+            atMs: write.timestampMs - callMs
+        }));
+        for (const record of ioAPI.simTakeWriteLog()) {
+            writes.push({
+                kind: 'ec',
+                target: '0x' + record.request.toString(16),
+                worker: workerAt(tccd.windows, record.timestampMs),
+                atMs: record.timestampMs - callMs
+            });
+        }
+        writes.sort((first, second) => first.atMs - second.atMs);
+        report({ switchReport, callOffsetMs: switchReport.requestMs - callMs, writes, done: false });
+    }
+
+    const failed = tccd.log.filter(line => line.startsWith('Failed'));
+    report({ switchReport: undefined, callOffsetMs: 0, writes: [], done: true, errors: failed });
+    ioAPI.telemetryPageDestroy();
+    process.exit(0);
+}
+
+main().catch(err => {
+    console.log(err);
+    process.exit(1);
+});
@@ -0,0 +1,182 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Profile switch latency benchmark
+ *
+ * Runs the daemon workers (profile-switch-daemon.ts) in a user and mount
+ * namespace with a fake /sys bind mounted over the real one and the simulated
+ * tuxedo_io EC, and switches between two profiles over the DBus interface.
+ * Reported from the DBus call: time until the profile is selected, until the
+ * critical workers and all workers applied it and until the last hardware
+ * write, plus the contribution of each worker.
+ *
+ * Usage: npm run bench-profile-switch -- [--switches=20] [--pause=200]
+ *        [--budget=<ms>] [--json]
+ *
+ * With --budget the run fails if the p95 time until fully applied exceeds it.
+ */
+import * as child_process from 'child_process';
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+import { createFakeSysFs } from './FakeSysFs';
+import { ISwitchRunReport, SWITCH_REPORT_PREFIX, percentile, parseArgs } from './BenchUtils';
+
+interface IWorkerContribution {
+    name: string;
+    critical: boolean;
+    meanDurationMs: number;
+    // Of the summed time until fully applied
+    sharePercent: number;
+    sysFsWritesPerSwitch: number;
+    ecWritesPerSwitch: number;
+}
+
+const args = parseArgs({ switches: '20', pause: '200', budget: '0' });
+const simulation = process.env.TUXEDO_IO_SIMULATION || 'uniwill';
+
+function spawnDaemon(fakeSys: string): child_process.ChildProcess {
+    const tsNode = path.join(process.cwd(), 'node_modules', '.bin', 'ts-node');
+    const daemonArgs = [ path.join(__dirname, 'profile-switch-daemon.ts'), '--switches=' + args.switches, '--pause=' + args.pause ];
+    const env = Object.assign({}, process.env, {
+        TUXEDO_IO_SIMULATION: simulation
+    });
+    const mountSys = 'mount --bind "$0" /sys && exec "$@"';
+    return child_process.spawn('unshare', [ '--user', '--map-root-user', '--mount', 'sh', '-c', mountSys, fakeSys, tsNode ].concat(daemonArgs),
+        { env, stdio: [ 'ignore', 'pipe', 'inherit' ] });
+}
+
+function collectReports(daemon: child_process.ChildProcess): Promise<ISwitchRunReport[]> {
+    return new Promise((resolve, reject) => {
+        const reports: ISwitchRunReport[] = [];
+        let buffer = '';
+        daemon.stdout.on('data', (data: Buffer) => {
+            buffer += data.toString();
+            let newline: number;
+            while ((newline = buffer.indexOf('\n')) >= 0) {
+                const line = buffer.substring(0, newline);
+                buffer = buffer.substring(newline + 1);
+                if (line.startsWith(SWITCH_REPORT_PREFIX)) {
+                    const report: ISwitchRunReport = JSON.parse(line.substring(SWITCH_REPORT_PREFIX.length));
+                    reports.push(report);
+                    if (report.done) {
+                        resolve(reports);
+                    }
+                }
+            }
+        });
+        daemon.once('exit', code => reject(new Error('Profile switch daemon exited with ' + code)));
+    });
+}
+
+function distribution(values: number[]): { p50: number, p95: number, max: number } {
+    return { p50: percentile(values, 50), p95: percentile(values, 95), max: Math.max(...values) };
+}
+
+function contributions(switches: ISwitchRunReport[]): IWorkerContribution[] {
+    const totalMs = switches.reduce((sum, run) => sum + run.switchReport.fullyAppliedMs, 0);
+    const names = switches[0].switchReport.workers.map(worker => worker.name);
+    return names.map(name => {
+        const traces = switches.map(run => run.switchReport.workers.find(worker => worker.name === name));
+        const durationMs = traces.reduce((sum, trace) => sum + trace.durationMs, 0);
+        const writes = switches.reduce((all, run) => all.concat(run.writes.filter(write => write.worker === name)), []);
+        return {
+            name,
+            critical: traces[0].critical,
+            meanDurationMs: durationMs / switches.length,
+            sharePercent: totalMs > 0 ? durationMs * 100 / totalMs : 0,
+            sysFsWritesPerSwitch: writes.filter(write => write.kind === 'sysfs').length / switches.length,
+            ecWritesPerSwitch: writes.filter(write => write.kind === 'ec').length / switches.length
+        };
+    }).sort((first, second) => second.meanDurationMs - first.meanDurationMs);
+}
+
+function formatDistribution(label: string, values: { p50: number, p95: number, max: number }): string {
+    return '  ' + label.padEnd(26) + 'p50 ' + values.p50.toFixed(1).padStart(8) + ' ms  p95 '
+        + values.p95.toFixed(1).padStart(8) + ' ms  max ' + values.max.toFixed(1).padStart(8) + ' ms';
+}
+
+async function main() {
+    const fakeSys = fs.mkdtempSync(path.join(os.tmpdir(), 'tcc-switch-sys-'));
+    createFakeSysFs(fakeSys);
+
+    const daemon = spawnDaemon(fakeSys);
+    let reports: ISwitchRunReport[];
+    let failure: Error;
+    try {
+        reports = await collectReports(daemon);
+    } catch (err) {
+        failure = err;
+    }
+    fs.rmSync(fakeSys, { recursive: true, force: true });
+    if (failure !== undefined) {
+        console.log(failure.message + ' (unshare needs unprivileged user namespaces)');
+        process.exit(1);
+    }
+
+    const switches = reports.filter(report => !report.done);
+    const errors = reports[reports.length - 1].errors || [];
+    if (switches.length === 0) {
+        console.log('No profile switch completed' + (errors.length > 0 ? ':\n  ' + errors.join('\n  ') : ''));
+        process.exit(1);
+    }
+
+    const lastWriteMs = (run: ISwitchRunReport) => run.writes.length > 0 ? run.writes[run.writes.length - 1].atMs : 0;
+    const requestMs = (run: ISwitchRunReport) => run.callOffsetMs;
+    const latencies = {
+        selectedMs: distribution(switches.map(run => requestMs(run) + run.switchReport.selectedMs)),
+        criticalAppliedMs: distribution(switches.map(run => requestMs(run) + run.switchReport.criticalAppliedMs)),
+        fullyAppliedMs: distribution(switches.map(run => requestMs(run) + run.switchReport.fullyAppliedMs)),
+        lastWriteMs: distribution(switches.map(lastWriteMs))
+    };
+    const workers = contributions(switches);
+    const unattributedWrites = switches.reduce((sum, run) => sum + run.writes.filter(write => write.worker === undefined).length, 0);
+    const budgetMs = parseFloat(args.budget);
+    const overBudget = budgetMs > 0 && latencies.fullyAppliedMs.p95 > budgetMs;
+
+    if (args.json === 'true') {
+        console.log(JSON.stringify({ simulation, switches: switches.length, latencies, workers,
+            unattributedWritesPerSwitch: unattributedWrites / switches.length, errors, overBudget }, null, 4));
+    } else {
+        console.log('Profile switch over DBus, ' + switches.length + ' switches (simulation: ' + simulation + ')');
+        console.log(formatDistribution('profile selected', latencies.selectedMs));
+        console.log(formatDistribution('critical workers applied', latencies.criticalAppliedMs));
+        console.log(formatDistribution('fully applied', latencies.fullyAppliedMs));
+        console.log(formatDistribution('last hardware write', latencies.lastWriteMs));
+        console.log('  worker                         mean ms  share  sysfs/sw  ec/sw');
+        for (const worker of workers) {
+            console.log('  ' + (worker.name + (worker.critical ? ' *' : '')).padEnd(28)
+                + worker.meanDurationMs.toFixed(2).padStart(10)
+                + (worker.sharePercent.toFixed(0) + '%').padStart(7)
+                + worker.sysFsWritesPerSwitch.toFixed(1).padStart(10)
+                + worker.ecWritesPerSwitch.toFixed(1).padStart(7));
+        }
+        console.log('  (* critical) unattributed writes per switch: ' + (unattributedWrites / switches.length).toFixed(1));
+        if (errors.length > 0) {
+            console.log('  worker errors:\n    ' + errors.join('\n    '));
+        }
+        if (budgetMs > 0) {
+            console.log(overBudget ? 'Fully applied p95 exceeds the budget of ' + budgetMs + ' ms' : 'Within budget of ' + budgetMs + ' ms');
+        }
+    }
+    process.exit(overBudget ? 1 : 0);
+}
+
+main();
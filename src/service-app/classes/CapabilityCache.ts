@@ -0,0 +1,222 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import * as fs from 'fs';
+import * as path from 'path';
+import * as os from 'os';
+import { DMIController } from '../../common/classes/DMIController';
+import { TccPaths } from '../../common/classes/TccPaths';
+import { TuxedoIOAPI as ioAPI, ModuleInfo, TuxedoIOCapabilities, TDPInfo } from '../../native-lib/TuxedoIOAPI';
+
+export interface ICapabilityCacheKey {
+    moduleVersion: string;
+    boardVendor: string;
+    boardName: string;
+    productSKU: string;
+    kernelRelease: string;
+}
+
+export interface IHwmonCapabilities {
+    tuxiPath: string;
+    pwmPath: string;
+}
+
+export interface ICapabilities {
+    key: ICapabilityCacheKey;
+    io: TuxedoIOCapabilities;
+    hwmon: IHwmonCapabilities;
+}
+
+export const HWMON_NAME_TUXI = 'tuxedo_tuxi_sensors';
+export const HWMON_NAME_PWM = 'tuxedo';
+
+/**
+ * Persists the probed hardware capabilities so that a restart of the daemon
+ * does not need to probe again before taking over control. The cache is only
+ * used as long as tuxedo-io version, DMI board data and kernel are unchanged,
+ * verify() probes again and updates the cache if the hardware answers differently.
+ */
+export class CapabilityCache {
+
+    private static moduleInfo: ModuleInfo;
+
+    private current: ICapabilities;
+    private loadedFromCache = false;
+
+    constructor(
+        private cacheFile: string = TccPaths.CAPABILITIES_CACHE_FILE,
+        private dmiPath: string = '/sys/class/dmi/id',
+        private hwmonBasePath: string = '/sys/class/hwmon') {}
+
+    public get capabilities(): ICapabilities {
+        return this.current;
+    }
+
+    public get fromCache(): boolean {
+        return this.loadedFromCache;
+    }
+
+    public load(): ICapabilities {
+        const key = this.getKey();
+        const cached = this.readCache();
+        if (cached !== undefined && JSON.stringify(cached.key) === JSON.stringify(key)) {
+            this.current = cached;
+            this.loadedFromCache = true;
+        } else {
+            this.current = this.probe(key);
+            this.loadedFromCache = false;
+            this.writeCache(this.current);
+        }
+        return this.current;
+    }
+
+    /**
+     * Probe hardware again and update cache if anything changed
+     *
+     * @returns True if the capabilities differ from the loaded ones
+     */
+    public verify(): boolean {
+        const probed = this.probe(this.getKey());
+        const changed = this.current === undefined || JSON.stringify(probed) !== JSON.stringify(this.current);
+        if (changed) {
+            this.current = probed;
+            this.writeCache(probed);
+        }
+        this.loadedFromCache = false;
+        return changed;
+    }
+
+    /**
+     * TDP descriptors and limits, current values are not part of the cache
+     *
+     * @returns Undefined if no capabilities are loaded
+     */
+    public getTDPLimits(): TDPInfo[] {
+        if (this.current === undefined || this.current.io === undefined) {
+            return undefined;
+        }
+        return this.current.io.tdps.map(tdp => ({ descriptor: tdp.descriptor, min: tdp.min, max: tdp.max, current: undefined }));
+    }
+
+    /**
+     * ODM performance profiles offered through tuxedo_io
+     *
+     * @returns Undefined if no capabilities are loaded
+     */
+    public getODMProfiles(): { available: string[], defaultProfile: string } {
+        if (this.current === undefined || this.current.io === undefined) {
+            return undefined;
+        }
+        return { available: Array.from(this.current.io.odmProfiles), defaultProfile: this.current.io.odmDefaultProfile };
+    }
+
+    /**
+     * Get path of hwmon interface by name, preferring the cached path if still valid.
+     * hwmon numbering is not stable across boots so the cached path is only a hint.
+     */
+    public resolveHwmonPath(name: string): string {
+        if (this.current !== undefined) {
+            const cachedPath = name === HWMON_NAME_TUXI ? this.current.hwmon.tuxiPath : this.current.hwmon.pwmPath;
+            if (cachedPath !== undefined && this.readHwmonName(cachedPath) === name) {
+                return cachedPath;
+            }
+        }
+        return this.findHwmonPath(name);
+    }
+
+    /**
+     * tuxedo-io module info, read from the device once per process since
+     * that opens the device and identifies the interface
+     */
+    public static getModuleInfo(): ModuleInfo {
+        if (CapabilityCache.moduleInfo === undefined) {
+            const modInfo = new ModuleInfo();
+            if (!ioAPI.getModuleInfo(modInfo)) {
+                // Not loaded (yet), ask again next time
+                return modInfo;
+            }
+            CapabilityCache.moduleInfo = modInfo;
+        }
+        return CapabilityCache.moduleInfo;
+    }
+
+    public getKey(): ICapabilityCacheKey {
+        const dmi = new DMIController(this.dmiPath);
+        return {
+            moduleVersion: CapabilityCache.getModuleInfo().version,
+            boardVendor: dmi.boardVendor.readValueNT(),
+            boardName: dmi.boardName.readValueNT(),
+            productSKU: dmi.productSKU.readValueNT(),
+            kernelRelease: os.release()
+        };
+    }
+
+    private probe(key: ICapabilityCacheKey): ICapabilities {
+        return {
+            key,
+            io: ioAPI.probeCapabilities(),
+            hwmon: {
+                tuxiPath: this.findHwmonPath(HWMON_NAME_TUXI),
+                pwmPath: this.findHwmonPath(HWMON_NAME_PWM)
+            }
+        };
+    }
+
+    private findHwmonPath(name: string): string {
+        let entries: string[];
+        try {
+            entries = fs.readdirSync(this.hwmonBasePath);
+        } catch (err) {
+            return undefined;
+        }
+        for (const entry of entries) {
+            const hwmonPath = path.join(this.hwmonBasePath, entry);
+            if (this.readHwmonName(hwmonPath) === name) {
+                return hwmonPath;
+            }
+        }
+        return undefined;
+    }
+
+    private readHwmonName(hwmonPath: string): string {
+        try {
+            return fs.readFileSync(path.join(hwmonPath, 'name')).toString().trim();
+        } catch (err) {
+            return undefined;
+        }
+    }
+
+    private readCache(): ICapabilities {
+        try {
+            return JSON.parse(fs.readFileSync(this.cacheFile).toString());
+        } catch (err) {
+            return undefined;
+        }
+    }
+
+    private writeCache(capabilities: ICapabilities): void {
+        try {
+            if (!fs.existsSync(path.dirname(this.cacheFile))) {
+                fs.mkdirSync(path.dirname(this.cacheFile), { mode: 0o755, recursive: true });
+            }
+            fs.writeFileSync(this.cacheFile, JSON.stringify(capabilities), { mode: 0o644 });
+        } catch (err) {
+            console.log('CapabilityCache: Failed to write cache => ' + err);
+        }
+    }
+}
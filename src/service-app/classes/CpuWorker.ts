@@ -23,6 +23,8 @@ import { TuxedoControlCenterDaemon } from './TuxedoControlCenterDaemon';
 import { ITccProfile } from '../../common/models/TccProfile';
 import { ScalingDriver } from '../../common/classes/LogicalCpuController';
 import { TUXEDODevice } from '../../common/models/DefaultProfiles';
+import { SysFsBatch, ISysFsWriteResult } from '../../common/classes/SysFsBatch';
+import { TuxedoIOAPI as ioAPI, CpuDesiredAttribute } from '../../native-lib/TuxedoIOAPI';
 
 export class CpuWorker extends DaemonWorker {
     private readonly basePath = '/sys/devices/system/cpu';
@@ -31,6 +33,12 @@ export class CpuWorker extends DaemonWorker {
     private readonly preferredAcpiFreqGovernors = [ 'ondemand', 'schedutil', 'conservative' ];
     private readonly preferredPerformanceAcpiFreqGovernors = [ 'performance' ];
 
+    /**
+     * Cores verified per onWork by the native reconciler
+     */
+    private readonly reconcileCoresPerTick = 4;
+    private reconcilerActive = false;
+
     /**
      * Skip writing energy performance preference if flag is set
      */
@@ -39,7 +47,7 @@ export class CpuWorker extends DaemonWorker {
 
     constructor(tccd: TuxedoControlCenterDaemon) {
         super(10000, tccd);
-        this.cpuCtrl = new CpuController(this.basePath);
+        this.cpuCtrl = new CpuController(this.basePath, (writes, results) => ioAPI.sysFsWriteBatch(writes, results));
 
         this.device = this.tccd.identifyDevice();
         if ([TUXEDODevice.SIRIUS1602, TUXEDODevice.STELLSL15A06].includes(this.device)) {
@@ -52,10 +60,17 @@ export class CpuWorker extends DaemonWorker {
     public onStart() {
         if (this.tccd.settings.cpuSettingsEnabled) {
             this.applyCpuProfile(this.activeProfile);
+        } else {
+            this.setDesiredState(undefined);
         }
     }
 
     public onWork() {
+        if (this.tccd.settings.cpuSettingsEnabled && this.reconcilerActive) {
+            this.reconcile();
+            return;
+        }
+
         // Check if current profile CPU values are actually set. If not
         // apply profile again
 
@@ -70,9 +85,89 @@ export class CpuWorker extends DaemonWorker {
     }
 
     public onExit() {
+        this.setDesiredState(undefined);
         this.setCpuDefaultConfig();
     }
 
+    /**
+     * Verify part of the applied state natively and reapply only what drifted
+     */
+    private reconcile() {
+        try {
+            for (const drift of ioAPI.cpuReconcilerTick(this.reconcileCoresPerTick)) {
+                let action: string;
+                if (!drift.reapplied) {
+                    action = 'not reapplied, does not stick';
+                } else if (drift.error !== 0) {
+                    action = 'reapply failed (errno ' + drift.error + ')';
+                } else {
+                    action = 'reapplied';
+                }
+                this.tccd.logLine('CpuWorker: Unexpected value ' + drift.path + ' => \''
+                    + drift.actual + '\' instead of \'' + drift.expected + '\', ' + action);
+            }
+            this.tccd.dbusData.cpuReconcilerStatsJSON = JSON.stringify(ioAPI.cpuReconcilerGetStats());
+        } catch (err) {
+            this.tccd.logLine('CpuWorker: Error reconciling cpu state => ' + err);
+            this.reconcilerActive = false;
+        }
+    }
+
+    /**
+     * Hand what was written for the profile to the native reconciler as the
+     * state to keep. Skips what the kernel does not read back as written, as
+     * the full validation does.
+     *
+     * @param results Results of the profile batch, undefined to stop reconciling
+     */
+    private setDesiredState(results: ISysFsWriteResult[], profile?: ITccProfile) {
+        const desired = new Map<string, CpuDesiredAttribute>();
+        if (results !== undefined) {
+            const skipFrequencies = profile.cpu.noTurbo === true
+                || this.cpuCtrl.cores[0].scalingDriver.readValueNT() === ScalingDriver.intel_pstate;
+            for (const result of results) {
+                const attribute = result.path.substring(result.path.lastIndexOf('/') + 1);
+                if (result.errno !== 0
+                    || (skipFrequencies && (attribute === 'scaling_min_freq' || attribute === 'scaling_max_freq'))
+                    || (attribute === 'energy_performance_preference' && result.value === 'default')) {
+                    desired.delete(result.path);
+                    continue;
+                }
+                const coreMatch = result.path.match(/\/cpu(\d+)\//);
+                desired.set(result.path, {
+                    core: coreMatch !== null ? parseInt(coreMatch[1], 10) : -1,
+                    path: result.path,
+                    value: result.value
+                });
+            }
+        }
+
+        // Attributes of offline cores do not exist, online state goes first
+        const offlineCores = new Set<number>();
+        const attributes: CpuDesiredAttribute[] = [];
+        for (const attribute of desired.values()) {
+            if (attribute.path.endsWith('/online')) {
+                attributes.push(attribute);
+                if (attribute.value === '0') {
+                    offlineCores.add(attribute.core);
+                }
+            }
+        }
+        for (const attribute of desired.values()) {
+            if (!attribute.path.endsWith('/online') && !offlineCores.has(attribute.core)) {
+                attributes.push(attribute);
+            }
+        }
+
+        try {
+            ioAPI.cpuReconcilerSetDesired(attributes);
+            this.reconcilerActive = results !== undefined;
+            this.tccd.dbusData.cpuReconcilerStatsJSON = JSON.stringify(ioAPI.cpuReconcilerGetStats());
+        } catch (err) {
+            this.reconcilerActive = false;
+        }
+    }
+
     /**
      * Choose the default governor for the current system
      *
@@ -156,68 +251,108 @@ export class CpuWorker extends DaemonWorker {
      *                  Undefined values are interpreted as "use default".
      */
     private applyCpuProfile(profile: ITccProfile) {
+        // Cores have to be online before their cpufreq attributes can be
+        // written, everything else is collected and applied in one batch
+        this.commitBatch(this.createOnlineBatch(), 'Failed to bring cores online');
+
+        const batch = this.cpuCtrl.createBatch();
         try {
             // Reset everything to default on all cores before applying settings
             // Set online status last so that all cores get the same settings
-            this.setCpuDefaultConfig();
+            this.setCpuDefaultConfig(batch);
 
             if (!profile.cpu.useMaxPerfGov) {
                 // Note: Hard set governor to default (not included in profiles atm)
                 profile.cpu.governor = this.findDefaultGovernor();
 
-                this.cpuCtrl.setGovernor(profile.cpu.governor);
+                this.cpuCtrl.setGovernor(profile.cpu.governor, batch);
                 if (!this.noEPPWriteQuirk) {
                     if (this.device === TUXEDODevice.GEMINI17I04) {
                         // Quirk for Gemini Gen4 Intel, needs EPP = performance to allow full frequency range
-                        this.cpuCtrl.setEnergyPerformancePreference("performance");
+                        this.cpuCtrl.setEnergyPerformancePreference("performance", batch);
                     } else {
-                        this.cpuCtrl.setEnergyPerformancePreference(profile.cpu.energyPerformancePreference);
+                        this.cpuCtrl.setEnergyPerformancePreference(profile.cpu.energyPerformancePreference, batch);
                     }
                 }
 
-                this.cpuCtrl.setGovernorScalingMinFrequency(profile.cpu.scalingMinFrequency);
-                this.cpuCtrl.setGovernorScalingMaxFrequency(profile.cpu.scalingMaxFrequency);
+                this.cpuCtrl.setGovernorScalingMinFrequency(profile.cpu.scalingMinFrequency, batch);
+                this.cpuCtrl.setGovernorScalingMaxFrequency(profile.cpu.scalingMaxFrequency, batch);
             }
             else {
                 profile.cpu.governor = this.findPerformanceGovernor();
 
-                this.cpuCtrl.setGovernor(profile.cpu.governor);
+                this.cpuCtrl.setGovernor(profile.cpu.governor, batch);
                 if (!this.noEPPWriteQuirk) {
-                    this.cpuCtrl.setEnergyPerformancePreference("performance");
+                    this.cpuCtrl.setEnergyPerformancePreference("performance", batch);
                 }
 
-                this.cpuCtrl.setGovernorScalingMinFrequency(-2);
-                this.cpuCtrl.setGovernorScalingMaxFrequency(undefined);
+                this.cpuCtrl.setGovernorScalingMinFrequency(-2, batch);
+                this.cpuCtrl.setGovernorScalingMaxFrequency(undefined, batch);
             }
 
             // Finally set the number of online cores
-            this.cpuCtrl.useCores(profile.cpu.onlineCores);
+            this.cpuCtrl.useCores(profile.cpu.onlineCores, batch);
 
             if (this.cpuCtrl.intelPstate.noTurbo.isAvailable() && this.cpuCtrl.intelPstate.noTurbo.isWritable()) {
                 if (profile.cpu.noTurbo !== undefined) {
-                    this.cpuCtrl.intelPstate.noTurbo.writeValue(profile.cpu.noTurbo);
+                    this.cpuCtrl.intelPstate.noTurbo.writeValueQueued(profile.cpu.noTurbo, batch);
                 }
             }
         } catch (err) {
             this.tccd.logLine('CpuWorker: Failed to apply profile => ' + err);
         }
+        // Apply what could be queued even if a later stage failed, as before
+        this.setDesiredState(this.commitBatch(batch, 'Failed to apply profile'), profile);
     }
 
-    private setCpuDefaultConfig(): void {
+    /**
+     * @param batch Queue writes in batch, applies them directly if undefined
+     */
+    private setCpuDefaultConfig(batch?: SysFsBatch): void {
+        let ownBatch: SysFsBatch;
+        if (batch === undefined) {
+            this.commitBatch(this.createOnlineBatch(), 'Failed to bring cores online');
+            ownBatch = this.cpuCtrl.createBatch();
+            batch = ownBatch;
+        }
         try {
-            this.cpuCtrl.useCores();
-            this.cpuCtrl.setGovernorScalingMinFrequency();
-            this.cpuCtrl.setGovernorScalingMaxFrequency();
-            this.cpuCtrl.setGovernor(this.findDefaultGovernor());
+            this.cpuCtrl.useCores(undefined, batch);
+            this.cpuCtrl.setGovernorScalingMinFrequency(undefined, batch);
+            this.cpuCtrl.setGovernorScalingMaxFrequency(undefined, batch);
+            this.cpuCtrl.setGovernor(this.findDefaultGovernor(), batch);
             if (!this.noEPPWriteQuirk) {
-                this.cpuCtrl.setEnergyPerformancePreference('default');
+                this.cpuCtrl.setEnergyPerformancePreference('default', batch);
             }
             if (this.cpuCtrl.intelPstate.noTurbo.isAvailable() && this.cpuCtrl.intelPstate.noTurbo.isWritable()) {
-                this.cpuCtrl.intelPstate.noTurbo.writeValue(false);
+                this.cpuCtrl.intelPstate.noTurbo.writeValueQueued(false, batch);
             }
         } catch (err) {
             this.tccd.logLine('CpuWorker: Failed to set default cpu config => ' + err);
         }
+        if (ownBatch !== undefined) {
+            this.commitBatch(ownBatch, 'Failed to set default cpu config');
+        }
+    }
+
+    private createOnlineBatch(): SysFsBatch {
+        const batch = this.cpuCtrl.createBatch();
+        try {
+            this.cpuCtrl.useCores(undefined, batch);
+        } catch (err) {
+            this.tccd.logLine('CpuWorker: Failed to bring cores online => ' + err);
+        }
+        return batch;
+    }
+
+    private commitBatch(batch: SysFsBatch, errorMessage: string): ISysFsWriteResult[] {
+        const results = batch.commit();
+        for (const result of results) {
+            if (result.errno !== 0) {
+                this.tccd.logLine('CpuWorker: ' + errorMessage + ' => could not write value \''
+                    + result.value + '\' to path: ' + result.path + ' (' + result.error + ')');
+            }
+        }
+        return results;
     }
 
     private validateCpuFreq(): boolean {
@@ -27,26 +27,36 @@ export abstract class DaemonWorker {
         // Also inject the state (i.e configs etc..)
         protected tccd: TuxedoControlCenterDaemon) {}
 
-    public timer: NodeJS.Timer;
-
     protected previousProfile: ITccProfile;
     protected activeProfile: ITccProfile;
 
-    protected abstract onStart(): void;
+    protected abstract onStart(): void | Promise<void>;
     protected abstract onWork(): void;
     protected abstract onExit(): void;
 
-    public start(): void { this.triggerWork(this.onStart); }
+    /**
+     * @returns Promise of asynchronous onStart implementations
+     */
+    public start(): void | Promise<void> { return this.triggerWork(this.onStart); }
     public work(): void { this.triggerWork(this.onWork); }
     public exit(): void { this.triggerWork(this.onExit); }
 
+    /**
+     * Interval until the next onWork, asked by the scheduler after each run.
+     * Workers override it to slow down while nothing changes.
+     */
+    public getNextInterval(): number {
+        return this.timeout;
+    }
+
     public updateProfile(activeProfile: ITccProfile): void {
         this.activeProfile = activeProfile;
     }
 
-    private triggerWork(eventFunction: () => void): void {
-        eventFunction.call(this);
+    private triggerWork(eventFunction: () => void | Promise<void>): void | Promise<void> {
+        const result = eventFunction.call(this);
         this.previousProfile = this.activeProfile;
+        return result;
     }
 
 }
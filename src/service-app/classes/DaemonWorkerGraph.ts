@@ -0,0 +1,137 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import { TuxedoControlCenterDaemon } from './TuxedoControlCenterDaemon';
+import { DaemonWorker } from './DaemonWorker';
+import { WorkerStartup, WorkerStartFunction } from './WorkerStartup';
+import { StateSwitcherWorker } from './StateSwitcherWorker';
+import { ChargingWorker } from './ChargingWorker';
+import { DisplayBacklightWorker } from './DisplayBacklightWorker';
+import { DisplayRefreshRateWorker } from './DisplayRefreshRateWorker';
+import { CpuWorker } from './CpuWorker';
+import { WebcamWorker } from './WebcamWorker';
+import { FanControlWorker } from './FanControlWorker';
+import { YCbCr420WorkaroundWorker } from './YCbCr420WorkaroundWorker';
+import { GpuInfoWorker } from './GpuInfoWorker';
+import { CpuPowerWorker } from './CpuPowerWorker';
+import { PrimeWorker } from './PrimeWorker';
+import { ODMProfileWorker } from './ODMProfileWorker';
+import { ODMPowerLimitWorker } from './ODMPowerLimitWorker';
+import { ThrottleMonitorWorker } from './ThrottleMonitorWorker';
+import { MetricsExporterWorker } from './MetricsExporterWorker';
+import { TelemetryPageWorker } from './TelemetryPageWorker';
+import { AvailabilityService } from '../../common/classes/availability.service';
+import { ITccProfile } from '../../common/models/TccProfile';
+
+export interface IDaemonWorkerNode {
+    worker: DaemonWorker;
+    // Workers that have to be started before this one
+    after: DaemonWorker[];
+    // Started (and controlling the hardware) before all non-critical workers
+    critical: boolean;
+}
+
+export interface IDaemonWorkerOptions {
+    // Left out if undefined, e.g. by benchmarks running without the system bus
+    dbusService?: DaemonWorker;
+    metricsSocketPath?: string;
+}
+
+/**
+ * Workers of tccd and the dependencies they are started along
+ *
+ * Shared with the benchmarks so that they measure the graph tccd runs.
+ */
+export class DaemonWorkerGraph {
+
+    public readonly stateWorker: StateSwitcherWorker;
+    public readonly chargingWorker: ChargingWorker;
+    public readonly fanWorker: FanControlWorker;
+    // In the order they are added to the scheduler
+    public readonly nodes: IDaemonWorkerNode[] = [];
+
+    constructor(private tccd: TuxedoControlCenterDaemon) {
+        this.stateWorker = new StateSwitcherWorker(tccd);
+        this.chargingWorker = new ChargingWorker(tccd);
+        this.fanWorker = new FanControlWorker(tccd);
+    }
+
+    /**
+     * Adds all workers, separate from the constructor since services like
+     * TccDBusService look up the workers above on tccd when constructed
+     */
+    public addDaemonWorkers(options: IDaemonWorkerOptions = {}): void {
+        const tccd = this.tccd;
+        const odmProfileWorker = new ODMProfileWorker(tccd);
+        // Critical workers start first, the others wait for the state worker
+        // since it selects the profile they apply
+        this.add(this.chargingWorker, [], true);
+        this.add(this.stateWorker, [], true);
+        this.add(new DisplayBacklightWorker(tccd));
+        this.add(new CpuWorker(tccd));
+        this.add(new WebcamWorker(tccd));
+        this.add(this.fanWorker, [this.stateWorker], true);
+        this.add(new YCbCr420WorkaroundWorker(tccd));
+        this.add(new GpuInfoWorker(tccd, new AvailabilityService()));
+        this.add(new CpuPowerWorker(tccd));
+        this.add(new PrimeWorker(tccd));
+        if (options.dbusService !== undefined) {
+            this.add(options.dbusService);
+        }
+        this.add(odmProfileWorker, [this.stateWorker], true);
+        this.add(new ODMPowerLimitWorker(tccd), [odmProfileWorker], true);
+        this.add(new ThrottleMonitorWorker(tccd));
+        this.add(new TelemetryPageWorker(tccd));
+        this.add(new DisplayRefreshRateWorker(tccd));
+        if (options.metricsSocketPath !== undefined && options.metricsSocketPath !== '') {
+            this.add(new MetricsExporterWorker(tccd, options.metricsSocketPath));
+        }
+    }
+
+    public get workers(): DaemonWorker[] {
+        return this.nodes.map(node => node.worker);
+    }
+
+    /**
+     * @param getProfile Read as each worker starts, the state worker may
+     *                   select a different profile on its start
+     * @param instrument Optional wrapper around each start, e.g. for tracing
+     */
+    public createStartup(
+        getProfile: () => ITccProfile,
+        logLine: (line: string) => void,
+        instrument?: (name: string, start: WorkerStartFunction) => WorkerStartFunction): WorkerStartup {
+        const startup = new WorkerStartup(logLine);
+        for (const node of this.nodes) {
+            const name = node.worker.constructor.name;
+            let start: WorkerStartFunction = () => {
+                node.worker.updateProfile(getProfile());
+                return node.worker.start();
+            };
+            if (instrument !== undefined) {
+                start = instrument(name, start);
+            }
+            startup.add(name, start, node.after.map(dependency => dependency.constructor.name), node.critical);
+        }
+        return startup;
+    }
+
+    private add(worker: DaemonWorker, after: DaemonWorker[] = [this.stateWorker], critical: boolean = false): void {
+        this.nodes.push({ worker, after, critical });
+    }
+}
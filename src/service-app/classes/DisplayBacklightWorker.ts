@@ -16,6 +16,7 @@
  * You should have received a copy of the GNU General Public License
  * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
  */
+import * as path from 'path';
 import { DaemonWorker } from './DaemonWorker';
 import { DisplayBacklightController } from '../../common/classes/DisplayBacklightController';
 
@@ -23,9 +24,14 @@ import { TuxedoControlCenterDaemon } from './TuxedoControlCenterDaemon';
 
 export class DisplayBacklightWorker extends DaemonWorker {
 
+    // Drivers are still reenumerated while the brightness of all is watched
+    private static readonly WATCHED_INTERVAL_MS = 30000;
+
     private controllers: DisplayBacklightController[];
     private basePath = '/sys/class/backlight';
     private useAutosave = false;
+    // Watch handle per driver, undefined if the driver has to be polled
+    private brightnessWatches = new Map<string, number>();
 
     constructor(tccd: TuxedoControlCenterDaemon) {
         super(3000, tccd);
@@ -69,25 +75,30 @@ export class DisplayBacklightWorker extends DaemonWorker {
 
     public onWork(): void {
         this.findDrivers(); // Drivers are reenumerated before use since they can change on the fly
+        this.updateBrightnessWatches();
 
         // Possibly save brightness regularly
         for (const controller of this.controllers) {
-            let value: number;
-            let maxBrightness: number;
-
-            try {
-                value = controller.brightness.readValue();
-                maxBrightness = controller.maxBrightness.readValue();
-                if (!Number.isNaN(value) && value !== 0) {
-                    this.tccd.autosave.displayBrightness = Math.round((value * 100) / maxBrightness);
-                }
-            } catch (err) {
-                this.tccd.logLine('DisplayBacklightWorker => ' + err);
-            }
+            this.saveBrightness(controller);
         }
     }
 
+    /**
+     * Brightness changes (also by hotkeys) are signalled through
+     * actual_brightness, polling is only needed for new or unwatchable drivers
+     */
+    public getNextInterval(): number {
+        const allWatched = this.controllers !== undefined && this.controllers.length > 0
+            && this.controllers.every(controller => this.brightnessWatches.get(controller.driver) !== undefined);
+        return allWatched ? DisplayBacklightWorker.WATCHED_INTERVAL_MS : this.timeout;
+    }
+
     public onExit(): void {
+        for (const id of this.brightnessWatches.values()) {
+            this.tccd.sysFsWatcher.unwatch(id);
+        }
+        this.brightnessWatches.clear();
+
         this.findDrivers(); // Drivers are reenumerated before use since they can change on the fly
 
         this.controllers.forEach((controller) => {
@@ -112,6 +123,36 @@ export class DisplayBacklightWorker extends DaemonWorker {
         });
     }
 
+    private saveBrightness(controller: DisplayBacklightController): void {
+        try {
+            const value = controller.brightness.readValue();
+            const maxBrightness = controller.maxBrightness.readValue();
+            if (!Number.isNaN(value) && value !== 0) {
+                this.tccd.autosave.displayBrightness = Math.round((value * 100) / maxBrightness);
+            }
+        } catch (err) {
+            this.tccd.logLine('DisplayBacklightWorker => ' + err);
+        }
+    }
+
+    private updateBrightnessWatches(): void {
+        const drivers = this.controllers.map(controller => controller.driver);
+        for (const [driver, id] of this.brightnessWatches) {
+            if (!drivers.includes(driver)) {
+                this.tccd.sysFsWatcher.unwatch(id);
+                this.brightnessWatches.delete(driver);
+            }
+        }
+        for (const controller of this.controllers) {
+            if (!this.brightnessWatches.has(controller.driver)) {
+                const id = this.tccd.sysFsWatcher.watch(
+                    path.join(this.basePath, controller.driver, 'actual_brightness'),
+                    () => this.saveBrightness(controller));
+                this.brightnessWatches.set(controller.driver, id);
+            }
+        }
+    }
+
     private writeBrightness(brightnessPercent: number, recheck?: boolean): void {
         this.findDrivers();
         // Try all possible drivers to be on the safe side, fail silently if they do not work
@@ -25,12 +25,15 @@ import {
 } from "../../common/models/DisplayFreqRes";
 import { TuxedoControlCenterDaemon } from "./TuxedoControlCenterDaemon";
 import * as child_process from "child_process";
+import { TuxedoIOAPI as ioAPI, DrmCatalog } from "../../native-lib/TuxedoIOAPI";
+import { findInternalConnector, drmConnectorToDisplayModes } from "./DrmDisplayModes";
 
 export class DisplayRefreshRateWorker extends DaemonWorker {
     private controller: XDisplayRefreshRateController;
     private displayInfo: IDisplayFreqRes;
     private displayInfoFound: boolean = false;
     private previousUsers: string = "";
+    private drmCatalog: DrmCatalog;
 
     constructor(tccd: TuxedoControlCenterDaemon) {
         super(5000, tccd);
@@ -65,13 +68,33 @@ export class DisplayRefreshRateWorker extends DaemonWorker {
             this.resetToDefault();
         }
 
+        // Connectors or modes changed (hotplug, mode set), only then query again
+        const drmChanged = this.updateDrmCatalog();
+
         if (usersAvailable && !this.controller.getIsWayland()) {
-            if (!this.displayInfoFound) {
+            if (!this.displayInfoFound || drmChanged) {
                 this.updateDisplayData();
             }
 
             this.setActiveDisplayMode();
+        } else if (usersAvailable && drmChanged) {
+            this.updateDisplayData();
+        }
+    }
+
+    /**
+     * @returns True if the connector catalog changed since the last call
+     */
+    private updateDrmCatalog(): boolean {
+        let catalog: DrmCatalog;
+        try {
+            catalog = ioAPI.getDrmCatalog();
+        } catch (err) {
+            return false;
         }
+        const changed = this.drmCatalog === undefined || catalog.generation !== this.drmCatalog.generation;
+        this.drmCatalog = catalog;
+        return changed;
     }
 
     public onExit(): void {}
@@ -104,7 +127,11 @@ export class DisplayRefreshRateWorker extends DaemonWorker {
         this.tccd.dbusData.isX11 = this.controller.getIsX11();
 
         if (this.displayInfo === undefined) {
-            this.tccd.dbusData.displayModes = undefined;
+            // No X11 session (e.g. Wayland), modes from the DRM catalog for display only,
+            // setting modes stays X11 only
+            const connector = findInternalConnector(this.drmCatalog);
+            this.tccd.dbusData.displayModes = connector !== undefined
+                ? JSON.stringify(drmConnectorToDisplayModes(connector)) : undefined;
         } else {
             this.displayInfoFound = true;
             this.tccd.dbusData.displayModes = JSON.stringify(this.displayInfo);
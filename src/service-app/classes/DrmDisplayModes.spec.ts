@@ -0,0 +1,65 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import 'jasmine';
+import { findInternalConnector, drmConnectorToDisplayModes } from './DrmDisplayModes';
+import { DrmCatalog } from '../../native-lib/TuxedoIOAPI';
+
+describe('DrmDisplayModes', () => {
+
+    const catalog: DrmCatalog = {
+        generation: 1,
+        scans: 1,
+        connectors: [
+            { card: 1, name: 'HDMI-A-1', status: 'disconnected', enabled: false, modes: [] },
+            {
+                card: 1, name: 'eDP-1', status: 'connected', enabled: true,
+                modes: [ '2560x1600', '2560x1600', '1920x1200' ],
+                edid: {
+                    manufacturer: 'BOE', productCode: 0x0a1b, monitorName: '',
+                    timings: [
+                        { width: 2560, height: 1600, refreshRate: 240, interlaced: false, preferred: true },
+                        { width: 2560, height: 1600, refreshRate: 60, interlaced: false, preferred: false }
+                    ]
+                }
+            }
+        ]
+    };
+
+    it('should find the connected internal panel', () => {
+        expect(findInternalConnector(catalog).name).toBe('eDP-1');
+        expect(findInternalConnector({ generation: 0, scans: 0, connectors: [ catalog.connectors[0] ] })).toBeUndefined();
+        expect(findInternalConnector(undefined)).toBeUndefined();
+    });
+
+    it('should combine kernel modes with EDID refresh rates', () => {
+        const displayModes = drmConnectorToDisplayModes(catalog.connectors[1]);
+        expect(displayModes.displayName).toBe('eDP-1');
+        expect(displayModes.displayModes.length).toBe(2);
+        expect(displayModes.displayModes[0]).toEqual({ refreshRates: [ 240, 60 ], xResolution: 2560, yResolution: 1600 });
+        expect(displayModes.displayModes[1].refreshRates).toEqual([]);
+        expect(displayModes.activeMode).toEqual({ refreshRates: [ 240 ], xResolution: 2560, yResolution: 1600 });
+    });
+
+    it('should fall back to EDID resolutions without kernel modes', () => {
+        const connector = Object.assign({}, catalog.connectors[1], { modes: [] });
+        const displayModes = drmConnectorToDisplayModes(connector);
+        expect(displayModes.displayModes.length).toBe(1);
+        expect(displayModes.displayModes[0].xResolution).toBe(2560);
+    });
+});
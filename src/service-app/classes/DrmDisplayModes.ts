@@ -0,0 +1,79 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import { IDisplayFreqRes, IDisplayMode } from '../../common/models/DisplayFreqRes';
+import { DrmCatalog, DrmConnector } from '../../native-lib/TuxedoIOAPI';
+
+/**
+ * Connected internal panel (eDP/LVDS) of the catalog, undefined if none
+ */
+export function findInternalConnector(catalog: DrmCatalog): DrmConnector {
+    if (catalog === undefined) {
+        return undefined;
+    }
+    return catalog.connectors.find(connector =>
+        connector.status === 'connected' && /^(eDP|LVDS)/.test(connector.name));
+}
+
+/**
+ * Display modes of a connector in the form xrandr parsing provides them
+ *
+ * Resolutions come from the kernel mode list, refresh rates from the EDID
+ * timings. The active mode is not exposed in sysfs, the preferred mode is
+ * reported instead.
+ */
+export function drmConnectorToDisplayModes(connector: DrmConnector): IDisplayFreqRes {
+    const timings = connector.edid !== undefined ? connector.edid.timings.filter(timing => !timing.interlaced) : [];
+    const displayModes: IDisplayMode[] = [];
+    const addResolution = (xResolution: number, yResolution: number) => {
+        if (displayModes.find(mode => mode.xResolution === xResolution && mode.yResolution === yResolution) !== undefined) {
+            return;
+        }
+        const refreshRates = timings
+            .filter(timing => timing.width === xResolution && timing.height === yResolution)
+            .map(timing => timing.refreshRate)
+            .sort((a, b) => b - a);
+        displayModes.push({ refreshRates, xResolution, yResolution });
+    };
+
+    for (const modeName of connector.modes) {
+        const match = modeName.match(/^(\d+)x(\d+)$/);
+        if (match !== null) {
+            addResolution(parseInt(match[1], 10), parseInt(match[2], 10));
+        }
+    }
+    if (displayModes.length === 0) {
+        for (const timing of timings) {
+            addResolution(timing.width, timing.height);
+        }
+    }
+
+    const activeMode: IDisplayMode = { refreshRates: [], xResolution: 0, yResolution: 0 };
+    const preferred = timings.find(timing => timing.preferred);
+    if (preferred !== undefined) {
+        activeMode.refreshRates = [ preferred.refreshRate ];
+        activeMode.xResolution = preferred.width;
+        activeMode.yResolution = preferred.height;
+    } else if (displayModes.length > 0 && displayModes[0].refreshRates.length > 0) {
+        activeMode.refreshRates = [ displayModes[0].refreshRates[0] ];
+        activeMode.xResolution = displayModes[0].xResolution;
+        activeMode.yResolution = displayModes[0].yResolution;
+    }
+
+    return { displayName: connector.name, activeMode, displayModes };
+}
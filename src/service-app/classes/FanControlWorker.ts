@@ -26,6 +26,7 @@ import {
     TuxedoIOAPI as ioAPI,
     TuxedoIOAPI,
     ObjWrapper,
+    DeviceTelemetry,
 } from "../../native-lib/TuxedoIOAPI";
 import { FanControlLogic, FAN_LOGIC } from "./FanControlLogic";
 import { interpolatePointsArray } from "../../common/classes/FanUtils";
@@ -34,11 +35,12 @@ import {
     ITccFanTableEntry,
     customFanPreset,
 } from "../../common/models/TccFanTable";
-import { exec } from "child_process";
 import * as path from "path";
 import * as fs from "fs";
 import { ITccProfile } from "../../common/models/TccProfile";
 import { TUXEDODevice } from "../../common/models/DefaultProfiles";
+import { HWMON_NAME_PWM, HWMON_NAME_TUXI } from "./CapabilityCache";
+import { ProfileStates } from "../../common/models/TccSettings";
 
 export class FanControlWorker extends DaemonWorker {
     private fans: Map<number, FanControlLogic>;
@@ -62,6 +64,9 @@ export class FanControlWorker extends DaemonWorker {
     private fansOffAvailable: boolean = true;
     private fansMinSpeedHWLimit: number = 0;
 
+    // Asked once per start, again after a batch read was of no use
+    private telemetryBatchSupported: boolean = false;
+
     private platformAvailable: boolean;
     private platformPath: string =
         "/sys/bus/platform/devices/tuxedo_fan_control";
@@ -88,18 +93,56 @@ export class FanControlWorker extends DaemonWorker {
         tableGPU: [],
     };
 
+    // Adaptive interval: base interval on temperature changes, slowing down
+    // step by step while temperatures stay flat
+    private static readonly SLOPE_THRESHOLD_CELSIUS = 2;
+    private static readonly MAX_INTERVAL_AC_MS = 2000;
+    private static readonly MAX_INTERVAL_BAT_MS = 3000;
+    private lastIntervalTemp: number;
+    private interval: number;
+
     constructor(tccd: TuxedoControlCenterDaemon) {
         super(1000, tccd);
+        this.interval = this.timeout;
+    }
+
+    public getNextInterval(): number {
+        // Published by every control path, -1 for missing sensors
+        const temps = (this.tccd.dbusData.fans || [])
+            .map((fan) => fan.temp.data.value)
+            .filter((temp) => temp !== undefined && temp >= 0);
+        if (temps.length === 0) {
+            this.interval = this.timeout;
+            return this.interval;
+        }
+        const maxTemp = Math.max(...temps);
+        const maxInterval =
+            this.tccd.getProfileState() === ProfileStates.BAT
+                ? FanControlWorker.MAX_INTERVAL_BAT_MS
+                : FanControlWorker.MAX_INTERVAL_AC_MS;
+
+        if (
+            this.lastIntervalTemp === undefined ||
+            Math.abs(maxTemp - this.lastIntervalTemp) >=
+                FanControlWorker.SLOPE_THRESHOLD_CELSIUS
+        ) {
+            this.interval = this.timeout;
+            this.lastIntervalTemp = maxTemp;
+        } else {
+            this.interval = Math.min(this.interval + this.timeout, maxInterval);
+        }
+        return this.interval;
     }
 
-    public async onStart(): Promise<void> {
-        await this.setupTuxi();
+    public onStart(): void {
+        this.telemetryBatchSupported = ioAPI.getTelemetryBatchSupported();
+        this.setupTuxi();
 
         if (this.hwmonTuxiAvailable) {
             console.log("Using tuxi hwmon");
         }
         if (!this.hwmonTuxiAvailable) {
-            await this.setupPwm();
+            this.setupPwm();
 
             if (this.hwmonPwmAvailable) {
                 console.log("Using pwm hwmon");
@@ -144,8 +187,8 @@ export class FanControlWorker extends DaemonWorker {
         }
     }
 
-    private async setupTuxi() {
-        this.hwmonPath = this.hwmonTuxiPath = await this.getHwmonTuxiPath();
+    private setupTuxi() {
+        this.hwmonPath = this.hwmonTuxiPath = this.getHwmonTuxiPath();
         this.hwmonTuxiAvailable = fs.existsSync(this.hwmonTuxiPath);
 
         if (this.hwmonTuxiAvailable) {
@@ -156,8 +199,8 @@ export class FanControlWorker extends DaemonWorker {
             }
         }
     }
-    private async setupPwm() {
-        this.hwmonPath = this.hwmonPwmPath = await this.getHwmonPwmPath();
+    private setupPwm() {
+        this.hwmonPath = this.hwmonPwmPath = this.getHwmonPwmPath();
         this.hwmonPwmAvailable = fs.existsSync(this.hwmonPwmPath);
 
         if (this.hwmonPwmAvailable) {
@@ -214,8 +257,14 @@ export class FanControlWorker extends DaemonWorker {
     }
 
     private initHardwareCapabilities(): void {
-        this.fansOffAvailable = ioAPI.getFansOffAvailable();
-        this.fansMinSpeedHWLimit = ioAPI.getFansMinSpeed();
+        const capabilities = this.tccd.capabilityCache.capabilities;
+        if (capabilities !== undefined) {
+            this.fansOffAvailable = capabilities.io.fansOffAvailable;
+            this.fansMinSpeedHWLimit = capabilities.io.fansMinSpeed;
+        } else {
+            this.fansOffAvailable = ioAPI.getFansOffAvailable();
+            this.fansMinSpeedHWLimit = ioAPI.getFansMinSpeed();
+        }
 
         this.tccd.dbusData.fansOffAvailable = this.fansOffAvailable;
         this.tccd.dbusData.fansMinSpeed = this.fansMinSpeedHWLimit;
@@ -414,6 +463,14 @@ export class FanControlWorker extends DaemonWorker {
         // devices can not be controlled individually.
         this.modeSameSpeed = true;
 
+        // All fans are read at once on modules with the batch read, otherwise
+        // only the temperatures are read one by one
+        const telemetry = new DeviceTelemetry();
+        const telemetryReadSuccess = this.telemetryBatchSupported && ioAPI.getDeviceTelemetry(telemetry);
+        if (this.telemetryBatchSupported && (!telemetryReadSuccess || !telemetry.batched)) {
+            this.telemetryBatchSupported = ioAPI.getTelemetryBatchSupported();
+        }
+
         // For each fan read and process sensor values
         for (const fanNumber of this.fans.keys()) {
             const fanIndex: number = fanNumber - 1;
@@ -422,10 +479,19 @@ export class FanControlWorker extends DaemonWorker {
 
             // Read and store sensor values
             const currentTemperatureCelsius: ObjWrapper<number> = { value: 0 };
-            const tempReadSuccess = ioAPI.getFanTemperature(
-                fanIndex,
-                currentTemperatureCelsius
-            );
+            let tempReadSuccess: boolean;
+            if (telemetryReadSuccess) {
+                const fanTelemetry = telemetry.fans[fanIndex];
+                tempReadSuccess = fanTelemetry !== undefined && fanTelemetry.temperature !== -1;
+                if (tempReadSuccess) {
+                    currentTemperatureCelsius.value = fanTelemetry.temperature;
+                }
+            } else {
+                tempReadSuccess = ioAPI.getFanTemperature(
+                    fanIndex,
+                    currentTemperatureCelsius
+                );
+            }
             const currentSpeedPercent: ObjWrapper<number> = { value: 0 };
             // const speedReadSuccess = ioAPI.getFanSpeedPercent(fanIndex, currentSpeedPercent);
 
@@ -490,16 +556,12 @@ export class FanControlWorker extends DaemonWorker {
             );
         }
     }
-    private async getHwmonTuxiPath(): Promise<string | undefined> {
-        return await execCommand(
-            "grep -rl '^tuxedo_tuxi_sensors$' /sys/class/hwmon/*/name | sed 's|/name$||'"
-        );
+    private getHwmonTuxiPath(): string | undefined {
+        return this.tccd.capabilityCache.resolveHwmonPath(HWMON_NAME_TUXI);
     }
 
-    private async getHwmonPwmPath(): Promise<string | undefined> {
-        return await execCommand(
-            "grep -rl '^tuxedo$' /sys/class/hwmon/*/name | sed 's|/name$||'"
-        );
+    private getHwmonPwmPath(): string | undefined {
+        return this.tccd.capabilityCache.resolveHwmonPath(HWMON_NAME_PWM);
     }
 
     private getFilteredAndMappedFiles(
@@ -665,15 +727,3 @@ export class FanControlWorker extends DaemonWorker {
         return this.tccd.settings.fanControlEnabled;
     }
 }
-
-async function execCommand(command: string): Promise<string> {
-    return new Promise((resolve, reject) => {
-        exec(command, (error, stdout, stderr) => {
-            if (error || stderr) {
-                resolve(undefined);
-            } else {
-                resolve(stdout.trim());
-            }
-        });
-    });
-}
\ No newline at end of file
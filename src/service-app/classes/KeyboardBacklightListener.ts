@@ -24,10 +24,13 @@ import { DaemonListener } from "./DaemonListener";
 import { TuxedoControlCenterDaemon } from './TuxedoControlCenterDaemon';
 import { KeyboardBacklightColorModes, KeyboardBacklightCapabilitiesInterface, KeyboardBacklightStateInterface } from '../../common/models/TccSettings';
 import { fileOK, fileOKAsync, getDirectories, getSymbolicLinks } from '../../common/classes/Utils';
+import { TuxedoIOAPI as ioAPI } from '../../native-lib/TuxedoIOAPI';
 
 export class KeyboardBacklightListener extends DaemonListener {
     protected ledsWhiteOnly: string = "/sys/devices/platform/tuxedo_keyboard/leds/white:kbd_backlight";
     protected ledsWhiteOnlyNB05: string = "/sys/bus/platform/devices/tuxedo_nb05_kbd_backlight/leds/white:kbd_backlight";
+    // Detected white only LED, undefined on RGB keyboards
+    protected ledsWhitePath: string;
     protected ledsRGBZones: Array<string> = ["/sys/devices/platform/tuxedo_keyboard/leds/rgb:kbd_backlight",
                                              "/sys/devices/platform/tuxedo_keyboard/leds/rgb:kbd_backlight_1",
                                              "/sys/devices/platform/tuxedo_keyboard/leds/rgb:kbd_backlight_2"];
@@ -35,6 +38,17 @@ export class KeyboardBacklightListener extends DaemonListener {
     protected sysDBusUPowerProps: dbus.ClientInterface = {} as dbus.ClientInterface;
     protected sysDBusUPowerKbdBacklightInterface: dbus.ClientInterface = {} as dbus.ClientInterface;
     protected onStartRetryCount: number = 5;
+    // Handles of the attributes watched through tccd.sysFsWatcher
+    protected sysFsWatches: Array<number> = [];
+    // multi_intensity of the zones, fs.watch handles for zones the sysfs
+    // watcher can not watch
+    protected multiIntensityWatches: Array<number> = [];
+    protected multiIntensityFsWatchers: Array<fs.FSWatcher> = [];
+    // Native frame engine used for per-key keyboards
+    protected ledFrameEngineActive: boolean = false;
+    protected ledFrameEngineAnimating: boolean = false;
+    protected static readonly LED_ENGINE_FRAMES_PER_SECOND = 30;
+    protected static readonly LED_ENGINE_BREATHE_PERIOD_MS = 4000;
 
     constructor(tccd: TuxedoControlCenterDaemon) {
         super(tccd);
@@ -70,6 +84,7 @@ export class KeyboardBacklightListener extends DaemonListener {
                 this.tccd.config.writeSettingsAsync(this.tccd.settings);
             }
 
+            this.initLedFrameEngine();
             await this.initUPower();
             await this.initSysFSListener();
             this.tccd.dbusData.keyboardBacklightStatesNewJSON.subscribe(
@@ -111,26 +126,149 @@ export class KeyboardBacklightListener extends DaemonListener {
     }
 
     private async initSysFSListener() {
-        if (this.keyboardBacklightCapabilities.maxRed != undefined) {
-            for (let i: number = 0; i < this.ledsRGBZones.length ; ++i) {
-                if (await fileOKAsync(this.ledsRGBZones[i] + "/multi_intensity")) {
-                    (function(i: number): void {
-                        fs.watch(this.ledsRGBZones[i] + "/multi_intensity", (async function(): Promise<void> {
-                            if (!(await this.sysDBusUPowerProps.Get('org.freedesktop.UPower', 'LidIsClosed')).value) {
-                                let keyboardBacklightStatesNew: KeyboardBacklightStateInterface = this.tccd.settings.keyboardBacklightStates;
-                                let colors = (await fs.promises.readFile(this.ledsRGBZones[i] + "/multi_intensity")).toString().split(' ').map(Number);
-                                keyboardBacklightStatesNew[i].red = colors[0];
-                                keyboardBacklightStatesNew[i].green = colors[1];
-                                keyboardBacklightStatesNew[i].blue = colors[2];
-                                this.setKeyboardBacklightStates(keyboardBacklightStatesNew, false, true, true);
-                            }
-                        }).bind(this));
-                    }).bind(this)(i);
-                }
+        this.unwatchSysFS();
+
+        // Fn-key brightness changes are signalled by the kernel with sysfs_notify, which fs.watch does not see
+        let brightnessLedPath = this.keyboardBacklightCapabilities.maxRed != undefined ? this.ledsRGBZones[0] : this.ledsWhitePath;
+        if (brightnessLedPath !== undefined && await fileOKAsync(brightnessLedPath + "/brightness_hw_changed")) {
+            this.addSysFsWatch(this.tccd.sysFsWatcher.watch(brightnessLedPath + "/brightness_hw_changed",
+                                                            this.brightnessHwChangedHandler.bind(this)));
+        }
+
+        // Animation frames are not user input, watched again when it stops
+        if (!this.ledFrameEngineAnimating) {
+            this.watchMultiIntensity();
+        }
+    }
+
+    /**
+     * Color changes are taken from the sysfs watcher, fs.watch is only used
+     * for zones it can not watch
+     */
+    private watchMultiIntensity(): void {
+        if (this.keyboardBacklightCapabilities.maxRed == undefined) {
+            return;
+        }
+        for (let i: number = 0; i < this.ledsRGBZones.length ; ++i) {
+            const multiIntensityPath = this.ledsRGBZones[i] + "/multi_intensity";
+            if (!fileOK(multiIntensityPath)) {
+                continue;
+            }
+            const id = this.tccd.sysFsWatcher.watch(multiIntensityPath, (colors: string): void => {
+                this.multiIntensityChangedHandler(i, colors);
+            });
+            if (id !== undefined) {
+                this.multiIntensityWatches.push(id);
+                continue;
+            }
+            try {
+                this.multiIntensityFsWatchers.push(fs.watch(multiIntensityPath, async (): Promise<void> => {
+                    if (this.ledFrameEngineAnimating) {
+                        return;
+                    }
+                    let colors = (await fs.promises.readFile(multiIntensityPath)).toString();
+                    this.multiIntensityChangedHandler(i, colors);
+                }));
+            } catch (err) {
+                console.log('KeyboardBacklightListener: Failed to watch ' + multiIntensityPath + ' => ' + err);
             }
         }
     }
 
+    private unwatchMultiIntensity(): void {
+        for (const id of this.multiIntensityWatches) {
+            this.tccd.sysFsWatcher.unwatch(id);
+        }
+        this.multiIntensityWatches = [];
+        for (const watcher of this.multiIntensityFsWatchers) {
+            watcher.close();
+        }
+        this.multiIntensityFsWatchers = [];
+    }
+
+    private addSysFsWatch(id: number): void {
+        // Undefined for attributes without sysfs_notify support
+        if (id !== undefined) {
+            this.sysFsWatches.push(id);
+        }
+    }
+
+    private unwatchSysFS(): void {
+        for (const id of this.sysFsWatches) {
+            this.tccd.sysFsWatcher.unwatch(id);
+        }
+        this.sysFsWatches = [];
+        this.unwatchMultiIntensity();
+    }
+
+    private async brightnessHwChangedHandler(value: string): Promise<void> {
+        // Empty until the first change
+        let brightness: number = parseInt(value);
+        if (Number.isNaN(brightness) || this.tccd.settings.keyboardBacklightStates.length === 0
+            || this.tccd.settings.keyboardBacklightStates[0].brightness === brightness) {
+            return;
+        }
+        if (!(await this.sysDBusUPowerProps.Get('org.freedesktop.UPower', 'LidIsClosed')).value) {
+            let keyboardBacklightStatesNew: Array<KeyboardBacklightStateInterface> = this.tccd.settings.keyboardBacklightStates;
+            for (let i in keyboardBacklightStatesNew) {
+                keyboardBacklightStatesNew[i].brightness = brightness;
+            }
+            this.setKeyboardBacklightStates(keyboardBacklightStatesNew, false, true, true);
+        }
+    }
+
+    private async multiIntensityChangedHandler(zone: number, value: string): Promise<void> {
+        // Animation frames are not user input
+        if (this.ledFrameEngineAnimating) {
+            return;
+        }
+        if (!(await this.sysDBusUPowerProps.Get('org.freedesktop.UPower', 'LidIsClosed')).value) {
+            let keyboardBacklightStatesNew: Array<KeyboardBacklightStateInterface> = this.tccd.settings.keyboardBacklightStates;
+            let colors = value.trim().split(' ').map(Number);
+            keyboardBacklightStatesNew[zone].red = colors[0];
+            keyboardBacklightStatesNew[zone].green = colors[1];
+            keyboardBacklightStatesNew[zone].blue = colors[2];
+            this.setKeyboardBacklightStates(keyboardBacklightStatesNew, false, true, true);
+        }
+    }
+
+
+
+    private initLedFrameEngine(): void {
+        if (this.keyboardBacklightCapabilities.maxRed !== undefined && this.ledsRGBZones.length > 3) {
+            try {
+                this.ledFrameEngineActive = ioAPI.ledEngineStart(this.ledsRGBZones,
+                    KeyboardBacklightListener.LED_ENGINE_FRAMES_PER_SECOND);
+            } catch (err) {
+                console.log('KeyboardBacklightListener: Failed to start LED frame engine => ' + err);
+                this.ledFrameEngineActive = false;
+            }
+        }
+    }
+
+    private setLedFrame(keyboardBacklightStatesNew: Array<KeyboardBacklightStateInterface>): void {
+        const colors: number[] = [];
+        for (let i: number = 0; i < this.ledsRGBZones.length && i < keyboardBacklightStatesNew.length; ++i) {
+            colors.push(keyboardBacklightStatesNew[i].red, keyboardBacklightStatesNew[i].green, keyboardBacklightStatesNew[i].blue);
+        }
+        const animating = keyboardBacklightStatesNew.length > 0
+            && keyboardBacklightStatesNew[0].mode === KeyboardBacklightColorModes.breathing;
+        if (animating !== this.ledFrameEngineAnimating) {
+            this.ledFrameEngineAnimating = animating;
+            // The engine writes every changed key per frame, reading them
+            // back would only see its own writes
+            if (animating) {
+                this.unwatchMultiIntensity();
+            } else {
+                this.watchMultiIntensity();
+            }
+        }
+        // UPower only sets the brightness of the led it picked, the engine sets it on every key
+        ioAPI.ledEngineSetFrame(colors, keyboardBacklightStatesNew.length > 0 ? keyboardBacklightStatesNew[0].brightness : undefined);
+        ioAPI.ledEngineSetAnimation(this.ledFrameEngineAnimating ? 'breathe' : 'none',
+            KeyboardBacklightListener.LED_ENGINE_BREATHE_PERIOD_MS);
+    }
+
 
 
     // Input from TCC
@@ -162,16 +300,16 @@ export class KeyboardBacklightListener extends DaemonListener {
 
         this.keyboardBacklightCapabilities.modes = [KeyboardBacklightColorModes.static];
 
-        let ledsWhitePath;
+        this.ledsWhitePath = undefined;
         if (fileOK(this.ledsWhiteOnly + "/max_brightness")) {
-            ledsWhitePath = this.ledsWhiteOnly;
+            this.ledsWhitePath = this.ledsWhiteOnly;
         } else if (fileOK(this.ledsWhiteOnlyNB05 + "/max_brightness")) {
-            ledsWhitePath = this.ledsWhiteOnlyNB05;
+            this.ledsWhitePath = this.ledsWhiteOnlyNB05;
         }
 
-        if (ledsWhitePath) {
+        if (this.ledsWhitePath) {
             console.log("Detected white only keyboard backlight");
-            this.keyboardBacklightCapabilities.maxBrightness = Number(fs.readFileSync(ledsWhitePath + "/max_brightness"));
+            this.keyboardBacklightCapabilities.maxBrightness = Number(fs.readFileSync(this.ledsWhitePath + "/max_brightness"));
             this.keyboardBacklightCapabilities.zones = 1;
         }
         else {
@@ -302,19 +440,24 @@ export class KeyboardBacklightListener extends DaemonListener {
                 }
             }
 
-            if (this.ledsRGBZones.length > 0) {
-                this.setBufferInput(this.ledsRGBZones[0], true)
-            }
-            for (let i: number = 0; i < this.ledsRGBZones.length ; ++i) {
-                if (await fileOKAsync(this.ledsRGBZones[i] + "/multi_intensity")) {
-                    await fs.promises.appendFile(this.ledsRGBZones[i] + "/multi_intensity",
-                                                    keyboardBacklightStatesNew[i].red.toString() + " " + 
-                                                    keyboardBacklightStatesNew[i].green.toString() + " " + 
-                                                    keyboardBacklightStatesNew[i].blue.toString());
+            if (this.ledFrameEngineActive) {
+                // Diffing, buffer_input and pacing are handled by the engine
+                this.setLedFrame(keyboardBacklightStatesNew);
+            } else {
+                if (this.ledsRGBZones.length > 0) {
+                    this.setBufferInput(this.ledsRGBZones[0], true)
+                }
+                for (let i: number = 0; i < this.ledsRGBZones.length ; ++i) {
+                    if (await fileOKAsync(this.ledsRGBZones[i] + "/multi_intensity")) {
+                        await fs.promises.appendFile(this.ledsRGBZones[i] + "/multi_intensity",
+                                                        keyboardBacklightStatesNew[i].red.toString() + " " + 
+                                                        keyboardBacklightStatesNew[i].green.toString() + " " + 
+                                                        keyboardBacklightStatesNew[i].blue.toString());
+                    }
+                }
+                if (this.ledsRGBZones.length > 0) {
+                    this.setBufferInput(this.ledsRGBZones[0], false);
                 }
-            }
-            if (this.ledsRGBZones.length > 0) {
-                this.setBufferInput(this.ledsRGBZones[0], false);
             }
         }
 
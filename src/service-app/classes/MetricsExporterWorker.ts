@@ -0,0 +1,199 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import { DaemonWorker } from './DaemonWorker';
+import { TuxedoControlCenterDaemon } from './TuxedoControlCenterDaemon';
+
+import { TuxedoIOAPI as ioAPI, TDPInfo } from '../../native-lib/TuxedoIOAPI';
+import { ICpuPower } from '../../common/models/TccPowerSettings';
+import { IdGpuInfo, IiGpuInfo } from '../../common/models/TccGpuValues';
+
+/**
+ * Exports the values the other workers already collected as OpenMetrics
+ * gauges on a unix socket (tccd --metrics-socket <path>).
+ *
+ * Values are copied into native slots on every work cycle, scrapes are
+ * answered natively from the slots and never cause hardware reads. Values
+ * that are not known (e.g. CPU/GPU power while sensor data collection is off)
+ * are left out of the scrape.
+ */
+export class MetricsExporterWorker extends DaemonWorker {
+
+    // Charge thresholds are read from sysfs, refresh them every n cycles only
+    private static readonly CHARGE_THRESHOLD_CYCLES = 12;
+
+    private exporterStarted = false;
+    private slots = new Map<string, number>();
+    private odmProfileSlots = new Map<string, number>();
+    private tccProfileSlot: number;
+    private workCycles = 0;
+
+    constructor(tccd: TuxedoControlCenterDaemon, private socketPath: string) {
+        super(5000, tccd);
+    }
+
+    public onStart(): void {
+        if (!this.exporterStarted) {
+            this.exporterStarted = ioAPI.metricsExporterStart(this.socketPath);
+            if (this.exporterStarted) {
+                this.tccd.logLine('MetricsExporterWorker: Serving metrics on ' + this.socketPath);
+            } else {
+                this.tccd.logLine('MetricsExporterWorker: Failed to listen on ' + this.socketPath);
+            }
+        }
+        this.workCycles = 0;
+        this.onWork();
+    }
+
+    public onWork(): void {
+        if (!this.exporterStarted) {
+            return;
+        }
+        this.updateFans();
+        this.updatePowerLimits();
+        this.updateProfiles();
+        this.updatePowerDraw();
+        if (this.workCycles % MetricsExporterWorker.CHARGE_THRESHOLD_CYCLES === 0) {
+            this.updateChargeThresholds();
+        }
+        this.workCycles++;
+    }
+
+    public onExit(): void {
+        if (this.exporterStarted) {
+            ioAPI.metricsExporterStop();
+            this.exporterStarted = false;
+        }
+    }
+
+    /**
+     * Sets a gauge, registering it on first use
+     *
+     * @param value Value, undefined or negative (unavailable) leaves it out
+     */
+    private set(name: string, help: string, value: number, labels?: { [label: string]: string }): number {
+        const key = name + JSON.stringify(labels !== undefined ? labels : {});
+        let slot = this.slots.get(key);
+        if (slot === undefined) {
+            slot = ioAPI.metricsRegisterGauge(name, help, labels);
+            this.slots.set(key, slot);
+        }
+        if (slot >= 0) {
+            ioAPI.metricsSet(slot, typeof value === 'number' && value >= 0 ? value : undefined);
+        }
+        return slot;
+    }
+
+    private updateFans(): void {
+        const fans = this.tccd.dbusData.fans;
+        for (let i = 0; i < fans.length; ++i) {
+            const labels = { fan: i.toString() };
+            // Timestamp 0 means not read yet
+            const valid = fans[i].temp.timestamp.value !== 0;
+            this.set('tccd_fan_temperature_celsius', 'Temperature of the sensor assigned to the fan',
+                valid ? fans[i].temp.data.value : undefined, labels);
+            this.set('tccd_fan_speed_percent', 'Fan speed',
+                valid ? fans[i].speed.data.value : undefined, labels);
+        }
+    }
+
+    private updatePowerLimits(): void {
+        const tdpInfo: TDPInfo[] = this.parse(this.tccd.dbusData.odmPowerLimitsJSON);
+        if (!Array.isArray(tdpInfo)) {
+            return;
+        }
+        for (let i = 0; i < tdpInfo.length; ++i) {
+            const labels = { index: i.toString(), descriptor: tdpInfo[i].descriptor };
+            this.set('tccd_tdp_watts', 'Current ODM power limit', tdpInfo[i].current, labels);
+            this.set('tccd_tdp_max_watts', 'Maximum ODM power limit', tdpInfo[i].max, labels);
+        }
+    }
+
+    private updateProfiles(): void {
+        const profile = this.tccd.getCurrentProfile();
+        if (profile !== undefined) {
+            // Info style gauge, the previous profile is dropped from the scrape
+            const slot = ioAPI.metricsRegisterGauge('tccd_profile_info', 'Active TCC profile',
+                { id: profile.id, name: profile.name });
+            if (slot !== this.tccProfileSlot) {
+                if (this.tccProfileSlot !== undefined) {
+                    ioAPI.metricsSet(this.tccProfileSlot, undefined);
+                }
+                this.tccProfileSlot = slot;
+            }
+            ioAPI.metricsSet(slot, 1);
+        }
+
+        const available = this.tccd.dbusData.odmProfilesAvailable;
+        if (Array.isArray(available)) {
+            for (const name of available) {
+                if (!this.odmProfileSlots.has(name)) {
+                    this.odmProfileSlots.set(name, ioAPI.metricsRegisterGauge('tccd_odm_profile',
+                        'Applied ODM performance profile (1) among the available ones (0)', { profile: name }));
+                }
+            }
+        }
+        const applied = this.tccd.dbusData.odmProfileApplied;
+        for (const [name, slot] of this.odmProfileSlots) {
+            ioAPI.metricsSet(slot, applied !== undefined ? (name === applied ? 1 : 0) : undefined);
+        }
+    }
+
+    private updatePowerDraw(): void {
+        const cpuPower: ICpuPower = this.parse(this.tccd.dbusData.cpuPowerValuesJSON);
+        this.set('tccd_cpu_power_watts', 'CPU package power draw', cpuPower?.powerDraw);
+        this.set('tccd_cpu_power_limit_watts', 'Highest CPU power limit', cpuPower?.maxPowerLimit);
+
+        const iGpu: IiGpuInfo = this.parse(this.tccd.dbusData.iGpuInfoValuesJSON);
+        this.set('tccd_gpu_power_watts', 'GPU power draw', iGpu?.powerDraw, { gpu: 'integrated' });
+        this.set('tccd_gpu_temperature_celsius', 'GPU temperature', iGpu?.temp, { gpu: 'integrated' });
+        this.set('tccd_gpu_frequency_mhz', 'GPU core frequency', iGpu?.coreFrequency, { gpu: 'integrated' });
+
+        const dGpu: IdGpuInfo = this.parse(this.tccd.dbusData.dGpuInfoValuesJSON);
+        this.set('tccd_gpu_power_watts', 'GPU power draw', dGpu?.powerDraw, { gpu: 'discrete' });
+        this.set('tccd_gpu_frequency_mhz', 'GPU core frequency', dGpu?.coreFrequency, { gpu: 'discrete' });
+    }
+
+    private async updateChargeThresholds(): Promise<void> {
+        const chargingWorker = this.tccd.getChargingWorker();
+        if (chargingWorker === undefined) {
+            return;
+        }
+        try {
+            const [start, end] = await Promise.all([
+                chargingWorker.getChargeStartThreshold(),
+                chargingWorker.getChargeEndThreshold()
+            ]);
+            this.set('tccd_charge_start_threshold_percent', 'Battery charge start threshold', start);
+            this.set('tccd_charge_end_threshold_percent', 'Battery charge end threshold', end);
+        } catch (err) {
+            this.tccd.logLine('MetricsExporterWorker: Failed reading charge thresholds => ' + err);
+        }
+    }
+
+    private parse(json: string): any {
+        if (json === undefined) {
+            return undefined;
+        }
+        try {
+            return JSON.parse(json);
+        } catch (err) {
+            return undefined;
+        }
+    }
+}
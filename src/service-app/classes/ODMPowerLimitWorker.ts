@@ -19,10 +19,12 @@
 import { DaemonWorker } from './DaemonWorker';
 import { TuxedoControlCenterDaemon } from './TuxedoControlCenterDaemon';
 
-import { TuxedoIOAPI as ioAPI, TDPInfo} from '../../native-lib/TuxedoIOAPI';
+import { TuxedoIOAPI as ioAPI, TDPInfo, TDPAutotunerDecision } from '../../native-lib/TuxedoIOAPI';
 
 export class ODMPowerLimitWorker extends DaemonWorker {
 
+    private tdpInfo: TDPInfo[] = [];
+
     constructor(tccd: TuxedoControlCenterDaemon) {
         super(5000, tccd);
     }
@@ -33,8 +35,19 @@ export class ODMPowerLimitWorker extends DaemonWorker {
             odmPowerLimitSettings = { tdpValues: [] }
         }
 
-        let tdpInfo: TDPInfo[] = [];
-        if (ioAPI.getTDPInfo(tdpInfo) && tdpInfo.length > 0) {
+        // Start over from the profile values on every profile (re)apply
+        ioAPI.tdpAutotunerReset();
+        this.tccd.dbusData.tdpAutotunerDecisionsJSON = JSON.stringify([]);
+
+        // Limits are probed once per hardware and module version
+        let tdpInfo: TDPInfo[] = this.tccd.capabilityCache.getTDPLimits();
+        if (tdpInfo === undefined) {
+            tdpInfo = [];
+            if (!ioAPI.getTDPInfo(tdpInfo)) {
+                tdpInfo = [];
+            }
+        }
+        if (tdpInfo.length > 0) {
             let newTDPValues: number[] = [];
             // If set in profile use these
             if (odmPowerLimitSettings.tdpValues && odmPowerLimitSettings.tdpValues.length > 0) {
@@ -55,14 +68,43 @@ export class ODMPowerLimitWorker extends DaemonWorker {
                 }
             } else {
                 this.tccd.logLine('ODMPowerLimitWorker: Failed to write TDP values');
+                // Report what the hardware has instead
+                const currentTDPInfo: TDPInfo[] = [];
+                if (ioAPI.getTDPInfo(currentTDPInfo)) {
+                    tdpInfo = currentTDPInfo;
+                }
             }
             
         }
+        this.tdpInfo = tdpInfo;
         this.tccd.dbusData.odmPowerLimitsJSON = JSON.stringify(tdpInfo);
     }
 
     public onWork(): void {
+        const autotune = this.activeProfile.odmPowerLimits?.autotune;
+        if (autotune === undefined || !autotune.enabled || this.tdpInfo.length === 0) {
+            return;
+        }
 
+        const decision: TDPAutotunerDecision = ioAPI.tdpAutotunerStep({
+            targetTemperature: autotune.targetTemperature,
+            maxFanSpeedPercent: autotune.maxFanSpeed,
+            temperatureHysteresis: autotune.temperatureHysteresis,
+            stepWatts: autotune.stepWatts
+        });
+        if (decision === undefined) {
+            return;
+        }
+        if (decision.action !== 'hold') {
+            this.tccd.logLine('ODMPowerLimitWorker: Autotune ' + decision.action + ' ('
+                + decision.reason + ', ' + decision.temperature + ' °C) => '
+                + JSON.stringify(decision.tdpValues.map(tdpValue => tdpValue + ' W')));
+        }
+        for (let i = 0; i < this.tdpInfo.length && i < decision.tdpValues.length; ++i) {
+            this.tdpInfo[i].current = decision.tdpValues[i];
+        }
+        this.tccd.dbusData.odmPowerLimitsJSON = JSON.stringify(this.tdpInfo);
+        this.tccd.dbusData.tdpAutotunerDecisionsJSON = JSON.stringify(ioAPI.tdpAutotunerGetDecisions());
     }
 
     public onExit(): void {
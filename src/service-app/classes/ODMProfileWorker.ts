@@ -19,7 +19,9 @@
 import { DaemonWorker } from "./DaemonWorker";
 import { TuxedoControlCenterDaemon } from "./TuxedoControlCenterDaemon";
 
-import { TuxedoIOAPI as ioAPI, ObjWrapper } from "../../native-lib/TuxedoIOAPI";
+import { TuxedoIOAPI as ioAPI, ObjWrapper, LoadMonitorState } from "../../native-lib/TuxedoIOAPI";
+import * as fs from "fs";
+import * as path from "path";
 
 import {
     SysFsPropertyString,
@@ -42,6 +44,13 @@ export class ODMProfileWorker extends DaemonWorker {
         "/sys/firmware/acpi/platform_profile_choices"
     );
 
+    private static drmClassPath = "/sys/class/drm";
+
+    // Profiles ordered from lowest to highest performance as reported
+    private availableProfiles: string[] = [];
+    private applyProfile: (profileName: string) => boolean = () => false;
+    private appliedProfileName: string;
+
     constructor(tccd: TuxedoControlCenterDaemon) {
         super(10000, tccd);
     }
@@ -63,9 +72,42 @@ export class ODMProfileWorker extends DaemonWorker {
         } else {
             this.fallbackODM();
         }
+
+        this.startAutoSwitching();
+        this.reportProfiles();
     }
 
-    public onWork(): void {}
+    public onWork(): void {
+        if (this.activeProfile.odmProfile?.auto?.enabled !== true) {
+            return;
+        }
+        const loadState: LoadMonitorState = ioAPI.loadMonitorGetState();
+        if (loadState === undefined) {
+            return;
+        }
+
+        let profileName: string;
+        if (loadState.phase === "idle") {
+            profileName = this.availableProfiles[0];
+        } else if (loadState.phase === "heavy") {
+            profileName = this.availableProfiles[this.availableProfiles.length - 1];
+        } else {
+            profileName = this.getODMProfileName();
+        }
+
+        if (profileName !== this.appliedProfileName && this.availableProfiles.includes(profileName)) {
+            this.tccd.logLine(
+                "ODMProfileWorker: Load " + loadState.phase + " (" + loadState.meanLoad.toFixed(0) +
+                " %, busiest core " + loadState.meanCoreLoad.toFixed(0) + " %), set ODM profile '" + profileName + "'"
+            );
+            if (this.applyProfile(profileName)) {
+                this.appliedProfileName = profileName;
+                this.reportProfiles();
+            } else {
+                this.tccd.logLine("ODMProfileWorker: Failed to apply profile");
+            }
+        }
+    }
 
     public onExit(): void {}
 
@@ -75,17 +117,35 @@ export class ODMProfileWorker extends DaemonWorker {
     ): void {
         const availableProfiles = platformProfileChoices.readValueNT();
         this.tccd.dbusData.odmProfilesAvailable = availableProfiles;
+        this.availableProfiles = availableProfiles !== undefined ? availableProfiles : [];
+        this.applyProfile = (profileName: string) => {
+            try {
+                platformProfile.writeValue(profileName);
+                return true;
+            } catch (err) {
+                this.tccd.logLine("ODMProfileWorker: Failed to write platform_profile => " + err);
+                return false;
+            }
+        };
 
         let chosenODMProfileName = this.getODMProfileName();
-        if (availableProfiles.includes(chosenODMProfileName)) {
+        if (this.availableProfiles.includes(chosenODMProfileName)) {
             platformProfile.writeValue(chosenODMProfileName);
+            this.appliedProfileName = chosenODMProfileName;
         }
     }
 
     private fallbackODM(): void {
+        // Probed once per hardware and module version
+        const cachedProfiles = this.tccd.capabilityCache.getODMProfiles();
         const availableProfiles: ObjWrapper<string[]> = { value: [] };
-        const odmProfilesAvailable =
-            ioAPI.getAvailableODMPerformanceProfiles(availableProfiles);
+        let odmProfilesAvailable: boolean;
+        if (cachedProfiles !== undefined) {
+            availableProfiles.value = cachedProfiles.available;
+            odmProfilesAvailable = cachedProfiles.available.length > 0;
+        } else {
+            odmProfilesAvailable = ioAPI.getAvailableODMPerformanceProfiles(availableProfiles);
+        }
         if (odmProfilesAvailable) {
             let chosenODMProfileName = this.getODMProfileName();
 
@@ -93,7 +153,11 @@ export class ODMProfileWorker extends DaemonWorker {
             // attempt to get the default profile name
             if (!availableProfiles.value.includes(chosenODMProfileName)) {
                 const defaultProfileName: ObjWrapper<string> = { value: "" };
-                ioAPI.getDefaultODMPerformanceProfile(defaultProfileName);
+                if (cachedProfiles !== undefined) {
+                    defaultProfileName.value = cachedProfiles.defaultProfile;
+                } else {
+                    ioAPI.getDefaultODMPerformanceProfile(defaultProfileName);
+                }
                 chosenODMProfileName = defaultProfileName.value;
             }
 
@@ -102,7 +166,9 @@ export class ODMProfileWorker extends DaemonWorker {
                 this.tccd.logLine(
                     "Set ODM profile '" + chosenODMProfileName + "' "
                 );
-                if (!ioAPI.setODMPerformanceProfile(chosenODMProfileName)) {
+                if (ioAPI.setODMPerformanceProfile(chosenODMProfileName)) {
+                    this.appliedProfileName = chosenODMProfileName;
+                } else {
                     this.tccd.logLine(
                         "ODMProfileWorker: Failed to apply profile"
                     );
@@ -117,6 +183,48 @@ export class ODMProfileWorker extends DaemonWorker {
         }
 
         this.tccd.dbusData.odmProfilesAvailable = availableProfiles.value;
+        this.availableProfiles = availableProfiles.value;
+        this.applyProfile = (profileName: string) => ioAPI.setODMPerformanceProfile(profileName);
+    }
+
+    /**
+     * Profiles recorded with throttle episodes and exported as metrics
+     */
+    private reportProfiles(): void {
+        this.tccd.dbusData.odmProfileApplied = this.appliedProfileName;
+        ioAPI.throttleMonitorSetProfiles(
+            this.activeProfile.name !== undefined ? this.activeProfile.name : "",
+            this.appliedProfileName !== undefined ? this.appliedProfileName : ""
+        );
+    }
+
+    private startAutoSwitching(): void {
+        const autoSettings = this.activeProfile.odmProfile?.auto;
+        if (autoSettings === undefined || !autoSettings.enabled || this.availableProfiles.length < 2) {
+            ioAPI.loadMonitorStop();
+            return;
+        }
+        ioAPI.loadMonitorStart({
+            heavyDwellMs: autoSettings.heavyDwellMs,
+            idleDwellMs: autoSettings.idleDwellMs,
+            hysteresis: autoSettings.hysteresis,
+            gpuBusyPath: ODMProfileWorker.findGpuBusyPath()
+        });
+    }
+
+    /**
+     * gpu_busy_percent of the first drm card offering it (amdgpu)
+     */
+    private static findGpuBusyPath(): string {
+        try {
+            for (const entry of fs.readdirSync(this.drmClassPath)) {
+                const gpuBusyPath = path.join(this.drmClassPath, entry, "device/gpu_busy_percent");
+                if (/^card\d+$/.test(entry) && fs.existsSync(gpuBusyPath)) {
+                    return gpuBusyPath;
+                }
+            }
+        } catch (err) {}
+        return undefined;
     }
 
     private getODMProfileName(): string {
@@ -137,7 +245,13 @@ export class ODMProfileWorker extends DaemonWorker {
         return quirkNoPlatformProfile;
     }
 
-    public static getDefaultODMPerformanceProfile(dev: TUXEDODevice): string {
+    /**
+     * @param cachedProfiles Used instead of asking tuxedo_io if given
+     */
+    public static getDefaultODMPerformanceProfile(
+        dev: TUXEDODevice,
+        cachedProfiles?: { available: string[], defaultProfile: string }
+    ): string {
         if (
             this.tuxedoPlatformProfile.isAvailable() &&
             this.tuxedoPlatformProfileChoices.isAvailable()
@@ -155,6 +269,8 @@ export class ODMProfileWorker extends DaemonWorker {
             if (availableProfiles !== undefined && availableProfiles.length > 0) {
                 return availableProfiles[availableProfiles.length-1];
             }
+        } else if (cachedProfiles !== undefined) {
+            return cachedProfiles.defaultProfile;
         } else {
             const defaultODMProfileName: ObjWrapper<string> = { value: '' };
             ioAPI.getDefaultODMPerformanceProfile(defaultODMProfileName);
@@ -163,7 +279,13 @@ export class ODMProfileWorker extends DaemonWorker {
         return '';
     }
 
-    public static getAvailableODMPerformanceProfiles(dev: TUXEDODevice): string[] {
+    /**
+     * @param cachedProfiles Used instead of asking tuxedo_io if given
+     */
+    public static getAvailableODMPerformanceProfiles(
+        dev: TUXEDODevice,
+        cachedProfiles?: { available: string[], defaultProfile: string }
+    ): string[] {
         if (
             this.tuxedoPlatformProfile.isAvailable() &&
             this.tuxedoPlatformProfileChoices.isAvailable()
@@ -181,6 +303,8 @@ export class ODMProfileWorker extends DaemonWorker {
             if (availableProfiles !== undefined) {
                 return availableProfiles;
             }
+        } else if (cachedProfiles !== undefined) {
+            return cachedProfiles.available;
         } else {
                 const availableODMProfiles: ObjWrapper<string[]> = { value: [] };
                 ioAPI.getAvailableODMPerformanceProfiles(availableODMProfiles);
@@ -0,0 +1,72 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import 'jasmine';
+import { IWorkerStartupReport } from './WorkerStartup';
+import { IProfileSwitchReport, ProfileSwitchHistory, createProfileSwitchReport } from './ProfileSwitchTrace';
+
+describe('ProfileSwitchTrace', () => {
+
+    const startup: IWorkerStartupReport = {
+        beginMs: 10030,
+        criticalDoneMs: 40,
+        allDoneMs: 120,
+        workers: [
+            { name: 'StateSwitcherWorker', critical: true, startMs: 0, durationMs: 5 },
+            { name: 'ODMPowerLimitWorker', critical: true, startMs: 5, durationMs: 35 },
+            { name: 'CpuWorker', critical: false, startMs: 40, durationMs: 80 }
+        ]
+    };
+
+    function reportWithDuration(fullyAppliedMs: number): IProfileSwitchReport {
+        return {
+            trigger: 'SetTempProfileById', profileId: 'a', requestMs: 0,
+            selectedMs: 0, criticalAppliedMs: 0, fullyAppliedMs, workers: []
+        };
+    }
+
+    it('should measure the worker start from the request', () => {
+        const report = createProfileSwitchReport({
+            trigger: 'SetTempProfileById',
+            profileId: 'quiet',
+            requestMs: 10000,
+            selectedMs: 10025
+        }, startup);
+
+        expect(report.selectedMs).toBe(25);
+        expect(report.criticalAppliedMs).toBe(70);
+        expect(report.fullyAppliedMs).toBe(150);
+        expect(report.workers.map(worker => worker.startMs)).toEqual([ 30, 35, 70 ]);
+        expect(startup.workers[2].startMs).toBe(40);
+    });
+
+    it('should keep the latest switches', () => {
+        const history = new ProfileSwitchHistory(3);
+        expect(history.getStats().fullyAppliedMsP50).toBeUndefined();
+
+        for (const duration of [ 900, 100, 300, 200 ]) {
+            history.add(reportWithDuration(duration));
+        }
+        const stats = history.getStats();
+
+        expect(stats.switches).toBe(4);
+        expect(stats.recent.map(report => report.fullyAppliedMs)).toEqual([ 100, 300, 200 ]);
+        expect(stats.fullyAppliedMsP50).toBe(200);
+        expect(stats.fullyAppliedMsMax).toBe(300);
+    });
+});
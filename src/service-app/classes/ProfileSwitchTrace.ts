@@ -0,0 +1,97 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import { IWorkerStartTrace, IWorkerStartupReport } from './WorkerStartup';
+
+/**
+ * Profile switch selected by the state switcher, passed on to the worker start
+ */
+export interface IProfileSwitchRequest {
+    // DBus method, 'state' for power state changes, 'reapply' on reload or
+    // 'check' for temp profiles found by the periodic check
+    trigger: string;
+    profileId: string;
+    // Monotonic clock of the request, for DBus requests the time of the call
+    requestMs: number;
+    // Monotonic clock when the state switcher selected the profile
+    selectedMs: number;
+}
+
+export interface IProfileSwitchReport {
+    trigger: string;
+    profileId: string;
+    requestMs: number;
+    // Relative to requestMs
+    selectedMs: number;
+    criticalAppliedMs: number;
+    fullyAppliedMs: number;
+    // Start times relative to requestMs
+    workers: IWorkerStartTrace[];
+}
+
+export interface IProfileSwitchStats {
+    switches: number;
+    fullyAppliedMsP50: number;
+    fullyAppliedMsMax: number;
+    recent: IProfileSwitchReport[];
+}
+
+/**
+ * Combines a switch request with the report of the worker start it caused
+ */
+export function createProfileSwitchReport(request: IProfileSwitchRequest, startup: IWorkerStartupReport): IProfileSwitchReport {
+    const startOffsetMs = startup.beginMs - request.requestMs;
+    return {
+        trigger: request.trigger,
+        profileId: request.profileId,
+        requestMs: request.requestMs,
+        selectedMs: request.selectedMs - request.requestMs,
+        criticalAppliedMs: startOffsetMs + startup.criticalDoneMs,
+        fullyAppliedMs: startOffsetMs + startup.allDoneMs,
+        workers: startup.workers.map(worker => ({ ...worker, startMs: startOffsetMs + worker.startMs }))
+    };
+}
+
+/**
+ * Keeps the latest profile switches for DBus and the log
+ */
+export class ProfileSwitchHistory {
+
+    private switches = 0;
+    private recent: IProfileSwitchReport[] = [];
+
+    constructor(private keep: number = 16) {}
+
+    public add(report: IProfileSwitchReport): void {
+        this.switches++;
+        this.recent.push(report);
+        if (this.recent.length > this.keep) {
+            this.recent.shift();
+        }
+    }
+
+    public getStats(): IProfileSwitchStats {
+        const sorted = this.recent.map(report => report.fullyAppliedMs).sort((a, b) => a - b);
+        return {
+            switches: this.switches,
+            fullyAppliedMsP50: sorted.length > 0 ? sorted[Math.ceil(sorted.length / 2) - 1] : undefined,
+            fullyAppliedMsMax: sorted.length > 0 ? sorted[sorted.length - 1] : undefined,
+            recent: this.recent
+        };
+    }
+}
@@ -20,6 +20,8 @@ import { DaemonWorker } from './DaemonWorker';
 import { TuxedoControlCenterDaemon } from './TuxedoControlCenterDaemon';
 import { ProfileStates } from '../../common/models/TccSettings';
 import { determineState } from '../../common/classes/StateUtils';
+import { monotonicMs } from './WorkerScheduler';
+import { IProfileSwitchRequest } from './ProfileSwitchTrace';
 
 export class StateSwitcherWorker extends DaemonWorker {
 
@@ -27,6 +29,7 @@ export class StateSwitcherWorker extends DaemonWorker {
     private currentStateProfileId: string;
 
     private refreshProfile = false;
+    private pendingRequest: { trigger: string, requestMs: number };
 
     constructor(tccd: TuxedoControlCenterDaemon) {
         super(2000, tccd);
@@ -37,11 +40,21 @@ export class StateSwitcherWorker extends DaemonWorker {
         this.currentState = undefined;
     }
 
+    /** Last determined power state, undefined before the first check */
+    public getCurrentState(): ProfileStates {
+        return this.currentState;
+    }
+
     /** Refresh profile application */
     public reapplyProfile() {
         this.refreshProfile = true;
     }
 
+    /** Time a request that may switch the profile, traced by the next check */
+    public requestProfileSwitch(trigger: string) {
+        this.pendingRequest = { trigger, requestMs: monotonicMs() };
+    }
+
     public onStart(): void {
         // Check state and switch profile if appropriate
         const newState = determineState();
@@ -63,14 +76,19 @@ export class StateSwitcherWorker extends DaemonWorker {
     }
 
     public onWork(): void {
+        const checkMs = monotonicMs();
+        const request = this.pendingRequest;
+        this.pendingRequest = undefined;
+
         // Check state and switch profile if appropriate
         const newState = determineState();
         const oldActiveProfileId = this.tccd.activeProfile.id;
         const oldActiveProfileName = this.tccd.activeProfile.name;
 
         const newStateProfileId = this.tccd.settings.stateMap[newState.toString()];
+        const stateChanged = newState !== this.currentState || newStateProfileId !== this.currentStateProfileId;
 
-        if (newState !== this.currentState || newStateProfileId !== this.currentStateProfileId) {
+        if (stateChanged) {
             /*
              * If state changed or assigned profile depending on state changed,
              * unset temp profile and set state selected profile
@@ -106,9 +124,21 @@ export class StateSwitcherWorker extends DaemonWorker {
         // Run worker start procedure / application of profile
         // if the profile changed
         if (oldActiveProfileId !== this.tccd.activeProfile.id || this.refreshProfile) {
+            const profileSwitch: IProfileSwitchRequest = {
+                trigger: stateChanged ? 'state' : 'check',
+                profileId: this.tccd.activeProfile.id,
+                requestMs: checkMs,
+                selectedMs: monotonicMs()
+            };
+            if (!stateChanged && request !== undefined) {
+                profileSwitch.trigger = request.trigger;
+                profileSwitch.requestMs = request.requestMs;
+            } else if (!stateChanged && this.refreshProfile) {
+                profileSwitch.trigger = 'reapply';
+            }
             this.refreshProfile = false;
             this.tccd.updateDBusActiveProfileData();
-            this.tccd.startWorkers();
+            this.tccd.startWorkers(profileSwitch);
         }
     }
 
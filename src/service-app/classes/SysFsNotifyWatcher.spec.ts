@@ -0,0 +1,109 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import 'jasmine';
+import { ITuxedoIOAPI, SysFsAttributeChange } from '../../native-lib/TuxedoIOAPI';
+import { SysFsNotifyWatcher } from './SysFsNotifyWatcher';
+
+describe('SysFsNotifyWatcher', () => {
+
+    let startResult: boolean;
+    let callback: (changes: SysFsAttributeChange[]) => void;
+    let watched: Map<number, string>;
+    let nextId: number;
+    let stopped: number;
+    let logLines: string[];
+
+    const api = {
+        sysFsWatcherStart: (cb: (changes: SysFsAttributeChange[]) => void) => { callback = cb; return startResult; },
+        sysFsWatcherAdd: (path: string) => {
+            if (!path.startsWith('/sys/')) {
+                return -1;
+            }
+            watched.set(nextId, path);
+            return nextId++;
+        },
+        sysFsWatcherRemove: (id: number) => watched.delete(id),
+        sysFsWatcherStop: () => { stopped++; watched.clear(); },
+        sysFsWatcherGetStats: () => undefined
+    } as any as ITuxedoIOAPI;
+
+    function notify(id: number, value: string) {
+        callback([ { id, path: watched.get(id), value } ]);
+    }
+
+    beforeEach(() => {
+        startResult = true;
+        callback = undefined;
+        watched = new Map<number, string>();
+        nextId = 0;
+        stopped = 0;
+        logLines = [];
+    });
+
+    it('should dispatch changes to the handler of the attribute', () => {
+        const watcher = new SysFsNotifyWatcher(api, line => logLines.push(line));
+        const keyboard: string[] = [];
+        const display: string[] = [];
+        const keyboardId = watcher.watch('/sys/class/leds/white:kbd_backlight/brightness_hw_changed', value => keyboard.push(value));
+        const displayId = watcher.watch('/sys/class/backlight/intel_backlight/actual_brightness', value => display.push(value));
+
+        notify(displayId, '120');
+        notify(keyboardId, '2');
+        notify(displayId, '96');
+
+        expect(keyboard).toEqual([ '2' ]);
+        expect(display).toEqual([ '120', '96' ]);
+    });
+
+    it('should stop the native watcher with the last attribute', () => {
+        const watcher = new SysFsNotifyWatcher(api, line => logLines.push(line));
+        const first = watcher.watch('/sys/a', () => {});
+        const second = watcher.watch('/sys/b', () => {});
+
+        watcher.unwatch(first);
+        expect(stopped).toBe(0);
+        watcher.unwatch(second);
+        watcher.unwatch(second);
+        expect(stopped).toBe(1);
+        expect(watcher.watch('/sys/c', () => {})).toBeDefined();
+    });
+
+    it('should leave unwatchable attributes to polling', () => {
+        const watcher = new SysFsNotifyWatcher(api, line => logLines.push(line));
+        expect(watcher.watch('/tmp/not-sysfs', () => {})).toBeUndefined();
+
+        startResult = false;
+        const unavailable = new SysFsNotifyWatcher(api, line => logLines.push(line));
+        expect(unavailable.watch('/sys/a', () => {})).toBeUndefined();
+        expect(unavailable.watch('/sys/b', () => {})).toBeUndefined();
+        expect(logLines.length).toBe(1);
+    });
+
+    it('should keep dispatching when a handler throws', () => {
+        const watcher = new SysFsNotifyWatcher(api, line => logLines.push(line));
+        const values: string[] = [];
+        const failing = watcher.watch('/sys/a', () => { throw new Error('broken'); });
+        const working = watcher.watch('/sys/b', value => values.push(value));
+
+        callback([ { id: failing, path: '/sys/a', value: '1' }, { id: working, path: '/sys/b', value: '2' } ]);
+
+        expect(values).toEqual([ '2' ]);
+        expect(logLines[0]).toContain('broken');
+    });
+});
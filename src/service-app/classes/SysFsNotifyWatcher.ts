@@ -0,0 +1,118 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import { ITuxedoIOAPI, SysFsAttributeChange, SysFsWatcherStats } from '../../native-lib/TuxedoIOAPI';
+
+export type SysFsChangeHandler = (value: string) => void;
+
+/**
+ * Shared watcher for sysfs attributes changed from the kernel side
+ *
+ * Drivers signal such changes (Fn-key brightness, hotkey backlight changes)
+ * with sysfs_notify, which fs.watch does not see. The native watcher is
+ * started with the first watched attribute and stopped with the last one.
+ * If an attribute can not be watched watch() returns undefined and the
+ * caller has to keep polling it.
+ */
+export class SysFsNotifyWatcher {
+
+    private handlers = new Map<number, SysFsChangeHandler>();
+    private started = false;
+    private unavailable = false;
+
+    constructor(private api: ITuxedoIOAPI, private logLine: (line: string) => void) {}
+
+    /**
+     * @param onChange Called on the event loop with the new content
+     * @returns Handle for unwatch(), undefined if not watchable
+     */
+    public watch(path: string, onChange: SysFsChangeHandler): number {
+        if (!this.start()) {
+            return undefined;
+        }
+        let id: number;
+        try {
+            id = this.api.sysFsWatcherAdd(path);
+        } catch (err) {
+            id = -1;
+        }
+        if (id < 0) {
+            if (this.handlers.size === 0) {
+                this.stop();
+            }
+            return undefined;
+        }
+        this.handlers.set(id, onChange);
+        return id;
+    }
+
+    public unwatch(id: number): void {
+        if (id === undefined || !this.handlers.delete(id)) {
+            return;
+        }
+        this.api.sysFsWatcherRemove(id);
+        if (this.handlers.size === 0) {
+            this.stop();
+        }
+    }
+
+    public stop(): void {
+        if (this.started) {
+            this.api.sysFsWatcherStop();
+            this.started = false;
+        }
+        this.handlers.clear();
+    }
+
+    /**
+     * @returns Statistics of the native watcher, undefined if not started
+     */
+    public getStats(): SysFsWatcherStats {
+        return this.started ? this.api.sysFsWatcherGetStats() : undefined;
+    }
+
+    private start(): boolean {
+        if (this.started || this.unavailable) {
+            return this.started;
+        }
+        try {
+            this.started = this.api.sysFsWatcherStart(changes => this.dispatch(changes));
+        } catch (err) {
+            this.started = false;
+        }
+        if (!this.started) {
+            this.unavailable = true;
+            this.logLine('SysFsNotifyWatcher: Native watcher unavailable, attributes stay polled');
+        }
+        return this.started;
+    }
+
+    private dispatch(changes: SysFsAttributeChange[]): void {
+        for (const change of changes) {
+            const handler = this.handlers.get(change.id);
+            if (handler === undefined) {
+                continue;
+            }
+            try {
+                handler(change.value);
+            } catch (err) {
+                this.logLine('SysFsNotifyWatcher: Failed handling change of ' + change.path + ' => ' + err);
+            }
+        }
+    }
+}
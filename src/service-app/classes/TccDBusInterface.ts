@@ -94,7 +94,17 @@ export class TccDBusData {
     public defaultValuesProfileJSON: string;
     public settingsJSON: string;
     public odmProfilesAvailable: string[];
+    // Applied profile, differs from the configured one while auto switching
+    public odmProfileApplied: string;
     public odmPowerLimitsJSON: string;
+    public tdpAutotunerDecisionsJSON: string;
+    public cpuReconcilerStatsJSON: string;
+    public schedulerStatsJSON: string;
+    public workerStartupJSON: string;
+    public profileSwitchStatsJSON: string;
+    public throttleStatsJSON: string;
+    // Read only memfd of the telemetry page, -1 if not created
+    public telemetryPageFd: number = -1;
     public keyboardBacklightCapabilitiesJSON: string;
     public keyboardBacklightStatesJSON: string;
     public keyboardBacklightStatesNewJSON: BehaviorSubject<string> = new BehaviorSubject<string>(undefined);
@@ -110,7 +120,10 @@ export class TccDBusData {
 }
 
 export class TccDBusOptions {
-    public triggerStateCheck?: () => Promise<void>;
+    /**
+     * @param trigger Method requesting a profile switch, for tracing
+     */
+    public triggerStateCheck?: (trigger?: string) => Promise<void>;
     public chargingWorker?: ChargingWorker;
 }
 
@@ -163,7 +176,13 @@ export class TccDBusInterface extends dbus.interface.Interface {
 
     GetCpuPowerValuesJSON() { return this.data.cpuPowerValuesJSON; }
     GetPrimeState() { return this.data.primeState; }
-    SetSensorDataCollectionStatus(status: boolean) {this.data.sensorDataCollectionStatus = status}
+    SetSensorDataCollectionStatus(status: boolean) {
+        // Clients reading the telemetry page renew the collection with this
+        if (status) {
+            this.resetDataCollectionTimeout();
+        }
+        this.data.sensorDataCollectionStatus = status;
+    }
     GetSensorDataCollectionStatus() {
         return this.data.sensorDataCollectionStatus;
     }
@@ -182,11 +201,12 @@ export class TccDBusInterface extends dbus.interface.Interface {
     GetActiveProfileJSON() { return this.data.activeProfileJSON; }
     SetTempProfile(profileName: string) {
         this.data.tempProfileName = profileName;
+        this.interfaceOptions.triggerStateCheck('SetTempProfile');
         return true;
     }
     SetTempProfileById(id: string) {
         this.data.tempProfileId = id;
-        this.interfaceOptions.triggerStateCheck();
+        this.interfaceOptions.triggerStateCheck('SetTempProfileById');
         return true;
     }
     GetProfilesJSON() { return this.data.profilesJSON; }
@@ -196,6 +216,18 @@ export class TccDBusInterface extends dbus.interface.Interface {
     GetSettingsJSON() { return this.data.settingsJSON; }
     ODMProfilesAvailable() { return this.data.odmProfilesAvailable; }
     ODMPowerLimitsJSON() { return this.data.odmPowerLimitsJSON; }
+    GetTDPAutotunerDecisionsJSON() { return this.data.tdpAutotunerDecisionsJSON; }
+    GetCpuReconcilerStatsJSON() { return this.data.cpuReconcilerStatsJSON; }
+    GetSchedulerStatsJSON() { return this.data.schedulerStatsJSON; }
+    GetWorkerStartupJSON() { return this.data.workerStartupJSON; }
+    GetProfileSwitchStatsJSON() { return this.data.profileSwitchStatsJSON; }
+    GetThrottleStatsJSON() { return this.data.throttleStatsJSON; }
+    GetTelemetryPageFd() {
+        if (this.data.telemetryPageFd < 0) {
+            throw new dbus.DBusError('com.tuxedocomputers.tccd.Error.Unavailable', 'Telemetry page not created');
+        }
+        return this.data.telemetryPageFd;
+    }
     GetKeyboardBacklightCapabilitiesJSON() { return this.data.keyboardBacklightCapabilitiesJSON; }
     GetKeyboardBacklightStatesJSON() { return this.data.keyboardBacklightStatesJSON; }
     SetKeyboardBacklightStatesJSON(keyboardBacklightStatesJSON: string) {
@@ -305,6 +337,13 @@ TccDBusInterface.configureMembers({
         GetSettingsJSON: { outSignature: 's' },
         ODMProfilesAvailable: { outSignature: 'as' },
         ODMPowerLimitsJSON: { outSignature: 's' },
+        GetTDPAutotunerDecisionsJSON: { outSignature: 's' },
+        GetCpuReconcilerStatsJSON: { outSignature: 's' },
+        GetSchedulerStatsJSON: { outSignature: 's' },
+        GetWorkerStartupJSON: { outSignature: 's' },
+        GetProfileSwitchStatsJSON: { outSignature: 's' },
+        GetThrottleStatsJSON: { outSignature: 's' },
+        GetTelemetryPageFd: { outSignature: 'h' },
         GetKeyboardBacklightCapabilitiesJSON: { outSignature: 's' },
         GetKeyboardBacklightStatesJSON: { outSignature: 's' },
         SetKeyboardBacklightStatesJSON: { inSignature: 's',  outSignature: 'b' },
@@ -36,11 +36,12 @@ export class TccDBusService extends DaemonWorker {
         super(1500, tccd);
 
         const options: TccDBusOptions = new TccDBusOptions();
-        options.triggerStateCheck = async () => { this.tccd.triggerStateCheck(); }
+        options.triggerStateCheck = async (trigger?: string) => { this.tccd.triggerStateCheck(false, trigger); }
         options.chargingWorker = this.tccd.getChargingWorker();
 
         try {
-            this.bus = dbus.systemBus();
+            // Unix fds to hand out the telemetry page
+            this.bus = dbus.systemBus({ negotiateUnixFd: true });
             this.interface = new TccDBusInterface(dbusData, options);
         } catch (err) {
             this.tccd.logLine('TccDBusService: Error initializing DBus service => ' + err);
@@ -65,6 +66,7 @@ export class TccDBusService extends DaemonWorker {
     public onWork(): void {
         // Make sure wmiAvailability info is updated. Is done here until it gets its own worker.
         this.dbusData.tuxedoWmiAvailable = TuxedoIOAPI.wmiAvailable();
+        this.tccd.updateDBusSchedulerStats();
 
         if (this.dbusData.modeReapplyPending) {
             this.interface.ModeReapplyPendingChanged();
@@ -0,0 +1,196 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import { DaemonWorker } from './DaemonWorker';
+import { TuxedoControlCenterDaemon } from './TuxedoControlCenterDaemon';
+
+import { TuxedoIOAPI as ioAPI, TelemetryPageData } from '../../native-lib/TuxedoIOAPI';
+import { ICpuPower } from '../../common/models/TccPowerSettings';
+import { IdGpuInfo, IiGpuInfo } from '../../common/models/TccGpuValues';
+
+/**
+ * Publishes live telemetry to the shared telemetry page. GUI and tray map the
+ * page (path handed out over DBus) and read it at their own rate without
+ * DBus round-trips. The generation counters tell them when profiles,
+ * settings or the rarely changing device state have to be refetched over
+ * DBus.
+ */
+export class TelemetryPageWorker extends DaemonWorker {
+
+    private pageCreated = false;
+    private data: TelemetryPageData = {
+        updateCount: 0,
+        profileGeneration: 0,
+        profilesGeneration: 0,
+        settingsGeneration: 0,
+        fans: [],
+        cpuPower: -1,
+        cpuPowerLimit: -1,
+        iGpuPower: -1,
+        iGpuTemperature: -1,
+        dGpuPower: -1,
+        activeProfileId: '',
+        odmProfile: '',
+        stateGeneration: 0,
+        iGpuCoreFrequency: -1,
+        iGpuMaxCoreFrequency: -1,
+        iGpuVendor: '',
+        dGpuCoreFrequency: -1,
+        dGpuMaxCoreFrequency: -1,
+        dGpuMaxPowerLimit: -1,
+        dGpuEnforcedPowerLimit: -1,
+        dGpuD0MetricsUsage: -1,
+        sensorDataCollection: -1,
+        powerState: ''
+    };
+    private previousActiveProfileJSON: string;
+    private previousProfilesJSON: string;
+    private previousSettingsJSON: string;
+    private previousState: any[] = [];
+
+    constructor(tccd: TuxedoControlCenterDaemon) {
+        super(1000, tccd);
+    }
+
+    public onStart(): void {
+        if (!this.pageCreated) {
+            this.pageCreated = ioAPI.telemetryPageCreate();
+            if (this.pageCreated) {
+                this.tccd.dbusData.telemetryPageFd = ioAPI.telemetryPageGetClientFd();
+            } else {
+                this.tccd.logLine('TelemetryPageWorker: Could not create the telemetry page');
+            }
+        }
+        this.onWork();
+    }
+
+    public onWork(): void {
+        if (!this.pageCreated) {
+            return;
+        }
+        const dbusData = this.tccd.dbusData;
+
+        // Comparing unchanged strings is a reference check
+        if (dbusData.activeProfileJSON !== this.previousActiveProfileJSON) {
+            this.previousActiveProfileJSON = dbusData.activeProfileJSON;
+            this.data.profileGeneration++;
+        }
+        if (dbusData.profilesJSON !== this.previousProfilesJSON) {
+            this.previousProfilesJSON = dbusData.profilesJSON;
+            this.data.profilesGeneration++;
+        }
+        if (dbusData.settingsJSON !== this.previousSettingsJSON) {
+            this.previousSettingsJSON = dbusData.settingsJSON;
+            this.data.settingsGeneration++;
+        }
+        const state = this.getDeviceState();
+        if (state.some((value, i) => value !== this.previousState[i])) {
+            this.previousState = state;
+            this.data.stateGeneration++;
+        }
+
+        this.data.fans = dbusData.fans.map(fan => ({
+            timestamp: fan.temp.timestamp.value,
+            temperature: fan.temp.timestamp.value !== 0 ? fan.temp.data.value : -1,
+            speed: fan.speed.timestamp.value !== 0 ? fan.speed.data.value : -1
+        }));
+
+        const cpuPower: ICpuPower = this.parse(dbusData.cpuPowerValuesJSON);
+        const iGpu: IiGpuInfo = this.parse(dbusData.iGpuInfoValuesJSON);
+        const dGpu: IdGpuInfo = this.parse(dbusData.dGpuInfoValuesJSON);
+        this.data.cpuPower = this.valueOrUnknown(cpuPower?.powerDraw);
+        this.data.cpuPowerLimit = this.valueOrUnknown(cpuPower?.maxPowerLimit);
+        this.data.iGpuPower = this.valueOrUnknown(iGpu?.powerDraw);
+        this.data.iGpuTemperature = this.valueOrUnknown(iGpu?.temp);
+        this.data.iGpuCoreFrequency = this.valueOrUnknown(iGpu?.coreFrequency);
+        this.data.iGpuMaxCoreFrequency = this.valueOrUnknown(iGpu?.maxCoreFrequency);
+        this.data.iGpuVendor = typeof iGpu?.vendor === 'string' ? iGpu.vendor : '';
+        this.data.dGpuPower = this.valueOrUnknown(dGpu?.powerDraw);
+        this.data.dGpuCoreFrequency = this.valueOrUnknown(dGpu?.coreFrequency);
+        this.data.dGpuMaxCoreFrequency = this.valueOrUnknown(dGpu?.maxCoreFrequency);
+        this.data.dGpuMaxPowerLimit = this.valueOrUnknown(dGpu?.maxPowerLimit);
+        this.data.dGpuEnforcedPowerLimit = this.valueOrUnknown(dGpu?.enforcedPowerLimit);
+        this.data.dGpuD0MetricsUsage = this.flagOrUnknown(dGpu?.d0MetricsUsage);
+        this.data.sensorDataCollection = this.flagOrUnknown(dbusData.sensorDataCollectionStatus);
+
+        const profile = this.tccd.getCurrentProfile();
+        this.data.activeProfileId = profile !== undefined ? profile.id : '';
+        this.data.odmProfile = dbusData.odmProfileApplied !== undefined ? dbusData.odmProfileApplied : '';
+        const powerState = this.tccd.getProfileState();
+        this.data.powerState = powerState !== undefined ? powerState : '';
+
+        this.data.updateCount++;
+        ioAPI.telemetryPagePublish(this.data);
+    }
+
+    public onExit(): void {
+        if (this.pageCreated) {
+            ioAPI.telemetryPageDestroy();
+            this.tccd.dbusData.telemetryPageFd = -1;
+            this.pageCreated = false;
+        }
+    }
+
+    /**
+     * Values behind the DBus getters the GUI only refetches on a state
+     * generation change. Arrays are replaced, not modified, when they change
+     * so comparing elements is enough.
+     */
+    private getDeviceState(): any[] {
+        const dbusData = this.tccd.dbusData;
+        return [
+            dbusData.device,
+            dbusData.displayModes,
+            dbusData.isX11,
+            dbusData.tuxedoWmiAvailable,
+            dbusData.fanHwmonAvailable,
+            dbusData.webcamSwitchAvailable,
+            dbusData.webcamSwitchStatus,
+            dbusData.forceYUV420OutputSwitchAvailable,
+            dbusData.primeState,
+            dbusData.odmProfilesAvailable,
+            dbusData.odmPowerLimitsJSON,
+            dbusData.keyboardBacklightCapabilitiesJSON,
+            dbusData.keyboardBacklightStatesJSON,
+            dbusData.fansMinSpeed,
+            dbusData.fansOffAvailable,
+            dbusData.nvidiaPowerCTRLDefaultPowerLimit,
+            dbusData.nvidiaPowerCTRLMaxPowerLimit,
+            dbusData.nvidiaPowerCTRLAvailable
+        ];
+    }
+
+    private valueOrUnknown(value: number): number {
+        return typeof value === 'number' ? value : -1;
+    }
+
+    private flagOrUnknown(value: boolean): number {
+        return typeof value === 'boolean' ? (value ? 1 : 0) : -1;
+    }
+
+    private parse(json: string): any {
+        if (json === undefined) {
+            return undefined;
+        }
+        try {
+            return JSON.parse(json);
+        } catch (err) {
+            return undefined;
+        }
+    }
+}
@@ -0,0 +1,63 @@
+/*!
+ * Copyright (c) 2019-2022 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import { DaemonWorker } from './DaemonWorker';
+import { TuxedoControlCenterDaemon } from './TuxedoControlCenterDaemon';
+
+import { TuxedoIOAPI as ioAPI } from '../../native-lib/TuxedoIOAPI';
+
+/**
+ * Publishes the throttle episodes detected by the native throttle monitor.
+ * The monitor keeps running across profile changes so the statistics cover
+ * the whole daemon lifetime.
+ */
+export class ThrottleMonitorWorker extends DaemonWorker {
+
+    private monitorStarted = false;
+
+    constructor(tccd: TuxedoControlCenterDaemon) {
+        super(5000, tccd);
+    }
+
+    public onStart(): void {
+        if (!this.monitorStarted) {
+            this.monitorStarted = ioAPI.throttleMonitorStart({ sampleIntervalMs: 1000, quietSamples: 3 });
+            if (!this.monitorStarted) {
+                this.tccd.logLine('ThrottleMonitorWorker: No thermal throttle counters available');
+            }
+        }
+        this.updateDBusData();
+    }
+
+    public onWork(): void {
+        this.updateDBusData();
+    }
+
+    public onExit(): void {
+        if (this.monitorStarted) {
+            ioAPI.throttleMonitorStop();
+            this.monitorStarted = false;
+        }
+    }
+
+    private updateDBusData(): void {
+        if (this.monitorStarted) {
+            this.tccd.dbusData.throttleStatsJSON = JSON.stringify(ioAPI.throttleMonitorGetStats());
+        }
+    }
+}
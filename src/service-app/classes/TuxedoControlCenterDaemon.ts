@@ -28,32 +28,28 @@ import { defaultSettings, ITccSettings, ProfileStates } from '../../common/model
 import { generateProfileId, ITccProfile } from '../../common/models/TccProfile';
 import { DaemonWorker } from './DaemonWorker';
 import { DaemonListener } from './DaemonListener';
-import { DisplayBacklightWorker } from './DisplayBacklightWorker';
-import { DisplayRefreshRateWorker } from './DisplayRefreshRateWorker';
-import { CpuWorker } from './CpuWorker';
 import { ITccAutosave } from '../../common/models/TccAutosave';
 import { StateSwitcherWorker } from './StateSwitcherWorker';
-import { WebcamWorker } from './WebcamWorker';
 import { FanControlWorker } from './FanControlWorker';
-import { YCbCr420WorkaroundWorker } from './YCbCr420WorkaroundWorker';
 import { ITccFanProfile, customFanPreset } from '../../common/models/TccFanTable';
 import { TccDBusService } from './TccDBusService';
 import { TccDBusData } from './TccDBusInterface';
-import { TuxedoIOAPI, ModuleInfo, TDPInfo } from '../../native-lib/TuxedoIOAPI';
+import { TuxedoIOAPI, TDPInfo } from '../../native-lib/TuxedoIOAPI';
 import { ODMProfileWorker } from './ODMProfileWorker';
-import { ODMPowerLimitWorker } from './ODMPowerLimitWorker';
 import { CpuController } from '../../common/classes/CpuController';
 import { DMIController } from '../../common/classes/DMIController';
 import { TUXEDODevice, defaultCustomProfile } from '../../common/models/DefaultProfiles';
 import { ScalingDriver } from '../../common/classes/LogicalCpuController';
 import { ChargingWorker } from './ChargingWorker';
 import { WebcamPreset } from 'src/common/models/TccWebcamSettings';
-import { GpuInfoWorker } from "./GpuInfoWorker";
-import { CpuPowerWorker } from './CpuPowerWorker';
-import { PrimeWorker } from './PrimeWorker';
 import { KeyboardBacklightListener } from './KeyboardBacklightListener';
 import { NVIDIAPowerCTRLListener } from './NVIDIAPowerCTRLListener';
-import { AvailabilityService } from "../../common/classes/availability.service";
+import { CapabilityCache } from './CapabilityCache';
+import { WorkerScheduler, NativeSchedulerTimer, TimeoutSchedulerTimer, monotonicMs } from './WorkerScheduler';
+import { IWorkerStartupReport } from './WorkerStartup';
+import { DaemonWorkerGraph } from './DaemonWorkerGraph';
+import { SysFsNotifyWatcher } from './SysFsNotifyWatcher';
+import { IProfileSwitchRequest, ProfileSwitchHistory, createProfileSwitchReport } from './ProfileSwitchTrace';
 
 const tccPackage = require('../../package.json');
 
@@ -62,6 +58,11 @@ export class TuxedoControlCenterDaemon extends SingleProcess {
     static readonly CMD_RESTART_SERVICE = 'systemctl restart tccd.service';
     static readonly CMD_START_SERVICE = 'systemctl start tccd.service';
     static readonly CMD_STOP_SERVICE = 'systemctl stop tccd.service';
+    static readonly CAPABILITIES_VERIFY_DELAY_MS = 2000;
+    // Worker start until the first fan control cycle, only critical workers are in between
+    static readonly FANS_CONTROLLED_BUDGET_MS = 1000;
+    // Profile switch request until all workers applied the profile
+    static readonly PROFILE_SWITCH_BUDGET_MS = 500;
 
     public config: ConfigHandler;
 
@@ -72,16 +73,30 @@ export class TuxedoControlCenterDaemon extends SingleProcess {
 
     public dbusData = new TccDBusData(3);
 
+    public capabilityCache = new CapabilityCache();
+
+    // Kernel side sysfs changes, shared by workers and listeners
+    public sysFsWatcher = new SysFsNotifyWatcher(TuxedoIOAPI, (line: string) => this.logLine(line));
+
     public activeProfile: ITccProfile;
 
     private workers: DaemonWorker[] = [];
+    private workerGraph: DaemonWorkerGraph;
     private listeners: DaemonListener[] = [];
 
     protected started = false;
 
     private stateWorker: StateSwitcherWorker;
     private chargingWorker: ChargingWorker;
-    private displayWorker: DisplayRefreshRateWorker;
+    private fanWorker: FanControlWorker;
+    private workersStartedOnce = false;
+    // Worker starts run one at a time, requests arriving meanwhile are
+    // coalesced into one more start after the running one
+    private workerStartRunning: Promise<IWorkerStartupReport>;
+    private workerStartRerun: Promise<IWorkerStartupReport>;
+    private pendingProfileSwitches: IProfileSwitchRequest[] = [];
+    private profileSwitches = new ProfileSwitchHistory();
+    private scheduler: WorkerScheduler;
     constructor() {
         super(TccPaths.PID_FILE);
         this.config = new ConfigHandler(
@@ -111,27 +126,21 @@ export class TuxedoControlCenterDaemon extends SingleProcess {
 
         // If program is still running this is the start of the daemon
 
-        this.displayWorker = new DisplayRefreshRateWorker(this);
+        // Before the profiles, their device specific defaults use the capabilities
+        this.loadCapabilities();
         this.loadConfigsAndProfiles();
         this.setupSignalHandling();
 
         this.dbusData.tccdVersion = tccPackage.version;
-        this.stateWorker = new StateSwitcherWorker(this);
-        this.chargingWorker = new ChargingWorker(this);
-        this.workers.push(this.chargingWorker);
-        this.workers.push(this.stateWorker);
-        this.workers.push(new DisplayBacklightWorker(this));
-        this.workers.push(new CpuWorker(this));
-        this.workers.push(new WebcamWorker(this));
-        this.workers.push(new FanControlWorker(this));
-        this.workers.push(new YCbCr420WorkaroundWorker(this));
-        this.workers.push(new GpuInfoWorker(this, new AvailabilityService()));
-        this.workers.push(new CpuPowerWorker(this));
-        this.workers.push(new PrimeWorker(this));
-        this.workers.push(new TccDBusService(this, this.dbusData));
-        this.workers.push(new ODMProfileWorker(this));
-        this.workers.push(new ODMPowerLimitWorker(this));
-        this.workers.push(this.displayWorker);
+        this.workerGraph = new DaemonWorkerGraph(this);
+        this.stateWorker = this.workerGraph.stateWorker;
+        this.chargingWorker = this.workerGraph.chargingWorker;
+        this.fanWorker = this.workerGraph.fanWorker;
+        this.workerGraph.addDaemonWorkers({
+            dbusService: new TccDBusService(this, this.dbusData),
+            metricsSocketPath: this.getPathArgument('--metrics-socket')
+        });
+        this.workers = this.workerGraph.workers;
 
         this.listeners.push(new KeyboardBacklightListener(this));
         this.listeners.push(new NVIDIAPowerCTRLListener(this));
@@ -141,31 +150,155 @@ export class TuxedoControlCenterDaemon extends SingleProcess {
         this.started = true;
         this.logLine('Daemon started');
 
-        // Start continuous work for each worker with individual interval
+        // Start continuous work for all workers on a shared timer
+        this.startScheduler();
+
+        // Re-verify cached capabilities once control is established
+        if (this.capabilityCache.fromCache) {
+            setTimeout(() => this.verifyCapabilities(), TuxedoControlCenterDaemon.CAPABILITIES_VERIFY_DELAY_MS);
+        }
+    }
+
+    private startScheduler(): void {
+        const logLine = (line: string) => this.logLine(line);
+        this.scheduler = new WorkerScheduler(new NativeSchedulerTimer(TuxedoIOAPI), logLine);
+        if (!this.scheduler.start()) {
+            this.logLine('Native scheduler timer unavailable, using fallback');
+            this.scheduler = new WorkerScheduler(new TimeoutSchedulerTimer(), logLine);
+            this.scheduler.start();
+        }
         for (const worker of this.workers) {
-            worker.timer = setInterval(() => {
-                try {
-                    worker.work();
-                } catch (err) {
-                    this.logLine('Failed executing onWork() => ' + err);
-                }
-            }, worker.timeout);
+            this.scheduler.add(worker);
         }
+    }
 
+    public updateDBusSchedulerStats(): void {
+        if (this.scheduler !== undefined) {
+            this.dbusData.schedulerStatsJSON = JSON.stringify(this.scheduler.getStats());
+        }
     }
 
-    public startWorkers(): void {
-        for (const worker of this.workers) {
-            try {
-                worker.updateProfile(this.getCurrentProfile());
-                worker.start();
-            } catch (err) {
-                this.logLine('Failed executing onStart() => ' + err);
+    public getProfileState(): ProfileStates {
+        return this.stateWorker !== undefined ? this.stateWorker.getCurrentState() : undefined;
+    }
+
+    private loadCapabilities(): void {
+        try {
+            this.capabilityCache.load();
+            if (this.capabilityCache.fromCache) {
+                this.logLine('Using cached hardware capabilities');
+            }
+        } catch (err) {
+            this.logLine('Failed to load hardware capabilities => ' + err);
+        }
+    }
+
+    private verifyCapabilities(): void {
+        try {
+            if (this.capabilityCache.verify()) {
+                this.logLine('Hardware capabilities changed, restarting workers');
+                this.startWorkers();
+            }
+        } catch (err) {
+            this.logLine('Failed to verify hardware capabilities => ' + err);
+        }
+    }
+
+    /**
+     * Starts the workers for the current profile. A request while a start is
+     * running is served by one more start afterwards, shared by all requests
+     * arriving in the meantime, so the async worker starts never interleave.
+     *
+     * @param profileSwitch Switch causing the start, traced from the request
+     *                      until the profile is fully applied
+     */
+    public startWorkers(profileSwitch?: IProfileSwitchRequest): Promise<IWorkerStartupReport> {
+        if (profileSwitch !== undefined) {
+            this.pendingProfileSwitches.push(profileSwitch);
+        }
+        if (this.workerStartRerun !== undefined) {
+            return this.workerStartRerun;
+        }
+        if (this.workerStartRunning !== undefined) {
+            this.workerStartRerun = this.workerStartRunning.then(() => {
+                this.workerStartRerun = undefined;
+                return this.runWorkerStartup();
+            });
+            return this.workerStartRerun;
+        }
+        return this.runWorkerStartup();
+    }
+
+    private runWorkerStartup(): Promise<IWorkerStartupReport> {
+        const startup = this.workerGraph.createStartup(() => this.getCurrentProfile(), (line: string) => this.logLine(line));
+        const profileSwitches = this.pendingProfileSwitches;
+        this.pendingProfileSwitches = [];
+        // Restarts on profile changes are only reported over DBus
+        const initialStart = !this.workersStartedOnce;
+        this.workersStartedOnce = true;
+        let fansControlledMs: number;
+        const running = startup.run((report) => {
+            fansControlledMs = this.controlFans(report, initialStart);
+        }).then((report) => {
+            this.dbusData.workerStartupJSON = JSON.stringify({ ...report, fansControlledMs });
+            for (const profileSwitch of profileSwitches) {
+                this.traceProfileSwitch(profileSwitch, report);
+            }
+            if (initialStart) {
+                const slowest = report.workers.reduce((prev, cur) => cur.durationMs > prev.durationMs ? cur : prev);
+                this.logLine(`Workers started in ${Math.round(report.allDoneMs)} ms, `
+                    + `slowest ${slowest.name} (${Math.round(slowest.durationMs)} ms)`);
             }
+            return report;
+        }).catch((err) => {
+            this.logLine('Failed starting workers => ' + err);
+            return undefined;
+        }).then((report) => {
+            this.workerStartRunning = undefined;
+            return report;
+        });
+        this.workerStartRunning = running;
+        return running;
+    }
+
+    /**
+     * First fan control cycle right after the critical workers started
+     * instead of one interval later
+     *
+     * @returns Time from the begin of the worker start until fans are controlled
+     */
+    private controlFans(report: IWorkerStartupReport, initialStart: boolean): number {
+        this.fanWorker.work();
+        const nowMs = monotonicMs();
+        const fansControlledMs = nowMs - report.beginMs;
+        if (initialStart) {
+            this.logLine(`Fans controlled ${Math.round(fansControlledMs)} ms after worker start `
+                + `(${Math.round(process.uptime() * 1000)} ms after tccd start, ${Math.round(nowMs)} ms after boot)`);
+        }
+        if (fansControlledMs > TuxedoControlCenterDaemon.FANS_CONTROLLED_BUDGET_MS) {
+            this.logLine(`Fan control took longer than ${TuxedoControlCenterDaemon.FANS_CONTROLLED_BUDGET_MS} ms, `
+                + report.workers.map(worker => `${worker.name} ${Math.round(worker.durationMs)} ms`).join(', '));
+        }
+        return fansControlledMs;
+    }
+
+    private traceProfileSwitch(profileSwitch: IProfileSwitchRequest, startup: IWorkerStartupReport): void {
+        const report = createProfileSwitchReport(profileSwitch, startup);
+        this.profileSwitches.add(report);
+        this.dbusData.profileSwitchStatsJSON = JSON.stringify(this.profileSwitches.getStats());
+        this.logLine(`Profile ${report.profileId} applied ${Math.round(report.fullyAppliedMs)} ms after ${report.trigger}`);
+        if (report.fullyAppliedMs > TuxedoControlCenterDaemon.PROFILE_SWITCH_BUDGET_MS) {
+            this.logLine(`Profile switch took longer than ${TuxedoControlCenterDaemon.PROFILE_SWITCH_BUDGET_MS} ms, `
+                + `selected after ${Math.round(report.selectedMs)} ms, `
+                + report.workers.map(worker => `${worker.name} ${Math.round(worker.durationMs)} ms`).join(', '));
         }
     }
 
-    public triggerStateCheck(reset?: boolean) {
+    /**
+     * @param trigger Name of the request (e.g. DBus method) if it may switch
+     *                the profile, traced until the profile is applied
+     */
+    public triggerStateCheck(reset?: boolean, trigger?: string) {
         if (reset === undefined) {
             reset = false;
         }
@@ -173,6 +306,9 @@ export class TuxedoControlCenterDaemon extends SingleProcess {
             if (reset) {
                 this.stateWorker.reapplyProfile();
             }
+            if (trigger !== undefined) {
+                this.stateWorker.requestProfileSwitch(trigger);
+            }
             this.stateWorker.work();
         }
     }
@@ -195,9 +331,10 @@ export class TuxedoControlCenterDaemon extends SingleProcess {
     }
 
     public onExit() {
-        this.workers.forEach((worker) => {
-            clearInterval(worker.timer);
-        });
+        if (this.scheduler !== undefined) {
+            this.scheduler.stop();
+        }
+        this.sysFsWatcher.stop();
         this.workers.forEach((worker) => {
             // On exit events for each worker before exiting and saving settings
             try {
@@ -217,9 +354,8 @@ export class TuxedoControlCenterDaemon extends SingleProcess {
                 throw Error('Couldn\'t start daemon. It is probably already running');
             } else {
                 this.logLine('Starting daemon v' + tccPackage.version + ' (node: ' + process.version + ' arch: ' + os.arch() + ')');
-                const modInfo = new ModuleInfo();
                 if (TuxedoIOAPI.wmiAvailable()) {
-                    TuxedoIOAPI.getModuleInfo(modInfo);
+                    const modInfo = CapabilityCache.getModuleInfo();
                     this.logLine('tuxedo-io ver ' + modInfo.version + ' [ interface: ' + modInfo.activeInterface + ' ]');
                 } else {
                     this.logLine('No tuxedo-io found on start');
@@ -502,8 +638,7 @@ export class TuxedoControlCenterDaemon extends SingleProcess {
         const dmi = new DMIController('/sys/class/dmi/id');
         const productSKU = dmi.productSKU.readValueNT();
         const boardName = dmi.boardName.readValueNT();
-        const modInfo = new ModuleInfo();
-        TuxedoIOAPI.getModuleInfo(modInfo);
+        const modInfo = CapabilityCache.getModuleInfo();
 
         const dmiSKUDeviceMap = new Map<string, TUXEDODevice>();
         dmiSKUDeviceMap.set('IBS1706', TUXEDODevice.IBP17G6);
@@ -778,8 +913,9 @@ export class TuxedoControlCenterDaemon extends SingleProcess {
             }
         }
 
-        const defaultODMProfileName = ODMProfileWorker.getDefaultODMPerformanceProfile(dev);
-        const availableODMProfiles = ODMProfileWorker.getAvailableODMPerformanceProfiles(dev);
+        const cachedODMProfiles = this.capabilityCache.getODMProfiles();
+        const defaultODMProfileName = ODMProfileWorker.getDefaultODMPerformanceProfile(dev, cachedODMProfiles);
+        const availableODMProfiles = ODMProfileWorker.getAvailableODMPerformanceProfiles(dev, cachedODMProfiles);
         if (profile.odmProfile === undefined || !availableODMProfiles.includes(profile.odmProfile.name)) {
             profile.odmProfile = {
                 name: defaultODMProfileName
@@ -790,8 +926,11 @@ export class TuxedoControlCenterDaemon extends SingleProcess {
             profile.odmProfile.name = defaultODMProfileName;
         }
 
-        let tdpInfo: TDPInfo[] = [];
-        TuxedoIOAPI.getTDPInfo(tdpInfo);
+        let tdpInfo: TDPInfo[] = this.capabilityCache.getTDPLimits();
+        if (tdpInfo === undefined) {
+            tdpInfo = [];
+            TuxedoIOAPI.getTDPInfo(tdpInfo);
+        }
         if (profile.odmPowerLimits === undefined
             || profile.odmPowerLimits.tdpValues === undefined) {
             profile.odmPowerLimits = { tdpValues: [] };
@@ -0,0 +1,107 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import 'jasmine';
+import { ISchedulerTimer, WorkerScheduler } from './WorkerScheduler';
+
+describe('WorkerScheduler', () => {
+
+    let nowMs: number;
+    let deadlineMs: number;
+    let callback: () => void;
+    const timer: ISchedulerTimer = {
+        start: (cb) => { callback = cb; return true; },
+        arm: (deadline) => { deadlineMs = deadline; },
+        stop: () => { deadlineMs = undefined; },
+        getStats: () => undefined
+    };
+
+    class CountingWorker {
+        public runs: number[] = [];
+        constructor(public interval: number) {}
+        work() { this.runs.push(nowMs); }
+        getNextInterval() { return this.interval; }
+    }
+
+    function runUntil(endMs: number) {
+        while (deadlineMs !== undefined && deadlineMs <= endMs) {
+            nowMs = deadlineMs;
+            callback();
+        }
+        nowMs = endMs;
+    }
+
+    beforeEach(() => {
+        nowMs = 10130;
+        deadlineMs = undefined;
+    });
+
+    it('should run workers with different intervals in common wakeups', () => {
+        const scheduler = new WorkerScheduler(timer, () => {}, () => nowMs);
+        const fast = new CountingWorker(1000);
+        const slow = new CountingWorker(2000);
+        scheduler.add(fast);
+        scheduler.add(slow);
+        scheduler.start();
+        runUntil(20500);
+
+        expect(fast.runs.length).toBe(10);
+        expect(slow.runs.length).toBe(5);
+        for (const run of slow.runs) {
+            expect(fast.runs).toContain(run);
+        }
+        expect(scheduler.getStats().wakeups).toBe(10);
+    });
+
+    it('should follow the interval returned after each run', () => {
+        const scheduler = new WorkerScheduler(timer, () => {}, () => nowMs);
+        const worker = new CountingWorker(1000);
+        scheduler.add(worker);
+        scheduler.start();
+        runUntil(13000);
+        worker.interval = 3000;
+        runUntil(25000);
+
+        expect(worker.runs).toEqual([ 11500, 12500, 13500, 16500, 19500, 22500 ]);
+    });
+
+    it('should keep running after a failing worker', () => {
+        const log: string[] = [];
+        const scheduler = new WorkerScheduler(timer, (line) => log.push(line), () => nowMs);
+        const failing = { work: () => { throw new Error('fail'); }, getNextInterval: () => 1000 };
+        const worker = new CountingWorker(1000);
+        scheduler.add(failing);
+        scheduler.add(worker);
+        scheduler.start();
+        runUntil(12500);
+
+        expect(worker.runs.length).toBe(2);
+        expect(log.length).toBe(2);
+    });
+
+    it('should not run anything after stop', () => {
+        const scheduler = new WorkerScheduler(timer, () => {}, () => nowMs);
+        const worker = new CountingWorker(1000);
+        scheduler.add(worker);
+        scheduler.start();
+        scheduler.stop();
+        runUntil(20000);
+
+        expect(worker.runs.length).toBe(0);
+    });
+});
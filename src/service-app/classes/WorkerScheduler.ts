@@ -0,0 +1,228 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import { ITuxedoIOAPI, SchedulerTimerStats } from '../../native-lib/TuxedoIOAPI';
+
+export interface ISchedulableWorker {
+    work(): void;
+    getNextInterval(): number;
+}
+
+/**
+ * Single wakeup source of the scheduler, deadlines are absolute times of
+ * the scheduler clock
+ */
+export interface ISchedulerTimer {
+    start(callback: () => void, slackMs: number): boolean;
+    arm(deadlineMs: number): void;
+    stop(): void;
+    getStats(): SchedulerTimerStats;
+}
+
+export interface IWorkerSchedulerStats {
+    wakeups: number;
+    wakeupsLastMinute: number;
+    workRuns: number;
+    workers: { name: string, intervalMs: number }[];
+    timer?: SchedulerTimerStats;
+}
+
+/**
+ * Current CLOCK_MONOTONIC time in ms, the time base of the native timer
+ */
+export function monotonicMs(): number {
+    const [seconds, nanoseconds] = process.hrtime();
+    return seconds * 1e3 + nanoseconds / 1e6;
+}
+
+/**
+ * Timer on the native timerfd (absolute monotonic deadlines)
+ */
+export class NativeSchedulerTimer implements ISchedulerTimer {
+    constructor(private api: ITuxedoIOAPI) {}
+
+    public start(callback: () => void, slackMs: number): boolean {
+        return this.api.schedulerStart(callback, slackMs);
+    }
+
+    public arm(deadlineMs: number): void {
+        this.api.schedulerArm(deadlineMs);
+    }
+
+    public stop(): void {
+        this.api.schedulerStop();
+    }
+
+    public getStats(): SchedulerTimerStats {
+        return this.api.schedulerGetStats();
+    }
+}
+
+/**
+ * Fallback timer if the native one is not available
+ */
+export class TimeoutSchedulerTimer implements ISchedulerTimer {
+    private timeout: NodeJS.Timeout;
+    private callback: () => void;
+
+    constructor(private clock: () => number = monotonicMs) {}
+
+    public start(callback: () => void, slackMs: number): boolean {
+        this.callback = callback;
+        return true;
+    }
+
+    public arm(deadlineMs: number): void {
+        clearTimeout(this.timeout);
+        this.timeout = setTimeout(() => this.callback(), Math.max(0, deadlineMs - this.clock()));
+    }
+
+    public stop(): void {
+        clearTimeout(this.timeout);
+        this.timeout = undefined;
+    }
+
+    public getStats(): SchedulerTimerStats {
+        return undefined;
+    }
+}
+
+interface ScheduleEntry {
+    worker: ISchedulableWorker;
+    dueMs: number;
+    intervalMs: number;
+}
+
+/**
+ * Runs the workers on one timer instead of one interval each
+ *
+ * Due times are aligned to a common grid so workers with different
+ * intervals are run in the same wakeup. Everything due within the slack of
+ * a wakeup is run right away instead of waking up again shortly after. The
+ * interval is asked from the worker after each run, allowing workers to
+ * adapt it.
+ */
+export class WorkerScheduler {
+
+    public static readonly GRID_MS = 500;
+    public static readonly SLACK_MS = 250;
+    private static readonly MINUTE_MS = 60000;
+
+    private entries: ScheduleEntry[] = [];
+    private running = false;
+    private wakeups = 0;
+    private workRuns = 0;
+    private wakeupTimes: number[] = [];
+
+    /**
+     * @param gridMs Grid and slack are only changed by benchmarks running
+     *               the scheduler at a compressed time scale
+     */
+    constructor(
+        private timer: ISchedulerTimer,
+        private logLine: (line: string) => void,
+        private clock: () => number = monotonicMs,
+        private gridMs: number = WorkerScheduler.GRID_MS,
+        private slackMs: number = WorkerScheduler.SLACK_MS) {}
+
+    /**
+     * Add a worker, first run one interval from now
+     */
+    public add(worker: ISchedulableWorker): void {
+        const intervalMs = worker.getNextInterval();
+        this.entries.push({ worker, intervalMs, dueMs: this.align(this.clock() + intervalMs) });
+        if (this.running) {
+            this.arm();
+        }
+    }
+
+    public start(): boolean {
+        this.running = this.timer.start(() => this.onWakeup(), this.slackMs);
+        if (this.running) {
+            this.arm();
+        }
+        return this.running;
+    }
+
+    public stop(): void {
+        this.running = false;
+        this.timer.stop();
+    }
+
+    public getStats(): IWorkerSchedulerStats {
+        this.pruneWakeups(this.clock());
+        return {
+            wakeups: this.wakeups,
+            wakeupsLastMinute: this.wakeupTimes.length,
+            workRuns: this.workRuns,
+            workers: this.entries.map(entry => ({ name: entry.worker.constructor.name, intervalMs: entry.intervalMs })),
+            timer: this.timer.getStats()
+        };
+    }
+
+    private onWakeup(): void {
+        const nowMs = this.clock();
+        this.wakeups++;
+        this.wakeupTimes.push(nowMs);
+        this.pruneWakeups(nowMs);
+
+        for (const entry of this.entries) {
+            if (!this.running) {
+                return;
+            }
+            if (entry.dueMs > nowMs + this.slackMs) {
+                continue;
+            }
+            try {
+                entry.worker.work();
+            } catch (err) {
+                this.logLine('Failed executing onWork() => ' + err);
+            }
+            this.workRuns++;
+            try {
+                entry.intervalMs = entry.worker.getNextInterval();
+            } catch (err) {
+                this.logLine('Failed getting worker interval => ' + err);
+            }
+            // Keep the grid phase, missed runs are skipped and not caught up
+            entry.dueMs = Math.max(this.align(entry.dueMs + entry.intervalMs), this.align(this.clock() + 1));
+        }
+
+        if (this.running) {
+            this.arm();
+        }
+    }
+
+    private arm(): void {
+        if (this.entries.length === 0) {
+            return;
+        }
+        const nextDueMs = this.entries.reduce((min, entry) => Math.min(min, entry.dueMs), Infinity);
+        this.timer.arm(nextDueMs);
+    }
+
+    private align(timeMs: number): number {
+        return Math.ceil(timeMs / this.gridMs) * this.gridMs;
+    }
+
+    private pruneWakeups(nowMs: number): void {
+        while (this.wakeupTimes.length > 0 && nowMs - this.wakeupTimes[0] > WorkerScheduler.MINUTE_MS) {
+            this.wakeupTimes.shift();
+        }
+    }
+}
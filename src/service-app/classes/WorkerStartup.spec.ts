@@ -0,0 +1,100 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import 'jasmine';
+import { WorkerStartup } from './WorkerStartup';
+
+describe('WorkerStartup', () => {
+
+    let events: string[];
+    let logLines: string[];
+
+    function delayed(name: string, delayMs: number): () => Promise<void> {
+        return () => {
+            events.push(name + ' begin');
+            return new Promise<void>(resolve => setTimeout(() => {
+                events.push(name + ' end');
+                resolve();
+            }, delayMs));
+        };
+    }
+
+    function immediate(name: string): () => void {
+        return () => { events.push(name); };
+    }
+
+    beforeEach(() => {
+        events = [];
+        logLines = [];
+    });
+
+    it('should start critical workers before all others', async () => {
+        const startup = new WorkerStartup(line => logLines.push(line));
+        startup.add('state', immediate('state'), [], true);
+        startup.add('display', immediate('display'), ['state']);
+        startup.add('fan', immediate('fan'), ['state'], true);
+        startup.add('odmPowerLimit', immediate('odmPowerLimit'), ['state'], true);
+
+        const report = await startup.run(() => events.push('critical done'));
+
+        expect(events).toEqual([ 'state', 'fan', 'odmPowerLimit', 'critical done', 'display' ]);
+        expect(report.workers.map(worker => worker.name)).toEqual([ 'state', 'fan', 'odmPowerLimit', 'display' ]);
+        expect(report.workers.filter(worker => worker.critical).length).toBe(3);
+    });
+
+    it('should overlap independent asynchronous starts and wait for dependencies', async () => {
+        const startup = new WorkerStartup(line => logLines.push(line));
+        startup.add('state', immediate('state'), [], true);
+        startup.add('gpu', delayed('gpu', 30), ['state']);
+        startup.add('prime', delayed('prime', 10), ['state']);
+        startup.add('metrics', immediate('metrics'), ['gpu']);
+
+        const report = await startup.run();
+
+        expect(events).toEqual([ 'state', 'gpu begin', 'prime begin', 'prime end', 'gpu end', 'metrics' ]);
+        const gpu = report.workers.find(worker => worker.name === 'gpu');
+        const metrics = report.workers.find(worker => worker.name === 'metrics');
+        expect(gpu.durationMs).toBeGreaterThanOrEqual(25);
+        expect(metrics.startMs).toBeGreaterThanOrEqual(gpu.startMs + gpu.durationMs);
+    });
+
+    it('should trace failing and hanging starts and continue with the others', async () => {
+        const startup = new WorkerStartup(line => logLines.push(line), undefined, 20);
+        startup.add('state', () => { throw new Error('broken'); }, [], true);
+        startup.add('fan', immediate('fan'), ['state'], true);
+        startup.add('probe', () => new Promise<void>(() => {}), ['state']);
+        startup.add('dbus', immediate('dbus'), ['probe']);
+
+        const report = await startup.run();
+
+        expect(events).toEqual([ 'fan', 'dbus' ]);
+        expect(report.workers.find(worker => worker.name === 'state').error).toContain('broken');
+        expect(report.workers.find(worker => worker.name === 'probe').timedOut).toBe(true);
+        expect(logLines.length).toBe(2);
+    });
+
+    it('should reject invalid dependencies', () => {
+        const startup = new WorkerStartup(() => {});
+        startup.add('state', immediate('state'), [], true);
+        startup.add('display', immediate('display'), ['state']);
+
+        expect(() => startup.add('fan', immediate('fan'), ['unknown'], true)).toThrow();
+        expect(() => startup.add('fan', immediate('fan'), ['display'], true)).toThrow();
+        expect(() => startup.add('display', immediate('display'), ['state'])).toThrow();
+    });
+});
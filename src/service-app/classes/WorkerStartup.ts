@@ -0,0 +1,180 @@
+/*!
+ * Copyright (c) 2024 TUXEDO Computers GmbH <tux@tuxedocomputers.com>
+ *
+ * This file is part of TUXEDO Control Center.
+ *
+ * TUXEDO Control Center is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TUXEDO Control Center is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TUXEDO Control Center.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import { monotonicMs } from './WorkerScheduler';
+
+export type WorkerStartFunction = () => void | Promise<void>;
+
+export interface IWorkerStartTrace {
+    name: string;
+    critical: boolean;
+    // Relative to the begin of the startup
+    startMs: number;
+    durationMs: number;
+    timedOut?: boolean;
+    error?: string;
+}
+
+export interface IWorkerStartupReport {
+    // Monotonic clock at the begin, i.e. time since boot without suspend
+    beginMs: number;
+    // Relative to beginMs
+    criticalDoneMs: number;
+    allDoneMs: number;
+    workers: IWorkerStartTrace[];
+}
+
+interface StartupNode {
+    name: string;
+    start: WorkerStartFunction;
+    after: string[];
+    critical: boolean;
+}
+
+/**
+ * Starts workers along a small dependency graph
+ *
+ * Critical workers (hardware safety: fans, power limits, charging) are
+ * started first, in dependency order. Everything else is started afterwards,
+ * each worker as soon as the workers it depends on are started, so that
+ * asynchronous starts (probes awaiting commands) overlap instead of queuing.
+ * An asynchronous start counts as done after a timeout so that a hanging
+ * probe does not hold back its dependents.
+ */
+export class WorkerStartup {
+
+    public static readonly START_TIMEOUT_MS = 10000;
+
+    private nodes: StartupNode[] = [];
+
+    constructor(
+        private logLine: (line: string) => void,
+        private clock: () => number = monotonicMs,
+        private startTimeoutMs: number = WorkerStartup.START_TIMEOUT_MS) {}
+
+    /**
+     * @param after Names of workers that have to be started before, they
+     *              have to be added already which keeps the graph acyclic
+     * @param critical Critical workers may only depend on critical workers
+     */
+    public add(name: string, start: WorkerStartFunction, after: string[] = [], critical: boolean = false): void {
+        if (this.findNode(name) !== undefined) {
+            throw new Error('WorkerStartup: ' + name + ' added twice');
+        }
+        for (const dependency of after) {
+            const node = this.findNode(dependency);
+            if (node === undefined) {
+                throw new Error('WorkerStartup: ' + name + ' depends on unknown ' + dependency);
+            }
+            if (critical && !node.critical) {
+                throw new Error('WorkerStartup: critical ' + name + ' depends on non-critical ' + dependency);
+            }
+        }
+        this.nodes.push({ name, start, after, critical });
+    }
+
+    /**
+     * Starts all added workers
+     *
+     * @param onCriticalStarted Called once all critical workers are started,
+     *                          before any other worker starts
+     */
+    public async run(onCriticalStarted?: (report: IWorkerStartupReport) => void): Promise<IWorkerStartupReport> {
+        const report: IWorkerStartupReport = {
+            beginMs: this.clock(),
+            criticalDoneMs: undefined,
+            allDoneMs: undefined,
+            workers: []
+        };
+        const started = new Map<string, Promise<void>>();
+        const startNode = (node: StartupNode): Promise<void> => {
+            let promise = started.get(node.name);
+            if (promise === undefined) {
+                const dependencies = node.after.map(name => startNode(this.findNode(name)));
+                promise = Promise.all(dependencies).then(() => this.startWorker(node, report));
+                started.set(node.name, promise);
+            }
+            return promise;
+        };
+
+        await Promise.all(this.nodes.filter(node => node.critical).map(startNode));
+        report.criticalDoneMs = this.clock() - report.beginMs;
+        if (onCriticalStarted !== undefined) {
+            try {
+                onCriticalStarted(report);
+            } catch (err) {
+                this.logLine('WorkerStartup: Failed after critical workers => ' + err);
+            }
+        }
+
+        await Promise.all(this.nodes.filter(node => !node.critical).map(startNode));
+        report.allDoneMs = this.clock() - report.beginMs;
+        return report;
+    }
+
+    private findNode(name: string): StartupNode {
+        return this.nodes.find(node => node.name === name);
+    }
+
+    private async startWorker(node: StartupNode, report: IWorkerStartupReport): Promise<void> {
+        const trace: IWorkerStartTrace = {
+            name: node.name,
+            critical: node.critical,
+            startMs: this.clock() - report.beginMs,
+            durationMs: undefined
+        };
+        report.workers.push(trace);
+        try {
+            const result = node.start();
+            if (result instanceof Promise) {
+                trace.timedOut = !await this.withTimeout(result, node.name);
+            }
+        } catch (err) {
+            trace.error = String(err);
+            this.logLine('Failed executing onStart() of ' + node.name + ' => ' + err);
+        }
+        trace.durationMs = this.clock() - report.beginMs - trace.startMs;
+        if (trace.timedOut) {
+            this.logLine('WorkerStartup: ' + node.name + ' did not start within ' + this.startTimeoutMs + ' ms, continuing');
+        }
+    }
+
+    /**
+     * @returns False if the start did not complete within the timeout
+     */
+    private withTimeout(start: Promise<void>, name: string): Promise<boolean> {
+        return new Promise<boolean>((resolve, reject) => {
+            let expired = false;
+            const timeout = setTimeout(() => {
+                expired = true;
+                resolve(false);
+            }, this.startTimeoutMs);
+            start.then(() => {
+                clearTimeout(timeout);
+                resolve(true);
+            }, (err) => {
+                clearTimeout(timeout);
+                if (expired) {
+                    this.logLine('Failed executing onStart() of ' + name + ' => ' + err);
+                } else {
+                    reject(err);
+                }
+            });
+        });
+    }
+}